@@ -4,12 +4,122 @@
 
 #include <cassert>
 #include <map>
+#include <vector>
 
 //! Class representing a generic (single-parameter) function,
 //! which can be passed into the functional boxplot calculation.
 template <typename ArgType, typename ValType>
 class iAFunction : public std::map<ArgType, ValType> {};
 
+//! Dense representation of a set of functions which are all defined at the same arguments.
+//! Values are stored argument-major, i.e. the values of all functions at one argument are contiguous.
+template <typename ArgType, typename ValType>
+class iAFunctionMatrix
+{
+public:
+	//! Copy the values of the given functions; all of them need to be defined for the same arguments.
+	explicit iAFunctionMatrix(std::vector<iAFunction<ArgType, ValType>*> const& functions);
+	//! Create functionCount functions defined at the given (ascending) arguments, with all values initialized to 0;
+	//! for filling in the values directly from dense data, via argValues.
+	iAFunctionMatrix(std::vector<ArgType> const& args, size_t functionCount);
+	size_t functionCount() const;
+	size_t argCount() const;
+	//! the argIdx-th argument (in ascending order)
+	ArgType arg(size_t argIdx) const;
+	ValType value(size_t funcIdx, size_t argIdx) const;
+	//! @{
+	//! pointer to the functionCount() values of all functions at the argIdx-th argument
+	ValType const* argValues(size_t argIdx) const;
+	ValType* argValues(size_t argIdx);
+	//! @}
+	//! copy of the funcIdx-th function
+	iAFunction<ArgType, ValType> function(size_t funcIdx) const;
+private:
+	size_t m_functionCount;
+	std::vector<ArgType> m_args;
+	std::vector<ValType> m_values;
+};
+
+template <typename ArgType, typename ValType>
+iAFunctionMatrix<ArgType, ValType>::iAFunctionMatrix(std::vector<iAFunction<ArgType, ValType>*> const& functions) :
+	m_functionCount(functions.size())
+{
+	if (functions.empty())
+	{
+		return;
+	}
+	for (auto it = functions[0]->begin(); it != functions[0]->end(); ++it)
+	{
+		m_args.push_back(it->first);
+	}
+	m_values.resize(m_args.size() * m_functionCount);
+	long long funcCount = static_cast<long long>(m_functionCount);
+#pragma omp parallel for
+	for (long long f = 0; f < funcCount; ++f)
+	{
+		assert(functions[f]->size() == m_args.size());
+		size_t a = 0;
+		for (auto it = functions[f]->begin(); it != functions[f]->end(); ++it, ++a)
+		{
+			m_values[a * m_functionCount + f] = it->second;
+		}
+	}
+}
+
+template <typename ArgType, typename ValType>
+iAFunctionMatrix<ArgType, ValType>::iAFunctionMatrix(std::vector<ArgType> const& args, size_t functionCount) :
+	m_functionCount(functionCount),
+	m_args(args),
+	m_values(args.size() * functionCount, ValType())
+{}
+
+template <typename ArgType, typename ValType>
+size_t iAFunctionMatrix<ArgType, ValType>::functionCount() const
+{
+	return m_functionCount;
+}
+
+template <typename ArgType, typename ValType>
+size_t iAFunctionMatrix<ArgType, ValType>::argCount() const
+{
+	return m_args.size();
+}
+
+template <typename ArgType, typename ValType>
+ArgType iAFunctionMatrix<ArgType, ValType>::arg(size_t argIdx) const
+{
+	return m_args[argIdx];
+}
+
+template <typename ArgType, typename ValType>
+ValType iAFunctionMatrix<ArgType, ValType>::value(size_t funcIdx, size_t argIdx) const
+{
+	return m_values[argIdx * m_functionCount + funcIdx];
+}
+
+template <typename ArgType, typename ValType>
+ValType const* iAFunctionMatrix<ArgType, ValType>::argValues(size_t argIdx) const
+{
+	return m_values.data() + argIdx * m_functionCount;
+}
+
+template <typename ArgType, typename ValType>
+ValType* iAFunctionMatrix<ArgType, ValType>::argValues(size_t argIdx)
+{
+	return m_values.data() + argIdx * m_functionCount;
+}
+
+template <typename ArgType, typename ValType>
+iAFunction<ArgType, ValType> iAFunctionMatrix<ArgType, ValType>::function(size_t funcIdx) const
+{
+	iAFunction<ArgType, ValType> result;
+	for (size_t a = 0; a < m_args.size(); ++a)
+	{
+		result.emplace_hint(result.end(), m_args[a], value(funcIdx, a));
+	}
+	return result;
+}
+
 /*
 template <typename ArgType, typename ValType>
 class iAFunction
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -17,6 +18,8 @@ class iAFunctionBand
 public:
 	//! merge the given function so that it also lies inside the band
 	void merge(iAFunction<ArgType, ValType> const & f, size_t functionIdx);
+	//! merge the functions with the given indices in the given matrix so that they also lie inside the band
+	void merge(iAFunctionMatrix<ArgType, ValType> const & matrix, std::vector<size_t> const & functionIndices);
 
 	//! @{ getters/setters
 	ValType getMin(ArgType a) const;
@@ -65,22 +68,37 @@ public:
 	};
 	//! Construction & calculation of functional boxplot data
 	//! @param functions functions for which to calculate band depth
-	//! @param measure the measure to use to compute the depth (see SimpleDepthMeasure and ModifiedDepthMeasure)
+	//! @param measure the measure to use to compute the depth (see SimpleDepthMeasure and ModifiedDepthMeasure);
+	//!    for iAModifiedDepthMeasure, the exact depth over all function pairs is computed (see modifiedBandDepth),
+	//!    for other measures, the depth is computed over a subsample of the function pairs
 	//! @param maxBandSize the maximum band size to consider for band depth calculation (i.e. how
 	//!    many functions at most should be combined to bands). Band depth will be calculated
 	//!    as a combination of all band sizes from 2 to maxBandSize
 	iAFunctionalBoxplot(std::vector<iAFunction<ArgType, ValType> *> & functions,
 		iADepthMeasure<ArgType, ValType>* measure,
 		size_t maxBandSize = 2);
+	//! Construction & calculation of functional boxplot data from functions stored densely, using the exact
+	//! modified band depth (as for iAModifiedDepthMeasure, see modifiedBandDepth). Only the median and outlier
+	//! functions are copied out of the matrix, so it does not need to be kept.
+	//! @param matrix the functions for which to calculate band depth
+	explicit iAFunctionalBoxplot(iAFunctionMatrix<ArgType, ValType> const & matrix);
 	iAFunction<ArgType, ValType> const & getMedian() const;
 	iAFunctionBand<ArgType, ValType> const & getCentralRegion() const;
 	iAFunctionBand<ArgType, ValType> const & getEnvelope() const;
 	std::vector<iAFunction<ArgType, ValType>* > const & getOutliers() const;
 private:
+	//! band depth computed with the given measure over a subsample of all function pairs (each function pair
+	//! containing the function itself contributes the number of functions)
+	void calculateSampledBandDepth(std::vector<iAFunction<ArgType, ValType> *> const & functions,
+		iADepthMeasure<ArgType, ValType>* measure, std::vector<double> & bandDepth);
+	//! pairs of depth and function index, ordered by decreasing depth
+	static std::vector<std::pair<double, size_t>> orderByDepth(std::vector<double> const & bandDepth);
 	iAFunction<ArgType, ValType>* m_median;
 	iAFunctionBand<ArgType, ValType> m_centralRegion;
 	iAFunctionBand<ArgType, ValType> m_envelope;
 	std::vector<iAFunction<ArgType, ValType> *> m_outliers;
+	//! median and outliers, if they were copied out of a function matrix
+	std::vector<std::shared_ptr<iAFunction<ArgType, ValType>>> m_ownedFunctions;
 };
 
 
@@ -112,6 +130,45 @@ void iAFunctionBand<ArgType, ValType>::merge(iAFunction<ArgType, ValType> const
 	m_Functions.insert(funcIdx);
 }
 
+template <typename ArgType, typename ValType>
+void iAFunctionBand<ArgType, ValType>::merge(iAFunctionMatrix<ArgType, ValType> const & matrix,
+	std::vector<size_t> const & funcIndices)
+{
+	if (funcIndices.empty())
+	{
+		return;
+	}
+	// the values of all functions at one argument are contiguous in the matrix, so compute the bounds per argument:
+	std::vector<std::pair<ValType, ValType>> bounds(matrix.argCount());
+	long long const argCount = static_cast<long long>(matrix.argCount());
+#pragma omp parallel for
+	for (long long a = 0; a < argCount; ++a)
+	{
+		ValType const* values = matrix.argValues(a);
+		std::pair<ValType, ValType> b(values[funcIndices[0]], values[funcIndices[0]]);
+		for (size_t f : funcIndices)
+		{
+			b.first = std::min(b.first, values[f]);
+			b.second = std::max(b.second, values[f]);
+		}
+		bounds[a] = b;
+	}
+	for (size_t a = 0; a < matrix.argCount(); ++a)
+	{
+		auto it = m_Bounds.find(matrix.arg(a));
+		if (it == m_Bounds.end())
+		{
+			m_Bounds.insert(std::make_pair(matrix.arg(a), bounds[a]));
+		}
+		else
+		{
+			it->second.first = std::min(it->second.first, bounds[a].first);
+			it->second.second = std::max(it->second.second, bounds[a].second);
+		}
+	}
+	m_Functions.insert(funcIndices.begin(), funcIndices.end());
+}
+
 template <typename ArgType, typename ValType>
 ValType iAFunctionBand<ArgType, ValType>::getMin(ArgType a) const
 {
@@ -249,27 +306,63 @@ public:
 	}
 };
 
+//! Exact modified band depth (band size 2) of all functions in the given matrix, in O(n*m*log(n)) for n functions
+//! and m arguments: For each argument, the number of bands (function pairs, including the ones with the function
+//! itself) containing the value of a function is the number of all pairs, minus the pairs lying completely below,
+//! minus the pairs lying completely above the value; these counts follow from the rank of the value among all
+//! values at that argument. Arguments are processed in parallel.
+//! @return for each function, the fraction of (band, argument) combinations for which it lies inside the band
 template <typename ArgType, typename ValType>
-iAFunctionalBoxplot<ArgType, ValType>::iAFunctionalBoxplot(std::vector<iAFunction<ArgType, ValType> *> & functions,
-	iADepthMeasure<ArgType, ValType>* measure,
-	size_t
-#ifndef NDEBUG // to silence compiler warning about unused parameter
-		maxBandSize
-#endif
-	)
+std::vector<double> modifiedBandDepth(iAFunctionMatrix<ArgType, ValType> const & matrix)
 {
-	assert(maxBandSize <= functions.size());
-	assert(maxBandSize >= 2);
-	assert(functions.size() >= 2);
-
-	double * bandDepth = new double[functions.size()];
-
-	// initialize depth to 0
-	for (size_t i = 0; i < functions.size(); ++i)
+	size_t const n = matrix.functionCount();
+	std::vector<double> depth(n, 0.0);
+	if (n < 2 || matrix.argCount() == 0)
+	{
+		return depth;
+	}
+	auto pairCount = [](double k) { return k * (k - 1) / 2; };
+	double const allPairs = pairCount(static_cast<double>(n));
+	long long const argCount = static_cast<long long>(matrix.argCount());
+#pragma omp parallel
+	{
+		std::vector<double> threadDepth(n, 0.0);
+		std::vector<ValType> sorted(n);
+#pragma omp for schedule(dynamic)
+		for (long long a = 0; a < argCount; ++a)
+		{
+			ValType const* values = matrix.argValues(a);
+			std::copy(values, values + n, sorted.begin());
+			std::sort(sorted.begin(), sorted.end());
+			for (size_t f = 0; f < n; ++f)
+			{
+				auto range = std::equal_range(sorted.begin(), sorted.end(), values[f]);
+				double below = static_cast<double>(range.first - sorted.begin());
+				double above = static_cast<double>(sorted.end() - range.second);
+				// all counts are integers < 2^53, so summing them is exact and independent of the order:
+				threadDepth[f] += allPairs - pairCount(below) - pairCount(above);
+			}
+		}
+#pragma omp critical
+		for (size_t f = 0; f < n; ++f)
+		{
+			depth[f] += threadDepth[f];
+		}
+	}
+	double const normalizeFactor = 1.0 / (allPairs * argCount);
+	for (auto& d : depth)
 	{
-		bandDepth[i] = 0;
+		d *= normalizeFactor;
 	}
+	return depth;
+}
 
+template <typename ArgType, typename ValType>
+void iAFunctionalBoxplot<ArgType, ValType>::calculateSampledBandDepth(
+	std::vector<iAFunction<ArgType, ValType> *> const & functions,
+	iADepthMeasure<ArgType, ValType>* measure,
+	std::vector<double> & bandDepth)
+{
 	// set up sampling:
 
 	// start at minimum counts:
@@ -322,15 +415,32 @@ iAFunctionalBoxplot<ArgType, ValType>::iAFunctionalBoxplot(std::vector<iAFunctio
 		}
 		bandDepth[func_nr] *= normalizeFactor;
 	}
-	std::vector < std::pair<double, size_t> > bandDepthList;
+}
 
-	for (size_t f = 0; f < functions.size(); ++f)
+template <typename ArgType, typename ValType>
+iAFunctionalBoxplot<ArgType, ValType>::iAFunctionalBoxplot(std::vector<iAFunction<ArgType, ValType> *> & functions,
+	iADepthMeasure<ArgType, ValType>* measure,
+	size_t
+#ifndef NDEBUG // to silence compiler warning about unused parameter
+		maxBandSize
+#endif
+	)
+{
+	assert(maxBandSize <= functions.size());
+	assert(maxBandSize >= 2);
+	assert(functions.size() >= 2);
+
+	std::vector<double> bandDepth(functions.size(), 0.0);
+	if (dynamic_cast<iAModifiedDepthMeasure<ArgType, ValType>*>(measure))
+	{	// the modified band depth can be computed exactly and fast from the ranks of the values:
+		bandDepth = modifiedBandDepth(iAFunctionMatrix<ArgType, ValType>(functions));
+	}
+	else
 	{
-		bandDepthList.push_back(std::pair<double, size_t>(bandDepth[f], f));
+		calculateSampledBandDepth(functions, measure, bandDepth);
 	}
-
 	// order function by bd/mbd
-	std::sort(bandDepthList.begin(), bandDepthList.end(), iADepthComparator());
+	auto bandDepthList = orderByDepth(bandDepth);
 
 	m_median = functions[bandDepthList[0].second];
 
@@ -368,7 +478,62 @@ iAFunctionalBoxplot<ArgType, ValType>::iAFunctionalBoxplot(std::vector<iAFunctio
 			m_outliers.push_back(functions[bandDepthList[f].second]);
 		}
 	}
-	delete[] bandDepth;
+}
+
+template <typename ArgType, typename ValType>
+iAFunctionalBoxplot<ArgType, ValType>::iAFunctionalBoxplot(iAFunctionMatrix<ArgType, ValType> const & matrix)
+{
+	assert(matrix.functionCount() >= 2);
+	auto bandDepthList = orderByDepth(modifiedBandDepth(matrix));
+
+	m_ownedFunctions.push_back(std::make_shared<iAFunction<ArgType, ValType>>(matrix.function(bandDepthList[0].second)));
+	m_median = m_ownedFunctions.back().get();
+
+	size_t centralRegionEnd = bandDepthList.size() / 2;
+	std::vector<size_t> central, remaining;
+	for (size_t f = 0; f < bandDepthList.size(); ++f)
+	{
+		(f < centralRegionEnd ? central : remaining).push_back(bandDepthList[f].second);
+	}
+	m_centralRegion.merge(matrix, central);
+	m_envelope = m_centralRegion;
+	m_envelope.merge(matrix, remaining);
+
+	// determine outliers -> everything outside envelope
+	std::vector<char> outside(remaining.size(), 0);
+	for (size_t a = 0; a < matrix.argCount(); ++a)
+	{
+		ValType const* values = matrix.argValues(a);
+		ValType const envMin = m_envelope.getMin(matrix.arg(a));
+		ValType const envMax = m_envelope.getMax(matrix.arg(a));
+		for (size_t r = 0; r < remaining.size(); ++r)
+		{
+			if (values[remaining[r]] < envMin || values[remaining[r]] > envMax)
+			{
+				outside[r] = 1;
+			}
+		}
+	}
+	for (size_t r = 0; r < remaining.size(); ++r)
+	{
+		if (outside[r])
+		{
+			m_ownedFunctions.push_back(std::make_shared<iAFunction<ArgType, ValType>>(matrix.function(remaining[r])));
+			m_outliers.push_back(m_ownedFunctions.back().get());
+		}
+	}
+}
+
+template <typename ArgType, typename ValType>
+std::vector<std::pair<double, size_t>> iAFunctionalBoxplot<ArgType, ValType>::orderByDepth(std::vector<double> const & bandDepth)
+{
+	std::vector<std::pair<double, size_t>> result;
+	for (size_t f = 0; f < bandDepth.size(); ++f)
+	{
+		result.push_back(std::pair<double, size_t>(bandDepth[f], f));
+	}
+	std::sort(result.begin(), result.end(), iADepthComparator());
+	return result;
 }
 
 template <typename ArgType, typename ValType>
@@ -0,0 +1,292 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASMACOF.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace
+{
+	const double Epsilon = 0.000001;
+
+	double configDistance(double const* a, double const* b, int dims, double p)
+	{
+		double sum = 0;
+		if (p == 2.0)
+		{
+			for (int k = 0; k < dims; ++k)
+			{
+				double d = a[k] - b[k];
+				sum += d * d;
+			}
+			return std::sqrt(sum);
+		}
+		for (int k = 0; k < dims; ++k)
+		{
+			sum += std::pow(std::abs(a[k] - b[k]), p);
+		}
+		return std::pow(sum, 1.0 / p);
+	}
+
+	double matrixMean(double const* matrix, size_t n)
+	{
+		long long count = static_cast<long long>(n) * n;
+		double sum = 0;
+#pragma omp parallel for reduction(+ : sum)
+		for (long long i = 0; i < count; ++i)
+		{
+			sum += matrix[i];
+		}
+		return sum / count;
+	}
+
+	bool isSymmetric(double const* matrix, size_t n)
+	{
+		for (size_t r = 0; r < n; ++r)
+		{
+			for (size_t c = r + 1; c < n; ++c)
+			{
+				if (matrix[r * n + c] != matrix[c * n + r])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	//! initial configuration (row-major, n x dims) as specified by the settings, before centering and scaling
+	std::vector<double> initialConfiguration(size_t n, iASMACOFSettings const& s)
+	{
+		if (!s.initialConfiguration.empty())
+		{
+			assert(s.initialConfiguration.size() == n * s.dimensions);
+			return s.initialConfiguration;
+		}
+		std::vector<double> result(n * s.dimensions);
+		std::mt19937 rng;
+		rng.seed(std::random_device{}());
+		std::uniform_real_distribution<double> dist;
+		for (size_t r = 0; r < n; ++r)
+		{
+			for (int c = 0; c < s.dimensions; ++c)
+			{
+				result[r * s.dimensions + c] = s.initRandom ? dist(rng) : static_cast<double>(r + c) / (n + s.dimensions);
+			}
+		}
+		return result;
+	}
+
+	//! move configuration to the center, and scale it according to the given mean dissimilarity
+	void normalizeConfiguration(std::vector<double>& X, int dims, double meanD)
+	{
+		// before this step, mean distance is 1/3*std::sqrt(d)
+		double scale = 0.1 * meanD / (1.0 / 3.0 * std::sqrt(dims));
+		for (auto& v : X)
+		{
+			v = (v - 0.5) * scale;
+		}
+	}
+
+	//! SMACOF iterations, starting from configuration X (row-major, n x dims) which is updated in place.
+	//! @param delta the row-major n x n dissimilarity matrix
+	void smacof(double const* delta, size_t n, std::vector<double>& X, iASMACOFSettings const& s)
+	{
+		int const dims = s.dimensions;
+		// B(r, c) = -delta(r, c) / D(r, c) for r != c, the diagonal entries of B are the negated column sums.
+		// For symmetric dissimilarities, row and column of delta are the same; otherwise, keep a transposed
+		// copy, so that the column can be traversed as contiguously as the row:
+		std::vector<double> deltaTransposed;
+		if (!isSymmetric(delta, n))
+		{
+			deltaTransposed.resize(n * n);
+			for (size_t r = 0; r < n; ++r)
+			{
+				for (size_t c = 0; c < n; ++c)
+				{
+					deltaTransposed[c * n + r] = delta[r * n + c];
+				}
+			}
+		}
+		double const* deltaCols = deltaTransposed.empty() ? delta : deltaTransposed.data();
+		std::vector<double> Z(X);
+		long long const numRows = static_cast<long long>(n);
+		double diffSum = 1;
+		for (int it = 0; it < s.iterations && diffSum > s.maxError; ++it)
+		{
+			diffSum = 0;
+			// X = B*Z/n, with each row of B computed from the distances in the current configuration Z:
+#pragma omp parallel reduction(+ : diffSum)
+			{
+				std::vector<double> acc(dims);
+#pragma omp for schedule(dynamic, 64)
+				for (long long r = 0; r < numRows; ++r)
+				{
+					double const* zr = Z.data() + r * dims;
+					double const* deltaRow = delta + r * n;
+					double const* deltaCol = deltaCols + r * n;
+					std::fill(acc.begin(), acc.end(), 0.0);
+					double diag = 0;
+					for (long long c = 0; c < numRows; ++c)
+					{
+						if (c == r)
+						{
+							continue;
+						}
+						double const* zc = Z.data() + c * dims;
+						double D = configDistance(zr, zc, dims, s.minkowskiP);
+						if (D < Epsilon)
+						{
+							continue;
+						}
+						double b = -deltaRow[c] / D;
+						for (int k = 0; k < dims; ++k)
+						{
+							acc[k] += b * zc[k];
+						}
+						diag += deltaCol[c] / D;
+					}
+					for (int k = 0; k < dims; ++k)
+					{
+						double x = (acc[k] + diag * zr[k]) / n;
+						diffSum += std::abs(zr[k] - x);
+						X[r * dims + k] = x;
+					}
+				}
+			}
+			Z = X;
+		}
+	}
+
+	//! choose landmarks by farthest point sampling: starting with the first element, repeatedly add
+	//! the element with the largest dissimilarity to its closest already chosen landmark
+	std::vector<size_t> selectLandmarks(double const* delta, size_t n, size_t count)
+	{
+		std::vector<size_t> landmarks;
+		landmarks.reserve(count);
+		std::vector<double> minDissim(n, std::numeric_limits<double>::max());
+		long long const numElems = static_cast<long long>(n);
+		size_t next = 0;
+		while (landmarks.size() < count)
+		{
+			landmarks.push_back(next);
+			double const* row = delta + next * n;
+#pragma omp parallel for
+			for (long long i = 0; i < numElems; ++i)
+			{
+				minDissim[i] = std::min(minDissim[i], row[i]);
+			}
+			minDissim[next] = -1;  // never choose a landmark twice
+			next = std::max_element(minDissim.begin(), minDissim.end()) - minDissim.begin();
+		}
+		return landmarks;
+	}
+
+	//! place all non-landmark elements with regard to the fixed landmark configuration Y, by applying
+	//! the SMACOF update to each single element, with all landmarks as the only other elements
+	void placeRelativeToLandmarks(double const* delta, size_t n, std::vector<size_t> const& landmarks,
+		std::vector<double> const& Y, std::vector<double>& X, iASMACOFSettings const& s)
+	{
+		int const dims = s.dimensions;
+		size_t const L = landmarks.size();
+		std::vector<char> isLandmark(n, 0);
+		for (size_t l = 0; l < L; ++l)
+		{
+			isLandmark[landmarks[l]] = 1;
+			std::copy(Y.begin() + l * dims, Y.begin() + (l + 1) * dims, X.begin() + landmarks[l] * dims);
+		}
+		long long const numElems = static_cast<long long>(n);
+#pragma omp parallel
+		{
+			std::vector<double> x(dims), acc(dims);
+#pragma omp for schedule(dynamic, 64)
+			for (long long i = 0; i < numElems; ++i)
+			{
+				if (isLandmark[i])
+				{
+					continue;
+				}
+				double const* deltaRow = delta + i * n;
+				// start at the average of the landmark positions, weighted by inverse dissimilarity:
+				std::fill(x.begin(), x.end(), 0.0);
+				double weightSum = 0;
+				for (size_t l = 0; l < L; ++l)
+				{
+					double w = 1.0 / (deltaRow[landmarks[l]] + Epsilon);
+					for (int k = 0; k < dims; ++k)
+					{
+						x[k] += w * Y[l * dims + k];
+					}
+					weightSum += w;
+				}
+				for (int k = 0; k < dims; ++k)
+				{
+					x[k] /= weightSum;
+				}
+				for (int it = 0; it < s.iterations; ++it)
+				{
+					std::fill(acc.begin(), acc.end(), 0.0);
+					for (size_t l = 0; l < L; ++l)
+					{
+						double const* y = Y.data() + l * dims;
+						double D = configDistance(x.data(), y, dims, s.minkowskiP);
+						double ratio = (D < Epsilon) ? 0.0 : deltaRow[landmarks[l]] / D;
+						for (int k = 0; k < dims; ++k)
+						{
+							acc[k] += y[k] + ratio * (x[k] - y[k]);
+						}
+					}
+					double diff = 0;
+					for (int k = 0; k < dims; ++k)
+					{
+						double newX = acc[k] / L;
+						diff += std::abs(newX - x[k]);
+						x[k] = newX;
+					}
+					if (diff <= s.maxError)
+					{
+						break;
+					}
+				}
+				std::copy(x.begin(), x.end(), X.begin() + i * dims);
+			}
+		}
+	}
+}
+
+std::vector<double> computeSMACOF(std::vector<double> const& dissimilarities, size_t numElems,
+	iASMACOFSettings const& settings)
+{
+	assert(numElems > 2 && dissimilarities.size() == numElems * numElems);
+	int const dims = settings.dimensions;
+	auto X = initialConfiguration(numElems, settings);
+	if (settings.landmarkThreshold == 0 || numElems <= settings.landmarkThreshold ||
+		settings.landmarkCount <= static_cast<size_t>(dims) || settings.landmarkCount >= numElems)
+	{
+		normalizeConfiguration(X, dims, matrixMean(dissimilarities.data(), numElems));
+		smacof(dissimilarities.data(), numElems, X, settings);
+		return X;
+	}
+	// landmark MDS:
+	auto landmarks = selectLandmarks(dissimilarities.data(), numElems, settings.landmarkCount);
+	size_t const L = landmarks.size();
+	std::vector<double> landmarkDissim(L * L);
+	std::vector<double> Y(L * dims);
+	long long const numLandmarks = static_cast<long long>(L);
+#pragma omp parallel for
+	for (long long l1 = 0; l1 < numLandmarks; ++l1)
+	{
+		for (size_t l2 = 0; l2 < L; ++l2)
+		{
+			landmarkDissim[l1 * L + l2] = dissimilarities[landmarks[l1] * numElems + landmarks[l2]];
+		}
+		std::copy(X.begin() + landmarks[l1] * dims, X.begin() + (landmarks[l1] + 1) * dims, Y.begin() + l1 * dims);
+	}
+	normalizeConfiguration(Y, dims, matrixMean(landmarkDissim.data(), L));
+	smacof(landmarkDissim.data(), L, Y, settings);
+	placeRelativeToLandmarks(dissimilarities.data(), numElems, landmarks, Y, X, settings);
+	return X;
+}
@@ -0,0 +1,40 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iAbase_export.h"
+
+#include <cstddef>    // for size_t
+#include <vector>
+
+//! Settings for computeSMACOF.
+struct iAbase_API iASMACOFSettings
+{
+	int dimensions = 2;         //!< number of output dimensions
+	int iterations = 100;       //!< maximum number of iterations
+	double maxError = 0.0;      //!< stop iterating once the summed absolute change of all coordinates is not larger than this
+	bool initRandom = true;     //!< whether to initialize the configuration randomly (only if initialConfiguration is empty)
+	//! initial configuration (row-major, numElems x dimensions); it is centered and scaled to the mean
+	//! dissimilarity before iterating. If empty, a random (see initRandom) or a fixed diagonal layout is used
+	std::vector<double> initialConfiguration;
+	//! order of the Minkowski distance used between points of the configuration (2 = Euclidean distance)
+	double minkowskiP = 2.0;
+	//! use landmark MDS if there are more elements than this: the full SMACOF is only computed for a subset
+	//! of landmarkCount elements (chosen by farthest point sampling), all other elements are placed relative
+	//! to these landmarks afterwards; 0 disables landmark MDS
+	size_t landmarkThreshold = 5000;
+	size_t landmarkCount = 1000; //!< number of landmarks to use (see landmarkThreshold)
+};
+
+//! Multidimensional scaling (MDS) with SMACOF (Scaling by MAjorizing a COmplicated Function).
+//! Re-implements Michael Bronstein's SMACOF in his Matlab Toolbox for Surface Comparison and Analysis
+//! (downloadable at http://tosca.cs.technion.ac.il/), see
+//! [1] A. M. Bronstein, M. M. Bronstein, R. Kimmel,"Numerical geometry of nonrigid shapes", Springer, 2008.
+//! The B matrix of the Guttman transform is never stored; each row of it is computed on the fly from the current
+//! configuration and directly multiplied with it, rows are processed in parallel.
+//! @param dissimilarities the (row-major) numElems x numElems matrix of dissimilarities between all elements
+//! @param numElems the number of elements (at least 3)
+//! @param settings the parameters of the computation, see iASMACOFSettings
+//! @return the configuration of the elements in the output space, row-major (numElems x settings.dimensions)
+iAbase_API std::vector<double> computeSMACOF(std::vector<double> const& dissimilarities, size_t numElems,
+	iASMACOFSettings const& settings);
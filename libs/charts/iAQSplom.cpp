@@ -13,6 +13,7 @@
 #include "iAQGLWidget.h"
 #include "iAScatterPlot.h"
 #include "iASettings.h"    // for mapFromQSettings
+#include "iASPLOMCorrelation.h"
 #include "iASPLOMData.h"
 #include "iASPMSettings.h"
 #include "iAStringHelper.h"
@@ -335,6 +336,18 @@ void iAQSplom::updateHistograms()
 
 void iAQSplom::updateFilter()
 {
+	std::vector<size_t> filtered;
+	if (m_viewData->filterDefined())
+	{
+		for (size_t i = 0; i < m_splomData->numPoints(); ++i)
+		{
+			if (m_viewData->matchesFilter(m_splomData, i))
+			{
+				filtered.push_back(i);
+			}
+		}
+	}
+	m_correlation->setSubset(filtered);
 	for (auto& row : m_visiblePlots)
 	{
 		for (iAScatterPlot* s : row)
@@ -380,6 +393,7 @@ void iAQSplom::setData( QSharedPointer<iASPLOMData> data, std::vector<char> cons
 			.arg(std::numeric_limits<int>::max()));
 	}
 	m_splomData = data;
+	m_correlation = QSharedPointer<iASPLOMCorrelation>::create(m_splomData);
 	dataChanged(visibility);
 }
 
@@ -388,6 +402,11 @@ QSharedPointer<iASPLOMData> iAQSplom::data()
 	return m_splomData;
 }
 
+QSharedPointer<iASPLOMCorrelation> iAQSplom::correlation()
+{
+	return m_correlation;
+}
+
 void iAQSplom::createScatterPlot(size_t y, size_t x, bool initial)
 {
 	if (!m_paramVisibility[y] || !m_paramVisibility[x] || (m_mode == smUpperHalf && x >= y)
@@ -399,6 +418,7 @@ void iAQSplom::createScatterPlot(size_t y, size_t x, bool initial)
 	s->settings.backgroundColor = settings.backgroundColor;
 	connect(s, &iAScatterPlot::transformModified, this, &iAQSplom::transformUpdated);
 	connect(s, &iAScatterPlot::currentPointModified, this, &iAQSplom::currentPointUpdated);
+	s->setCorrelation(m_correlation);
 	s->setData(x, y, m_splomData);
 	s->setSelectionColor(settings.selectionColor);
 	s->setPointRadius(settings.pointRadius);
@@ -873,6 +893,7 @@ void iAQSplom::maximizeSelectedPlot(iAScatterPlot *selectedPlot)
 		plotInds[(settings.flipAxes) ? 1 : 0],
 		plotInds[(settings.flipAxes) ? 0 : 1]
 	};
+	m_maximizedPlot->setCorrelation(m_correlation);
 	m_maximizedPlot->setData(actualPlotInds[0], actualPlotInds[1], m_splomData);
 	m_maximizedPlot->setLookupTable(m_lut, m_colorLookupParam);
 	m_maximizedPlot->setSelectionColor(settings.selectionColor);
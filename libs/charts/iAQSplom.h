@@ -23,6 +23,7 @@ class iAChartWidget;
 class iAColorTheme;
 class iALookupTable;
 class iAScatterPlot;
+class iASPLOMCorrelation;
 class iASPLOMData;
 class iASPMSettings;
 
@@ -106,6 +107,7 @@ public:
 
 	void setData(QSharedPointer<iASPLOMData> data, std::vector<char> const & visibility);                  //! set SPLOM data directly.
 	QSharedPointer<iASPLOMData> data();                              //! retrieve SPLOM data
+	QSharedPointer<iASPLOMCorrelation> correlation();                //! retrieve correlation coefficient cache (e.g. for sorting parameters by correlation)
 	void setLookupTable( vtkLookupTable * lut, const QString & paramName ); //!< Set lookup table from VTK (vtkLookupTable) given the name of a parameter to color-code.
 	void setLookupTable( iALookupTable &lut, size_t paramIndex );    //!< Set lookup table given the index of a parameter to color-code.
 	void setColorParam( const QString & paramName );                 //!< Set the parameter to color code, lookup table will be auto-determined (By Parameter)
@@ -274,6 +276,7 @@ protected:
 	iAScatterPlot * m_activePlot;                //!< scatter plot that user currently interacts with
 	SPMMode m_mode;                              //!< SPLOM current state: all plots or upper triangle with maximized plot (TODO: Move to settings?)
 	QSharedPointer<iASPLOMData> m_splomData;     //!< contains raw data points used in SPLOM
+	QSharedPointer<iASPLOMCorrelation> m_correlation; //!< correlation coefficients between parameters, shared with individual scatter plots
 	iAScatterPlot * m_previewPlot;               //!< plot currently being previewed (shown in maximized plot)
 	iAScatterPlot * m_maximizedPlot;             //!< pointer to the maximized plot
 	QSharedPointer<iAScatterPlotViewData> m_viewData;
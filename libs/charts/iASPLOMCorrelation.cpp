@@ -0,0 +1,180 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASPLOMCorrelation.h"
+
+#include "iAMathUtility.h"
+#include "iASPLOMData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+iASPLOMCorrelation::iASPLOMCorrelation(QSharedPointer<iASPLOMData> data) :
+	m_data(data),
+	m_numParams(0)
+{
+	connect(m_data.data(), &iASPLOMData::dataChanged, this, &iASPLOMCorrelation::invalidate);
+}
+
+void iASPLOMCorrelation::checkSize()
+{
+	if (m_numParams == m_data->numParams())
+	{
+		return;
+	}
+	m_numParams = m_data->numParams();
+	for (int t = 0; t < CorrelationTypeCount; ++t)
+	{
+		m_normed[t].clear();
+		m_normed[t].resize(m_numParams);
+		m_normedValid[t].assign(m_numParams, 0);
+		m_matrix[t].assign(m_numParams * m_numParams, 0.0);
+		m_matrixValid[t].assign(m_numParams * m_numParams, 0);
+	}
+}
+
+void iASPLOMCorrelation::prepareColumn(CorrelationType type, size_t param)
+{
+	auto const& paramData = m_data->paramData(param);
+	FuncType values;
+	if (m_subset.empty())
+	{
+		values = paramData;
+	}
+	else
+	{
+		values.resize(m_subset.size());
+		for (size_t i = 0; i < m_subset.size(); ++i)
+		{
+			values[i] = paramData[m_subset[i]];
+		}
+	}
+	if (type == Spearman)
+	{
+		values = getNormedRanks(values);
+	}
+	double meanVal = mean(values);
+	double sqSum = 0;
+	for (auto& v : values)
+	{
+		v -= meanVal;
+		sqSum += v * v;
+	}
+	// for a constant column, this results in NaN values, just as pearsonsCorrelationCoefficient does:
+	double norm = std::sqrt(sqSum);
+	for (auto& v : values)
+	{
+		v /= norm;
+	}
+	m_normed[type][param] = std::move(values);
+	m_normedValid[type][param] = 1;
+}
+
+double iASPLOMCorrelation::coefficient(CorrelationType type, size_t param1, size_t param2)
+{
+	checkSize();
+	size_t idx = param1 * m_numParams + param2;
+	if (!m_matrixValid[type][idx])
+	{
+		for (size_t p : {param1, param2})
+		{
+			if (!m_normedValid[type][p])
+			{
+				prepareColumn(type, p);
+			}
+		}
+		auto const& col1 = m_normed[type][param1];
+		double coeff = std::inner_product(col1.begin(), col1.end(), m_normed[type][param2].begin(), 0.0);
+		m_matrix[type][idx] = m_matrix[type][param2 * m_numParams + param1] = coeff;
+		m_matrixValid[type][idx] = m_matrixValid[type][param2 * m_numParams + param1] = 1;
+	}
+	return m_matrix[type][idx];
+}
+
+std::vector<double> const& iASPLOMCorrelation::matrix(CorrelationType type)
+{
+	checkSize();
+	int numParams = static_cast<int>(m_numParams);
+#pragma omp parallel for
+	for (int p = 0; p < numParams; ++p)
+	{
+		if (!m_normedValid[type][p])
+		{
+			prepareColumn(type, p);
+		}
+	}
+	// only compute upper triangle (including diagonal), the matrix is symmetric:
+	long long numPairs = static_cast<long long>(m_numParams) * m_numParams;
+#pragma omp parallel for schedule(dynamic, 16)
+	for (long long i = 0; i < numPairs; ++i)
+	{
+		size_t p1 = static_cast<size_t>(i) / m_numParams, p2 = static_cast<size_t>(i) % m_numParams;
+		if (p2 < p1 || m_matrixValid[type][i])
+		{
+			continue;
+		}
+		auto const& col1 = m_normed[type][p1];
+		double coeff = std::inner_product(col1.begin(), col1.end(), m_normed[type][p2].begin(), 0.0);
+		m_matrix[type][i] = m_matrix[type][p2 * m_numParams + p1] = coeff;
+		m_matrixValid[type][i] = m_matrixValid[type][p2 * m_numParams + p1] = 1;
+	}
+	return m_matrix[type];
+}
+
+std::vector<size_t> iASPLOMCorrelation::paramsSortedByCorrelation(CorrelationType type, size_t refParam)
+{
+	auto const& m = matrix(type);
+	std::vector<size_t> result(m_numParams);
+	std::iota(result.begin(), result.end(), 0);
+	auto const* row = m.data() + refParam * m_numParams;
+	std::stable_sort(result.begin(), result.end(), [row, refParam](size_t a, size_t b)
+	{
+		if (a == refParam || b == refParam)
+		{
+			return a == refParam && b != refParam;
+		}
+		// NaN values (constant columns) go to the end:
+		double absA = std::isnan(row[a]) ? -1 : std::abs(row[a]);
+		double absB = std::isnan(row[b]) ? -1 : std::abs(row[b]);
+		return absA > absB;
+	});
+	return result;
+}
+
+void iASPLOMCorrelation::setSubset(std::vector<size_t> const& pointIndices)
+{
+	if (pointIndices == m_subset)
+	{
+		return;
+	}
+	m_subset = pointIndices;
+	invalidateAll();
+}
+
+std::vector<size_t> const& iASPLOMCorrelation::subset() const
+{
+	return m_subset;
+}
+
+void iASPLOMCorrelation::invalidateAll()
+{
+	m_numParams = 0;    // forces re-initialization in checkSize
+}
+
+void iASPLOMCorrelation::invalidate(size_t paramIndex)
+{
+	if (paramIndex >= m_numParams || m_numParams != m_data->numParams())
+	{
+		invalidateAll();
+		return;
+	}
+	for (int t = 0; t < CorrelationTypeCount; ++t)
+	{
+		m_normedValid[t][paramIndex] = 0;
+		for (size_t p = 0; p < m_numParams; ++p)
+		{
+			m_matrixValid[t][paramIndex * m_numParams + p] = 0;
+			m_matrixValid[t][p * m_numParams + paramIndex] = 0;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "iAcharts_export.h"
+
+#include <QObject>
+#include <QSharedPointer>
+
+#include <cstddef>    // for size_t
+#include <vector>
+
+class iASPLOMData;
+
+//! Computes and caches the correlation coefficients between all pairs of parameters of a SPLOM data set.
+//! Shared between all scatter plots of a scatter plot matrix, so that each column is normalized
+//! (and, for Spearman's coefficient, ranked) only once, instead of once per plot it appears in.
+//! Single coefficients are computed on demand; the full matrix (computed in parallel) can be retrieved
+//! via matrix(). Changes to a parameter's data (see iASPLOMData::dataChanged) only invalidate the
+//! coefficients involving that parameter. Computation can be restricted to a subset of the data points
+//! (e.g. the currently selected or filtered ones) via setSubset.
+class iAcharts_API iASPLOMCorrelation : public QObject
+{
+	Q_OBJECT
+public:
+	enum CorrelationType
+	{
+		Pearson,         //!< Pearson's correlation coefficient (PCC)
+		Spearman,        //!< Spearman's (rank) correlation coefficient (SCC)
+		CorrelationTypeCount
+	};
+	//! Create a correlation cache for the given SPLOM data.
+	iASPLOMCorrelation(QSharedPointer<iASPLOMData> data);
+	//! Correlation coefficient of the given type between two parameters; computed and cached if not yet available.
+	double coefficient(CorrelationType type, size_t param1, size_t param2);
+	//! Full (numParams x numParams, row-major) matrix of correlation coefficients of the given type;
+	//! all coefficients not yet available are computed in parallel.
+	std::vector<double> const& matrix(CorrelationType type);
+	//! Indices of all parameters, sorted descending by the absolute value of their correlation with the given parameter.
+	//! The reference parameter itself is always first.
+	std::vector<size_t> paramsSortedByCorrelation(CorrelationType type, size_t refParam);
+	//! Restrict computation to the given data point indices (e.g. current selection, or points matching a filter).
+	//! Pass an empty list to use all data points again. Invalidates all cached coefficients.
+	void setSubset(std::vector<size_t> const& pointIndices);
+	//! The data point indices to which the computation is currently restricted; empty if all points are used.
+	std::vector<size_t> const& subset() const;
+	//! Invalidate all cached values; call e.g. if the number of parameters or points has changed.
+	void invalidateAll();
+public slots:
+	//! Invalidate all cached values involving the given parameter.
+	void invalidate(size_t paramIndex);
+
+private:
+	//! make sure that the internal data structures match the number of parameters in the data
+	void checkSize();
+	//! compute normalized (centered, unit-length) vector for given parameter (ranks for Spearman)
+	void prepareColumn(CorrelationType type, size_t param);
+
+	QSharedPointer<iASPLOMData> m_data;
+	std::vector<size_t> m_subset;                              //!< subset of points to use (all if empty)
+	size_t m_numParams;                                        //!< number of parameters the cache data structures were set up for
+	//! per type and parameter, the centered values (or ranks for Spearman), scaled to unit length;
+	//! with that, the correlation coefficient of two parameters is the dot product of their normalized columns
+	std::vector<std::vector<double>> m_normed[CorrelationTypeCount];
+	std::vector<char> m_normedValid[CorrelationTypeCount];     //!< per type and parameter, whether m_normed is up to date
+	std::vector<double> m_matrix[CorrelationTypeCount];        //!< per type, cached coefficient matrix
+	std::vector<char> m_matrixValid[CorrelationTypeCount];     //!< per type, whether the entry in m_matrix is up to date
+};
@@ -7,6 +7,7 @@
 #include "iALookupTable.h"
 #include "iAMathUtility.h"
 #include "iAScatterPlotViewData.h"
+#include "iASPLOMCorrelation.h"
 #include "iASPLOMData.h"
 
 #include <QApplication>
@@ -70,11 +71,7 @@ iAScatterPlot::iAScatterPlot(iAScatterPlotViewData* viewData, iAChartParentWidge
 	m_isMaximizedPlot( isMaximizedPlot ),
 	m_isPreviewPlot( false ),
 	m_curVisiblePts ( 0 ),
-	m_dragging(false),
-	m_pcc(0),
-	m_scc(0),
-	m_pccValid(false),
-	m_sccValid(false)
+	m_dragging(false)
 {
 	m_paramIndices[0] = 0; m_paramIndices[1] = 1;
 	initGrid();
@@ -101,6 +98,10 @@ void iAScatterPlot::setData(size_t x, size_t y, QSharedPointer<iASPLOMData>& spl
 	}
 
 	m_splomData = splomData;
+	if (!m_correlation)
+	{
+		m_correlation = QSharedPointer<iASPLOMCorrelation>::create(m_splomData);
+	}
 	connect(m_splomData.data(), &iASPLOMData::dataChanged, this, &iAScatterPlot::dataChanged);
 	if (!hasData())
 	{
@@ -112,8 +113,6 @@ void iAScatterPlot::setData(size_t x, size_t y, QSharedPointer<iASPLOMData>& spl
 void iAScatterPlot::setIndices(size_t x, size_t y)
 {
 	m_paramIndices[0] = x; m_paramIndices[1] = y;
-	m_pccValid = false;
-	m_sccValid = false;
 	applyMarginToRanges();
 	updateGrid();
 	updatePoints();
@@ -1338,24 +1337,19 @@ void iAScatterPlot::setPointRadius(double radius)
 	settings.pointRadius = radius;
 }
 
+void iAScatterPlot::setCorrelation(QSharedPointer<iASPLOMCorrelation> correlation)
+{
+	m_correlation = correlation;
+}
+
 double iAScatterPlot::scc()
 {
-	if (!m_sccValid)
-	{
-		m_scc = spearmansCorrelationCoefficient(m_splomData->paramData(m_paramIndices[0]), m_splomData->paramData(m_paramIndices[1]));
-		m_sccValid = true;
-	}
-	return m_scc;
+	return m_correlation->coefficient(iASPLOMCorrelation::Spearman, m_paramIndices[0], m_paramIndices[1]);
 }
 
 double iAScatterPlot::pcc()
 {
-	if (!m_pccValid)
-	{
-		m_pcc = pearsonsCorrelationCoefficient(m_splomData->paramData(m_paramIndices[0]), m_splomData->paramData(m_paramIndices[1]));
-		m_pccValid = true;
-	}
-	return m_pcc;
+	return m_correlation->coefficient(iASPLOMCorrelation::Pearson, m_paramIndices[0], m_paramIndices[1]);
 }
 
 QColor iAScatterPlot::highlightColorPoint(size_t i, size_t idx)
@@ -21,6 +21,7 @@ using iAChartParentWidget = QWidget;
 class iAColorTheme;
 class iALookupTable;
 class iAScatterPlotViewData;
+class iASPLOMCorrelation;
 class iASPLOMData;
 
 class QTimer;
@@ -57,6 +58,9 @@ public:
 
 	void setData(size_t x, size_t y, QSharedPointer<iASPLOMData> &splomData ); //!< Set data to the scatter plot using indices of X and Y parameters and the raw SPLOM data
 	void setIndices(size_t x, size_t y);                             //!< Set the indices of the parameters to view
+	//! Set the correlation cache to use (shared between all plots of a SPLOM); call before setData.
+	//! If none is set, the plot creates its own when data is set.
+	void setCorrelation(QSharedPointer<iASPLOMCorrelation> correlation);
 	bool hasData() const;                                            //!< Check if data is already set to the plot
 	//! Set color lookup table and the name of a color-coded parameter
 	void setLookupTable( QSharedPointer<iALookupTable> &lut, size_t colInd );
@@ -230,8 +234,7 @@ private:
 	double scc();
 	double pcc();
 	QColor highlightColorPoint(size_t i, size_t idx);
-	double m_pcc, m_scc;                                             //!< correlation coefficients between the two given data columns
-	bool m_pccValid, m_sccValid;                                     //!< indicates whether current cached values cor correlation coefficients can be used
+	QSharedPointer<iASPLOMCorrelation> m_correlation;                //!< cache for correlation coefficients between the data columns
 	bool m_useFixedYAxis = false;                                    //!< whether y axis uses a custom range or should be set automatically from data ranges
 	
 };
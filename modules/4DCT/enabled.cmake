@@ -0,0 +1,29 @@
+if (openiA_TESTING_ENABLED)
+	get_filename_component(CoreSrcDir "../libs/base" REALPATH BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
+	add_executable(FiberNeighborIndexTest 4DCT/iAFiberNeighborIndexTest.cpp 4DCT/iAFiberNeighborIndex.cpp)
+	target_link_libraries(FiberNeighborIndexTest PRIVATE Qt${QT_VERSION_MAJOR}::Core)   # for QString, required by iAVec3
+	target_include_directories(FiberNeighborIndexTest PRIVATE ${CoreSrcDir})
+	target_compile_definitions(FiberNeighborIndexTest PRIVATE NO_DLL_LINKAGE)
+	add_executable(CalculateDensityMapTest 4DCT/iACalculateDensityMapTest.cpp)
+	target_link_libraries(CalculateDensityMapTest PRIVATE Qt${QT_VERSION_MAJOR}::Core)   # for Q_UNUSED
+	set(VTK_REQUIRED_LIBS
+		CommonCore        # for vtkSmartPointer
+		CommonDataModel   # for vtkImageData
+	)
+	ADD_VTK_LIBRARIES(CalculateDensityMapTest "PRIVATE" "${VTK_REQUIRED_LIBS}")
+	target_include_directories(CalculateDensityMapTest PRIVATE ${CoreSrcDir})
+	target_compile_definitions(CalculateDensityMapTest PRIVATE NO_DLL_LINKAGE)
+	add_test(NAME FiberNeighborIndexTest COMMAND FiberNeighborIndexTest)
+	add_test(NAME CalculateDensityMapTest COMMAND CalculateDensityMapTest)
+	if (MSVC)
+		string(REGEX REPLACE "/" "\\\\" QT_WIN_DLL_DIR ${QT_LIB_DIR})
+		set_tests_properties(FiberNeighborIndexTest PROPERTIES ENVIRONMENT "PATH=${QT_WIN_DLL_DIR};$ENV{PATH}")
+		set_target_properties(FiberNeighborIndexTest PROPERTIES VS_DEBUGGER_ENVIRONMENT "PATH=${QT_WIN_DLL_DIR};$ENV{PATH}")
+		set_tests_properties(CalculateDensityMapTest PROPERTIES ENVIRONMENT "PATH=${TestEnvPath}")
+		set_target_properties(CalculateDensityMapTest PROPERTIES VS_DEBUGGER_ENVIRONMENT "PATH=${WinDLLPaths};$ENV{PATH}")
+	endif()
+	if (openiA_USE_IDE_FOLDERS)
+		set_property(TARGET FiberNeighborIndexTest PROPERTY FOLDER "Tests")
+		set_property(TARGET CalculateDensityMapTest PROPERTY FOLDER "Tests")
+	endif()
+endif()
@@ -3,22 +3,75 @@
 #pragma once
 
 // std
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
+// Qt
+#include <QtGlobal>    // for Q_UNUSED
 // vtk
 #include <vtkImageData.h>
 
+//! Computes density maps, i.e. the number of foreground (> 0) voxels of a mask in each cell of a regular grid.
+//! Density maps are stored contiguously, x fastest: the cell (x, y, z) is at (z * gridSize[1] + y) * gridSize[0] + x.
 template<class TPrecision, class TScalar>
 class CalculateDensityMap
 {
 public:
-	static std::vector<std::vector<std::vector<TPrecision>>>
-		Calculate(vtkImageData* mask, int* gridSize, double* cellSize);
+	//! Computes the density map of a single mask; the mask is traversed in memory order, slabs of slices in parallel.
+	//! @param mask the mask image, its scalar type has to be TScalar
+	//! @param gridSize the number of grid cells along each axis
+	//! @param cellSize receives the size of a grid cell (in voxels) along each axis
+	static std::vector<TPrecision> Calculate(vtkImageData* mask, int const* gridSize, double* cellSize);
+	//! Computes the density maps of a series of masks (e.g. the same mask in all stages of a 4DCT series),
+	//! processing the masks concurrently.
+	//! @param masks the mask images, their scalar type has to be TScalar
+	//! @param gridSize the number of grid cells along each axis
+	//! @return the density map of each mask
+	static std::vector<std::vector<TPrecision>> Calculate(std::vector<vtkImageData*> const& masks, int const* gridSize);
+
+private:
+	//! the grid cell of each coordinate along one axis
+	static std::vector<int> cellIndices(int size, int gridSize, double cellSize);
+	static std::vector<TPrecision> calculate(vtkImageData* mask, int const* gridSize, double* cellSize, bool parallel);
 };
 
 template<class TPrecision, class TScalar>
-std::vector<std::vector<std::vector<TPrecision>>> CalculateDensityMap<TPrecision, TScalar>::Calculate(vtkImageData* mask, int* gridSize, double* cellSize)
+std::vector<TPrecision> CalculateDensityMap<TPrecision, TScalar>::Calculate(vtkImageData* mask, int const* gridSize, double* cellSize)
+{
+	return calculate(mask, gridSize, cellSize, true);
+}
+
+template<class TPrecision, class TScalar>
+std::vector<std::vector<TPrecision>> CalculateDensityMap<TPrecision, TScalar>::Calculate(
+	std::vector<vtkImageData*> const& masks, int const* gridSize)
+{
+	std::vector<std::vector<TPrecision>> result(masks.size());
+	int maskCount = static_cast<int>(masks.size());
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int m = 0; m < maskCount; ++m)
+	{
+		double cellSize[3];
+		result[m] = calculate(masks[m], gridSize, cellSize, false);
+	}
+	return result;
+}
+
+template<class TPrecision, class TScalar>
+std::vector<int> CalculateDensityMap<TPrecision, TScalar>::cellIndices(int size, int gridSize, double cellSize)
+{
+	std::vector<int> result(size);
+	for (int i = 0; i < size; ++i)
+	{
+		result[i] = std::min(static_cast<int>((double)i / cellSize), gridSize - 1);
+	}
+	return result;
+}
+
+template<class TPrecision, class TScalar>
+std::vector<TPrecision> CalculateDensityMap<TPrecision, TScalar>::calculate(vtkImageData* mask, int const* gridSize, double* cellSize,
+	bool parallel)
 {
-	//TScalar* buffer = (TScalar*)mask->GetScalarPointer();
 	int extent[6];
 	mask->GetExtent(extent);
 	int size[3];
@@ -26,95 +79,50 @@ std::vector<std::vector<std::vector<TPrecision>>> CalculateDensityMap<TPrecision
 	size[1] = extent[3] - extent[2] + 1;
 	size[2] = extent[5] - extent[4] + 1;
 
-	std::vector<std::vector<std::vector<TPrecision>>> density;
-	for (int i = 0; i < gridSize[0]; i++)
-	{
-		std::vector<std::vector<TPrecision>> subVec;
-		for (int j = 0; j < gridSize[1]; j++)
-		{
-			std::vector<TPrecision> subSubVec;
-			for (int k = 0; k < gridSize[2]; k++)
-			{
-				subSubVec.push_back(0);
-			}
-			subVec.push_back(subSubVec);
-		}
-		density.push_back(subVec);
-	}
-
-	//double cellSize[3];
 	cellSize[0] = (double)size[0] / gridSize[0];
 	cellSize[1] = (double)size[1] / gridSize[1];
 	cellSize[2] = (double)size[2] / gridSize[2];
 
-	for (int x = 0; x < size[0]; x++)
+	// the cell divisions are done once per coordinate instead of once per voxel:
+	std::vector<int> cellX = cellIndices(size[0], gridSize[0], cellSize[0]);
+	std::vector<int> cellY = cellIndices(size[1], gridSize[1], cellSize[1]);
+	std::vector<int> cellZ = cellIndices(size[2], gridSize[2], cellSize[2]);
+
+	size_t const cellCount = static_cast<size_t>(gridSize[0]) * gridSize[1] * gridSize[2];
+	std::vector<uint64_t> counts(cellCount, 0);
+	TScalar const* buffer = static_cast<TScalar const*>(mask->GetScalarPointer());
+	size_t const components = mask->GetNumberOfScalarComponents();
+	size_t const sliceSize = static_cast<size_t>(size[0]) * size[1];
+	Q_UNUSED(parallel);  // only used with OpenMP
+#pragma omp parallel if (parallel)
 	{
-		for (int y = 0; y < size[1]; y++)
+		std::vector<uint64_t> threadCounts(cellCount, 0);
+#pragma omp for schedule(dynamic, 1)
+		for (int z = 0; z < size[2]; ++z)
 		{
-			for (int z = 0; z < size[2]; z++)
+			for (int y = 0; y < size[1]; ++y)
 			{
-				TScalar* val = (TScalar*)mask->GetScalarPointer(x, y, z);
-				if (val[0] > 0)
+				TScalar const* row = buffer + (z * sliceSize + static_cast<size_t>(y) * size[0]) * components;
+				uint64_t* cellRow = threadCounts.data() + (static_cast<size_t>(cellZ[z]) * gridSize[1] + cellY[y]) * gridSize[0];
+				for (int x = 0; x < size[0]; ++x)
 				{
-					int gridX = (double)x / cellSize[0];
-					int gridY = (double)y / cellSize[1];
-					int gridZ = (double)z / cellSize[2];
-
-					density[gridX][gridY][gridZ] += 1;
+					if (row[x * components] > 0)
+					{
+						++cellRow[cellX[x]];
+					}
 				}
 			}
 		}
-	}
-
-	return density;
-
-	/*TScalar* buffer = (TScalar*)mask->GetScalarPointer();
-	int extent[6];
-	mask->GetExtent(extent);
-	int size[3];
-	size[0] = extent[1] - extent[0];
-	size[1] = extent[3] - extent[2];
-	size[2] = extent[5] - extent[4];
-
-	int densitySize[3];
-	densitySize[0] = (int)(size[0] / gridSize) + 1;
-	densitySize[1] = (int)(size[1] / gridSize) + 1;
-	densitySize[2] = (int)(size[2] / gridSize) + 1;
-
-	std::vector<std::vector<std::vector<TPrecision>>> density;
-	for (int i = 0; i < densitySize[0]; i++)
-	{
-		std::vector<std::vector<TPrecision>> subVec;
-		for (int j = 0; j < densitySize[1]; j++)
+#pragma omp critical
+		for (size_t c = 0; c < cellCount; ++c)
 		{
-			std::vector<TPrecision> subSubVec;
-			for (int k = 0; k < densitySize[2]; k++)
-			{
-				subSubVec.push_back(0);
-			}
-			subVec.push_back(subSubVec);
+			counts[c] += threadCounts[c];
 		}
-		density.push_back(subVec);
 	}
-
-	for (int x = 0; x < size[0]; x++)
+	std::vector<TPrecision> density(cellCount);
+	for (size_t c = 0; c < cellCount; ++c)
 	{
-		for (int y = 0; y < size[1]; y++)
-		{
-			for (int z = 0; z < size[2]; z++)
-			{
-				TScalar* val = (TScalar*)mask->GetScalarPointer(x, y, z);
-				if (val[0] > 0)
-				{
-					int gridX = x / gridSize;
-					int gridY = y / gridSize;
-					int gridZ = z / gridSize;
-
-					density[gridX][gridY][gridZ] += 1;
-				}
-			}
-		}
+		density[c] = static_cast<TPrecision>(counts[c]);
 	}
-
-	return density;*/
+	return density;
 }
@@ -0,0 +1,105 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "iACalculateDensityMap.h"
+
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	//! random mask with the given dimensions; the first component of roughly every third voxel is foreground
+	vtkSmartPointer<vtkImageData> createMask(int const* dim, int components, unsigned int seed)
+	{
+		auto mask = vtkSmartPointer<vtkImageData>::New();
+		mask->SetDimensions(dim[0], dim[1], dim[2]);
+		mask->AllocateScalars(VTK_UNSIGNED_SHORT, components);
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<int> value(0, 2);
+		for (int z = 0; z < dim[2]; ++z)
+		{
+			for (int y = 0; y < dim[1]; ++y)
+			{
+				for (int x = 0; x < dim[0]; ++x)
+				{
+					auto voxel = static_cast<unsigned short*>(mask->GetScalarPointer(x, y, z));
+					for (int c = 0; c < components; ++c)
+					{
+						// other components are set where the first one is background, to check that they are ignored:
+						voxel[c] = static_cast<unsigned short>((c == 0) ? (value(rng) == 0 ? 1 : 0) : 1);
+					}
+				}
+			}
+		}
+		return mask;
+	}
+
+	//! reference as computed before the per-axis cell lookup: one cell computation per voxel
+	std::vector<double> referenceDensity(vtkImageData* mask, int const* gridSize)
+	{
+		int extent[6];
+		mask->GetExtent(extent);
+		int size[3] = {extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1};
+		double cellSize[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			cellSize[i] = (double)size[i] / gridSize[i];
+		}
+		std::vector<double> result(static_cast<size_t>(gridSize[0]) * gridSize[1] * gridSize[2], 0.0);
+		for (int z = 0; z < size[2]; ++z)
+		{
+			for (int y = 0; y < size[1]; ++y)
+			{
+				for (int x = 0; x < size[0]; ++x)
+				{
+					if (*static_cast<unsigned short*>(mask->GetScalarPointer(x, y, z)) > 0)
+					{
+						int cx = std::min(static_cast<int>(x / cellSize[0]), gridSize[0] - 1);
+						int cy = std::min(static_cast<int>(y / cellSize[1]), gridSize[1] - 1);
+						int cz = std::min(static_cast<int>(z / cellSize[2]), gridSize[2] - 1);
+						result[(static_cast<size_t>(cz) * gridSize[1] + cy) * gridSize[0] + cx] += 1;
+					}
+				}
+			}
+		}
+		return result;
+	}
+}
+
+BEGIN_TEST
+	// sizes not divisible by the grid size, and grids finer than the mask along one axis:
+	int const gridSize[3] = {7, 5, 4};
+	int const dims[][3] = {{30, 20, 10}, {23, 17, 3}, {7, 5, 4}, {64, 1, 9}};
+	std::vector<vtkSmartPointer<vtkImageData>> masks;
+	unsigned int seed = 1;
+	for (auto dim : dims)
+	{
+		for (int components : {1, 3})
+		{
+			masks.push_back(createMask(dim, components, seed++));
+		}
+	}
+	std::vector<vtkImageData*> maskPtrs;
+	for (auto& mask : masks)
+	{
+		double cellSize[3];
+		auto density = CalculateDensityMap<double, unsigned short>::Calculate(mask.GetPointer(), gridSize, cellSize);
+		int extent[6];
+		mask->GetExtent(extent);
+		TestEqualFloatingPoint(cellSize[0], (extent[1] - extent[0] + 1) / 7.0);
+		TestAssert(density == referenceDensity(mask.GetPointer(), gridSize));
+		maskPtrs.push_back(mask.GetPointer());
+	}
+	// the batch of masks (e.g. one mask in all stages) yields the same maps as the masks one by one:
+	auto densities = CalculateDensityMap<double, unsigned short>::Calculate(maskPtrs, gridSize);
+	TestEqual(densities.size(), maskPtrs.size());
+	for (size_t m = 0; m < maskPtrs.size(); ++m)
+	{
+		TestAssert(densities[m] == referenceDensity(maskPtrs[m], gridSize));
+	}
+	auto noDensities = CalculateDensityMap<double, unsigned short>::Calculate(std::vector<vtkImageData*>(), gridSize);
+	TestAssert(noDensities.empty());
+END_TEST
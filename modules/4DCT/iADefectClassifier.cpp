@@ -4,15 +4,17 @@
 
 #include "iAFeature.h"
 #include "iAFiberCharacteristics.h"
+#include "iAFiberNeighborIndex.h"
 #include "iA4DCTDefects.h"
 
 #include <iAFileUtils.h>
 
 #include <vtkMath.h>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <map>
-#include <chrono>
 
 iADefectClassifier::iADefectClassifier( )
 {
@@ -60,103 +62,137 @@ void iADefectClassifier::classify( FibersData* fibers, FeatureList* defects )
 {
 	std::cout << "Classifying defects 0%... ";
 
-	std::chrono::time_point<std::chrono::system_clock> currentTime = std::chrono::system_clock::now( );
-	unsigned int currIter = 0;
-
-	for( auto def : *defects )
+	// index the fiber end points once; both neighborhoods of a defect are then found in a single query
+	std::vector<iAVec3d> fiberEndPoints;
+	fiberEndPoints.reserve( 2 * fibers->size( ) );
+	for( auto const & fib : *fibers )
 	{
-		// progress reporting
-		++currIter;
-		std::chrono::duration<double> elapsed = std::chrono::system_clock::now( ) - currentTime;
-		if( elapsed.count() > 10. )
-		{
-			std::cout << ( 100. / defects->size( ) ) * currIter << "%... ";
-			currentTime = std::chrono::system_clock::now( );
-		}
-
-		ExtendedDefectInfo defInfo = calcExtendedDefectInfo( def );
-		FibersData neighborFibersP = findNeighboringFibers( *fibers, defInfo, m_param.NeighborhoodDistP );
-		FibersData neighborFibersFF = findNeighboringFibers( *fibers, defInfo, m_param.NeighborhoodDistFF );
-
-		enum DefectNames { Fracture, Pulloout, Debonding, Breakage };
-		DefectNames looksLike = DefectNames::Fracture;
-
-		// pull-outs
-		if( def.volume > m_param.BigVolumeThreshold )
-		{
-			if( defInfo.Elongation > m_param.ElongationP
-				&& def.obbSize[1] > m_param.LengthRangeP[0]
-				&& def.obbSize[1] < m_param.LengthRangeP[1]
-				&& def.obbSize[2] > m_param.WidthRangeP[0]
-				&& def.obbSize[2] < m_param.WidthRangeP[1]
-				&& defInfo.Angle < m_param.AngleP * vtkMath::Pi() / 180
-				&& neighborFibersP.size( ) >= 1 )
-			{
-				looksLike = DefectNames::Pulloout;
-			}
-		}
-		else
-		{
-			if( neighborFibersP.size( ) >= 1 )
-			{
-				looksLike = DefectNames::Pulloout;
-			}
-		}
-
-		// debondings
-		if( defInfo.Elongation > m_param.ElongationD
-			&& defInfo.Angle > m_param.AngleD * vtkMath::Pi() / 180 )
-		{
-			looksLike = DefectNames::Debonding;
-		}
+		fiberEndPoints.push_back( iAVec3d( fib.startPoint ) );
+		fiberEndPoints.push_back( iAVec3d( fib.endPoint ) );
+	}
+	const double distances[2] = { m_param.NeighborhoodDistP, m_param.NeighborhoodDistFF };
+	iAFiberNeighborIndex fiberIndex( fiberEndPoints, std::max( distances[0], distances[1] ) );
 
-		// breakages
-		if( looksLike == DefectNames::Pulloout
-			&& neighborFibersFF.size( ) >= 2 )
+	std::chrono::time_point<std::chrono::system_clock> currentTime = std::chrono::system_clock::now( );
+	const long long defectCount = static_cast<long long>( defects->size( ) );
+	std::vector<DefectNames> looksLike( defects->size( ) );
+#pragma omp parallel
+	{
+		iAFiberNeighborIndex::Scratch scratch;
+		std::vector<size_t> neighborFibers[2];
+#pragma omp for schedule(dynamic, 64)
+		for( long long d = 0; d < defectCount; ++d )
 		{
-			double minAngle = 2 * vtkMath::Pi(); // maximum possible angle
-			for (size_t i = 0; i < neighborFibersFF.size( ); ++i)
+			// progress reporting
+			if( d % 1024 == 0 )
 			{
-				for (size_t j = i + 1; j < neighborFibersFF.size( ); ++j)
+#pragma omp critical
 				{
-					double max[2], min[2];
-					max[0] = std::max( neighborFibersFF[i].startPoint[2], neighborFibersFF[i].endPoint[2] );
-					max[1] = std::max( neighborFibersFF[j].startPoint[2], neighborFibersFF[j].endPoint[2] );
-					min[0] = std::min( neighborFibersFF[i].startPoint[2], neighborFibersFF[i].endPoint[2] );
-					min[1] = std::min( neighborFibersFF[j].startPoint[2], neighborFibersFF[j].endPoint[2] );
-					if( min[0] < max[1] && min[1] < max[0] ) continue;	// fibers are overlapped
-
-					iAVec3d dir[2];
-					dir[0] = iAVec3d( neighborFibersFF[i].endPoint ) - iAVec3d( neighborFibersFF[i].startPoint );
-					dir[1] = iAVec3d( neighborFibersFF[j].endPoint ) - iAVec3d( neighborFibersFF[j].startPoint );
-					double angle = angleBetween( dir[0], dir[1] );
-					angle = angle > (vtkMath::Pi()/2) ? vtkMath::Pi() - angle : angle;
-					if( minAngle > angle ) minAngle = angle;
+					std::chrono::duration<double> elapsed = std::chrono::system_clock::now( ) - currentTime;
+					if( elapsed.count( ) > 10. )
+					{
+						std::cout << ( 100. / defectCount ) * d << "%... ";
+						currentTime = std::chrono::system_clock::now( );
+					}
 				}
 			}
 
-			if( minAngle < m_param.AngleB * vtkMath::Pi() / 180 ) looksLike = DefectNames::Breakage;
+			iAFeature const & def = ( *defects )[d];
+			ExtendedDefectInfo defInfo = calcExtendedDefectInfo( def );
+			fiberIndex.neighbors( defInfo.Endpoints, 2, distances, 2, neighborFibers, scratch );
+			looksLike[d] = classifyDefect( def, defInfo, *fibers, neighborFibers[0], neighborFibers[1] );
 		}
+	}
 
-		switch( looksLike )
+	// collect the ids in the order of the defects, independent of the thread scheduling
+	for( size_t d = 0; d < defects->size( ); ++d )
+	{
+		unsigned long id = ( *defects )[d].id;
+		switch( looksLike[d] )
 		{
 		case DefectNames::Fracture:
-			m_classification.Fractures.push_back( def.id );
+			m_classification.Fractures.push_back( id );
 			break;
 		case DefectNames::Pulloout:
-			m_classification.Pullouts.push_back( def.id );
+			m_classification.Pullouts.push_back( id );
 			break;
 		case DefectNames::Debonding:
-			m_classification.Debondings.push_back( def.id );
+			m_classification.Debondings.push_back( id );
 			break;
 		case DefectNames::Breakage:
-			m_classification.Breakages.push_back( def.id );
+			m_classification.Breakages.push_back( id );
 			break;
 		}
 	}
 	std::cout << "100%\n";
 }
 
+iADefectClassifier::DefectNames iADefectClassifier::classifyDefect( iAFeature const & def, ExtendedDefectInfo const & defInfo,
+	FibersData const & fibers, std::vector<size_t> const & neighborFibersP, std::vector<size_t> const & neighborFibersFF ) const
+{
+	DefectNames looksLike = DefectNames::Fracture;
+
+	// pull-outs
+	if( def.volume > m_param.BigVolumeThreshold )
+	{
+		if( defInfo.Elongation > m_param.ElongationP
+			&& def.obbSize[1] > m_param.LengthRangeP[0]
+			&& def.obbSize[1] < m_param.LengthRangeP[1]
+			&& def.obbSize[2] > m_param.WidthRangeP[0]
+			&& def.obbSize[2] < m_param.WidthRangeP[1]
+			&& defInfo.Angle < m_param.AngleP * vtkMath::Pi() / 180
+			&& neighborFibersP.size( ) >= 1 )
+		{
+			looksLike = DefectNames::Pulloout;
+		}
+	}
+	else
+	{
+		if( neighborFibersP.size( ) >= 1 )
+		{
+			looksLike = DefectNames::Pulloout;
+		}
+	}
+
+	// debondings
+	if( defInfo.Elongation > m_param.ElongationD
+		&& defInfo.Angle > m_param.AngleD * vtkMath::Pi() / 180 )
+	{
+		looksLike = DefectNames::Debonding;
+	}
+
+	// breakages
+	if( looksLike == DefectNames::Pulloout
+		&& neighborFibersFF.size( ) >= 2 )
+	{
+		double minAngle = 2 * vtkMath::Pi(); // maximum possible angle
+		for (size_t i = 0; i < neighborFibersFF.size( ); ++i)
+		{
+			Fiber const & fib0 = fibers[neighborFibersFF[i]];
+			for (size_t j = i + 1; j < neighborFibersFF.size( ); ++j)
+			{
+				Fiber const & fib1 = fibers[neighborFibersFF[j]];
+				double max[2], min[2];
+				max[0] = std::max( fib0.startPoint[2], fib0.endPoint[2] );
+				max[1] = std::max( fib1.startPoint[2], fib1.endPoint[2] );
+				min[0] = std::min( fib0.startPoint[2], fib0.endPoint[2] );
+				min[1] = std::min( fib1.startPoint[2], fib1.endPoint[2] );
+				if( min[0] < max[1] && min[1] < max[0] ) continue;	// fibers are overlapped
+
+				iAVec3d dir[2];
+				dir[0] = iAVec3d( fib0.endPoint ) - iAVec3d( fib0.startPoint );
+				dir[1] = iAVec3d( fib1.endPoint ) - iAVec3d( fib1.startPoint );
+				double angle = angleBetween( dir[0], dir[1] );
+				angle = angle > (vtkMath::Pi()/2) ? vtkMath::Pi() - angle : angle;
+				if( minAngle > angle ) minAngle = angle;
+			}
+		}
+
+		if( minAngle < m_param.AngleB * vtkMath::Pi() / 180 ) looksLike = DefectNames::Breakage;
+	}
+	return looksLike;
+}
+
 void iADefectClassifier::calcStatistic( FeatureList* defects )
 {
 	std::cout << "Calculating statistic......\n";
@@ -177,7 +213,7 @@ void iADefectClassifier::calcStatistic( FeatureList* defects )
 	for( auto i : m_classification.Breakages ) m_stat.breakagesVolume += idToFeature[i].volume;
 }
 
-iADefectClassifier::ExtendedDefectInfo iADefectClassifier::calcExtendedDefectInfo( iAFeature& def ) const
+iADefectClassifier::ExtendedDefectInfo iADefectClassifier::calcExtendedDefectInfo( iAFeature const & def ) const
 {
 	ExtendedDefectInfo defInfo;
 	defInfo.Direction = def.eigenvectors[2].normalized( );
@@ -190,32 +226,6 @@ iADefectClassifier::ExtendedDefectInfo iADefectClassifier::calcExtendedDefectInf
 	return defInfo;
 }
 
-FibersData iADefectClassifier::findNeighboringFibers( FibersData& fibers, ExtendedDefectInfo& defInfo, double distance ) const
-{
-	FibersData neighborFibers;
-	for( auto fib : fibers )
-	{
-		iAVec3d fibEndpoints[2];
-		fibEndpoints[0] = iAVec3d( fib.startPoint );
-		fibEndpoints[1] = iAVec3d( fib.endPoint );
-		bool isNeighbor = false;
-		for( int i = 0; i < 2; i++ )
-		{
-			for( int j = 0; j < 2; j++ )
-			{
-				if( ( fibEndpoints[j] - defInfo.Endpoints[i] ).magnitude( ) < distance )
-				{
-					isNeighbor = true;
-					break;
-				}
-			}
-			if( isNeighbor ) break;
-		}
-		if( isNeighbor ) neighborFibers.push_back( fib );
-	}
-	return neighborFibers;
-}
-
 void iADefectClassifier::save( ) const
 {
 	std::cout << "Saving results......\n";
@@ -45,6 +45,8 @@ private:
 		QVector<unsigned long> Fractures, Pullouts, Debondings, Breakages;
 	};
 
+	enum DefectNames { Fracture, Pulloout, Debonding, Breakage };
+
 	struct ExtendedDefectInfo
 	{
 		iAVec3d Direction;
@@ -86,8 +88,10 @@ private:
 	void				classify( FibersData* fibers, FeatureList* defects );
 	void				save( ) const;
 	void				calcStatistic( FeatureList* defects );
-	ExtendedDefectInfo	calcExtendedDefectInfo( iAFeature& def ) const;
-	FibersData			findNeighboringFibers( FibersData& fibers, ExtendedDefectInfo& defInfo, double distance ) const;
+	ExtendedDefectInfo	calcExtendedDefectInfo( iAFeature const & def ) const;
+	//! classifies a single defect, given the indices of the fibers within the pull-out and fiber fracture neighborhood distances
+	DefectNames			classifyDefect( iAFeature const & def, ExtendedDefectInfo const & defInfo, FibersData const & fibers,
+							std::vector<size_t> const & neighborFibersP, std::vector<size_t> const & neighborFibersFF ) const;
 
 	Classification		m_classification;
 	Parameters			m_param;
@@ -35,78 +35,45 @@ void iAFeatureExtraction::run(QString inputImgPath, QString outputImgPath)
 	LabelGeometryImageFilterType::Pointer labelGeometryImageFilter = LabelGeometryImageFilterType::New();
 	labelGeometryImageFilter->SetInput(labelImage);
 
-	// These generate optional outputs.
-	labelGeometryImageFilter->CalculatePixelIndicesOn();
+	// These generate optional outputs; the oriented bounding boxes are computed
+	// in a second pass over the label image instead of from stored pixel indices.
+	labelGeometryImageFilter->StreamingAccumulationOn();
 	labelGeometryImageFilter->CalculateOrientedBoundingBoxOn();
 	//labelGeometryImageFilter->CalculateOrientedLabelRegionsOn();
 	//labelGeometryImageFilter->CalculateOrientedIntensityRegionsOn();
 	labelGeometryImageFilter->Update();
 
-	LabelGeometryImageFilterType::LabelsType allLabels = labelGeometryImageFilter->GetLabels();
-	LabelGeometryImageFilterType::LabelsType::iterator allLabelsIt;
 	std::vector<iAFeature> features;
-	for( allLabelsIt = allLabels.begin(); allLabelsIt != allLabels.end(); allLabelsIt++ )
+	for (auto const & r : labelGeometryImageFilter->GetLabelGeometryRecords())
 	{
-		LabelGeometryImageFilterType::LabelPixelType labelValue = *allLabelsIt;
 		iAFeature f;
-		f.id = (int)labelValue;
-		f.volume = labelGeometryImageFilter->GetVolume(labelValue);
-		f.centroid[0] = labelGeometryImageFilter->GetCentroid(labelValue)[0];
-		f.centroid[1] = labelGeometryImageFilter->GetCentroid(labelValue)[1];
-		f.centroid[2] = labelGeometryImageFilter->GetCentroid(labelValue)[2];
-		f.eigenvalues[0] = labelGeometryImageFilter->GetEigenvalues(labelValue)[0];
-		f.eigenvalues[1] = labelGeometryImageFilter->GetEigenvalues(labelValue)[1];
-		f.eigenvalues[2] = labelGeometryImageFilter->GetEigenvalues(labelValue)[2];
-		f.eigenvectors[0][0] = labelGeometryImageFilter->GetEigenvectors(labelValue)[0][0];
-		f.eigenvectors[0][1] = labelGeometryImageFilter->GetEigenvectors(labelValue)[0][1];
-		f.eigenvectors[0][2] = labelGeometryImageFilter->GetEigenvectors(labelValue)[0][2];
-		f.eigenvectors[1][0] = labelGeometryImageFilter->GetEigenvectors(labelValue)[1][0];
-		f.eigenvectors[1][1] = labelGeometryImageFilter->GetEigenvectors(labelValue)[1][1];
-		f.eigenvectors[1][2] = labelGeometryImageFilter->GetEigenvectors(labelValue)[1][2];
-		f.eigenvectors[2][0] = labelGeometryImageFilter->GetEigenvectors(labelValue)[2][0];
-		f.eigenvectors[2][1] = labelGeometryImageFilter->GetEigenvectors(labelValue)[2][1];
-		f.eigenvectors[2][2] = labelGeometryImageFilter->GetEigenvectors(labelValue)[2][2];
-		f.axesLength[0] = labelGeometryImageFilter->GetAxesLength(labelValue)[0];
-		f.axesLength[1] = labelGeometryImageFilter->GetAxesLength(labelValue)[1];
-		f.axesLength[2] = labelGeometryImageFilter->GetAxesLength(labelValue)[2];
-		f.bb[0] = labelGeometryImageFilter->GetBoundingBox(labelValue)[0];
-		f.bb[1] = labelGeometryImageFilter->GetBoundingBox(labelValue)[1];
-		f.bb[2] = labelGeometryImageFilter->GetBoundingBox(labelValue)[2];
-		f.bb[3] = labelGeometryImageFilter->GetBoundingBox(labelValue)[3];
-		f.bb[4] = labelGeometryImageFilter->GetBoundingBox(labelValue)[4];
-		f.bb[5] = labelGeometryImageFilter->GetBoundingBox(labelValue)[5];
-		f.bbVolume = labelGeometryImageFilter->GetBoundingBoxVolume(labelValue);
-		f.bbSize[0] = labelGeometryImageFilter->GetBoundingBoxSize(labelValue)[0];
-		f.bbSize[1] = labelGeometryImageFilter->GetBoundingBoxSize(labelValue)[1];
-		f.bbSize[2] = labelGeometryImageFilter->GetBoundingBoxSize(labelValue)[2];
-		f.obbVertices[0][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[0][0];
-		f.obbVertices[0][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[0][1];
-		f.obbVertices[0][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[0][2];
-		f.obbVertices[1][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[1][0];
-		f.obbVertices[1][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[1][1];
-		f.obbVertices[1][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[1][2];
-		f.obbVertices[2][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[2][0];
-		f.obbVertices[2][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[2][1];
-		f.obbVertices[2][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[2][2];
-		f.obbVertices[3][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[3][0];
-		f.obbVertices[3][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[3][1];
-		f.obbVertices[3][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[3][2];
-		f.obbVertices[4][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[4][0];
-		f.obbVertices[4][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[4][1];
-		f.obbVertices[4][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[4][2];
-		f.obbVertices[5][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[5][0];
-		f.obbVertices[5][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[5][1];
-		f.obbVertices[5][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[5][2];
-		f.obbVertices[6][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[6][0];
-		f.obbVertices[6][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[6][1];
-		f.obbVertices[6][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[6][2];
-		f.obbVertices[7][0] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[7][0];
-		f.obbVertices[7][1] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[7][1];
-		f.obbVertices[7][2] = labelGeometryImageFilter->GetOrientedBoundingBoxVertices(labelValue)[7][2];
-		f.obbVolume = labelGeometryImageFilter->GetOrientedBoundingBoxVolume(labelValue);
-		f.obbSize[0] = labelGeometryImageFilter->GetOrientedBoundingBoxSize(labelValue)[0];
-		f.obbSize[1] = labelGeometryImageFilter->GetOrientedBoundingBoxSize(labelValue)[1];
-		f.obbSize[2] = labelGeometryImageFilter->GetOrientedBoundingBoxSize(labelValue)[2];
+		f.id = static_cast<int>(r.label);
+		f.volume = r.volume;
+		for (int i = 0; i < 3; ++i)
+		{
+			f.centroid[i] = r.centroid[i];
+			f.eigenvalues[i] = r.eigenvalues[i];
+			for (int j = 0; j < 3; ++j)
+			{
+				f.eigenvectors[i][j] = r.eigenvectors[i][j];
+			}
+			f.axesLength[i] = r.axesLength[i];
+			f.bbSize[i] = r.boundingBoxSize[i];
+			f.obbSize[i] = r.orientedBoundingBoxSize[i];
+		}
+		for (int i = 0; i < 6; ++i)
+		{
+			f.bb[i] = r.boundingBox[i];
+		}
+		f.bbVolume = r.boundingBoxVolume;
+		for (int v = 0; v < 8; ++v)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				f.obbVertices[v][j] = r.orientedBoundingBoxVertices[v][j];
+			}
+		}
+		f.obbVolume = r.orientedBoundingBoxVolume;
 		features.push_back(f);
 	}
 
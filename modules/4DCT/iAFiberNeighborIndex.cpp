@@ -0,0 +1,151 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAFiberNeighborIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	//! upper limit for the number of grid cells per fiber end point; the cells are enlarged if there would be more
+	const double MaxCellsPerPoint = 4.0;
+	//! relative enlargement of the searched region, so that rounding cannot exclude cells with neighbors
+	const double ReachTolerance = 1e-6;
+}
+
+iAFiberNeighborIndex::iAFiberNeighborIndex(std::vector<iAVec3d> const& endPoints, double maxDistance) :
+	m_endPoints(endPoints)
+{
+	double maxCoord[3];
+	for (int a = 0; a < 3; ++a)
+	{
+		m_origin[a] = std::numeric_limits<double>::max();
+		maxCoord[a] = std::numeric_limits<double>::lowest();
+	}
+	for (auto const& p : m_endPoints)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			if (std::isfinite(p[a]))
+			{
+				m_origin[a] = std::min(m_origin[a], p[a]);
+				maxCoord[a] = std::max(maxCoord[a], p[a]);
+			}
+		}
+	}
+	double extent[3];
+	for (int a = 0; a < 3; ++a)
+	{
+		if (m_origin[a] > maxCoord[a])
+		{   // no (finite) points at all
+			m_origin[a] = maxCoord[a] = 0.0;
+		}
+		extent[a] = maxCoord[a] - m_origin[a];
+	}
+	m_cellSize = (maxDistance > 0.0 && std::isfinite(maxDistance)) ? maxDistance :
+		std::max(std::max(extent[0], extent[1]), std::max(extent[2], 1.0));
+	const double maxCells = std::max(1.0, MaxCellsPerPoint * m_endPoints.size());
+	while ((std::floor(extent[0] / m_cellSize) + 1) * (std::floor(extent[1] / m_cellSize) + 1) *
+		(std::floor(extent[2] / m_cellSize) + 1) > maxCells)
+	{
+		m_cellSize *= 2;
+	}
+	for (int a = 0; a < 3; ++a)
+	{
+		m_cellCount[a] = static_cast<int>(std::floor(extent[a] / m_cellSize)) + 1;
+	}
+
+	// counting sort of the fibers by the cells of their end points:
+	size_t cellCount = static_cast<size_t>(m_cellCount[0]) * m_cellCount[1] * m_cellCount[2];
+	std::vector<size_t> pointCells(m_endPoints.size());
+	m_cellStart.assign(cellCount + 1, 0);
+	for (size_t i = 0; i < m_endPoints.size(); ++i)
+	{
+		auto const& p = m_endPoints[i];
+		pointCells[i] = (static_cast<size_t>(cellCoord(p[2], 2)) * m_cellCount[1] + cellCoord(p[1], 1)) * m_cellCount[0] +
+			cellCoord(p[0], 0);
+		++m_cellStart[pointCells[i] + 1];
+	}
+	for (size_t c = 0; c < cellCount; ++c)
+	{
+		m_cellStart[c + 1] += m_cellStart[c];
+	}
+	m_cellFibers.resize(m_endPoints.size());
+	std::vector<size_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+	for (size_t i = 0; i < m_endPoints.size(); ++i)
+	{
+		m_cellFibers[fill[pointCells[i]]++] = i / 2;
+	}
+}
+
+size_t iAFiberNeighborIndex::fiberCount() const
+{
+	return m_endPoints.size() / 2;
+}
+
+int iAFiberNeighborIndex::cellCoord(double value, int axis) const
+{
+	double cell = std::floor((value - m_origin[axis]) / m_cellSize);
+	if (!(cell >= 0.0))    // also catches NaN
+	{
+		return 0;
+	}
+	return (cell >= m_cellCount[axis]) ? m_cellCount[axis] - 1 : static_cast<int>(cell);
+}
+
+void iAFiberNeighborIndex::neighbors(iAVec3d const points[], int pointCount, double const distances[],
+	int distanceCount, std::vector<size_t> result[], Scratch& scratch) const
+{
+	double maxDistance = 0.0;
+	for (int d = 0; d < distanceCount; ++d)
+	{
+		result[d].clear();
+		maxDistance = std::max(maxDistance, distances[d]);
+	}
+	if (!(maxDistance > 0.0))
+	{
+		return;    // no end point can be closer than 0
+	}
+	const double reach = maxDistance * (1.0 + ReachTolerance);
+	scratch.candidates.clear();
+	for (int i = 0; i < pointCount; ++i)
+	{
+		int lo[3], hi[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			lo[a] = cellCoord(points[i][a] - reach, a);
+			hi[a] = cellCoord(points[i][a] + reach, a);
+		}
+		for (int z = lo[2]; z <= hi[2]; ++z)
+		{
+			for (int y = lo[1]; y <= hi[1]; ++y)
+			{
+				size_t rowStart = (static_cast<size_t>(z) * m_cellCount[1] + y) * m_cellCount[0];
+				scratch.candidates.insert(scratch.candidates.end(),
+					m_cellFibers.begin() + m_cellStart[rowStart + lo[0]],
+					m_cellFibers.begin() + m_cellStart[rowStart + hi[0] + 1]);
+			}
+		}
+	}
+	std::sort(scratch.candidates.begin(), scratch.candidates.end());
+	scratch.candidates.erase(std::unique(scratch.candidates.begin(), scratch.candidates.end()), scratch.candidates.end());
+	for (size_t f : scratch.candidates)
+	{
+		double minDistance = std::numeric_limits<double>::infinity();
+		for (int i = 0; i < pointCount; ++i)
+		{
+			for (int j = 0; j < 2; ++j)
+			{
+				minDistance = std::min(minDistance, (m_endPoints[2 * f + j] - points[i]).magnitude());
+			}
+		}
+		for (int d = 0; d < distanceCount; ++d)
+		{
+			if (minDistance < distances[d])
+			{
+				result[d].push_back(f);
+			}
+		}
+	}
+}
@@ -0,0 +1,51 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <iAVec3.h>
+
+#include <cstddef>    // for size_t
+#include <vector>
+
+//! Uniform grid over the end points of fibers, for finding all fibers with an end point close to given query points.
+//!
+//! Built once; queries only read the grid and can therefore be run concurrently, each thread passing its
+//! own iAFiberNeighborIndex::Scratch. A fiber is a neighbor for a given distance if the distance between
+//! one of its end points and one of the query points is smaller than that distance, which is exactly
+//! the criterion of the brute-force search over all fibers formerly used in iADefectClassifier.
+class iAFiberNeighborIndex
+{
+public:
+	//! per-thread memory used during queries
+	struct Scratch
+	{
+		std::vector<size_t> candidates;
+	};
+
+	//! Builds the index.
+	//! @param endPoints the start and end point of each fiber (i.e., two points per fiber)
+	//! @param maxDistance the largest distance that will be queried (determines the grid cell size)
+	iAFiberNeighborIndex(std::vector<iAVec3d> const& endPoints, double maxDistance);
+	size_t fiberCount() const;
+	//! Finds the neighboring fibers of the given points for several distances in one query.
+	//! @param points the query points
+	//! @param pointCount the number of query points
+	//! @param distances the neighborhood distances; distances larger than the maxDistance given on construction
+	//!        are answered correctly as well, but have to search more cells
+	//! @param distanceCount the number of distances
+	//! @param result receives, for each distance, the (ascending) indices of the fibers within that distance
+	//! @param scratch per-thread memory
+	void neighbors(iAVec3d const points[], int pointCount, double const distances[], int distanceCount,
+		std::vector<size_t> result[], Scratch& scratch) const;
+
+private:
+	//! the cell containing the given coordinate along the given axis, clamped to the grid
+	int cellCoord(double value, int axis) const;
+
+	std::vector<iAVec3d> m_endPoints;
+	double m_origin[3];
+	double m_cellSize;
+	int m_cellCount[3];
+	std::vector<size_t> m_cellStart;  //!< for each cell, the index of its first entry in m_cellFibers (plus one final element)
+	std::vector<size_t> m_cellFibers; //!< the fibers with an end point in each cell, cell by cell
+};
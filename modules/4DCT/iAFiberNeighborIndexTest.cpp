@@ -0,0 +1,144 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "iAFiberNeighborIndex.h"
+
+#include <random>
+
+namespace
+{
+	//! the brute-force search over all fibers previously used in iADefectClassifier::findNeighboringFibers
+	std::vector<size_t> bruteForceNeighbors(std::vector<iAVec3d> const& endPoints, iAVec3d const points[2], double distance)
+	{
+		std::vector<size_t> result;
+		for (size_t f = 0; f < endPoints.size() / 2; ++f)
+		{
+			bool isNeighbor = false;
+			for (int i = 0; i < 2 && !isNeighbor; i++)
+			{
+				for (int j = 0; j < 2; j++)
+				{
+					if ((endPoints[2 * f + j] - points[i]).magnitude() < distance)
+					{
+						isNeighbor = true;
+						break;
+					}
+				}
+			}
+			if (isNeighbor)
+			{
+				result.push_back(f);
+			}
+		}
+		return result;
+	}
+
+	//! number of queries for which the index does not find exactly the fibers the brute-force search finds
+	int compareToBruteForce(std::vector<iAVec3d> const& endPoints, std::vector<iAVec3d> const& queryPoints,
+		double const distances[2], size_t& neighborCount)
+	{
+		iAFiberNeighborIndex index(endPoints, std::max(distances[0], distances[1]));
+		iAFiberNeighborIndex::Scratch scratch;
+		std::vector<size_t> result[2];
+		int mismatches = 0;
+		neighborCount = 0;
+		for (size_t q = 0; q + 1 < queryPoints.size(); q += 2)
+		{
+			index.neighbors(&queryPoints[q], 2, distances, 2, result, scratch);
+			for (int d = 0; d < 2; ++d)
+			{
+				if (result[d] != bruteForceNeighbors(endPoints, &queryPoints[q], distances[d]))
+				{
+					++mismatches;
+				}
+				neighborCount += result[d].size();
+			}
+		}
+		return mismatches;
+	}
+}
+
+BEGIN_TEST
+{
+	// two fibers along x, one far away:
+	std::vector<iAVec3d> endPoints = {
+		iAVec3d(0, 0, 0), iAVec3d(10, 0, 0),
+		iAVec3d(0, 3, 0), iAVec3d(10, 3, 0),
+		iAVec3d(100, 100, 100), iAVec3d(110, 100, 100)
+	};
+	iAFiberNeighborIndex index(endPoints, 5);
+	TestEqual(static_cast<size_t>(3), index.fiberCount());
+	iAFiberNeighborIndex::Scratch scratch;
+	std::vector<size_t> result[2];
+	iAVec3d query[2] = {iAVec3d(11, 0, 0), iAVec3d(11, 1, 0)};
+	double distances[2] = {1.5, 5};
+	index.neighbors(query, 2, distances, 2, result, scratch);
+	TestEqual(static_cast<size_t>(1), result[0].size());
+	TestEqual(static_cast<size_t>(0), result[0][0]);
+	TestEqual(static_cast<size_t>(2), result[1].size());
+	TestEqual(static_cast<size_t>(1), result[1][1]);
+	// the distance is exclusive:
+	double exact[1] = {1.0};
+	index.neighbors(query, 1, exact, 1, result, scratch);
+	TestEqual(static_cast<size_t>(0), result[0].size());
+	// query points outside of the indexed region, and distances larger than the one given on construction:
+	iAVec3d farQuery[2] = {iAVec3d(-50, 0, 0), iAVec3d(140, 100, 100)};
+	double large[2] = {31, 51};
+	index.neighbors(farQuery, 2, large, 2, result, scratch);
+	TestEqual(static_cast<size_t>(1), result[0].size());
+	TestEqual(static_cast<size_t>(2), result[0][0]);
+	TestEqual(static_cast<size_t>(3), result[1].size());
+	// no fibers at all:
+	iAFiberNeighborIndex empty(std::vector<iAVec3d>(), 5);
+	empty.neighbors(query, 2, distances, 2, result, scratch);
+	TestEqual(static_cast<size_t>(0), result[0].size() + result[1].size());
+
+	// random fibers and defects, compared to the brute-force search over all fibers:
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> pos(0.0, 500.0);
+	std::normal_distribution<double> offset(0.0, 8.0);
+	std::vector<iAVec3d> fibers, defects;
+	for (int f = 0; f < 5000; ++f)
+	{
+		iAVec3d start(pos(rng), pos(rng), pos(rng));
+		fibers.push_back(start);
+		fibers.push_back(start + iAVec3d(offset(rng), offset(rng), 5 * offset(rng)));
+	}
+	for (int d = 0; d < 2000; ++d)
+	{
+		// half of the defects directly at fiber end points, i.e. with distances to them of exactly zero
+		iAVec3d center = (d % 2 == 0) ? fibers[d] : iAVec3d(pos(rng), pos(rng), pos(rng));
+		iAVec3d dir(offset(rng), offset(rng), offset(rng));
+		defects.push_back(center + dir);
+		defects.push_back(center - dir);
+	}
+	size_t neighborCount;
+	double randomDistances[2] = {5, 12};
+	TestEqual(0, compareToBruteForce(fibers, defects, randomDistances, neighborCount));
+	TestAssert(neighborCount > 0);
+	// very small distances, the grid cells are enlarged then:
+	double smallDistances[2] = {0.01, 1e-9};
+	TestEqual(0, compareToBruteForce(fibers, defects, smallDistances, neighborCount));
+	// zero and negative distances never find a neighbor:
+	double zeroDistances[2] = {0, -1};
+	TestEqual(0, compareToBruteForce(fibers, defects, zeroDistances, neighborCount));
+	TestEqual(static_cast<size_t>(0), neighborCount);
+	// all fibers in a plane (zero extent along z) and integer coordinates on cell borders:
+	std::vector<iAVec3d> planar;
+	for (int f = 0; f < 400; ++f)
+	{
+		planar.push_back(iAVec3d(f % 20, f / 20, 7));
+		planar.push_back(iAVec3d(f % 20 + 2, f / 20 + 1, 7));
+	}
+	std::vector<iAVec3d> gridQueries;
+	for (int q = 0; q < 100; ++q)
+	{
+		gridQueries.push_back(iAVec3d(q % 25, q / 4, 7 + q % 3));
+		gridQueries.push_back(iAVec3d(q % 13, q % 17, 7));
+	}
+	double integerDistances[2] = {1, 2};
+	TestEqual(0, compareToBruteForce(planar, gridQueries, integerDistances, neighborCount));
+	TestAssert(neighborCount > 0);
+}
+END_TEST
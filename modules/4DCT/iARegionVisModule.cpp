@@ -252,9 +252,8 @@ void iARegionVisModule::calculateDensityMap( QString fileName, iARegionVisModule
 
 	// calculate density map
 	//int m_densityMapSize[3] = { 15, 5, 30 };
-	std::vector<std::vector<std::vector<double>>> density;
 	double cellSize[3];
-	density = CalculateDensityMap<double, unsigned short>::Calculate( reader->GetOutput( ), m_densityMapSize, cellSize );
+	std::vector<double> density = CalculateDensityMap<double, unsigned short>::Calculate( reader->GetOutput( ), m_densityMapSize, cellSize );
 
 	// make an itk image
 	double* oldSpacing = reader->GetOutput( )->GetSpacing( );
@@ -278,18 +277,16 @@ void iARegionVisModule::calculateDensityMap( QString fileName, iARegionVisModule
 	image->SetSpacing( newSpacing );
 	image->Allocate( );
 	image->FillBuffer( 0 );
-	for (size_t x = 0; x < density.size(); ++x)
+	size_t densityIdx = 0;
+	for (int z = 0; z < m_densityMapSize[2]; ++z)
 	{
-		for (size_t y = 0; y < density[x].size(); ++y)
+		for (int y = 0; y < m_densityMapSize[1]; ++y)
 		{
-			for (size_t z = 0; z < density[x][y].size(); ++z)
+			for (int x = 0; x < m_densityMapSize[0]; ++x)
 			{
-				assert(x < static_cast<size_t>(std::numeric_limits<itk::IndexValueType>::max()) &&
-				       y < static_cast<size_t>(std::numeric_limits<itk::IndexValueType>::max()) &&
-				       z < static_cast<size_t>(std::numeric_limits<itk::IndexValueType>::max()));
 				DoubleImageType::IndexType ind;
 				ind[0] = x + 1; ind[1] = y + 1; ind[2] = z + 1;
-				image->SetPixel( ind, density[x][y][z] );
+				image->SetPixel( ind, density[densityIdx++] );
 			}
 		}
 	}
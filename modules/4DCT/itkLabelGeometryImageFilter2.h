@@ -28,7 +28,9 @@
 #include "vnl/vnl_det.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 
@@ -250,6 +252,40 @@ public:
     LabelPointType m_OrientedBoundingBoxOrigin;
   };
 
+  /** Number of vertices of an oriented bounding box */
+  itkStaticConstMacro(NumberOfOrientedBoundingBoxVertices, unsigned int,
+                      1u << TLabelImage::ImageDimension);
+
+  /** \class LabelGeometryRecord
+   * \brief All geometry values of one label in one flat structure, see
+   * GetLabelGeometryRecords. Contains the same values as the
+   * corresponding per-label accessors.
+   * \ingroup ITKReview
+   */
+  struct LabelGeometryRecord
+  {
+    LabelPixelType label;
+    SizeValueType  volume;
+    RealType       integratedIntensity;
+    double         centroid[ImageDimension];
+    double         weightedCentroid[ImageDimension];
+    double         eigenvalues[ImageDimension];
+    // eigenvectors[i][j] is the same as GetEigenvectors()(i, j), i.e. the
+    // eigenvectors are the columns.
+    double         eigenvectors[ImageDimension][ImageDimension];
+    double         axesLength[ImageDimension];
+    double         eccentricity;
+    double         elongation;
+    double         orientation;
+    typename LabelIndexType::IndexValueType boundingBox[2 * ImageDimension];
+    double         boundingBoxVolume;
+    SizeValueType  boundingBoxSize[ImageDimension];
+    double         orientedBoundingBoxVertices[NumberOfOrientedBoundingBoxVertices][ImageDimension];
+    double         orientedBoundingBoxVolume;
+    double         orientedBoundingBoxSize[ImageDimension];
+    double         orientedBoundingBoxOrigin[ImageDimension];
+  };
+
   /** Type of the map used to store data per label */
   // Map from the label to the class storing all of the geometry information.
   typedef std::unordered_map<LabelPixelType, LabelGeometry> MapType;
@@ -284,6 +320,19 @@ public:
       }
   }
 
+  /** Streaming accumulation mode: the label image is traversed by
+   * several threads, each accumulating the moments of the labels it
+   * encounters; these per-thread accumulators are merged in the end.
+   * The oriented bounding boxes are determined in a second (also
+   * multi-threaded) pass over the label image, which rotates each pixel
+   * by the rotation matrix of its label, instead of from the pixel
+   * indices of each label; CalculatePixelIndices is therefore not
+   * required for the oriented bounding boxes in this mode. The labels
+   * are reported in ascending order. Off by default. */
+  itkGetMacro(StreamingAccumulation, bool);
+  itkSetMacro(StreamingAccumulation, bool);
+  itkBooleanMacro(StreamingAccumulation);
+
   itkGetMacro(CalculateOrientedBoundingBox, bool);
   itkBooleanMacro(CalculateOrientedBoundingBox);
   void SetCalculateOrientedBoundingBox(const bool value)
@@ -375,6 +424,10 @@ public:
     return m_AllLabels;
   }
 
+  /** Return the geometry of all labels, one record per label, in the
+   * order of GetLabels(). Can only be called after a call to Update(). */
+  std::vector< LabelGeometryRecord > GetLabelGeometryRecords() const;
+
   /** Return the all pixel indices for a label. */
   LabelIndicesType GetPixelIndices(LabelPixelType label) const;
 
@@ -483,6 +536,76 @@ private:
 
   bool CalculateOrientedBoundingBoxVertices(vnl_symmetric_eigensystem< double > eig, LabelGeometry & m_LabelGeometry, LabelPixelType label);
 
+  /** Moments accumulated over the pixels of one label */
+  struct MomentAccumulator
+  {
+    SizeValueType   count;
+    BoundingBoxType boundingBox;
+    IndexArrayType  firstOrder;
+    std::int64_t    secondOrder[ImageDimension][ImageDimension];
+    RealType        sum;
+    IndexArrayType  firstOrderWeighted;
+
+    MomentAccumulator():
+      count(0),
+      sum(NumericTraits< RealType >::Zero)
+    {
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        boundingBox[2 * i] = NumericTraits< typename IndexType::IndexValueType >::max();
+        boundingBox[2 * i + 1] = NumericTraits< typename IndexType::IndexValueType >::NonpositiveMin();
+        firstOrder[i] = 0;
+        firstOrderWeighted[i] = 0;
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+          secondOrder[i][j] = 0;
+          }
+        }
+    }
+    void Add(const LabelIndexType & index)
+    {
+      ++count;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        boundingBox[2 * i] = std::min(boundingBox[2 * i], index[i]);
+        boundingBox[2 * i + 1] = std::max(boundingBox[2 * i + 1], index[i]);
+        firstOrder[i] += index[i];
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+          secondOrder[i][j] += static_cast< std::int64_t >( index[i] ) * index[j];
+          }
+        }
+    }
+    void Merge(const MomentAccumulator & other)
+    {
+      count += other.count;
+      sum += other.sum;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        boundingBox[2 * i] = std::min(boundingBox[2 * i], other.boundingBox[2 * i]);
+        boundingBox[2 * i + 1] = std::max(boundingBox[2 * i + 1], other.boundingBox[2 * i + 1]);
+        firstOrder[i] += other.firstOrder[i];
+        firstOrderWeighted[i] += other.firstOrderWeighted[i];
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+          secondOrder[i][j] += other.secondOrder[i][j];
+          }
+        }
+    }
+  };
+
+  /** Computes centroid, central moments, eigensystem and the values
+   * derived from it from the accumulated moments of a label. */
+  vnl_symmetric_eigensystem< double > CalculateMoments(LabelGeometry & labelGeometry, bool hasIntensity) const;
+
+  /** Sets the oriented bounding box values from the bounding box in the
+   * coordinate system rotated by the rotation matrix of the label. */
+  void SetOrientedBoundingBox(BoundingBoxFloatType transformedBoundingBox, LabelGeometry & labelGeometry) const;
+
+  /** GenerateData for the streaming accumulation mode */
+  void GenerateDataStreamed();
+
+  bool m_StreamingAccumulation;
   bool m_CalculatePixelIndices;
   bool m_CalculateOrientedBoundingBox;
   bool m_CalculateOrientedLabelRegions;
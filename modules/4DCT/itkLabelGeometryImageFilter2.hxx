@@ -190,6 +190,7 @@ LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
 ::LabelGeometryImageFilter2()
 {
   this->SetNumberOfRequiredInputs(1);
+  m_StreamingAccumulation = false;
   m_CalculatePixelIndices = false;
   m_CalculateOrientedBoundingBox = false;
   m_CalculateOrientedLabelRegions = false;
@@ -216,6 +217,12 @@ LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
   m_LabelGeometryMapper.clear();
   m_AllLabels.clear();
 
+  if ( m_StreamingAccumulation )
+    {
+    this->GenerateDataStreamed();
+    return;
+    }
+
   std::map<LabelPixelType, std::ofstream*> files;
   typename std::map<LabelPixelType, std::ofstream*>::iterator fileIt;
 
@@ -370,100 +377,12 @@ LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
     m_CalculateOrientedIntensityRegions = false;
     }
 
-  // We need to add to the second order moment the second order
-  // moment of a pixel.  This can be derived analytically.  The first
-  // order moment of a pixel can be shown to be 0, and the first order
-  // cross moment can also be shown to be 0.  The second order moment
-  // can be shown to be 1/12.
-  float pixelSecondOrderCentralMoment = 1.0f / 12.0f;
-
   // Now that the m_LabelGeometryMapper has been updated for all
   // pixels in the image, we can calculate other geometrical values.
   // Loop through all labels of the image.
   for ( mapIt = m_LabelGeometryMapper.begin(); mapIt != m_LabelGeometryMapper.end(); mapIt++ )
     {
-    // Update the bounding box measurements.
-    ( *mapIt ).second.m_BoundingBoxVolume = 1;
-    for ( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      ( *mapIt ).second.m_BoundingBoxSize[i] =
-        ( *mapIt ).second.m_BoundingBox[2 * i + 1] - ( *mapIt ).second.m_BoundingBox[2 * i] + 1;
-      ( *mapIt ).second.m_BoundingBoxVolume = ( *mapIt ).second.m_BoundingBoxVolume
-                                              * ( *mapIt ).second.m_BoundingBoxSize[i];
-      }
-
-    for ( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      // Normalize the centroid sum by the count to get the centroid.
-      ( *mapIt ).second.m_Centroid[i] =
-        static_cast< typename LabelPointType::ValueType >( ( *mapIt ).second.m_FirstOrderRawMoments[i] )
-        / ( *mapIt ).second.m_ZeroOrderMoment;
-
-      // This is the weighted sum.  It only calculates correctly if
-      // the intensity image is defined.
-      if ( !intensityImage )
-        {
-        ( *mapIt ).second.m_WeightedCentroid[i] = 0.0;
-        }
-      else
-        {
-        ( *mapIt ).second.m_WeightedCentroid[i] =
-          static_cast< typename LabelPointType::ValueType >( ( *mapIt ).second.m_FirstOrderWeightedRawMoments[i] )
-          / ( *mapIt ).second.m_Sum;
-        }
-      }
-
-    // Using the raw moments, we can calculate the central moments.
-    MatrixType normalizedSecondOrderCentralMoments(ImageDimension, ImageDimension, 0);
-    for ( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      for ( unsigned int j = 0; j < ImageDimension; j++ )
-        {
-        normalizedSecondOrderCentralMoments(i,
-                                            j) =
-          ( ( *mapIt ).second.m_SecondOrderRawMoments(i,
-                                                      j) ) / ( ( *mapIt ).second.m_ZeroOrderMoment )
-          - ( *mapIt ).second.m_Centroid[i]
-          * ( *mapIt ).second.m_Centroid[j];
-        // We need to add to the second order moment the second order
-        // moment of a pixel.  This can be derived analytically.
-        if ( i == j )
-          {
-          normalizedSecondOrderCentralMoments(i, j) += pixelSecondOrderCentralMoment;
-          }
-        }
-      }
-
-    // Compute the eigenvalues/eigenvectors of the covariance matrix.
-    // The result is stored in increasing eigenvalues with
-    // corresponding eigenvectors.
-    vnl_symmetric_eigensystem< double > eig(normalizedSecondOrderCentralMoments);
-
-    // Calculate the eigenvalues/eigenvectors
-    VectorType eigenvalues(ImageDimension, 0);
-    MatrixType eigenvectors(ImageDimension, ImageDimension, 0);
-    for ( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      eigenvectors.set_column( i, eig.get_eigenvector(i) );
-      eigenvalues[i] = eig.get_eigenvalue(i);
-      }
-    ( *mapIt ).second.m_Eigenvalues = eigenvalues;
-    ( *mapIt ).second.m_Eigenvectors = eigenvectors;
-
-    itk::FixedArray< float, ImageDimension > axesLength;
-    for ( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      axesLength[i] = 4 * std::sqrt(eigenvalues[i]);
-      }
-    ( *mapIt ).second.m_AxesLength = axesLength;
-
-    // The following three features are currently only meaningful in 2D.
-    ( *mapIt ).second.m_Eccentricity = std::sqrt( ( eigenvalues[ImageDimension-1] - eigenvalues[0] ) / eigenvalues[ImageDimension-1] );
-    ( *mapIt ).second.m_Elongation = axesLength[ImageDimension-1] / axesLength[0];
-    RealType orientation = std::atan2(eig.get_eigenvector(ImageDimension-1)[1], eig.get_eigenvector(ImageDimension-1)[0]);
-    // Change the orientation from being between -pi to pi to being from 0 to pi.
-    // We can add pi because the orientation of the major axis is symmetric about the origin.
-    ( *mapIt ).second.m_Orientation = orientation < 0.0 ? orientation + vnl_math::pi : orientation;
+    vnl_symmetric_eigensystem< double > eig = this->CalculateMoments( ( *mapIt ).second, intensityImage != nullptr );
 
     if ( m_CalculateOrientedBoundingBox == true )
       {
@@ -506,7 +425,6 @@ LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
   // handled by the flags.
 
   MatrixType rotationMatrix = CalculateRotationMatrix< TLabelImage, TIntensityImage >(eig);
-  MatrixType inverseRotationMatrix = rotationMatrix.transpose();
 
   labelGeometry.m_RotationMatrix = rotationMatrix;
 
@@ -575,6 +493,116 @@ LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
       }
     }
 
+  this->SetOrientedBoundingBox(transformedBoundingBox, labelGeometry);
+
+  return true;
+}
+
+template< typename TLabelImage, typename TIntensityImage >
+vnl_symmetric_eigensystem< double >
+LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
+::CalculateMoments(LabelGeometry & labelGeometry, bool hasIntensity) const
+{
+  // We need to add to the second order moment the second order
+  // moment of a pixel.  This can be derived analytically.  The first
+  // order moment of a pixel can be shown to be 0, and the first order
+  // cross moment can also be shown to be 0.  The second order moment
+  // can be shown to be 1/12.
+  float pixelSecondOrderCentralMoment = 1.0f / 12.0f;
+
+
+  // Update the bounding box measurements.
+  labelGeometry.m_BoundingBoxVolume = 1;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    labelGeometry.m_BoundingBoxSize[i] =
+      labelGeometry.m_BoundingBox[2 * i + 1] - labelGeometry.m_BoundingBox[2 * i] + 1;
+    labelGeometry.m_BoundingBoxVolume = labelGeometry.m_BoundingBoxVolume
+                                            * labelGeometry.m_BoundingBoxSize[i];
+    }
+
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    // Normalize the centroid sum by the count to get the centroid.
+    labelGeometry.m_Centroid[i] =
+      static_cast< typename LabelPointType::ValueType >( labelGeometry.m_FirstOrderRawMoments[i] )
+      / labelGeometry.m_ZeroOrderMoment;
+
+    // This is the weighted sum.  It only calculates correctly if
+    // the intensity image is defined.
+    if ( !hasIntensity )
+      {
+      labelGeometry.m_WeightedCentroid[i] = 0.0;
+      }
+    else
+      {
+      labelGeometry.m_WeightedCentroid[i] =
+        static_cast< typename LabelPointType::ValueType >( labelGeometry.m_FirstOrderWeightedRawMoments[i] )
+        / labelGeometry.m_Sum;
+      }
+    }
+
+  // Using the raw moments, we can calculate the central moments.
+  MatrixType normalizedSecondOrderCentralMoments(ImageDimension, ImageDimension, 0);
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      normalizedSecondOrderCentralMoments(i,
+                                          j) =
+        ( labelGeometry.m_SecondOrderRawMoments(i,
+                                                    j) ) / ( labelGeometry.m_ZeroOrderMoment )
+        - labelGeometry.m_Centroid[i]
+        * labelGeometry.m_Centroid[j];
+      // We need to add to the second order moment the second order
+      // moment of a pixel.  This can be derived analytically.
+      if ( i == j )
+        {
+        normalizedSecondOrderCentralMoments(i, j) += pixelSecondOrderCentralMoment;
+        }
+      }
+    }
+
+  // Compute the eigenvalues/eigenvectors of the covariance matrix.
+  // The result is stored in increasing eigenvalues with
+  // corresponding eigenvectors.
+  labelGeometry.m_SecondOrderCentralMoments = normalizedSecondOrderCentralMoments;
+  vnl_symmetric_eigensystem< double > eig(normalizedSecondOrderCentralMoments);
+
+  // Calculate the eigenvalues/eigenvectors
+  VectorType eigenvalues(ImageDimension, 0);
+  MatrixType eigenvectors(ImageDimension, ImageDimension, 0);
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    eigenvectors.set_column( i, eig.get_eigenvector(i) );
+    eigenvalues[i] = eig.get_eigenvalue(i);
+    }
+  labelGeometry.m_Eigenvalues = eigenvalues;
+  labelGeometry.m_Eigenvectors = eigenvectors;
+
+  itk::FixedArray< float, ImageDimension > axesLength;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    axesLength[i] = 4 * std::sqrt(eigenvalues[i]);
+    }
+  labelGeometry.m_AxesLength = axesLength;
+
+  // The following three features are currently only meaningful in 2D.
+  labelGeometry.m_Eccentricity = std::sqrt( ( eigenvalues[ImageDimension-1] - eigenvalues[0] ) / eigenvalues[ImageDimension-1] );
+  labelGeometry.m_Elongation = axesLength[ImageDimension-1] / axesLength[0];
+  RealType orientation = std::atan2(eig.get_eigenvector(ImageDimension-1)[1], eig.get_eigenvector(ImageDimension-1)[0]);
+  // Change the orientation from being between -pi to pi to being from 0 to pi.
+  // We can add pi because the orientation of the major axis is symmetric about the origin.
+  labelGeometry.m_Orientation = orientation < 0.0 ? orientation + vnl_math::pi : orientation;
+
+  return eig;
+}
+
+template< typename TLabelImage, typename TIntensityImage >
+void
+LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
+::SetOrientedBoundingBox(BoundingBoxFloatType transformedBoundingBox, LabelGeometry & labelGeometry) const
+{
   // Add 0.5 pixel buffers on each side of the bounding box to be sure to
   // encompass the pixels and not cut through them.
   for ( unsigned int i = 0; i < ( 2 * ImageDimension ); i += 2 )
@@ -631,7 +659,7 @@ LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
 
   // Transform the transformed bounding box vertices back to the
   // original coordinate system.
-  MatrixType orientedBoundingBoxVertices = inverseRotationMatrix * transformedBoundingBoxVertices;
+  MatrixType orientedBoundingBoxVertices = labelGeometry.m_RotationMatrix.transpose() * transformedBoundingBoxVertices;
 
   // Add the centroid back to each of the vertices since it was
   // subtracted when the points were rotated.
@@ -651,8 +679,283 @@ LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
     {
     labelGeometry.m_OrientedBoundingBoxOrigin[i] = transformedBoundingBox[2 * i] + labelGeometry.m_Centroid[i];
     }
+}
 
-  return true;
+template< typename TLabelImage, typename TIntensityImage >
+void
+LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
+::GenerateDataStreamed()
+{
+  const TLabelImage *     labelImage = this->GetInput();
+  const TIntensityImage * intensityImage = this->GetIntensityInput();
+  const LabelRegionType   bufferedRegion = labelImage->GetBufferedRegion();
+  const long long         sliceCount = static_cast< long long >( bufferedRegion.GetSize(ImageDimension - 1) );
+
+  typedef std::unordered_map< LabelPixelType, MomentAccumulator > AccumulatorMapType;
+
+  // First pass: accumulate the moments of all labels. Each thread
+  // processes whole slices (along the last dimension) into its own
+  // accumulators, which are merged in the end.
+  AccumulatorMapType accumulators;
+#pragma omp parallel
+  {
+    AccumulatorMapType threadAccumulators;
+#pragma omp for schedule(dynamic, 1)
+    for ( long long slice = 0; slice < sliceCount; ++slice )
+      {
+      LabelRegionType sliceRegion = bufferedRegion;
+      sliceRegion.SetIndex(ImageDimension - 1, bufferedRegion.GetIndex(ImageDimension - 1) + slice);
+      sliceRegion.SetSize(ImageDimension - 1, 1);
+      ImageRegionConstIteratorWithIndex< TLabelImage > labelIt(labelImage, sliceRegion);
+      ImageRegionConstIterator< TIntensityImage > intensityIt;
+      if ( intensityImage )
+        {
+        intensityIt = ImageRegionConstIterator< TIntensityImage >(intensityImage, sliceRegion);
+        }
+      // neighbouring pixels mostly share their label, so cache the last accumulator
+      LabelPixelType lastLabel = 0;
+      MomentAccumulator * accumulator = nullptr;
+      for ( ; !labelIt.IsAtEnd(); ++labelIt )
+        {
+        const LabelPixelType label = labelIt.Get();
+        if ( label != 0 )
+          {
+          if ( !accumulator || label != lastLabel )
+            {
+            accumulator = &threadAccumulators[label];
+            lastLabel = label;
+            }
+          const LabelIndexType index = labelIt.GetIndex();
+          accumulator->Add(index);
+          if ( intensityImage )
+            {
+            const RealType value = static_cast< RealType >( intensityIt.Get() );
+            accumulator->sum += value;
+            for ( unsigned int i = 0; i < ImageDimension; i++ )
+              {
+              accumulator->firstOrderWeighted[i] += index[i] * ( typename LabelIndexType::IndexValueType )value;
+              }
+            }
+          }
+        if ( intensityImage )
+          {
+          ++intensityIt;
+          }
+        }
+      }
+#pragma omp critical
+    {
+    for ( typename AccumulatorMapType::const_iterator it = threadAccumulators.begin();
+          it != threadAccumulators.end(); ++it )
+      {
+      accumulators[it->first].Merge(it->second);
+      }
+    }
+  }
+
+  m_AllLabels.reserve( accumulators.size() );
+  for ( typename AccumulatorMapType::const_iterator it = accumulators.begin(); it != accumulators.end(); ++it )
+    {
+    m_AllLabels.push_back(it->first);
+    }
+  std::sort( m_AllLabels.begin(), m_AllLabels.end() );
+
+  // If there is no intensity input defined, the oriented
+  // intensity regions cannot be calculated.
+  if ( !intensityImage )
+    {
+    if ( m_CalculateOrientedIntensityRegions )
+      {
+      std::cerr
+      << "ERROR: An input intensity image must be used in order to calculate the oriented intensity image."
+      << std::endl;
+      }
+    m_CalculateOrientedIntensityRegions = false;
+    }
+
+  // Calculate the geometrical values from the accumulated moments.
+  const size_t labelCount = m_AllLabels.size();
+  m_LabelGeometryMapper.reserve(labelCount);
+  std::vector< LabelGeometry * > geometries(labelCount);
+  for ( size_t l = 0; l < labelCount; ++l )
+    {
+    const MomentAccumulator & accumulator = accumulators[m_AllLabels[l]];
+    LabelGeometry & labelGeometry = m_LabelGeometryMapper[m_AllLabels[l]];
+    geometries[l] = &labelGeometry;
+    labelGeometry.m_Label = m_AllLabels[l];
+    labelGeometry.m_ZeroOrderMoment = accumulator.count;
+    labelGeometry.m_BoundingBox = accumulator.boundingBox;
+    labelGeometry.m_FirstOrderRawMoments = accumulator.firstOrder;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        labelGeometry.m_SecondOrderRawMoments(i, j) = static_cast< double >( accumulator.secondOrder[i][j] );
+        }
+      }
+    labelGeometry.m_Sum = accumulator.sum;
+    labelGeometry.m_FirstOrderWeightedRawMoments = accumulator.firstOrderWeighted;
+
+    vnl_symmetric_eigensystem< double > eig = this->CalculateMoments(labelGeometry, intensityImage != nullptr);
+    if ( m_CalculateOrientedBoundingBox == true )
+      {
+      labelGeometry.m_RotationMatrix = CalculateRotationMatrix< TLabelImage, TIntensityImage >(eig);
+      }
+    }
+  AccumulatorMapType().swap(accumulators);
+
+  if ( m_CalculateOrientedBoundingBox == true )
+    {
+    // Second pass: find the bounding box of each label in the coordinate
+    // system defined by its eigenvectors, by rotating each pixel location
+    // (relative to the centroid of its label) with the rotation matrix.
+    std::unordered_map< LabelPixelType, size_t > labelPositions;
+    labelPositions.reserve(labelCount);
+    std::vector< double > rotations(labelCount * ImageDimension * ImageDimension);
+    std::vector< double > centroids(labelCount * ImageDimension);
+    std::vector< double > transformedBounds(labelCount * 2 * ImageDimension);
+    for ( size_t l = 0; l < labelCount; ++l )
+      {
+      labelPositions[m_AllLabels[l]] = l;
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        centroids[l * ImageDimension + i] = geometries[l]->m_Centroid[i];
+        transformedBounds[l * 2 * ImageDimension + 2 * i] = NumericTraits< double >::max();
+        transformedBounds[l * 2 * ImageDimension + 2 * i + 1] = NumericTraits< double >::NonpositiveMin();
+        for ( unsigned int k = 0; k < ImageDimension; k++ )
+          {
+          rotations[( l * ImageDimension + i ) * ImageDimension + k] = geometries[l]->m_RotationMatrix(i, k);
+          }
+        }
+      }
+#pragma omp parallel
+    {
+      std::vector< double > threadBounds(transformedBounds);
+#pragma omp for schedule(dynamic, 1)
+      for ( long long slice = 0; slice < sliceCount; ++slice )
+        {
+        LabelRegionType sliceRegion = bufferedRegion;
+        sliceRegion.SetIndex(ImageDimension - 1, bufferedRegion.GetIndex(ImageDimension - 1) + slice);
+        sliceRegion.SetSize(ImageDimension - 1, 1);
+        ImageRegionConstIteratorWithIndex< TLabelImage > labelIt(labelImage, sliceRegion);
+        LabelPixelType lastLabel = 0;
+        size_t         l = 0;
+        for ( ; !labelIt.IsAtEnd(); ++labelIt )
+          {
+          const LabelPixelType label = labelIt.Get();
+          if ( label == 0 )
+            {
+            continue;
+            }
+          if ( label != lastLabel )
+            {
+            l = labelPositions.find(label)->second;
+            lastLabel = label;
+            }
+          const LabelIndexType index = labelIt.GetIndex();
+          double               location[ImageDimension];
+          for ( unsigned int k = 0; k < ImageDimension; k++ )
+            {
+            location[k] = index[k] - centroids[l * ImageDimension + k];
+            }
+          double * bounds = &threadBounds[l * 2 * ImageDimension];
+          for ( unsigned int i = 0; i < ImageDimension; i++ )
+            {
+            const double * rotation = &rotations[( l * ImageDimension + i ) * ImageDimension];
+            double         transformed = 0;
+            for ( unsigned int k = 0; k < ImageDimension; k++ )
+              {
+              transformed += rotation[k] * location[k];
+              }
+            bounds[2 * i] = std::min(bounds[2 * i], transformed);
+            bounds[2 * i + 1] = std::max(bounds[2 * i + 1], transformed);
+            }
+          }
+        }
+#pragma omp critical
+      {
+      for ( size_t b = 0; b < transformedBounds.size(); b += 2 )
+        {
+        transformedBounds[b] = std::min(transformedBounds[b], threadBounds[b]);
+        transformedBounds[b + 1] = std::max(transformedBounds[b + 1], threadBounds[b + 1]);
+        }
+      }
+    }
+    for ( size_t l = 0; l < labelCount; ++l )
+      {
+      BoundingBoxFloatType transformedBoundingBox;
+      for ( unsigned int i = 0; i < 2 * ImageDimension; i++ )
+        {
+        transformedBoundingBox[i] = static_cast< float >( transformedBounds[l * 2 * ImageDimension + i] );
+        }
+      this->SetOrientedBoundingBox(transformedBoundingBox, *geometries[l]);
+      }
+    }
+
+  if ( m_CalculateOrientedLabelRegions == true || m_CalculateOrientedIntensityRegions == true )
+    {
+    for ( size_t l = 0; l < labelCount; ++l )
+      {
+      vnl_symmetric_eigensystem< double > eig(geometries[l]->m_SecondOrderCentralMoments);
+      if ( m_CalculateOrientedLabelRegions == true )
+        {
+        CalculateOrientedImage< TLabelImage, TIntensityImage, LabelImageType >(
+          this, eig, *geometries[l], true);
+        }
+      if ( m_CalculateOrientedIntensityRegions == true )
+        {
+        CalculateOrientedImage< TLabelImage, TIntensityImage, IntensityImageType >(
+          this, eig, *geometries[l], false);
+        }
+      }
+    }
+}
+
+template< typename TLabelImage, typename TIntensityImage >
+std::vector< typename LabelGeometryImageFilter2< TLabelImage, TIntensityImage >::LabelGeometryRecord >
+LabelGeometryImageFilter2< TLabelImage, TIntensityImage >
+::GetLabelGeometryRecords() const
+{
+  std::vector< LabelGeometryRecord > records( m_AllLabels.size() );
+  for ( size_t l = 0; l < m_AllLabels.size(); ++l )
+    {
+    const LabelGeometry & labelGeometry = m_LabelGeometryMapper.find(m_AllLabels[l])->second;
+    LabelGeometryRecord & record = records[l];
+    record.label = m_AllLabels[l];
+    record.volume = labelGeometry.m_ZeroOrderMoment;
+    record.integratedIntensity = labelGeometry.m_Sum;
+    record.eccentricity = labelGeometry.m_Eccentricity;
+    record.elongation = labelGeometry.m_Elongation;
+    record.orientation = labelGeometry.m_Orientation;
+    record.boundingBoxVolume = labelGeometry.m_BoundingBoxVolume;
+    record.orientedBoundingBoxVolume = labelGeometry.m_OrientedBoundingBoxVolume;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      record.centroid[i] = labelGeometry.m_Centroid[i];
+      record.weightedCentroid[i] = labelGeometry.m_WeightedCentroid[i];
+      record.eigenvalues[i] = labelGeometry.m_Eigenvalues[i];
+      record.axesLength[i] = labelGeometry.m_AxesLength[i];
+      record.boundingBoxSize[i] = labelGeometry.m_BoundingBoxSize[i];
+      record.orientedBoundingBoxSize[i] = labelGeometry.m_OrientedBoundingBoxSize[i];
+      record.orientedBoundingBoxOrigin[i] = labelGeometry.m_OrientedBoundingBoxOrigin[i];
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        record.eigenvectors[i][j] = labelGeometry.m_Eigenvectors(i, j);
+        }
+      }
+    for ( unsigned int i = 0; i < 2 * ImageDimension; i++ )
+      {
+      record.boundingBox[i] = labelGeometry.m_BoundingBox[i];
+      }
+    for ( unsigned int v = 0; v < NumberOfOrientedBoundingBoxVertices; v++ )
+      {
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        record.orientedBoundingBoxVertices[v][j] = labelGeometry.m_OrientedBoundingBoxVertices[v][j];
+        }
+      }
+    }
+  return records;
 }
 
 template< typename TLabelImage, typename TIntensityImage >
@@ -1145,6 +1448,7 @@ LabelGeometryImageFilter2< TImage, TLabelImage >
 {
   Superclass::PrintSelf(os, indent);
 
+  os << indent << "StreamingAccumulation: " << m_StreamingAccumulation << std::endl;
   os << indent << "Number of labels: " << m_LabelGeometryMapper.size()
      << std::endl;
 
@@ -0,0 +1,9 @@
+if (openiA_TESTING_ENABLED)
+	get_filename_component(CoreSrcDir "../libs/base" REALPATH BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
+	add_executable(BoneThicknessBVHTest BoneThickness/iABoneThicknessBVHTest.cpp BoneThickness/iABoneThicknessBVH.cpp)
+	target_include_directories(BoneThicknessBVHTest PRIVATE ${CoreSrcDir})   # for iASimpleTester.h
+	add_test(NAME BoneThicknessBVHTest COMMAND BoneThicknessBVHTest)
+	if (openiA_USE_IDE_FOLDERS)
+		set_property(TARGET BoneThicknessBVHTest PROPERTY FOLDER "Tests")
+	endif()
+endif()
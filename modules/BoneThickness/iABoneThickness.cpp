@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iABoneThickness.h"
 
+#include "iABoneThicknessBVH.h"
 #include "iABoneThicknessChartBar.h"
 #include "iABoneThicknessTable.h"
 #include "iABoneThicknessMouseInteractor.h"
@@ -15,6 +16,7 @@
 
 #include <vtkOBBTree.h> // new instead of CellLocator
 
+#include <vtkCellArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkFloatArray.h>
 #include <vtkPointData.h>
@@ -30,10 +32,16 @@
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSphereSource.h>
+#include <vtkStaticPointLocator.h>
 #include <vtkTable.h>
 #include <vtkTubeFilter.h>
 #include <qvector.h>
 
+#include <algorithm>
+#include <cmath>
+
+const char* iABoneThickness::ThicknessArrayName = "Thickness";
+const char* iABoneThickness::SurfaceDistanceArrayName = "Surface distance";
 
 iABoneThickness::iABoneThickness()
 {
@@ -44,6 +52,8 @@ iABoneThickness::iABoneThickness()
 	std::fill(m_pRange, m_pRange+3, 0.0);
 }
 
+iABoneThickness::~iABoneThickness() = default;
+
 double iABoneThickness::axisXMax() const
 {
 	return m_pBound[1];
@@ -272,6 +282,166 @@ void iABoneThickness::calculate()
 
 	}
 }
+
+void iABoneThickness::calculateSurface(const int& _iDecimationLevel)
+{
+	if (!m_pPolyData)
+	{
+		return;
+	}
+	const vtkIdType idPoints(m_pPolyData->GetNumberOfPoints());
+
+	// Build ray casting structure over all triangles once (polygons are triangulated as fans)
+	if (!m_pSurfaceBVH)
+	{
+		std::vector<double> vPoints(3 * idPoints);
+		for (vtkIdType id(0); id < idPoints; ++id)
+		{
+			m_pPolyData->GetPoint(id, vPoints.data() + 3 * id);
+		}
+		std::vector<int> vTriangles;
+		vtkCellArray* pPolys(m_pPolyData->GetPolys());
+		vtkIdType idCellSize;
+		const vtkIdType* pCell;
+		for (pPolys->InitTraversal(); pPolys->GetNextCell(idCellSize, pCell);)
+		{
+			for (vtkIdType i(2); i < idCellSize; ++i)
+			{
+				vTriangles.push_back(static_cast<int>(pCell[0]));
+				vTriangles.push_back(static_cast<int>(pCell[i - 1]));
+				vTriangles.push_back(static_cast<int>(pCell[i]));
+			}
+		}
+		m_pSurfaceBVH.reset(new iABoneThicknessBVH(vPoints, vTriangles));
+	}
+
+	// Vertex normals: sum of the normals of the adjacent triangles, weighted by triangle area
+	std::vector<double> vNormals(3 * idPoints, 0.0);
+	for (int t(0); t < m_pSurfaceBVH->triangleCount(); ++t)
+	{
+		const int* pTriangle(m_pSurfaceBVH->triangle(t));
+		double pVertex[3][3];
+		for (int v(0); v < 3; ++v)
+		{
+			m_pPolyData->GetPoint(pTriangle[v], pVertex[v]);
+		}
+		double pEdge1[3], pEdge2[3], pNormal[3];
+		vtkMath::Subtract(pVertex[1], pVertex[0], pEdge1);
+		vtkMath::Subtract(pVertex[2], pVertex[0], pEdge2);
+		vtkMath::Cross(pEdge1, pEdge2, pNormal);
+		for (int v(0); v < 3; ++v)
+		{
+			vtkMath::Add(vNormals.data() + 3 * pTriangle[v], pNormal, vNormals.data() + 3 * pTriangle[v]);
+		}
+	}
+
+	vtkSmartPointer<vtkDoubleArray> daThickness(vtkSmartPointer<vtkDoubleArray>::New());
+	daThickness->SetName(ThicknessArrayName);
+	daThickness->SetNumberOfTuples(idPoints);
+	vtkSmartPointer<vtkDoubleArray> daDistance(vtkSmartPointer<vtkDoubleArray>::New());
+	daDistance->SetName(SurfaceDistanceArrayName);
+	daDistance->SetNumberOfTuples(idPoints);
+	double* pThickness(daThickness->GetPointer(0));
+	double* pDistance(daDistance->GetPointer(0));
+
+	// length of the normal vector for intersection test
+	const double dLength(0.5 * m_dRangeMax);
+	const long long llStride(1LL << std::min(std::max(_iDecimationLevel, 0), 30));
+	const long long llEvaluated((idPoints + llStride - 1) / llStride);
+	const iABoneThicknessBVH& bvh(*m_pSurfaceBVH);
+
+#pragma omp parallel
+	{
+		iABoneThicknessBVH::Scratch scratch;
+#pragma omp for schedule(dynamic, 1024)
+		for (long long i = 0; i < llEvaluated; ++i)
+		{
+			const vtkIdType id(i * llStride);
+			double pPoint[3];
+			m_pPolyData->GetPoint(id, pPoint);
+			double pOutward[3] = { vNormals[3 * id], vNormals[3 * id + 1], vNormals[3 * id + 2] };
+			pThickness[id] = pDistance[id] = 0.0;
+			if (vtkMath::Normalize(pOutward) == 0.0)
+			{
+				continue;    // vertex not part of any triangle
+			}
+			double pInward[3] = { -pOutward[0], -pOutward[1], -pOutward[2] };
+			iABoneThicknessBVH::Hit hitInward(bvh.firstHit(pPoint, pInward, dLength, static_cast<int>(id), scratch));
+			iABoneThicknessBVH::Hit hitOutward(bvh.firstHit(pPoint, pOutward, dLength, static_cast<int>(id), scratch));
+			// for inward oriented triangles, the ray along the normal is the one leaving the surface on the other side
+			if ((hitInward.triangle < 0 || !hitInward.exiting) && hitOutward.triangle >= 0 && hitOutward.exiting)
+			{
+				std::swap(hitInward, hitOutward);
+			}
+			const double dThickness((hitInward.triangle >= 0 && hitInward.exiting) ? hitInward.distance : 0.0);
+			const double dDistance((hitOutward.triangle >= 0 && !hitOutward.exiting) ? hitOutward.distance : 0.0);
+			if ((m_dThicknessMaximum < FloatTolerance) || (dThickness < m_dThicknessMaximum))
+			{
+				pThickness[id] = dThickness;
+			}
+			if ((m_dSurfaceDistanceMaximum < FloatTolerance) || (dDistance < m_dSurfaceDistanceMaximum))
+			{
+				pDistance[id] = dDistance;
+			}
+		}
+	}
+
+	// Vertices left out by the decimation take over the values of the closest evaluated vertex
+	if (llStride > 1)
+	{
+		vtkSmartPointer<vtkPoints> pEvaluatedPoints(vtkSmartPointer<vtkPoints>::New());
+		pEvaluatedPoints->SetNumberOfPoints(llEvaluated);
+		for (long long i = 0; i < llEvaluated; ++i)
+		{
+			pEvaluatedPoints->SetPoint(i, m_pPolyData->GetPoint(i * llStride));
+		}
+		vtkSmartPointer<vtkPolyData> pEvaluated(vtkSmartPointer<vtkPolyData>::New());
+		pEvaluated->SetPoints(pEvaluatedPoints);
+		// vtkStaticPointLocator (unlike vtkPointLocator) supports concurrent queries once it is built
+		vtkSmartPointer<vtkStaticPointLocator> pPointLocator(vtkSmartPointer<vtkStaticPointLocator>::New());
+		pPointLocator->SetDataSet(pEvaluated);
+		pPointLocator->BuildLocator();
+		const long long llPoints(idPoints);
+#pragma omp parallel for schedule(dynamic, 1024)
+		for (long long id = 0; id < llPoints; ++id)
+		{
+			if (id % llStride != 0)
+			{
+				double pPoint[3];
+				m_pPolyData->GetPoint(id, pPoint);
+				const vtkIdType idClosest(pPointLocator->FindClosestPoint(pPoint) * llStride);
+				pThickness[id] = pThickness[idClosest];
+				pDistance[id] = pDistance[idClosest];
+			}
+		}
+	}
+
+	// Mean and STD of the evaluated vertices
+	double dThicknessSum(0.0), dDistanceSum(0.0);
+	for (long long i = 0; i < llEvaluated; ++i)
+	{
+		dThicknessSum += pThickness[i * llStride];
+		dDistanceSum += pDistance[i * llStride];
+	}
+	m_dThicknessMean = (llEvaluated > 0) ? dThicknessSum / llEvaluated : 0.0;
+	m_dSurfaceDistanceMean = (llEvaluated > 0) ? dDistanceSum / llEvaluated : 0.0;
+	double dThicknessVar(0.0), dDistanceVar(0.0);
+	for (long long i = 0; i < llEvaluated; ++i)
+	{
+		dThicknessVar += (pThickness[i * llStride] - m_dThicknessMean) * (pThickness[i * llStride] - m_dThicknessMean);
+		dDistanceVar += (pDistance[i * llStride] - m_dSurfaceDistanceMean) * (pDistance[i * llStride] - m_dSurfaceDistanceMean);
+	}
+	m_dThicknessSTD = (llEvaluated > 1) ? std::sqrt(dThicknessVar / (llEvaluated - 1)) : 0.0;
+	m_dSurfaceDistanceSTD = (llEvaluated > 1) ? std::sqrt(dDistanceVar / (llEvaluated - 1)) : 0.0;
+
+	m_pPolyData->GetPointData()->RemoveArray(ThicknessArrayName);
+	m_pPolyData->GetPointData()->RemoveArray(SurfaceDistanceArrayName);
+	m_pPolyData->GetPointData()->AddArray(daThickness);
+	m_pPolyData->GetPointData()->AddArray(daDistance);
+	m_pPolyData->GetPointData()->SetActiveScalars(ThicknessArrayName);
+	m_pPolyData->Modified();
+}
+
 bool iABoneThickness::getNormalFromPCA(vtkIdList* _pIdList, double* _pNormal)
 {
 	const vtkIdType idList(_pIdList->GetNumberOfIds());
@@ -466,6 +636,7 @@ void iABoneThickness::set(iARenderer* _iARenderer, vtkPolyData* _pPolyData, iABo
 
 	m_pPolyData = _pPolyData;
 	m_pPolyData->GetBounds(m_pBound);
+	m_pSurfaceBVH.reset();
 
 	m_pRange[0] = m_pBound[1] - m_pBound[0];
 	m_pRange[1] = m_pBound[3] - m_pBound[2];
@@ -6,6 +6,8 @@
 
 #include <QVector>
 
+#include <memory>
+
 class vtkActorCollection;
 class vtkDoubleArray;
 class vtkIdList;
@@ -16,6 +18,7 @@ class vtkPolyData;
 
 class iARenderer;
 
+class iABoneThicknessBVH;
 class iABoneThicknessChartBar;
 class iABoneThicknessTable;
 
@@ -25,6 +28,7 @@ class iABoneThickness
 
 public:
 	iABoneThickness();
+	~iABoneThickness();
 	double axisXMax() const;
 	double axisXMin() const;
 	double axisYMax() const;
@@ -38,6 +42,13 @@ public:
 	double stdSurfaceDistance() const;
 
 	void calculate();
+	//! Computes thickness and surface distance for the vertices of the mesh, and stores them as point data arrays
+	//! (ThicknessArrayName, SurfaceDistanceArrayName) of the mesh, with the thickness as active scalars.
+	//! The thickness is the distance from a vertex, against its normal, to the opposite side of the surface;
+	//! the surface distance is the distance from a vertex, along its normal, to the next surface outside.
+	//! @param _iDecimationLevel only every 2^level-th vertex is evaluated, the others take over the values of the
+	//!        closest evaluated vertex; 0 evaluates all vertices
+	void calculateSurface(const int& _iDecimationLevel);
 
 	vtkDoubleArray* thickness();
 
@@ -75,6 +86,9 @@ public:
 	double thicknessMaximum() const;
 	double surfaceDistanceMaximum() const;
 
+	static const char* ThicknessArrayName;
+	static const char* SurfaceDistanceArrayName;
+
 private:
 	double m_pColorNormal[3];
 	double m_pColorSelected[3];
@@ -101,6 +115,8 @@ private:
 	vtkIdType m_idSelected = -1;
 
 	vtkPolyData* m_pPolyData = nullptr;
+	//! ray casting structure over the mesh triangles, built on first use of calculateSurface
+	std::unique_ptr<iABoneThicknessBVH> m_pSurfaceBVH;
 
 	vtkSmartPointer<vtkDoubleArray> m_daDistance;
 	vtkSmartPointer<vtkDoubleArray> m_daThickness;
@@ -0,0 +1,248 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iABoneThicknessBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	//! maximum number of triangles in a leaf
+	const int LeafSize = 4;
+	//! tolerance for the barycentric coordinates, so that rays through shared edges and vertices hit a triangle
+	const double BarycentricTolerance = 1e-9;
+	//! hits closer to the ray origin than this fraction of the mesh extent are considered to be at the origin itself
+	const double RelativeMinDistance = 1e-9;
+
+	void cross(double const a[3], double const b[3], double result[3])
+	{
+		result[0] = a[1] * b[2] - a[2] * b[1];
+		result[1] = a[2] * b[0] - a[0] * b[2];
+		result[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	double dot(double const a[3], double const b[3])
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	//! distance along the ray at which it enters the box, or a negative value if it misses the box within maxDistance
+	double enterBox(double const bounds[6], double const origin[3], double const direction[3], double maxDistance)
+	{
+		double tNear = 0.0, tFar = maxDistance;
+		for (int a = 0; a < 3; ++a)
+		{
+			if (direction[a] == 0.0)
+			{
+				if (origin[a] < bounds[2 * a] || origin[a] > bounds[2 * a + 1])
+				{
+					return -1.0;
+				}
+				continue;
+			}
+			double t0 = (bounds[2 * a] - origin[a]) / direction[a];
+			double t1 = (bounds[2 * a + 1] - origin[a]) / direction[a];
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			tNear = std::max(tNear, t0);
+			tFar = std::min(tFar, t1);
+			if (tNear > tFar)
+			{
+				return -1.0;
+			}
+		}
+		return tNear;
+	}
+}
+
+iABoneThicknessBVH::iABoneThicknessBVH(std::vector<double> const& points, std::vector<int> const& triangles) :
+	m_points(points),
+	m_triangles(triangles)
+{
+	int count = triangleCount();
+	m_order.resize(count);
+	std::vector<double> centroids(3 * static_cast<size_t>(count));
+	for (int t = 0; t < count; ++t)
+	{
+		m_order[t] = t;
+		for (int a = 0; a < 3; ++a)
+		{
+			centroids[3 * t + a] = (m_points[3 * m_triangles[3 * t] + a] + m_points[3 * m_triangles[3 * t + 1] + a] +
+				m_points[3 * m_triangles[3 * t + 2] + a]) / 3.0;
+		}
+	}
+	m_nodes.reserve(count > 0 ? 2 * (count / LeafSize + 1) : 1);
+	m_minDistance = 0.0;
+	if (count > 0)
+	{
+		build(0, count, centroids);
+		Node const& root = m_nodes[0];
+		double extent[3] = {root.bounds[1] - root.bounds[0], root.bounds[3] - root.bounds[2], root.bounds[5] - root.bounds[4]};
+		m_minDistance = RelativeMinDistance * std::sqrt(dot(extent, extent));
+	}
+}
+
+int iABoneThicknessBVH::build(int begin, int end, std::vector<double> const& centroids)
+{
+	int nodeIdx = static_cast<int>(m_nodes.size());
+	m_nodes.push_back(Node());
+	Node node;
+	double centroidBounds[6];
+	for (int a = 0; a < 3; ++a)
+	{
+		node.bounds[2 * a] = centroidBounds[2 * a] = std::numeric_limits<double>::max();
+		node.bounds[2 * a + 1] = centroidBounds[2 * a + 1] = std::numeric_limits<double>::lowest();
+	}
+	for (int i = begin; i < end; ++i)
+	{
+		int t = m_order[i];
+		for (int a = 0; a < 3; ++a)
+		{
+			for (int v = 0; v < 3; ++v)
+			{
+				double coord = m_points[3 * m_triangles[3 * t + v] + a];
+				node.bounds[2 * a] = std::min(node.bounds[2 * a], coord);
+				node.bounds[2 * a + 1] = std::max(node.bounds[2 * a + 1], coord);
+			}
+			centroidBounds[2 * a] = std::min(centroidBounds[2 * a], centroids[3 * t + a]);
+			centroidBounds[2 * a + 1] = std::max(centroidBounds[2 * a + 1], centroids[3 * t + a]);
+		}
+	}
+	int axis = 0;
+	for (int a = 1; a < 3; ++a)
+	{
+		if (centroidBounds[2 * a + 1] - centroidBounds[2 * a] > centroidBounds[2 * axis + 1] - centroidBounds[2 * axis])
+		{
+			axis = a;
+		}
+	}
+	if (end - begin <= LeafSize || centroidBounds[2 * axis + 1] <= centroidBounds[2 * axis])
+	{
+		node.first = begin;
+		node.count = end - begin;
+		m_nodes[nodeIdx] = node;
+		return nodeIdx;
+	}
+	// split at the median centroid along the axis of largest extent:
+	int mid = begin + (end - begin) / 2;
+	std::nth_element(m_order.begin() + begin, m_order.begin() + mid, m_order.begin() + end,
+		[&centroids, axis](int t1, int t2) { return centroids[3 * t1 + axis] < centroids[3 * t2 + axis]; });
+	node.count = 0;
+	build(begin, mid, centroids);
+	node.first = build(mid, end, centroids);
+	m_nodes[nodeIdx] = node;
+	return nodeIdx;
+}
+
+int iABoneThicknessBVH::triangleCount() const
+{
+	return static_cast<int>(m_triangles.size() / 3);
+}
+
+int const* iABoneThicknessBVH::triangle(int triangleIdx) const
+{
+	return m_triangles.data() + 3 * triangleIdx;
+}
+
+bool iABoneThicknessBVH::intersectTriangle(int triangleIdx, double const origin[3], double const direction[3],
+	double& distance, bool& exiting) const
+{
+	// Moeller-Trumbore ray/triangle intersection
+	double const* v0 = m_points.data() + 3 * m_triangles[3 * triangleIdx];
+	double const* v1 = m_points.data() + 3 * m_triangles[3 * triangleIdx + 1];
+	double const* v2 = m_points.data() + 3 * m_triangles[3 * triangleIdx + 2];
+	double e1[3] = {v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]};
+	double e2[3] = {v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]};
+	double p[3];
+	cross(direction, e2, p);
+	double det = dot(e1, p);
+	if (det == 0.0)
+	{
+		return false;    // ray parallel to triangle plane
+	}
+	double invDet = 1.0 / det;
+	double s[3] = {origin[0] - v0[0], origin[1] - v0[1], origin[2] - v0[2]};
+	double u = dot(s, p) * invDet;
+	if (u < -BarycentricTolerance || u > 1.0 + BarycentricTolerance)
+	{
+		return false;
+	}
+	double q[3];
+	cross(s, e1, q);
+	double v = dot(direction, q) * invDet;
+	if (v < -BarycentricTolerance || u + v > 1.0 + BarycentricTolerance)
+	{
+		return false;
+	}
+	distance = dot(e2, q) * invDet;
+	exiting = det < 0.0;    // det = -dot(direction, e1 x e2)
+	return distance > m_minDistance;
+}
+
+iABoneThicknessBVH::Hit iABoneThicknessBVH::firstHit(double const origin[3], double const direction[3],
+	double maxDistance, int skipVertex, Scratch& scratch) const
+{
+	Hit hit;
+	if (m_nodes.empty())
+	{
+		return hit;
+	}
+	double closest = maxDistance;
+	scratch.stack.clear();
+	scratch.stack.push_back(0);
+	while (!scratch.stack.empty())
+	{
+		int nodeIdx = scratch.stack.back();
+		scratch.stack.pop_back();
+		Node const& node = m_nodes[nodeIdx];
+		double enter = enterBox(node.bounds, origin, direction, closest);
+		if (enter < 0.0)
+		{
+			continue;
+		}
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; ++i)
+			{
+				int t = m_order[i];
+				int const* tri = triangle(t);
+				if (tri[0] == skipVertex || tri[1] == skipVertex || tri[2] == skipVertex)
+				{
+					continue;
+				}
+				double distance;
+				bool exiting;
+				if (intersectTriangle(t, origin, direction, distance, exiting) && distance < closest)
+				{
+					closest = distance;
+					hit.triangle = t;
+					hit.distance = distance;
+					hit.exiting = exiting;
+				}
+			}
+			continue;
+		}
+		// visit the nearer child first (it is pushed last):
+		int left = nodeIdx + 1, right = node.first;
+		double enterLeft = enterBox(m_nodes[left].bounds, origin, direction, closest);
+		double enterRight = enterBox(m_nodes[right].bounds, origin, direction, closest);
+		if (enterLeft >= 0.0 && enterRight >= 0.0)
+		{
+			bool leftFirst = enterLeft <= enterRight;
+			scratch.stack.push_back(leftFirst ? right : left);
+			scratch.stack.push_back(leftFirst ? left : right);
+		}
+		else if (enterLeft >= 0.0)
+		{
+			scratch.stack.push_back(left);
+		}
+		else if (enterRight >= 0.0)
+		{
+			scratch.stack.push_back(right);
+		}
+	}
+	return hit;
+}
@@ -0,0 +1,56 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <vector>
+
+//! Bounding volume hierarchy over the triangles of a mesh, for casting many rays against the same surface.
+//! Built once; queries only read the hierarchy and can therefore be run concurrently, each thread passing its
+//! own iABoneThicknessBVH::Scratch.
+class iABoneThicknessBVH
+{
+public:
+	//! first intersection of a ray with the surface
+	struct Hit
+	{
+		int triangle = -1;       //!< index of the triangle hit, -1 if there is no hit
+		double distance = 0.0;   //!< distance from the ray origin to the hit point
+		bool exiting = false;    //!< whether the ray leaves the surface there (i.e. the triangle normal points along the ray)
+	};
+	//! per-thread memory used during queries
+	struct Scratch
+	{
+		std::vector<int> stack;
+	};
+
+	//! Builds the hierarchy.
+	//! @param points the coordinates of the mesh vertices (x, y, z for each vertex)
+	//! @param triangles the vertex indices of the triangles (three per triangle)
+	iABoneThicknessBVH(std::vector<double> const& points, std::vector<int> const& triangles);
+	int triangleCount() const;
+	//! the vertex indices of the given triangle
+	int const* triangle(int triangleIdx) const;
+	//! Finds the first intersection of the ray from the given origin along the given (normalized) direction.
+	//! @param origin the ray origin
+	//! @param direction the normalized ray direction
+	//! @param maxDistance only intersections closer to the origin than this are considered
+	//! @param skipVertex triangles containing this vertex are ignored (e.g. the vertex the ray starts from); -1 for none
+	//! @param scratch per-thread memory
+	Hit firstHit(double const origin[3], double const direction[3], double maxDistance, int skipVertex, Scratch& scratch) const;
+
+private:
+	struct Node
+	{
+		double bounds[6];   //!< xmin, xmax, ymin, ymax, zmin, zmax
+		int first;          //!< for leaves, the index of the first triangle in m_order; for inner nodes, the second child
+		int count;          //!< number of triangles for leaves, 0 for inner nodes (whose first child directly follows them)
+	};
+	int build(int begin, int end, std::vector<double> const& centroids);
+	bool intersectTriangle(int triangleIdx, double const origin[3], double const direction[3], double& distance, bool& exiting) const;
+
+	std::vector<double> m_points;
+	std::vector<int> m_triangles;
+	std::vector<int> m_order;      //!< triangle indices, ordered such that each leaf references a contiguous range
+	std::vector<Node> m_nodes;
+	double m_minDistance;          //!< hits closer to the ray origin are ignored (the ray starts on the surface)
+};
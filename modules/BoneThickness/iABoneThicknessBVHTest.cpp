@@ -0,0 +1,175 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "iABoneThicknessBVH.h"
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+	//! Adds a sphere, triangulated along latitude and longitude lines, to the given mesh.
+	//! @param inward whether the triangle normals point to the center (as for the inner surface of a shell)
+	void addSphere(std::vector<double>& points, std::vector<int>& triangles, double radius, bool inward)
+	{
+		const int Rings = 24, Segments = 48;
+		const double Pi = 3.14159265358979323846;
+		int const first = static_cast<int>(points.size() / 3);
+		auto addTriangle = [&triangles, inward](int a, int b, int c)
+		{
+			triangles.push_back(a);
+			triangles.push_back(inward ? c : b);
+			triangles.push_back(inward ? b : c);
+		};
+		// poles, then rings 1 .. Rings-1:
+		points.insert(points.end(), {0.0, 0.0, radius, 0.0, 0.0, -radius});
+		for (int r = 1; r < Rings; ++r)
+		{
+			double const theta = Pi * r / Rings;
+			for (int s = 0; s < Segments; ++s)
+			{
+				double const phi = 2 * Pi * s / Segments;
+				points.push_back(radius * std::sin(theta) * std::cos(phi));
+				points.push_back(radius * std::sin(theta) * std::sin(phi));
+				points.push_back(radius * std::cos(theta));
+			}
+		}
+		auto ringVertex = [first](int r, int s) { return first + 2 + (r - 1) * Segments + s % Segments; };
+		for (int s = 0; s < Segments; ++s)
+		{
+			addTriangle(first, ringVertex(1, s), ringVertex(1, s + 1));
+			addTriangle(first + 1, ringVertex(Rings - 1, s + 1), ringVertex(Rings - 1, s));
+			for (int r = 1; r < Rings - 1; ++r)
+			{
+				addTriangle(ringVertex(r, s), ringVertex(r + 1, s), ringVertex(r, s + 1));
+				addTriangle(ringVertex(r, s + 1), ringVertex(r + 1, s), ringVertex(r + 1, s + 1));
+			}
+		}
+	}
+
+	//! first hit found by testing the ray against every triangle, with the same intersection test as the hierarchy
+	iABoneThicknessBVH::Hit bruteForceHit(std::vector<double> const& points, std::vector<int> const& triangles,
+		double const origin[3], double const direction[3], double maxDistance, int skipVertex, double minDistance)
+	{
+		auto cross = [](double const a[3], double const b[3], double r[3])
+		{
+			r[0] = a[1] * b[2] - a[2] * b[1];
+			r[1] = a[2] * b[0] - a[0] * b[2];
+			r[2] = a[0] * b[1] - a[1] * b[0];
+		};
+		auto dot = [](double const a[3], double const b[3]) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+		const double Tolerance = 1e-9;
+		iABoneThicknessBVH::Hit hit;
+		double closest = maxDistance;
+		for (size_t t = 0; t < triangles.size() / 3; ++t)
+		{
+			int const* tri = triangles.data() + 3 * t;
+			if (tri[0] == skipVertex || tri[1] == skipVertex || tri[2] == skipVertex)
+			{
+				continue;
+			}
+			double const* v0 = points.data() + 3 * tri[0];
+			double const* v1 = points.data() + 3 * tri[1];
+			double const* v2 = points.data() + 3 * tri[2];
+			double e1[3] = {v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]};
+			double e2[3] = {v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]};
+			double p[3];
+			cross(direction, e2, p);
+			double det = dot(e1, p);
+			if (det == 0.0)
+			{
+				continue;
+			}
+			double invDet = 1.0 / det;
+			double s[3] = {origin[0] - v0[0], origin[1] - v0[1], origin[2] - v0[2]};
+			double u = dot(s, p) * invDet;
+			if (u < -Tolerance || u > 1.0 + Tolerance)
+			{
+				continue;
+			}
+			double q[3];
+			cross(s, e1, q);
+			double v = dot(direction, q) * invDet;
+			if (v < -Tolerance || u + v > 1.0 + Tolerance)
+			{
+				continue;
+			}
+			double distance = dot(e2, q) * invDet;
+			if (distance > minDistance && distance < closest)
+			{
+				closest = distance;
+				hit.triangle = static_cast<int>(t);
+				hit.distance = distance;
+				hit.exiting = det < 0.0;
+			}
+		}
+		return hit;
+	}
+
+	//! hits are equal if both miss, or both hit the same triangle at the same distance; if the ray passes exactly
+	//! through an edge or vertex shared by several triangles, any of them may be reported, at a distance differing
+	//! by rounding errors only
+	bool sameHit(iABoneThicknessBVH::Hit const& a, iABoneThicknessBVH::Hit const& b)
+	{
+		return (a.triangle < 0 && b.triangle < 0) ||
+			(a.triangle >= 0 && b.triangle >= 0 && a.exiting == b.exiting &&
+			 (a.triangle == b.triangle ? a.distance == b.distance : std::abs(a.distance - b.distance) < 1e-12));
+	}
+}
+
+BEGIN_TEST
+	// a shell as in a bone: outer surface facing outwards, inner surface facing inwards
+	std::vector<double> points;
+	std::vector<int> triangles;
+	addSphere(points, triangles, 1.0, false);
+	addSphere(points, triangles, 0.8, true);
+	iABoneThicknessBVH bvh(points, triangles);
+	TestEqual(bvh.triangleCount(), static_cast<int>(triangles.size() / 3));
+	TestEqual(bvh.triangle(5)[1], triangles[16]);
+	// same as the hierarchy: extent is the diagonal of the bounding box of all vertices
+	double const minDistance = 1e-9 * std::sqrt(3 * 2.0 * 2.0);
+	iABoneThicknessBVH::Scratch scratch;
+
+	// a ray from the center leaves the shell at the outer surface, after entering it at the inner surface:
+	double const center[3] = {0.0, 0.0, 0.0};
+	double const up[3] = {0.3, 0.4, std::sqrt(1 - 0.3 * 0.3 - 0.4 * 0.4)};
+	auto first = bvh.firstHit(center, up, 10.0, -1, scratch);
+	TestAssert(first.triangle >= 0);
+	TestAssert(!first.exiting);
+	TestAssert(first.distance > 0.78 && first.distance <= 0.8);
+	TestAssert(bvh.firstHit(center, up, 0.5, -1, scratch).triangle < 0);   // nothing within maxDistance
+
+	// random rays, and rays from the vertices along the radius (as for the thickness), compared to brute force:
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> coord(-1.2, 1.2);
+	std::normal_distribution<double> dir(0.0, 1.0);
+	int differing = 0, hits = 0;
+	for (int i = 0; i < 2000; ++i)
+	{
+		double origin[3] = {coord(rng), coord(rng), coord(rng)};
+		double direction[3] = {dir(rng), dir(rng), dir(rng)};
+		double const len = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		for (auto& d : direction)
+		{
+			d /= len;
+		}
+		auto expected = bruteForceHit(points, triangles, origin, direction, 5.0, -1, minDistance);
+		auto actual = bvh.firstHit(origin, direction, 5.0, -1, scratch);
+		differing += sameHit(expected, actual) ? 0 : 1;
+		hits += (actual.triangle >= 0) ? 1 : 0;
+	}
+	int const vertexCount = static_cast<int>(points.size() / 3);
+	for (int v = 0; v < vertexCount; ++v)
+	{
+		double const* origin = points.data() + 3 * v;
+		double const len = std::sqrt(origin[0] * origin[0] + origin[1] * origin[1] + origin[2] * origin[2]);
+		double const inward[3] = {-origin[0] / len, -origin[1] / len, -origin[2] / len};
+		auto expected = bruteForceHit(points, triangles, origin, inward, 1.0, v, minDistance);
+		auto actual = bvh.firstHit(origin, inward, 1.0, v, scratch);
+		differing += sameHit(expected, actual) ? 0 : 1;
+		hits += (actual.triangle >= 0) ? 1 : 0;
+	}
+	TestEqual(differing, 0);
+	TestAssert(hits > 1000);
+END_TEST
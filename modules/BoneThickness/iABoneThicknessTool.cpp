@@ -13,15 +13,23 @@
 #include <iAMainWindow.h>
 
 #include <iADataSet.h>
+#include <iADataSetRenderer.h>
+#include <iADataSetViewer.h>
 
 #include <QApplication>
 #include <QCheckBox>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QLabel>
 #include <QPushButton>
 
+#include <vtkActor.h>
+#include <vtkDataArray.h>
+#include <vtkDataSet.h>
+#include <vtkMapper.h>
+#include <vtkPointData.h>
 #include <vtkPolyData.h>
 
 iABoneThicknessTool::iABoneThicknessTool(iAMainWindow* mainWnd, iAMdiChild * child):
@@ -40,6 +48,7 @@ iABoneThicknessTool::iABoneThicknessTool(iAMainWindow* mainWnd, iAMdiChild * chi
 		if (dynamic_cast<iAPolyData*>(ds.second.get()))
 		{
 			pd = dynamic_cast<iAPolyData*>(ds.second.get())->poly();
+			m_dataSetIdx = ds.first;
 			break;
 		}
 	}
@@ -60,6 +69,19 @@ iABoneThicknessTool::iABoneThicknessTool(iAMainWindow* mainWnd, iAMdiChild * chi
 	pPushButtonSave->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton));
 	connect(pPushButtonSave, &QPushButton::clicked, this, &iABoneThicknessTool::slotPushButtonSave);
 
+	QPushButton* pPushButtonComputeSurface(new QPushButton("Compute thickness map", pWidget));
+	pPushButtonComputeSurface->setToolTip("Compute thickness and surface distance for the vertices of the whole mesh, "
+		"and color the surface by thickness.");
+	connect(pPushButtonComputeSurface, &QPushButton::clicked, this, &iABoneThicknessTool::slotPushButtonComputeSurface);
+
+	QLabel* pLabelDecimationLevel(new QLabel("Decimation level:", pWidget));
+	m_pSpinBoxDecimationLevel = new QSpinBox(pWidget);
+	m_pSpinBoxDecimationLevel->setAlignment(Qt::AlignRight);
+	m_pSpinBoxDecimationLevel->setRange(0, 10);
+	m_pSpinBoxDecimationLevel->setValue(0);
+	m_pSpinBoxDecimationLevel->setToolTip("Evaluate only every 2^level-th vertex; the others take over the values of the "
+		"closest evaluated vertex.");
+
 	QGroupBox* pGroupBoxBound(new QGroupBox("Model Statistics", pWidget));
 	pGroupBoxBound->setFixedHeight(pGroupBoxBound->logicalDpiY() / 2);
 
@@ -127,9 +149,12 @@ iABoneThicknessTool::iABoneThicknessTool(iAMainWindow* mainWnd, iAMdiChild * chi
 	QGridLayout* pGridLayout(new QGridLayout(pWidget));
 	pGridLayout->addWidget(pPushButtonOpen, 0, 0);
 	pGridLayout->addWidget(pPushButtonSave, 0, 1);
-	pGridLayout->addWidget(pGroupBoxBound, 1, 0, 1, 2);
-	pGridLayout->addWidget(pBoneThicknessSplitter, 2, 0, 1, 2);
-	pGridLayout->addWidget(pGroupBoxSettings, 3, 0, 1, 2);
+	pGridLayout->addWidget(pPushButtonComputeSurface, 0, 2);
+	pGridLayout->addWidget(pLabelDecimationLevel, 0, 3, Qt::AlignRight);
+	pGridLayout->addWidget(m_pSpinBoxDecimationLevel, 0, 4, Qt::AlignLeft);
+	pGridLayout->addWidget(pGroupBoxBound, 1, 0, 1, 5);
+	pGridLayout->addWidget(pBoneThicknessSplitter, 2, 0, 1, 5);
+	pGridLayout->addWidget(pGroupBoxSettings, 3, 0, 1, 5);
 
 	iADockWidgetWrapper* pDockWidgetWrapper(new iADockWidgetWrapper(pWidget, tr("Bone thickness"), "BoneThickness"));
 	m_child->tabifyDockWidget(m_child->renderDockWidget(), pDockWidgetWrapper);
@@ -234,6 +259,31 @@ void iABoneThicknessTool::slotPushButtonOpen()
 	}
 }
 
+void iABoneThicknessTool::slotPushButtonComputeSurface()
+{
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	QApplication::processEvents();
+	QElapsedTimer timer;
+	timer.start();
+	m_pBoneThickness->calculateSurface(m_pSpinBoxDecimationLevel->value());
+	LOG(lvlInfo, QString("Bone thickness map computed in %1 ms.").arg(timer.elapsed()));
+	setStatistics();
+	// color the mesh by the thickness array:
+	auto viewer = m_child->dataSetViewer(m_dataSetIdx);
+	auto actor = (viewer && viewer->renderer()) ? vtkActor::SafeDownCast(viewer->renderer()->vtkProp()) : nullptr;
+	auto thickness = (actor && actor->GetMapper()->GetInput()) ?
+		actor->GetMapper()->GetInput()->GetPointData()->GetArray(iABoneThickness::ThicknessArrayName) : nullptr;
+	if (thickness)
+	{
+		actor->GetMapper()->SetScalarModeToUsePointFieldData();
+		actor->GetMapper()->SelectColorArray(iABoneThickness::ThicknessArrayName);
+		actor->GetMapper()->SetScalarRange(thickness->GetRange());
+		actor->GetMapper()->ScalarVisibilityOn();
+	}
+	m_child->renderer()->update();
+	QApplication::restoreOverrideCursor();
+}
+
 void iABoneThicknessTool::slotPushButtonSave()
 {
 	QPushButton* pPushButtonSave((QPushButton*)sender());
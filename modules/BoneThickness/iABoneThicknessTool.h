@@ -9,6 +9,7 @@
 #include <QDoubleSpinBox>
 #include <QScopedPointer>
 #include <QLabel>
+#include <QSpinBox>
 
 class iABoneThicknessChartBar;
 class iABoneThicknessTable;
@@ -27,11 +28,13 @@ private:
 	QDoubleSpinBox* m_pDoubleSpinBoxSphereRadius = nullptr;
 	QDoubleSpinBox* m_pDoubleSpinBoxThicknessMaximum = nullptr;
 	QDoubleSpinBox* m_pDoubleSpinBoxSurfaceDistanceMaximum = nullptr;
+	QSpinBox* m_pSpinBoxDecimationLevel = nullptr;
 	QLabel* pLabelMeanTh = nullptr;
 	QLabel* pLabelStdTh = nullptr;
 	QLabel* pLabelMeanSDi = nullptr;
 	QLabel* pLabelStdSDi = nullptr;
 	QScopedPointer<iABoneThickness> m_pBoneThickness;
+	size_t m_dataSetIdx = 0;   //!< index of the mesh dataset in the child
 
 private slots:
 	void slotDoubleSpinBoxSphereRadius();
@@ -39,6 +42,7 @@ private slots:
 	void slotDoubleSpinBoxSurfaceDistanceMaximum();
 	void slotPushButtonOpen();
 	void slotPushButtonSave();
+	void slotPushButtonComputeSurface();
 	void slotCheckBoxShowThickness(const bool& _bChecked);
 	void slotCheckBoxTransparency(const bool& _bChecked);
 };
@@ -4,6 +4,8 @@
 
 #include "iACompBayesianBlocksData.h"
 
+#include "iALog.h"
+
 #include <iostream>
 #include <cmath>
 #include <vector>
@@ -39,124 +41,40 @@ void iACompBayesianBlocks::calculateBins()
 	
 
 	QList<std::vector<double>>* binningStrategies = new QList<std::vector<double>>;
-	
-	for (int i = 0; i < static_cast<int>(m_bayesianBlocksData->getAmountObjectsEveryDataset()->size()); i++)
-	{  // do for every dataset
 
-		std::vector<double> values = m_datasets->at(i);
-		std::vector<double> binningValues = m_datasets->at(i);
+	int numberOfDatasets = static_cast<int>(m_bayesianBlocksData->getAmountObjectsEveryDataset()->size());
+	std::vector<bin::BinType*> datasetBins(numberOfDatasets);
+	std::vector<std::vector<csvDataType::ArrayType*>*> datasetBinsWithFiberIds(numberOfDatasets);
+	std::vector<std::vector<double>> datasetBinningStrategies(numberOfDatasets);
 
-		//TODO
-		//change bayesian blocks computation so that min and max are used for computing lower edges for each bin
-		//but the real values should be used for actual binning
-		//Questions is now: Is the maxValue inside or outside the binning?
-		//Problem: the last bin is always only filled with 1 value!
+	//TODO
+	//change bayesian blocks computation so that min and max are used for computing lower edges for each bin
+	//but the real values should be used for actual binning
+	//Questions is now: Is the maxValue inside or outside the binning?
+	//Problem: the last bin is always only filled with 1 value!
 
-		//add minimum and maximum value of all datasets for each dataset for calculation of bayesian blocks
-		/*
-		if (std::find(binningValues.begin(), binningValues.end(), minVal) == binningValues.end())
-		{
-			binningValues.insert(binningValues.begin(), minVal);
-			LOG(lvlDebug, "added min: " + QString::number(minVal));
-		}
-			
-		if (std::find(binningValues.begin(), binningValues.end(), maxVal) == binningValues.end())
-		{
-			binningValues.push_back(maxVal);
-			LOG(lvlDebug, "added max: " + QString::number(maxVal));
-		}
-		*/
-		
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < numberOfDatasets; i++)
+	{  // do for every dataset
 		//calculate for each dataset the adaptive histogram according to its lower bounds of each bin
-		auto currBinningStrategy = BayesianBlocks::blocks(binningValues, 0.01, false, true);
-		
+		auto currBinningStrategy = BayesianBlocks::blocks(m_datasets->at(i), 0.01);
+
 		int currentNumberOfBins = static_cast<int>(currBinningStrategy.size());
-		bin::BinType* bins = bin::initialize(currentNumberOfBins);
-		std::vector<csvDataType::ArrayType*>* binsWithFiberIds = new std::vector<csvDataType::ArrayType*>();
+		datasetBins[i] = bin::initialize(currentNumberOfBins);
+		datasetBinsWithFiberIds[i] = new std::vector<csvDataType::ArrayType*>();
 		for (int k = 0; k < currentNumberOfBins; k++)
 		{
-			csvDataType::ArrayType* init = new csvDataType::ArrayType();
-			binsWithFiberIds->push_back(init);
-		}
-
-		//////////////////////////////////////////////////////////////////////////////////////
-		//DEBUG
-		/*LOG(lvlDebug, "Resulting Bins (?) = " + QString::number(currBinningStrategy.size()));
-		for (int j = 0; j < currBinningStrategy.size(); j++)
-		{
-			LOG(lvlDebug, "value at " + QString::number(j) + " = " + QString::number(currBinningStrategy.at(j)));
-		}
-
-		LOG(lvlDebug, " ");*/
-		//////////////////////////////////////////////////////////////////////////////////////
-		
-		int datasetInd = static_cast<int>(values.size());
-
-		//check for every value inside a dataset for the corresponding bin	
-		for (int v = 0; v < static_cast<int>(values.size()); v++)
-		{
-			for (int b = 0; b < currentNumberOfBins; b++)
-			{
-				bool inside;
-				
-				if (b < currentNumberOfBins-1)
-				{
-					inside = checkRange(values.at(v), currBinningStrategy.at(b), currBinningStrategy.at(b + 1));
-				}
-				else
-				{
-					bool inside1 = checkRange(values.at(v), currBinningStrategy.at(b), maxVal);
-					bool inside2 = (abs(maxVal - values.at(v)) < 1e-16); 
-					inside = inside1 || inside2;
-				}
-
-				if (inside)
-				{
-					//store MDS value
-					bins->at(b).push_back(values.at(v));
-
-					//store Fiber ID
-					std::vector<double> object = m_dataStorage->getData()->at(i).values->at(v);
-					csvDataType::ArrayType* data = binsWithFiberIds->at(b);
-					data->push_back(object);
-
-					break;
-				}
-			}
-
-			datasetInd--;
-		}
-
-		binData->push_back(bins);
-		binDataObjects->push_back(binsWithFiberIds);
-
-		binningStrategies->push_back(currBinningStrategy);
-
-/*		std::ifstream fin;
-		fin.open("C:/FHTools/open_iA/src/modules/CompVis/test.dat");
-		if (!fin.is_open())
-		{
-			LOG(lvlDebug, "dat not found!");
+			datasetBinsWithFiberIds[i]->push_back(new csvDataType::ArrayType());
 		}
+		assignToBins(i, currBinningStrategy, maxVal, 1e-16, datasetBins[i], datasetBinsWithFiberIds[i]);
+		datasetBinningStrategies[i] = std::move(currBinningStrategy);
+	}
 
-		double a;
-		std::vector<double> v;
-		while (fin >> a) v.push_back(a);
-
-		LOG(lvlDebug, "v = " + QString::number(v.size()));
-
-		std::vector<double> exp = {
-			-3.48528, -1.87114, -1.36282, -0.677218, 0.659105, 1.39771, 4.06582, 5.60912, 6.17286, 7.76634, 9.91696};
-
-		 auto r = BayesianBlocks::blocks(v, 0.01, false, true);
-
-		 //DEBUG
-		 LOG(lvlDebug, "Resulting Bins (?) = " + QString::number(r.size()));
-		 for (int j = 0; j < r.size(); j++)
-		 {
-			 LOG(lvlDebug, "value at " + QString::number(j) + " = " + QString::number(r.at(j)));
-		 }
-	*/	
+	for (int i = 0; i < numberOfDatasets; i++)
+	{
+		binData->push_back(datasetBins[i]);
+		binDataObjects->push_back(datasetBinsWithFiberIds[i]);
+		binningStrategies->push_back(datasetBinningStrategies[i]);
 	}
 
 	m_bayesianBlocksData->setBinData(binData);
@@ -176,7 +94,8 @@ bin::BinType* iACompBayesianBlocks::calculateBins(bin::BinType* , int )
 namespace BayesianBlocks
 {
 	
-	bb::array blocks(bb::data_array data, bb::weights_array weights, const double p, bool counter, bool benchmark)
+	bb::array blocks(bb::data_array data, bb::weights_array weights, const double p, bool counter, bool benchmark,
+		std::size_t maxCells)
 	{
 		auto start = bb::clock::now();
 
@@ -196,11 +115,6 @@ namespace BayesianBlocks
 			throw std::domain_error("ERROR: invalid weights found in input");
 		}
 
-		if (std::unique(data.begin(), data.end()) != data.end())
-		{
-			throw std::invalid_argument("ERROR: duplicated values found in input");
-		}
-
 		const auto N = data.size();
 
 		// sort and copy data
@@ -214,39 +128,84 @@ namespace BayesianBlocks
 			weights[i] = hist[i].second;
 		}
 
+		if (std::adjacent_find(data.begin(), data.end()) != data.end())
+		{
+			throw std::invalid_argument("ERROR: duplicated values found in input");
+		}
+
 		// build up array with all possible bin edges
 		bb::array edges(N + 1);
 		edges[0] = data[0];
 		for (std::size_t i = 0; i < N - 1; ++i) edges[i + 1] = (data[i] + data[i + 1]) / 2.;
 		edges[N] = data[N - 1];
 
-		assert(std::unique(edges.begin(), edges.end()) == edges.end());
+		// cumulative weights, for computing the number of events in a block in O(1):
+		std::vector<long long> cumulWeights(N + 1, 0);
+		for (std::size_t i = 0; i < N; ++i) cumulWeights[i + 1] = cumulWeights[i] + weights[i];
+
+		// for large inputs, only every step-th edge is considered as change point; the fitness of blocks between
+		// these edges is still computed exactly, the result is the optimal partition restricted to these edges:
+		const std::size_t step = (maxCells > 0 && N > maxCells) ? (N + maxCells - 1) / maxCells : 1;
+		if (step > 1)
+		{
+			LOG(lvlInfo, QString("Bayesian blocks: %1 unique values exceed the limit of %2; "
+				"only every %3. edge is considered as change point, the binning is approximated.")
+				.arg(N).arg(maxCells).arg(step));
+		}
+		std::vector<std::size_t> cells;   // indices into edges of the considered change points
+		for (std::size_t i = 0; i < N; i += step) cells.push_back(i);
+		cells.push_back(N);
+		const auto M = cells.size() - 1;
 
 		// let's use here Cash statistics and calibrated prior on number of change points
-		auto cash = [](int N_k, double T_k) { return N_k * std::log(N_k / T_k); };
+		auto cash = [](long long N_k, double T_k) { return N_k * std::log(N_k / T_k); };
 		auto ncp_prior = std::log(73.53 * p * std::pow(N, -0.478)) - 4;
 
 		// arrays to store results
-		bb::array last(N);
-		bb::array best(N);
+		bb::array last(M);
+		bb::array best(M);
 
 		auto init_time = bb::duration_cast<bb::us>(bb::clock::now() - start).count();
 		start = bb::clock::now();
 
-		// do the actual recursive computation
-		for (std::size_t k = 0; k < N; ++k)
+		// do the actual recursive computation; the set of candidate start points r of the last block is
+		// pruned as in PELT (Killick et al. 2012, "Optimal detection of changepoints with a linear computational cost"):
+		// since splitting a block never decreases its Cash fitness, a start point r with
+		// best[r - 1] + fitness(r, k) < best[k] can never be the start of the optimal last block for any later k
+		std::vector<std::size_t> candidates;
+		candidates.reserve(M);
+		bb::array A;
+		A.reserve(M);
+		for (std::size_t k = 0; k < M; ++k)
 		{
-			bb::array A(k + 1);
-			for (std::size_t r = 0; r == 0 or r <= k; ++r)
+			candidates.push_back(k);
+			A.resize(candidates.size());
+			std::size_t bestIdx = 0;
+			for (std::size_t c = 0; c < candidates.size(); ++c)
 			{
-				A[r] = cash(std::accumulate(weights.begin() + r, weights.begin() + k + 1, 0), edges[k + 1] - edges[r]) +
+				auto r = candidates[c];
+				A[c] = cash(cumulWeights[cells[k + 1]] - cumulWeights[cells[r]], edges[cells[k + 1]] - edges[cells[r]]) +
 					ncp_prior + (r == 0 ? 0 : best[r - 1]);
+				if (A[c] > A[bestIdx])
+				{
+					bestIdx = c;
+				}
+			}
+			last[k] = candidates[bestIdx];
+			best[k] = A[bestIdx];
+
+			std::size_t kept = 0;
+			for (std::size_t c = 0; c < candidates.size(); ++c)
+			{
+				if (A[c] - ncp_prior >= best[k])
+				{
+					candidates[kept++] = candidates[c];
+				}
 			}
-			last[k] = std::distance(A.begin(), std::max_element(A.begin(), A.end()));
-			best[k] = *(std::max_element(A.begin(), A.end()));
+			candidates.resize(kept);
 
 			if (counter)
-				std::cout << '\r' << k << '/' << N << std::flush;
+				std::cout << '\r' << k << '/' << M << std::flush;
 		}
 		if (counter)
 			std::cout << std::endl;
@@ -256,12 +215,12 @@ namespace BayesianBlocks
 
 		// iteratively find the change points
 		std::vector<size_t> cp;
-		for (auto i = N; i != 0; i = last[i - 1]) cp.push_back(i);
+		for (auto i = M; i != 0; i = last[i - 1]) cp.push_back(i);
 		cp.push_back(0);
 
 		std::reverse(cp.begin(), cp.end());
 		bb::array result(cp.size(), 0);
-		std::transform(cp.begin(), cp.end(), result.begin(), [edges](size_t pos) { return edges[pos]; });
+		std::transform(cp.begin(), cp.end(), result.begin(), [&edges, &cells](size_t pos) { return edges[cells[pos]]; });
 
 		auto end_time = bb::duration_cast<bb::us>(bb::clock::now() - start).count();
 
@@ -281,26 +240,25 @@ namespace BayesianBlocks
 		return result;
 	}
 
-	bb::array blocks(bb::data_array data, const double p, bool counter, bool benchmark)
+	bb::array blocks(bb::data_array data, const double p, bool counter, bool benchmark, std::size_t maxCells)
 	{
-		// compute weights
-		std::map<double, int> hist;
-		for (auto& i : data)
-		{
-			if (hist.find(i) == hist.end())
-				hist.emplace(i, 1);
-			else
-				hist[i]++;
-		}
-
+		// compute weights (number of occurrences of each unique value):
+		std::sort(data.begin(), data.end());
 		bb::data_array x;
 		bb::weights_array weights;
-		for (auto& i : hist)
+		for (std::size_t i = 0; i < data.size(); ++i)
 		{
-			x.push_back(i.first);
-			weights.push_back(i.second);
+			if (i == 0 || data[i] != data[i - 1])
+			{
+				x.push_back(data[i]);
+				weights.push_back(1);
+			}
+			else
+			{
+				weights.back()++;
+			}
 		}
 
-		return BayesianBlocks::blocks(x, weights, p, counter, benchmark);
+		return BayesianBlocks::blocks(x, weights, p, counter, benchmark, maxCells);
 	}
 }
@@ -52,12 +52,16 @@ namespace BayesianBlocks
 	//implements the core functionality of bayesian blocks
 	// returns an array of the low-edges for each bin
 	//This array has a size of numberOfBins + 1 
+	//if there are more than maxCells unique values, only every (N/maxCells)-th edge between them is considered
+	//as change point, i.e. the result is an approximation (logged if it applies); by default (0), all edges are
+	//considered and the result is the exact optimal partition
 	bb::array blocks(bb::data_array data, bb::weights_array weights, const double p = 0.01, bool counter = false,
-		bool benchmark = false);
+		bool benchmark = false, std::size_t maxCells = 0);
 
 	// returns an array of the low-edges for each bin
 	//This array has a size of numberOfBins + 1 
-	bb::array blocks(bb::data_array data, const double p = 0.01, bool counter = false, bool benchmark = false);
+	bb::array blocks(bb::data_array data, const double p = 0.01, bool counter = false, bool benchmark = false,
+		std::size_t maxCells = 0);
 }
 
 //#endif
@@ -5,8 +5,46 @@
 //Qt
 #include "qlist.h"
 
+#include <algorithm>
 #include <cmath>
 
+namespace
+{
+	//! the sorted values of a cluster, with prefix sums for computing the average distance to a point in O(log n)
+	struct iASortedCluster
+	{
+		explicit iASortedCluster(std::vector<double> const& points) :
+			values(points),
+			prefixSum(points.size() + 1, 0.0)
+		{
+			std::sort(values.begin(), values.end());
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				prefixSum[i + 1] = prefixSum[i] + values[i];
+			}
+		}
+		bool contains(double point) const
+		{
+			return std::binary_search(values.begin(), values.end(), point);
+		}
+		//! the average (1D euclidean) distance between the given point and all points of the cluster
+		double averageDistance(double point) const
+		{
+			size_t n = values.size();
+			if (n == 0)
+			{
+				return 0.0;
+			}
+			size_t below = std::lower_bound(values.begin(), values.end(), point) - values.begin();
+			size_t aboveStart = std::upper_bound(values.begin(), values.end(), point) - values.begin();
+			double dist = (point * below - prefixSum[below]) + (prefixSum[n] - prefixSum[aboveStart]) - point * (n - aboveStart);
+			return dist / n;
+		}
+		std::vector<double> values;
+		std::vector<double> prefixSum;
+	};
+}
+
 iACompBinning::iACompBinning(iACsvDataStorage* dataStorage, bin::BinType* datasets) :
 	m_datasets(datasets),
 	m_dataStorage(dataStorage)
@@ -21,10 +59,11 @@ bool iACompBinning::checkRange(double value, double low, double high)
 std::vector<double>* iACompBinning::calculateSilhouetteCoefficient(iACompHistogramTableData* datastructure)
 {
 	QList<bin::BinType*>* clustersOfAllDatasets = datastructure->getBinData();
-	QList<std::vector<double>>* objectsPerBinAllDatasets = datastructure->getNumberOfObjectsPerBinAllDatasets();
-	std::vector<double>* resultPerDataset = new std::vector<double>();
+	int numberOfDatasets = static_cast<int>(datastructure->getNumberOfObjectsPerBinAllDatasets()->size());
+	std::vector<double>* resultPerDataset = new std::vector<double>(numberOfDatasets, 0.0);
 
-	for (int datasetID = 0; datasetID < objectsPerBinAllDatasets->size(); datasetID++)
+#pragma omp parallel for schedule(dynamic)
+	for (int datasetID = 0; datasetID < numberOfDatasets; datasetID++)
 	{
 		double silhouette = 0.0;
 		//the average distance between x and other objects in a group including x
@@ -32,30 +71,31 @@ std::vector<double>* iACompBinning::calculateSilhouetteCoefficient(iACompHistogr
 		//the minimum average distance between x and the nearest group.
 		double minAverageDist = 0.0;
 
-		bin::BinType* clusters = clustersOfAllDatasets->at(datasetID);
-		std::vector<double> numberOfPointsPerBin = objectsPerBinAllDatasets->at(datasetID);
-
-		std::vector<double> allPoints = m_datasets->at(datasetID);
-
-		std::vector<double>* cluster_points;
-		std::vector<double>* nearest_cluster_points;
+		bin::BinType const* clusters = clustersOfAllDatasets->at(datasetID);
+		std::vector<iASortedCluster> sortedClusters;
+		sortedClusters.reserve(clusters->size());
+		for (auto const& cluster : *clusters)
+		{
+			sortedClusters.emplace_back(cluster);
+		}
+		std::vector<double> const& clusterBoundaries = datastructure->getBinBoundaries()->at(datasetID);
+		std::vector<double> const& allPoints = m_datasets->at(datasetID);
 
 		for (int pID = 0; pID < static_cast<int>(allPoints.size()); pID++)
 		{
 			double thisPoint = allPoints.at(pID);
 
-			double binID = getPointsFromCluster(clusters, thisPoint);
-			cluster_points = &clusters->at(binID);
-			averageDist = getASilhouette(cluster_points, thisPoint);
-			
+			auto cluster = std::find_if(sortedClusters.begin(), sortedClusters.end(),
+				[thisPoint](iASortedCluster const& c) { return c.contains(thisPoint); });
+			if (cluster == sortedClusters.end())
+			{	// shouldn't happen, every point is in a bin
+				continue;
+			}
+			averageDist = cluster->averageDistance(thisPoint);
+
 			//Get closest cluster to p
-			std::vector<double> clusterBoundaries = datastructure->getBinBoundaries()->at(datasetID);
-			
 			double nearestClusterID = getNearestCluster(clusterBoundaries, thisPoint, datastructure->getMaxVal());
-			nearest_cluster_points = &clusters->at(nearestClusterID);
-			minAverageDist = getASilhouette(nearest_cluster_points, thisPoint);
-
-			
+			minAverageDist = sortedClusters.at(static_cast<size_t>(nearestClusterID)).averageDistance(thisPoint);
 
 			if ( (averageDist == 0 && minAverageDist == 0) )
 			{ //capture NANs
@@ -73,10 +113,9 @@ std::vector<double>* iACompBinning::calculateSilhouetteCoefficient(iACompHistogr
 					LOG(lvlDebug, "nearestClusterID " + QString::number(nearestClusterID));
 				}
 			}
-			
 		}
 
-		 resultPerDataset->push_back(silhouette / allPoints.size());
+		resultPerDataset->at(datasetID) = silhouette / allPoints.size();
 	}
 
 	////DEBUG
@@ -90,22 +129,41 @@ std::vector<double>* iACompBinning::calculateSilhouetteCoefficient(iACompHistogr
 	
 }
 
-double iACompBinning::getPointsFromCluster(bin::BinType* clusters, double point)
+int iACompBinning::binIndex(std::vector<double> const& lowerBounds, double maxVal, double maxTolerance, double value)
 {
-	for (int binID = 0; binID < static_cast<int>(clusters->size()); binID++)
+	int lastBin = static_cast<int>(lowerBounds.size()) - 1;
+	int b = static_cast<int>(std::upper_bound(lowerBounds.begin(), lowerBounds.end(), value) - lowerBounds.begin()) - 1;
+	if (b >= 0 && b < lastBin)
 	{
-		std::vector<double> currBin = clusters->at(binID);
-		if (std::find(currBin.begin(), currBin.end(), point) != currBin.end())
-		{ //found point in bin/cluster
-			return binID;
-		}
+		return b;
+	}
+	if (lastBin >= 0 && ((value >= lowerBounds[lastBin] && value < maxVal) || std::abs(maxVal - value) <= maxTolerance))
+	{
+		return lastBin;
 	}
-
-	//Shouldn't get here
 	return -1;
 }
 
-double iACompBinning::getNearestCluster(std::vector<double> clusterBoundaries, double point, double maxUpperBoundary)
+void iACompBinning::assignToBins(int datasetID, std::vector<double> const& lowerBounds, double maxVal,
+	double maxTolerance, bin::BinType* bins, std::vector<csvDataType::ArrayType*>* binsWithObjects)
+{
+	std::vector<double> const& values = m_datasets->at(datasetID);
+	auto const& objects = *m_dataStorage->getData()->at(datasetID).values;
+	for (size_t v = 0; v < values.size(); v++)
+	{
+		int b = binIndex(lowerBounds, maxVal, maxTolerance, values[v]);
+		if (b < 0)
+		{
+			continue;
+		}
+		//store MDS value
+		bins->at(b).push_back(values[v]);
+		//store object (e.g. fiber) data
+		binsWithObjects->at(b)->push_back(objects.at(v));
+	}
+}
+
+double iACompBinning::getNearestCluster(std::vector<double> const& clusterBoundaries, double point, double maxUpperBoundary)
 {
 	double min_dist = INFINITY;
 	
@@ -141,26 +199,3 @@ double iACompBinning::getNearestCluster(std::vector<double> clusterBoundaries, d
 	return nearestBinID;
 }
 
-double iACompBinning::getASilhouette(std::vector<double>* points_from_cluster, double thisPoint)
-{
-	double dist = 0.0;
-
-	for (int i = 0; i < static_cast<int>(points_from_cluster->size()); i++)
-	{
-		double point = points_from_cluster->at(i);
-
-		if (point == thisPoint)
-		{
-			continue;
-		}
-
-		dist += abs(point - thisPoint);  //euclideanDistance for 1D
-	}
-
-	if (points_from_cluster->size() != 0)
-	{
-		dist /= points_from_cluster->size();
-	}
-
-	return dist;
-}
@@ -39,11 +39,33 @@ public:
 	*/
 	std::vector<double>* calculateSilhouetteCoefficient(iACompHistogramTableData* datastructure);
 
+	/**
+	 * @brief find the bin a value belongs to via binary search over the lower boundaries of the bins
+	 * bin b contains the values in [lowerBounds[b], lowerBounds[b+1][, the last bin the values in [lowerBounds.back(), maxVal[
+	 * and additionally all values with a distance of at most maxTolerance to maxVal
+	 * @param lowerBounds - the lower boundary of each bin, sorted ascending
+	 * @param maxVal - the upper boundary of the last bin
+	 * @param maxTolerance - the maximum distance to maxVal for which a value is still considered inside the last bin
+	 * @param value - the value for which to find the bin
+	 * @return the index of the bin containing the value, or -1 if the value is not contained in any bin
+	*/
+	static int binIndex(std::vector<double> const& lowerBounds, double maxVal, double maxTolerance, double value);
+
 protected:
 
 	//checks if the value lies inside an interval [low,high[
 	bool checkRange(double value, double low, double high);
 
+	/**
+	 * @brief assign the values of a dataset to the given bins (see binIndex), and store the objects of each value in the respective bin
+	 * @param datasetID - the index of the dataset in m_datasets
+	 * @param lowerBounds, maxVal, maxTolerance - the bin boundaries, see binIndex
+	 * @param bins - receives the values contained in each bin (needs to contain lowerBounds.size() bins)
+	 * @param binsWithObjects - receives the objects contained in each bin (needs to contain lowerBounds.size() bins)
+	*/
+	void assignToBins(int datasetID, std::vector<double> const& lowerBounds, double maxVal, double maxTolerance,
+		bin::BinType* bins, std::vector<csvDataType::ArrayType*>* binsWithObjects);
+
 
 	//array where the size of the rows is not always the same
 	//store all mds values for each dataset
@@ -53,23 +75,6 @@ protected:
 
 private:
 
-	/**
-	 * @brief get all points of the cluster the specific point belongs to
-	 * @param clusters - all clusters of a dataset
-	 * @param point - the point for which the cluster is looked for
-	 * @return - the points of the cluster, the point belongs to
-	*/
-	double getPointsFromCluster(bin::BinType* clusters, double point);
-
-	/**
-	 * @brief compute the silhouette of a specifc point to all other points of his cluster by using the euclidean distance
-	 * @param points_from_cluster - the cluster this specific point belongs to
-	 * @param thisPoint - the point for which the silhouette is computed
-	 * @return - the silhouette/distance from thisPoint to the other points contained in the cluster points_from_cluster
-	*/
-	double getASilhouette(std::vector<double>* points_from_cluster, double thisPoint);
-
-
-	double getNearestCluster(std::vector<double> clusterBoundaries, double point, double maxUpperBoundary);
+	double getNearestCluster(std::vector<double> const& clusterBoundaries, double point, double maxUpperBoundary);
 
 };
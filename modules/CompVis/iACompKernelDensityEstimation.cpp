@@ -2,19 +2,90 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iACompKernelDensityEstimation.h"
 
+#include "iACompBinning.h"
 #include "iACompUniformBinningData.h"
 #include "iACompBayesianBlocksData.h"
 #include "iACompNaturalBreaksData.h"
 
+#include <algorithm>
+#include <cmath>
+#include <complex>
 #include <vector>
 
+namespace
+{
+	//! in-place iterative radix-2 FFT; the size of data must be a power of two
+	void fft(std::vector<std::complex<double>>& data, bool inverse)
+	{
+		size_t n = data.size();
+		for (size_t i = 1, j = 0; i < n; ++i)
+		{	// bit reversal permutation
+			size_t bit = n >> 1;
+			for (; j & bit; bit >>= 1)
+			{
+				j ^= bit;
+			}
+			j ^= bit;
+			if (i < j)
+			{
+				std::swap(data[i], data[j]);
+			}
+		}
+		const double Pi = std::acos(-1.0);
+		for (size_t len = 2; len <= n; len <<= 1)
+		{
+			double angle = 2 * Pi / len * (inverse ? 1 : -1);
+			std::complex<double> wLen(std::cos(angle), std::sin(angle));
+			for (size_t i = 0; i < n; i += len)
+			{
+				std::complex<double> w(1);
+				for (size_t j = 0; j < len / 2; ++j)
+				{
+					auto u = data[i + j];
+					auto v = data[i + j + len / 2] * w;
+					data[i + j] = u + v;
+					data[i + j + len / 2] = u - v;
+					w *= wLen;
+				}
+			}
+		}
+		if (inverse)
+		{
+			for (auto& d : data)
+			{
+				d /= static_cast<double>(n);
+			}
+		}
+	}
+
+	//! bandwidth according to Silverman's rule of thumb, for one dimension; the same as used by kde::DiagonalBandwidthMatrix
+	double silvermanBandwidth(std::vector<double> const& data)
+	{
+		double sum = 0, sqSum = 0;
+		for (double v : data)
+		{
+			sum += v;
+			sqSum += v * v;
+		}
+		double count = static_cast<double>(data.size());
+		double mean = sum / count;
+		double sigma = std::sqrt(std::max(0.0, sqSum / count - mean * mean));
+		return std::pow(4.0 / 3.0, 1.0 / 5.0) * std::pow(count, -1.0 / 5.0) * sigma;
+	}
+
+	//! cutoff of the gaussian kernel, in multiples of the bandwidth (exp(-0.5*5^2) ~ 3.7e-6)
+	const double KernelCutoff = 5.0;
+}
+
 iACompKernelDensityEstimation::iACompKernelDensityEstimation(
 	iACsvDataStorage* dataStorage, bin::BinType* datasets) :
 	m_datasets(datasets),
 	//m_dataStorage(dataStorage),
 	m_kdeData(nullptr),
 	m_maxKDE(-INFINITY),
-	m_minKDE(INFINITY)
+	m_minKDE(INFINITY),
+	m_exactComputation(false),
+	m_kdeCache(datasets->size())
 {
 	Q_UNUSED(dataStorage);
 	numSteps = 1000;  //(*std::minmax_element(amountObjectsEveryDataset->begin(), amountObjectsEveryDataset->end()).second); //
@@ -25,6 +96,11 @@ void iACompKernelDensityEstimation::setDataStructure(iACompKernelDensityEstimati
 	m_kdeData = datastructure;
 }
 
+void iACompKernelDensityEstimation::setExactComputation(bool exact)
+{
+	m_exactComputation = exact;
+}
+
 void iACompKernelDensityEstimation::calculateCurve(
 	iACompUniformBinningData* uData, iACompBayesianBlocksData* bbData, iACompNaturalBreaksData* nbData)
 {
@@ -38,27 +114,31 @@ void iACompKernelDensityEstimation::calculateCurve(
 	QList<bin::BinType*>* bbDataStore = bbData->getBinData();
 	QList<bin::BinType*>* nbDataStore = nbData->getBinData();
 
-	//data preparation
-	for (size_t dataID = 0; dataID < m_datasets->size(); dataID++)
-	{
-		kdeData::kdeBin* result = new kdeData::kdeBin();
-		calculateKDE(&m_datasets->at(dataID), result);
+	auto kdeResults = calculateKDEs();
+	int numberOfDatasets = static_cast<int>(m_datasets->size());
+	std::vector<kdeData::kdeBins*> kdeUniform(numberOfDatasets), kdeNB(numberOfDatasets), kdeBB(numberOfDatasets);
 
-		kdeData::kdeBins* kdeUniform = kdeData::initializeBins(static_cast<int>(uDataStore->at(static_cast<int>(dataID))->size()));
-		std::vector<double> binBoundariesUB = uData->getBinBoundaries()->at(static_cast<int>(dataID));
-		calculateKDEBinning(result, uData->getMaxVal(), &binBoundariesUB, kdeUniform);
+#pragma omp parallel for schedule(dynamic)
+	for (int dataID = 0; dataID < numberOfDatasets; dataID++)
+	{
+		kdeUniform[dataID] = kdeData::initializeBins(static_cast<int>(uDataStore->at(dataID)->size()));
+		calculateKDEBinning(kdeResults[dataID], uData->getMaxVal(), &uData->getBinBoundaries()->at(dataID), kdeUniform[dataID]);
 
-		kdeData::kdeBins* kdeNB = kdeData::initializeBins(static_cast<int>(nbDataStore->at(static_cast<int>(dataID))->size()));
-		std::vector<double> binBoundariesNB = nbData->getBinBoundaries()->at(static_cast<int>(dataID));
-		calculateKDEBinning(result, nbData->getMaxVal(), &binBoundariesNB, kdeNB);
+		kdeNB[dataID] = kdeData::initializeBins(static_cast<int>(nbDataStore->at(dataID)->size()));
+		calculateKDEBinning(kdeResults[dataID], nbData->getMaxVal(), &nbData->getBinBoundaries()->at(dataID), kdeNB[dataID]);
 
-		kdeData::kdeBins* kdeBB = kdeData::initializeBins(static_cast<int>(bbDataStore->at(static_cast<int>(dataID))->size()));
-		std::vector<double> binBoundariesBB = bbData->getBinBoundaries()->at(static_cast<int>(dataID));
-		calculateKDEBinning(result, bbData->getMaxVal(), &binBoundariesBB, kdeBB);
+		kdeBB[dataID] = kdeData::initializeBins(static_cast<int>(bbDataStore->at(dataID)->size()));
+		calculateKDEBinning(kdeResults[dataID], bbData->getMaxVal(), &bbData->getBinBoundaries()->at(dataID), kdeBB[dataID]);
+	}
 
-		kdeDataUniform->append(*kdeUniform);
-		kdeDataNB->append(*kdeNB);
-		kdeDataBB->append(*kdeBB);
+	for (int dataID = 0; dataID < numberOfDatasets; dataID++)
+	{
+		kdeDataUniform->append(*kdeUniform[dataID]);
+		kdeDataNB->append(*kdeNB[dataID]);
+		kdeDataBB->append(*kdeBB[dataID]);
+		delete kdeUniform[dataID];
+		delete kdeNB[dataID];
+		delete kdeBB[dataID];
 	}
 
 	m_kdeData->setKDEDataUniform(kdeDataUniform);
@@ -74,36 +154,87 @@ void iACompKernelDensityEstimation::calculateCurveUB(iACompUniformBinningData* u
 	//get binned data
 	QList<bin::BinType*>* uDataStore = uData->getBinData();
 
-	for (size_t dataID = 0; dataID < m_datasets->size(); dataID++)
-	{
-		kdeData::kdeBin* result = new kdeData::kdeBin();
-		calculateKDE(&m_datasets->at(dataID), result);
+	auto kdeResults = calculateKDEs();
+	int numberOfDatasets = static_cast<int>(m_datasets->size());
+	std::vector<kdeData::kdeBins*> kdeUniform(numberOfDatasets);
 
-		kdeData::kdeBins* kdeUniform = kdeData::initializeBins(static_cast<int>(uDataStore->at(static_cast<int>(dataID))->size()));
-		std::vector<double> binBoundariesUB = uData->getBinBoundaries()->at(static_cast<int>(dataID));
-		calculateKDEBinning(result, uData->getMaxVal(), &binBoundariesUB, kdeUniform);
+#pragma omp parallel for schedule(dynamic)
+	for (int dataID = 0; dataID < numberOfDatasets; dataID++)
+	{
+		kdeUniform[dataID] = kdeData::initializeBins(static_cast<int>(uDataStore->at(dataID)->size()));
+		calculateKDEBinning(kdeResults[dataID], uData->getMaxVal(), &uData->getBinBoundaries()->at(dataID), kdeUniform[dataID]);
+	}
 
-		kdeDataUniform->append(*kdeUniform);
+	for (int dataID = 0; dataID < numberOfDatasets; dataID++)
+	{
+		kdeDataUniform->append(*kdeUniform[dataID]);
+		delete kdeUniform[dataID];
 	}
 
 	m_kdeData->setKDEDataUniform(kdeDataUniform);
 }
 
-void iACompKernelDensityEstimation::calculateKDE(std::vector<double>* dataIn, kdeData::kdeBin* results)
+std::vector<kdeData::kdeBin const*> iACompKernelDensityEstimation::calculateKDEs()
 {
-	realMatrixType samples(dataIn->size(), 1);
+	int numberOfDatasets = static_cast<int>(m_datasets->size());
+	std::vector<kdeData::kdeBin const*> results(numberOfDatasets);
+	m_kdeCache.resize(numberOfDatasets);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int dataID = 0; dataID < numberOfDatasets; dataID++)
+	{
+		std::vector<double> const& data = m_datasets->at(dataID);
+		auto minMax = std::minmax_element(data.begin(), data.end());
+		double xMin = *minMax.first;
+		double dx = (*minMax.second - xMin) / static_cast<realScalarType>(numSteps);
+		double bandwidth = silvermanBandwidth(data);
+
+		// each thread only accesses the cache entries of its own datasets:
+		auto& cache = m_kdeCache[dataID];
+		auto it = std::find_if(cache.begin(), cache.end(), [=](KDECacheEntry const& e)
+		{
+			return e.bandwidth == bandwidth && e.xMin == xMin && e.dx == dx && e.numSteps == numSteps &&
+				e.exact == m_exactComputation;
+		});
+		if (it == cache.end())
+		{
+			KDECacheEntry entry{bandwidth, xMin, dx, numSteps, m_exactComputation, kdeData::kdeBin()};
+			if (m_exactComputation)
+			{
+				calculateKDEExact(data, xMin, dx, entry.result);
+			}
+			else
+			{
+				calculateKDEFFT(data, bandwidth, xMin, dx, entry.result);
+			}
+			cache.push_back(std::move(entry));
+			it = cache.end() - 1;
+		}
+		results[dataID] = &it->result;
+	}
 
-	for (size_t i = 0; i < dataIn->size(); ++i)
+	for (auto result : results)
 	{
-		samples(i) = dataIn->at(i);
+		for (auto const& pair : *result)
+		{
+			m_maxKDE = std::max(m_maxKDE, pair[1]);
+			m_minKDE = std::min(m_minKDE, pair[1]);
+		}
 	}
+	m_kdeData->setMaxKDEVal(m_maxKDE);
+	m_kdeData->setMinKDEVal(m_minKDE);
+	return results;
+}
 
-	// create a plottable data
-	auto result = std::minmax_element(dataIn->begin(), dataIn->end());
-	double xMax = *result.second;
-	double xMin = *result.first;
+void iACompKernelDensityEstimation::calculateKDEExact(
+	std::vector<double> const& dataIn, double xMin, double dx, kdeData::kdeBin& results)
+{
+	realMatrixType samples(dataIn.size(), 1);
 
-	const realScalarType dx = (xMax - xMin) / (realScalarType)numSteps;
+	for (size_t i = 0; i < dataIn.size(); ++i)
+	{
+		samples(i) = dataIn.at(i);
+	}
 
 	//build kde
 	kdeType kde(samples);
@@ -117,73 +248,75 @@ void iACompKernelDensityEstimation::calculateKDE(std::vector<double>* dataIn, kd
 		double kdeValue = kde.computePDF(samp);
 
 		kdeData::kdePair pair = {xi, kdeValue};
-		results->push_back(pair);
+		results.push_back(pair);
+	}
+}
 
-		if (kdeValue >= m_maxKDE)
+void iACompKernelDensityEstimation::calculateKDEFFT(
+	std::vector<double> const& dataIn, double bandwidth, double xMin, double dx, kdeData::kdeBin& results)
+{
+	results.resize(numSteps);
+	if (dx == 0 || bandwidth == 0)
+	{	// all values are the same; at their position, the kernel of every sample evaluates to 1
+		for (indexType i = 0; i < numSteps; ++i)
 		{
-			m_maxKDE = kdeValue;		
+			results[i] = {xMin + i * dx, 1.0};
 		}
-
-		if (kdeValue < m_minKDE)
+		return;
+	}
+	// linear binning of the samples onto the grid xMin + j*dx, j = 0..numSteps (the last grid point is the maximum):
+	size_t gridSize = static_cast<size_t>(numSteps) + 1;
+	size_t kernelRadius = std::min(gridSize - 1, static_cast<size_t>(std::ceil(KernelCutoff * bandwidth / dx)));
+	size_t fftSize = 1;
+	while (fftSize < gridSize + kernelRadius)
+	{	// avoids wrap-around of the (circular) convolution into the grid
+		fftSize <<= 1;
+	}
+	std::vector<std::complex<double>> counts(fftSize), kernel(fftSize);
+	for (double v : dataIn)
+	{
+		double pos = (v - xMin) / dx;
+		size_t j = std::min(static_cast<size_t>(pos), gridSize - 2);
+		double frac = pos - j;
+		counts[j] += 1.0 - frac;
+		counts[j + 1] += frac;
+	}
+	// the gaussian kernel, in the same (unnormalized) form as kde::Gaussian, sampled at the grid spacing:
+	for (size_t l = 0; l <= kernelRadius; ++l)
+	{
+		double z = l * dx / bandwidth;
+		kernel[l] = std::exp(-0.5 * z * z);
+		if (l > 0)
 		{
-			m_minKDE = kdeValue;
+			kernel[fftSize - l] = kernel[l];
 		}
 	}
-
-	m_kdeData->setMaxKDEVal(m_maxKDE);
-	m_kdeData->setMinKDEVal(m_minKDE);
+	fft(counts, false);
+	fft(kernel, false);
+	for (size_t i = 0; i < fftSize; ++i)
+	{
+		counts[i] *= kernel[i];
+	}
+	fft(counts, true);
+	double count = static_cast<double>(dataIn.size());
+	for (indexType i = 0; i < numSteps; ++i)
+	{
+		results[i] = {xMin + i * dx, std::max(0.0, counts[i].real()) / count};
+	}
 }
 
 void iACompKernelDensityEstimation::calculateKDEBinning(
-	kdeData::kdeBin* input, double maxMDSVal, std::vector<double>* binBoundaries, kdeData::kdeBins* result)
+	kdeData::kdeBin const* input, double maxMDSVal, std::vector<double> const* binBoundaries, kdeData::kdeBins* result)
 {
 	for (int pairId = 0; pairId < static_cast<int>(input->size()); pairId++)
 	{
-		kdeData::kdePair pair = input->at(pairId); 
-		double mdsVal = pair[0];
-		
-		for (int bin = 0; bin < static_cast<int>(binBoundaries->size()); bin++)
-		{  //look for the boundaries of each bin
-
-			double lowerBorder;
-			double upperBorder;
-
-			if (bin < (static_cast<int>(binBoundaries->size()) - 1))
-			{
-				lowerBorder = binBoundaries->at(bin);
-				upperBorder = binBoundaries->at(bin + 1);
-			}
-			else
-			{
-				lowerBorder = binBoundaries->at(bin);
-				upperBorder = maxMDSVal;
-			}
-
-			bool greaterLowerBorder = false;
-			bool smallerUpperBorder = false;
-			
-			if (mdsVal >= lowerBorder) greaterLowerBorder = true;
-			if (mdsVal < upperBorder) smallerUpperBorder = true;
-
-			if (greaterLowerBorder && smallerUpperBorder)
-			{
-				/*LOG(lvlDebug, "");
-				LOG(lvlDebug, "bin" + QString::number(bin));
-				LOG(lvlDebug, "lowerBorder" + QString::number(lowerBorder));
-				LOG(lvlDebug, "upperBorder" + QString::number(upperBorder));
-				LOG(lvlDebug, "pair:" + QString::number(pair[0]) + ", " + QString::number(pair[1]));*/
-
-				result->at(bin).push_back(pair);
-				break;
-			}
-
-			if ((bin == ((static_cast<int>(binBoundaries->size()) - 1))) && mdsVal == upperBorder)
-			{
-				result->at(bin).push_back(pair);
-				break;
-			}
+		kdeData::kdePair pair = input->at(pairId);
+		//look for the bin via its boundaries; the last bin also contains the maximum value
+		int bin = iACompBinning::binIndex(*binBoundaries, maxMDSVal, 0.0, pair[0]);
+		if (bin >= 0)
+		{
+			result->at(bin).push_back(pair);
 		}
-
 	}
 	
 	//Debug
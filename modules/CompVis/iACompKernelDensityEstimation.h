@@ -36,16 +36,30 @@ public:
 	//compute the curve only for the uniform binning
 	void calculateCurveUB(iACompUniformBinningData* uData);
 
+	//whether to compute the KDE exactly, by evaluating the kernel of every sample at each position (via a KD-tree);
+	//slow for large datasets, intended as reference. By default, the KDE is computed via linear binning and FFT
+	void setExactComputation(bool exact);
+
 private:
 
-	//compute the KDE for an individual dataset
-	void calculateKDE(std::vector<double>* dataIn, kdeData::kdeBin* results);
+	//compute the KDE for all datasets in parallel, or take it from the cache if already computed
+	//for the same dataset, bandwidth and grid; also updates the minimum and maximum kde value
+	std::vector<kdeData::kdeBin const*> calculateKDEs();
+
+	//compute the KDE for an individual dataset exactly, at numSteps positions starting at xMin with spacing dx
+	void calculateKDEExact(std::vector<double> const& dataIn, double xMin, double dx, kdeData::kdeBin& results);
+
+	//compute the KDE for an individual dataset, at numSteps positions starting at xMin with spacing dx,
+	//by linearly binning the values onto these positions and convolving with the kernel via FFT
+	//(O(N + M log M) for N values and M positions)
+	void calculateKDEFFT(std::vector<double> const& dataIn, double bandwidth, double xMin, double dx,
+		kdeData::kdeBin& results);
 	
 	//order kde data according to the binning of the given data
 	//if a uniform binBoundaries are given, then the data is ordered according to the uniform binning
 	//if bayesian blocks binBoundaries are given, then the data is ordered according to the bayesian blocks binning
 	//if natural breaks binBoundaries are given, then the data is ordered according to the natural breaks binning
-	void calculateKDEBinning(kdeData::kdeBin* input, double maxMDSVal, std::vector<double>* binBoundaries, kdeData::kdeBins* result);
+	void calculateKDEBinning(kdeData::kdeBin const* input, double maxMDSVal, std::vector<double> const* binBoundaries, kdeData::kdeBins* result);
 
 
 	//array where the size of the rows is not always the same
@@ -62,5 +76,21 @@ private:
 
 	//stores the minimal kde value for all datasets
 	double m_minKDE;
+
+	//whether the KDE is computed exactly, see setExactComputation
+	bool m_exactComputation;
+
+	//a computed KDE, with the parameters it was computed for
+	struct KDECacheEntry
+	{
+		double bandwidth;
+		double xMin;
+		double dx;
+		indexType numSteps;
+		bool exact;
+		kdeData::kdeBin result;
+	};
+	//for each dataset, the KDEs computed so far
+	std::vector<std::vector<KDECacheEntry>> m_kdeCache;
 	
 };
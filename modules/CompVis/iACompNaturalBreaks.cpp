@@ -4,6 +4,8 @@
 
 #include "iACompNaturalBreaksData.h"
 
+#include <cmath>
+
 iACompNaturalBreaks::iACompNaturalBreaks(iACsvDataStorage* dataStorage, bin::BinType* datasets) :
 	iACompBinning(dataStorage, datasets), 
 	m_naturalBreaksData(nullptr)
@@ -28,100 +30,67 @@ void iACompNaturalBreaks::calculateBins()
 
 	QList<std::vector<double>>* binningStrategies = new QList<std::vector<double>>; //stores number of bins for each dataset
 
-	for (int i = 0; i < static_cast<int>(m_naturalBreaksData->getAmountObjectsEveryDataset()->size()); i++)
+	int numberOfDatasets = static_cast<int>(m_naturalBreaksData->getAmountObjectsEveryDataset()->size());
+	std::vector<bin::BinType*> datasetBins(numberOfDatasets);
+	std::vector<std::vector<csvDataType::ArrayType*>*> datasetBinsWithFiberIds(numberOfDatasets);
+	std::vector<FishersNaturalBreaks::LimitsContainer> datasetBinningStrategies(numberOfDatasets);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < numberOfDatasets; i++)
 	{  // do for every dataset
 
-		std::vector<double> values = m_datasets->at(i);
+		std::vector<double> const& values = m_datasets->at(i);
+
+		//sorted unique values with their number of occurrences; the same for all numbers of bins
+		FishersNaturalBreaks::ValueCountPairContainer sortedUniqueValueCounts;
+		FishersNaturalBreaks::GetValueCountPairs(sortedUniqueValueCounts, values.data(), values.size());
 
-		bin::BinType* bins = new bin::BinType();
-		bin::BinType* bestBins = new bin::BinType();
-		std::vector<csvDataType::ArrayType*>* binsWithFiberIds = new std::vector<csvDataType::ArrayType*>();
-		std::vector<csvDataType::ArrayType*>* bestBinsWithFiberIds = new std::vector<csvDataType::ArrayType*>();
 		FishersNaturalBreaks::LimitsContainer currBinningStrategy;
 		FishersNaturalBreaks::LimitsContainer bestCurrBinningStrategy;
-		
+
 		//compute best number of bins by using goodness of variance fit
 		int currentNumberOfBins = 1;
 		double gvf = 0.0;  //value from 0 to 1 where 0 = No Fit and 1 = Perfect Fit.
 		double bestGvf = 0.0;
-		do
+		while (gvf < GFVLIMIT && static_cast<size_t>(currentNumberOfBins) < sortedUniqueValueCounts.size())
 		{
 			currentNumberOfBins += 1;
 
 			//compute Natural Breaks
-			FishersNaturalBreaks::ValueCountPairContainer sortedUniqueValueCounts;
-			FishersNaturalBreaks::GetValueCountPairs(sortedUniqueValueCounts, &values[0], values.size());
-
 			FishersNaturalBreaks::ClassifyJenksFisherFromValueCountPairs(
 				currBinningStrategy, currentNumberOfBins, sortedUniqueValueCounts);
-	
-			//Debug Output
-			/*LOG(lvlDebug, "Results of Natural Breaks: ");
-			for (double breakValue : currBinningStrategy) LOG(lvlDebug, QString::number(breakValue));*/
-
-			//calculate for each dataset the adaptive histogram according to its lower bounds of each bin
-			bins = bin::initialize(currentNumberOfBins);
-			binsWithFiberIds = new std::vector<csvDataType::ArrayType*>();
-			for (int k = 0; k < currentNumberOfBins; k++)
-			{
-				csvDataType::ArrayType* init = new csvDataType::ArrayType();
-				binsWithFiberIds->push_back(init);
-			}
-
-			int datasetInd = (int)values.size();
-
-			//check for every value inside a dataset for the corresponding bin
-			for (int v = 0; v < static_cast<int>(values.size()); v++)
-			{
-				for (int b = 0; b < currentNumberOfBins; b++)
-				{
-					bool inside;
-
-					if (b < currentNumberOfBins - 1)
-					{
-						inside = checkRange(values.at(v), currBinningStrategy.at(b), currBinningStrategy.at(b + 1));
-					}
-					else
-					{
-						bool inside1 = checkRange(values.at(v), currBinningStrategy.at(b), maxVal);
-						bool inside2 = (abs(maxVal - values.at(v)) < 1e-16);
-						inside = inside1 || inside2;
-					}
-
-					if (inside)
-					{
-						//store MDS value
-						bins->at(b).push_back(values.at(v));
-
-						//store Fiber ID
-						std::vector<double> object = m_dataStorage->getData()->at(i).values->at(v);
-						csvDataType::ArrayType* data = binsWithFiberIds->at(b);
-						data->push_back(object);
-
-						break;
-					}
-				}
-
-				datasetInd--;
-			}
 
 			//compute goodness of variance fit
-			gvf = computeGoodnessOfVarianceFit(values, currBinningStrategy, bins);
+			gvf = computeGoodnessOfVarianceFit(sortedUniqueValueCounts, currBinningStrategy);
 
 			if (gvf > bestGvf)
 			{
 				bestGvf = gvf;
-				bestBins = bins;
-				bestBinsWithFiberIds = binsWithFiberIds;
 				bestCurrBinningStrategy = currBinningStrategy;
 			}
-			
-		} while (gvf < GFVLIMIT && currBinningStrategy.size() < values.size());
+		}
+		if (bestCurrBinningStrategy.empty())
+		{	//not enough distinct values for more than one bin
+			bestCurrBinningStrategy.assign(1, sortedUniqueValueCounts.empty() ? maxVal : sortedUniqueValueCounts[0].first);
+		}
 
-		binData->push_back(bestBins);
-		binDataObjects->push_back(bestBinsWithFiberIds);
+		//calculate for each dataset the adaptive histogram according to its lower bounds of each bin
+		int bestNumberOfBins = static_cast<int>(bestCurrBinningStrategy.size());
+		datasetBins[i] = bin::initialize(bestNumberOfBins);
+		datasetBinsWithFiberIds[i] = new std::vector<csvDataType::ArrayType*>();
+		for (int k = 0; k < bestNumberOfBins; k++)
+		{
+			datasetBinsWithFiberIds[i]->push_back(new csvDataType::ArrayType());
+		}
+		assignToBins(i, bestCurrBinningStrategy, maxVal, 1e-16, datasetBins[i], datasetBinsWithFiberIds[i]);
+		datasetBinningStrategies[i] = std::move(bestCurrBinningStrategy);
+	}
 
-		binningStrategies->push_back(bestCurrBinningStrategy);
+	for (int i = 0; i < numberOfDatasets; i++)
+	{
+		binData->push_back(datasetBins[i]);
+		binDataObjects->push_back(datasetBinsWithFiberIds[i]);
+		binningStrategies->push_back(datasetBinningStrategies[i]);
 	}
 
 	m_naturalBreaksData->setBinData(binData);
@@ -133,45 +102,47 @@ void iACompNaturalBreaks::calculateBins()
 }
 
 double iACompNaturalBreaks::computeGoodnessOfVarianceFit(
-	std::vector<double> values, FishersNaturalBreaks::LimitsContainer currBinningStrategy, bin::BinType* bins)
+	FishersNaturalBreaks::ValueCountPairContainer const& sortedUniqueValueCounts,
+	FishersNaturalBreaks::LimitsContainer const& currBinningStrategy)
 {
-	double gvf = 0.0;  //value from 0 to 1 where 0 = No Fit and 1 = Perfect Fit.
-	
-	//compute squared deviations from the values (array) mean(SDAM)
-	std::sort(values.begin(), values.end());
-	double valuesMean = 0.0;
-	std::for_each(values.begin(), values.end(), [&](double m) { valuesMean += m; });
-	valuesMean = valuesMean / values.size();
-	double SDAM = 0.0;
-	for (int l = 0; l < static_cast<int>(values.size()); l++)
-	{
-		//sum of squared deviations from values mean
-		double sqDev = std::pow((values.at(l) - valuesMean), 2);
-		SDAM += sqDev;
-	}
-
-	//compute the squared deviations from the bin (class) means(SDCM)
-	double SDCM = 0.0;
-	for (int j = 0; j < static_cast<int>(currBinningStrategy.size()); j++)
+	//the values of a class are a contiguous range of the sorted unique values,
+	//sum of squared deviations from the mean for a range [begin, end) of them:
+	auto squaredDeviations = [&sortedUniqueValueCounts](size_t begin, size_t end)
 	{
-		std::vector<double> valsInBin = bins->at(j);
-
-		double binMean = 0.0;
-		std::for_each(valsInBin.begin(), valsInBin.end(), [&](double m) { binMean += m; });
-		binMean = binMean / valsInBin.size();
-		double preSDCM = 0.0;
-		for (int p = 0; p < static_cast<int>(valsInBin.size()); p++)
+		double sum = 0.0;
+		double count = 0.0;
+		for (size_t v = begin; v < end; ++v)
+		{
+			sum += sortedUniqueValueCounts[v].first * sortedUniqueValueCounts[v].second;
+			count += sortedUniqueValueCounts[v].second;
+		}
+		double mean = sum / count;
+		double sqDev = 0.0;
+		for (size_t v = begin; v < end; ++v)
 		{
-			double sqDev2 = std::pow((valsInBin.at(p) - binMean), 2);
-			preSDCM += sqDev2;
+			sqDev += std::pow(sortedUniqueValueCounts[v].first - mean, 2) * sortedUniqueValueCounts[v].second;
 		}
+		return sqDev;
+	};
 
-		SDCM += preSDCM;
-	}
+	//squared deviations from the values (array) mean (SDAM)
+	double SDAM = squaredDeviations(0, sortedUniqueValueCounts.size());
 
-	gvf = (SDAM - SDCM) / SDAM;
+	//squared deviations from the bin (class) means (SDCM)
+	double SDCM = 0.0;
+	size_t classBegin = 0;
+	for (size_t j = 1; j <= currBinningStrategy.size(); ++j)
+	{
+		size_t classEnd = (j < currBinningStrategy.size()) ?
+			std::lower_bound(sortedUniqueValueCounts.begin(), sortedUniqueValueCounts.end(), currBinningStrategy[j],
+				FishersNaturalBreaks::CompareFirst::withValue) - sortedUniqueValueCounts.begin() :
+			sortedUniqueValueCounts.size();
+		SDCM += squaredDeviations(classBegin, classEnd);
+		classBegin = classEnd;
+	}
 
-	return gvf;
+	//value from 0 to 1 where 0 = No Fit and 1 = Perfect Fit.
+	return (SDAM - SDCM) / SDAM;
 }
 
 bin::BinType* iACompNaturalBreaks::calculateBins(bin::BinType* , int )
@@ -188,6 +188,10 @@ namespace FishersNaturalBreaks
 		{
 			return lhs.first < rhs.first;
 		}
+		static bool withValue(const ValueCountPair& lhs, double rhs)
+		{
+			return lhs.first < rhs;
+		}
 	};
 	
 	void GetCountsDirect(ValueCountPairContainer& vcpc, const double* values, SizeT size);
@@ -216,9 +220,10 @@ private:
 	//testing Fishers Natural Breaks implementation
 	void test();
 
-	//compute the Goodness of Variance Fit to determine the best number of bins
-	double computeGoodnessOfVarianceFit(
-		std::vector<double> values, FishersNaturalBreaks::LimitsContainer currBinningStrategy, bin::BinType* bins);
+	//compute the Goodness of Variance Fit of a binning to determine the best number of bins
+	//the values are given as sorted unique values with their number of occurrences
+	double computeGoodnessOfVarianceFit(FishersNaturalBreaks::ValueCountPairContainer const& sortedUniqueValueCounts,
+		FishersNaturalBreaks::LimitsContainer const& currBinningStrategy);
 
 	iACompNaturalBreaksData* m_naturalBreaksData;
 
@@ -26,83 +26,33 @@ void iACompUniformBinning::calculateBins()
 	double minVal = m_uniformBinningData->getMinVal();
 	double maxVal = m_uniformBinningData->getMaxVal();
 
-	double length = computeIntervalLength(minVal, maxVal);
-	double binLength = length / m_currentNumberOfBins;
-
 	QList<std::vector<double>>* binBoundaries = new QList<std::vector<double>>();
 
-	for (int i = 0; i < static_cast<int>(m_uniformBinningData->getAmountObjectsEveryDataset()->size()); i++)
-	{// do for every dataset
+	// all datasets share the same bin boundaries:
+	std::vector<double> lowerBounds = calculateBinBoundaries(minVal, maxVal, m_currentNumberOfBins);
+	int numberOfDatasets = static_cast<int>(m_uniformBinningData->getAmountObjectsEveryDataset()->size());
+	std::vector<bin::BinType*> datasetBins(numberOfDatasets);
+	std::vector<std::vector<csvDataType::ArrayType*>*> datasetBinsWithFiberIds(numberOfDatasets);
 
-		std::vector<double> values = m_datasets->at(i);
-		bin::BinType* bins = bin::initialize(m_currentNumberOfBins);
-		
-		//initalize
-		std::vector<csvDataType::ArrayType*>* binsWithFiberIds = new std::vector<csvDataType::ArrayType*>();
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < numberOfDatasets; i++)
+	{// do for every dataset
+		datasetBins[i] = bin::initialize(m_currentNumberOfBins);
+		datasetBinsWithFiberIds[i] = new std::vector<csvDataType::ArrayType*>();
 		for (int k = 0; k < m_currentNumberOfBins; k++)
 		{
-			csvDataType::ArrayType* init = new csvDataType::ArrayType();
-			binsWithFiberIds->push_back(init);
-		}
-
-		int datasetInd = static_cast<int> (values.size());
-
-		//check for every value inside a dataset for the corresponding bin
-		for (int v = 0; v < static_cast<int>(values.size()); v++)
-		{
-			for (int b = 0; b < m_currentNumberOfBins; b++)
-			{
-				bool inside = checkRange(values.at(v), minVal + (binLength * b), minVal + (binLength * (b + 1)));
-
-				if (!inside && b == m_currentNumberOfBins - 1)
-				{
-					inside = (abs(maxVal - values.at(v)) < 0.0000001);
-				}
-				if (inside)
-				{
-					//store MDS value
-					bins->at(b).push_back(values.at(v));
-
-					//store Fiber ID
-					std::vector<double> object = m_dataStorage->getData()->at(i).values->at(v);
-					csvDataType::ArrayType* data = binsWithFiberIds->at(b);
-					data->push_back(object);
-					//binsWithFiberIds->at(b) = data;
-
-					//LOG(lvlDebug,"fibers stored = " + QString::number(values.at(v)) + " --> at Bin: " + QString::number(b));
-
-					break;
-				}
-			}
-
-			datasetInd--;
+			datasetBinsWithFiberIds[i]->push_back(new csvDataType::ArrayType());
 		}
-
-		initializeMaxAmountInBins(bins, initialNumberBins);
-		binData->push_back(bins);
-		binDataObjects->push_back(binsWithFiberIds);
-		binBoundaries->push_back(calculateBinBoundaries(minVal, maxVal, m_currentNumberOfBins));
+		assignToBins(i, lowerBounds, maxVal, 0.0000001, datasetBins[i], datasetBinsWithFiberIds[i]);
 	}
 
-	/*LOG(lvlDebug,"");
-	//DEBUG
-	for(int i = 0; i < binDataObjects->size(); i++)
-	{ //datasets
-		for(int k = 0; k < binDataObjects->at(i)->size(); k++)
-		{ //bins
-
-			csvDataType::ArrayType* data = binDataObjects->at(i)->at(k);
-
-			for(int j = 0; j < data->size(); j++)
-			{
-				LOG(lvlDebug,"fiberLabelId = " + QString::number(data->at(j).at(0)) + " --> at Bin: " + QString::number(k));
-			}
-
-		}
+	for (int i = 0; i < numberOfDatasets; i++)
+	{
+		initializeMaxAmountInBins(datasetBins[i], initialNumberBins);
+		binData->push_back(datasetBins[i]);
+		binDataObjects->push_back(datasetBinsWithFiberIds[i]);
+		binBoundaries->push_back(lowerBounds);
 	}
-	LOG(lvlDebug,"");
-	LOG(lvlDebug,"#######################################################");
-	*/
 
 	m_uniformBinningData->setBinData(binData);
 	m_uniformBinningData->setBinDataObjects(binDataObjects);
@@ -169,25 +119,19 @@ bin::BinType* iACompUniformBinning::calculateBins(bin::BinType* data, int currDa
 	double binLength = length / m_currentNumberOfBins;
 
 	bin::BinType* bins = bin::initialize(m_currentNumberOfBins);
+	std::vector<double> lowerBounds(m_currentNumberOfBins);
+	for (int b = 0; b < m_currentNumberOfBins; b++)
+	{
+		lowerBounds[b] = min + (binLength * b);
+	}
 
 	for (size_t v = 0; v < amountVals; v++)
 	{
-		for (int b = 0; b < m_currentNumberOfBins; b++)
+		//the maximum value is always added to the last bin, otherwise it would never be added to a bin
+		int b = binIndex(lowerBounds, max, 0.0, vals.at(v));
+		if (b >= 0)
 		{
-			bool inside = checkRange(vals.at(v), min + (binLength * b), min + (binLength * (b + 1)));
-
-			//check if the last value is the maximum value
-			//otherwise this value would never be added to a bin
-			if (!inside && b == m_currentNumberOfBins - 1)
-			{
-				inside = (vals.at(v) == max);
-			}
-
-			if (inside)
-			{
-				bins->at(b).push_back(vals.at(v));
-				break;
-			}
+			bins->at(b).push_back(vals.at(v));
 		}
 	}
 
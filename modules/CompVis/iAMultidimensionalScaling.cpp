@@ -4,16 +4,10 @@
 
 //CompVis
 #include "iAArcCosineDistance.h"
-#include "iASimilarityDistance.h"
-#include "iAMinkowskiDistance.h"
-#include "iAEuclideanDistance.h"
 
-//Debug
-#include "iALog.h"
+#include <iASMACOF.h>
 
 #include <algorithm>
-#include <cmath>
-#include <iostream>
 #include <limits>
 #include <vector>
 
@@ -202,170 +196,32 @@ void iAMultidimensionalScaling::calculateProximityDistance()
 	}
 }
 
-iASimilarityDistance* iAMultidimensionalScaling::initializeDistanceMetric()
+void iAMultidimensionalScaling::calculateMDS(int dim, int iterations)
 {
-	iASimilarityDistance* d = nullptr;
-	if (m_activeDisM == MDS::DistanceMetric::EuclideanDistance)
+	size_t numElems = csvDataType::getRows(m_matrixProximityDis);
+	std::vector<double> flatProximity;
+	flatProximity.reserve(numElems * numElems);
+	for (auto const& row : *m_matrixProximityDis)
 	{
-		d = new iAEuclideanDistance();
+		flatProximity.insert(flatProximity.end(), row.begin(), row.end());
 	}
-	else if (m_activeDisM == MDS::DistanceMetric::MinkowskiDistance)
+	iASMACOFSettings settings;
+	settings.dimensions = dim;
+	settings.iterations = iterations;
+	// do not initialize randomly, to reproduce the results of the MDS (same as csvDataType::initializeRandom):
+	settings.initialConfiguration.resize(numElems * dim);
+	for (size_t r = 0; r < numElems; ++r)
 	{
-		d = new iAMinkowskiDistance();
+		std::fill(settings.initialConfiguration.begin() + r * dim, settings.initialConfiguration.begin() + (r + 1) * dim,
+			static_cast<double>(r + 1) / numElems);
 	}
-
-	return d;
-}
-
-void iAMultidimensionalScaling::calculateMDS(int dim, int iterations)
-{
-	int amountColsProxM = csvDataType::getColumns(m_matrixProximityDis);
-	int amountRowsProxM = csvDataType::getRows(m_matrixProximityDis);
-
-	////DEBUG
-	/*LOG(lvlDebug," \n m_matrixProximityDis");
-	csvDataType::debugArrayType(m_matrixProximityDis);*/
-
-	//X - configuration of points in Euclidiean space
-	//initialize X with one vector filled with random values between [0,1]
-	csvDataType::ArrayType* X = new csvDataType::ArrayType();
-	csvDataType::initializeRandom(amountRowsProxM, dim, X);
-		
-	////DEBUG
-	/*LOG(lvlDebug," \n init X");
-	csvDataType::debugArrayType(X);*/
-
-	// mean value of distance matrix
-	double meanD = csvDataType::mean(m_matrixProximityDis);
-
-	// move to the center
-	csvDataType::addNumberSelf(X, -0.5);
-
-	// before this step, mean distance is 1/3*sqrt(d)
-	csvDataType::multiplyNumberSelf(X, 0.1 * meanD / (1.0 / 3.0 * std::sqrt((double)dim)));
-
-	////DEBUG
-	/*LOG(lvlDebug,"X");
-	csvDataType::debugArrayType(X);*/
-
-	csvDataType::ArrayType* Z = csvDataType::copy(X);
-	csvDataType::ArrayType* D_ = new csvDataType::ArrayType();
-	csvDataType::initialize(amountRowsProxM, amountColsProxM, D_);
-
-	csvDataType::ArrayType* B = new csvDataType::ArrayType();
-	csvDataType::initialize(amountRowsProxM, amountColsProxM, B);
-
-	/*LOG(lvlDebug,"\n init Z");
-	csvDataType::debugArrayType(Z);*/
-
-	//calculate euclidean distance
-	iASimilarityDistance* d = initializeDistanceMetric();
-	d->calculateSimilarityDistance(X, D_);
-
-	////DEBUG
-	/*LOG(lvlDebug,"\n D_");
-	csvDataType::debugArrayType(D_);*/
-
-	csvDataType::ArrayType oldX_ = *X;
-	csvDataType::ArrayType* result = new csvDataType::ArrayType();
-	csvDataType::initialize(csvDataType::getRows(&oldX_), csvDataType::getColumns(&oldX_), result);
-
-	//MDS iteration
-	for (int it = 0; it < iterations; it++)
+	// Minkowski distance of order 1 (see iAMinkowskiDistance), or Euclidean distance between points of the configuration:
+	settings.minkowskiP = (m_activeDisM == MDS::DistanceMetric::MinkowskiDistance) ? 1.0 : 2.0;
+	auto flatResult = computeSMACOF(flatProximity, numElems, settings);
+	m_configuration = new csvDataType::ArrayType(numElems);
+	for (size_t r = 0; r < numElems; ++r)
 	{
-		/*LOG(lvlDebug,QString("\n old B number %1").arg(it));
-		csvDataType::debugArrayType(B);*/
-
-		// B = calc_B(D_,D);
-		for (int r = 0; r < amountRowsProxM; r++)	
-		{
-			for (int c = 0; c < amountColsProxM; c++)
-			{
-				if ( r == c || std::fabs(D_->at(r).at(c)) < Epsilon)
-				{
-					B->at(r).at(c) = 0.0;
-				}
-				else
-				{
-					B->at(r).at(c) = -m_matrixProximityDis->at(r).at(c) / D_->at(r).at(c);
-				}
-			}
-		}
-
-		/*LOG(lvlDebug,QString("\n middle B number %1").arg(it));
-		csvDataType::debugArrayType(B);*/
-
-		double temp;
-		for (int c = 0; c < amountColsProxM; c++)
-		{
-			temp = 0;
-			for (int r = 0; r < amountRowsProxM; r++)
-			{
-				temp += B->at(r).at(c);
-
-			}
-
-			B->at(c).at(c) = -temp;
-		}
-
-		/*LOG(lvlDebug,QString("\n new B number %1").arg(it));
-		csvDataType::debugArrayType(B);
-
-		LOG(lvlDebug,QString("\n old Z number %1").arg(it));
-		csvDataType::debugArrayType(Z);*/
-
-		// X = B*Z/size(D,1);
-		for (int r = 0; r < csvDataType::getRows(X); r++)	
-		{
-			for (int xCols = 0; xCols < csvDataType::getColumns(X); xCols++)
-			{
-				temp = 0;
-				for (int bCols = 0; bCols < csvDataType::getColumns(B); bCols++)
-				{
-					temp += (B->at(r).at(bCols) * Z->at(bCols).at(xCols));
-				}
-
-				X->at(r).at(xCols) = temp / (double)amountRowsProxM;
-			}
-		}
-
-		//D_ = calc_D (X);
-		d->calculateSimilarityDistance(X, D_);
-
-		/*vectorDiff(X, &oldX_, result);
-		LOG(lvlDebug,QString("\n X diff number %1 ").arg(it));
-		csvDataType::debugArrayType(result);
-		oldX_ = *X;
-
-		//LOG(lvlDebug,QString("\n new D number %1").arg(it));
-		//csvDataType::debugArrayType(D_);	*/
-
-		//Z = X;
-		Z = csvDataType::elementCopy(X);
-
-		/*LOG(lvlDebug,QString("\n new X number %1").arg(it));
-		csvDataType::debugArrayType(X);
-
-		LOG(lvlDebug,QString("\n new Z number %1").arg(it));
-		csvDataType::debugArrayType(Z);*/
-
-	}
-
-	m_configuration = X;
-	
-	////DEBUG
-	//LOG(lvlDebug,"\n m_configuration");
-	//csvDataType::debugArrayType(m_configuration);
-}
-
-void iAMultidimensionalScaling::vectorDiff(csvDataType::ArrayType * a, csvDataType::ArrayType * b, csvDataType::ArrayType * result)
-{
-	for (int i = 0; i < csvDataType::getRows(a); i++)
-	{
-		for (int j = 0; j < csvDataType::getColumns(a); j++)
-		{
-			result->at(i).at(j) = abs(a->at(i).at(j)) - abs(b->at(i).at(j));
-		}
+		m_configuration->at(r).assign(flatResult.begin() + r * dim, flatResult.begin() + (r + 1) * dim);
 	}
 }
 
@@ -11,7 +11,6 @@
 #include <iostream>
 
 
-class iASimilarityDistance;
 class iAHistogramData;
 
 namespace MDS
@@ -66,13 +65,7 @@ class iAMultidimensionalScaling
 	//2.calculate proximity measure
 	void calculateProximityDistance();
 
-	//3.initialize which similarity metric to use for calculation
-	iASimilarityDistance* initializeDistanceMetric();
-
-	// Multidimensional scaling (MDS) with SMACOF
-	// This code re-implements Michael Bronstein's SMACOF in his Matlab Toolbox for Surface Comparison and Analysis
-	// The Matlab SMACOF can be downloaded at http://tosca.cs.technion.ac.il/
-	//[1] A. M. Bronstein, M. M. Bronstein, R. Kimmel,"Numerical geometry of nonrigid shapes", Springer, 2008.
+	//3.multidimensional scaling (MDS) with SMACOF, see computeSMACOF
 	void calculateMDS(int dim, int iterations);
 
 	//holds the data for which the MDS will be calculated
@@ -98,7 +91,4 @@ class iAMultidimensionalScaling
 
 	MDS::DistanceMetric m_activeDisM;
 	MDS::ProximityMetric m_activeProxM;
-
-	const double Epsilon = 0.000001;
-	void vectorDiff(csvDataType::ArrayType* a, csvDataType::ArrayType* b, csvDataType::ArrayType* result);
 };
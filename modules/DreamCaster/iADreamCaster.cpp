@@ -11,6 +11,7 @@
 #include "raycast/include/iADataFormat.h"
 #include "raycast/include/iABSPTree.h"
 #include "raycast/include/iAPlot3DVtk.h"
+#include "raycast/include/iARenderSetFile.h"
 #include "iAPaintWidget.h"
 #include "iAStabilityWidget.h"
 
@@ -20,8 +21,6 @@
 
 #include <iAQVTKWidget.h>
 
-#include <iAFileUtils.h>
-
 #include <itkMacro.h>    // for itk::ExceptionObject
 
 #include <vtkActor.h>
@@ -62,8 +61,10 @@
 
 #include <QElapsedTimer>
 #include <QFileDialog>
+#include <QThread>
 
 #include <algorithm>    // for std::fill
+#include <cstring>      // for std::memcpy
 
 #define DEG_IN_PI  180
 #define DEG2RAD M_PI/DEG_IN_PI
@@ -81,10 +82,17 @@ std::vector<iABSPNode> nodes;
 namespace
 {
 	const QString SettingsWindowStateKey = "DreamCaster/windowState";
-}
+	//! number of orientations per thread rendered in one batch of a sweep, between GUI updates
+	const int OrientationsPerThread = 2;
 
-const int CutAABSkipedSize = iACutAAB::getSkipedSizeInFile();
-const int RenderFromPositionSkipedSize = iARenderFromPosition::getSkipedSizeInFile();
+	//! indices, rotations and results of an orientation in a sweep
+	struct iASweepOrientation
+	{
+		int x, y, z;
+		float rx, ry, rz;
+		float avPenLen, avDipAng, maxPenLen;
+	};
+}
 
 #define PLATE_HEIGHT 20./stngs.SCALE_COEF
 extern QApplication * app;
@@ -130,6 +138,7 @@ iADreamCaster::iADreamCaster(QWidget *parent, Qt::WindowFlags flags)
 	CutFigParametersChangedOFF = false;
 	scrBuffer = new iAScreenBuffer( stngs.RFRAME_W, stngs.RFRAME_H );
 	tracer = 0;
+	renderSet = new iARenderSetFile();
 	cuda_avpl_buff = 0;
 	cuda_dipang_buff = 0;
 
@@ -430,6 +439,7 @@ iADreamCaster::~iADreamCaster()
 	settingsStore.setValue("DreamCaster/windowState", state);
 
 	ClearPrevData();
+	delete renderSet;
 	delete scrBuffer;
 	delete cutFigList;
 	delete [] cuda_avpl_buff;
@@ -518,6 +528,7 @@ void iADreamCaster::NewSetSlot()
 		return;
 	}
 	setFileName = newSetFileName;
+	renderSet->close();
 	ui.l_setName->setText(setFileName);
 	log("Created new set:");
 	log(setFileName, true);
@@ -582,42 +593,69 @@ void iADreamCaster::RenderViewsSlot()
 	float deltaX = (maxValX-minValX)/ renderCntX;
 	float deltaY = 2*M_PI/ renderCntY;
 	float deltaZ = (maxValZ-minValZ)/ renderCntZ;
-	//open file for writing in binary mode and write header
-	FILE *fptr = fopen( getLocalEncodingFileName(setFileName).c_str(),"wb");
-	if(!fptr)
-	{
-		log(QString("Error! Cannot open set file '%1' for writing.").arg(setFileName));
-		return;
-	}
 	float cur_minValX = ui.sb_min_x->value()/DEG_IN_PI;
 	float cur_minValZ = ui.sb_min_z->value()/DEG_IN_PI;
 	float cur_maxValX = ui.sb_max_x->value()/DEG_IN_PI;
 	float cur_maxValZ = ui.sb_max_z->value()/DEG_IN_PI;
-	fwrite(&renderCntX, sizeof(renderCntX), 1, fptr);
-	fwrite(&cur_minValX, sizeof(cur_minValX), 1, fptr);
-	fwrite(&cur_maxValX, sizeof(cur_maxValX), 1, fptr);
-
-	fwrite(&renderCntY, sizeof(renderCntY), 1, fptr);
-
-	fwrite(&renderCntZ, sizeof(renderCntZ), 1, fptr);
-	fwrite(&cur_minValZ, sizeof(cur_minValZ), 1, fptr);
-	fwrite(&cur_maxValZ, sizeof(cur_maxValZ), 1, fptr);
-
-	int aabCount = cutFigList->count();
-	fwrite(&aabCount, sizeof(aabCount), 1, fptr);
-	for (int i=0; i<aabCount; i++)
-	{
-		cutFigList->item(i)->Write2File(fptr);
+	set_pos[0] = ui.sb_posx->value()/stngs.SCALE_COEF;
+	set_pos[1] = ui.sb_posy->value()/stngs.SCALE_COEF;
+	set_pos[2] = ui.sb_posz->value()/stngs.SCALE_COEF;
+	bool saveAdditionalData = ui.cb_saveAdditionalData->isChecked();
+	iARenderSetHeader header;
+	header.cntX = renderCntX;
+	header.minX = cur_minValX;
+	header.maxX = cur_maxValX;
+	header.cntY = renderCntY;
+	header.cntZ = renderCntZ;
+	header.minZ = cur_minValZ;
+	header.maxZ = cur_maxValZ;
+	header.cutAABCount = cutFigList->count();
+	for (int i=0; i<header.cutAABCount; i++)
+	{
+		iACutAAB * cutAAB = cutFigList->item(i);
+		char const * box = reinterpret_cast<char const *>(&cutAAB->box);
+		char const * sliders = reinterpret_cast<char const *>(cutAAB->slidersValues);
+		header.cutAABs.insert(header.cutAABs.end(), box, box + sizeof(iAaabb));
+		header.cutAABs.insert(header.cutAABs.end(), sliders, sliders + sizeof(cutAAB->slidersValues));
+	}
+	header.triangleCount = tracer->scene()->getNrTriangles();
+	header.modelHash = iARenderSetHeader::computeModelHash(*tracer->scene());
+	header.radonMode = ui.cb_RadonSA->currentIndex();
+	std::copy(set_pos, set_pos + 3, header.pos);
+	header.originZ = stngs.ORIGIN_Z;
+	header.planeZ = stngs.PLANE_Z;
+	header.planeHalfW = stngs.PLANE_H_W;
+	header.planeHalfH = stngs.PLANE_H_H;
+	header.frameW = stngs.RFRAME_W;
+	header.frameH = stngs.RFRAME_H;
+	header.saveAdditionalData = saveAdditionalData;
+	// the set file might still be mapped for reading, which prevents writing it on some platforms:
+	renderSet->close();
+	// only the CPU sweep can skip orientations; it resumes an interrupted sweep with the same parameters:
+	bool cpuSweep = ui.cb_RadonSA->currentIndex() != 2 && !ui.cbOpenCLEnabled->isChecked();
+	iARenderSetFile setFile;
+	if (!setFile.openForWriting(setFileName, header, cpuSweep))
+	{
+		log(QString("Error! %1").arg(setFile.errorMessage()));
+		return;
 	}
+	std::vector<char> record;
+	auto storeRender = [this, &setFile, &record, saveAdditionalData](int x, int y, int z, iARenderFromPosition const & rend) -> bool
+	{
+		iARenderSetFile::serialize(rend, saveAdditionalData, record);
+		if (!setFile.append(x, y, z, record))
+		{
+			log(QString("Error! %1").arg(setFile.errorMessage()));
+			return false;
+		}
+		return true;
+	};
 	int totalTime=0;
 	QElapsedTimer totalQTime;
 	totalQTime.start();
 	//int totalStart = GetTickCount();
 	//float max_param=-1000;
 	//float min_param=100000;
-	set_pos[0] = ui.sb_posx->value()/stngs.SCALE_COEF;
-	set_pos[1] = ui.sb_posy->value()/stngs.SCALE_COEF;
-	set_pos[2] = ui.sb_posz->value()/stngs.SCALE_COEF;
 	tracer->setPositon(set_pos);
 	iAVec3f transl = -iAVec3f(set_pos);
 	tracer->scene()->recalculateD(&transl);
@@ -673,8 +711,10 @@ void iADreamCaster::RenderViewsSlot()
 					tracer->curRender.maxPenetrLen = 0.f;
 					tracer->curRender.avDipAngle = 0.f;
 					tracer->curRender.badAreaPercentage = placementsParams[x][z].badAreaPercentage;
-					//write data to file
-					tracer->curRender.write2BinaryFile(fptr, ui.cb_saveAdditionalData->isChecked());
+					if (!storeRender(x, y, z, tracer->curRender))
+					{
+						return;
+					}
 					//show progress and calculation time
 					totalTime = totalQTime.elapsed();//GetTickCount() - totalStart;
 					char t2[] = "00:00.000";
@@ -807,8 +847,11 @@ void iADreamCaster::RenderViewsSlot()
 				{
 					//remember bad area percentage
 					tracer->curBatchRenders[batch].badAreaPercentage = placementsParams[ xs[batch] ][ zs[batch] ].badAreaPercentage;
-					//write data to file
-					tracer->curBatchRenders[batch].write2BinaryFile(fptr, ui.cb_saveAdditionalData->isChecked());
+					if (!storeRender(xs[batch], ys[batch], zs[batch], tracer->curBatchRenders[batch]))
+					{
+						isStopped = true;	// cleans up at the start of the next iteration
+						break;
+					}
 					rotationsParams[ xs[batch] ][ ys[batch] ][ zs[batch] ].avPenLen = tracer->curBatchRenders[batch].avPenetrLen;
 					rotationsParams[ xs[batch] ][ ys[batch] ][ zs[batch] ].avDipAng = tracer->curBatchRenders[batch].avDipAngle;
 					rotationsParams[ xs[batch] ][ ys[batch] ][ zs[batch] ].maxPenLen = tracer->curBatchRenders[batch].maxPenetrLen;
@@ -879,10 +922,64 @@ void iADreamCaster::RenderViewsSlot()
 	}//GPU
 	else//using CPU
 	{
-		iAVec3f o; // rays' origin point
-		iAVec3f vp_corners[2];// plane's corners in 3d
-		iAVec3f vp_delta[2];// plane's x and y axes' directions in 3D
-		int counter = 0;
+		// independent orientations are rendered concurrently, in batches between which the GUI is updated;
+		// the results of each orientation are appended to the set file as soon as they are available
+		bool dipAsColor = ui.cb_dipAsColor->isChecked();
+		bool computeBadArea = ui.cb_RadonSA->currentIndex() == 1;
+		if (setFile.storedCount() > 0)
+		{
+			log(QString("Resuming interrupted sweep, %1 of %2 orientations are already stored in the set file.")
+				.arg(setFile.storedCount()).arg(totalRends));
+		}
+		auto addToPlacement = [this](int x, int y, int z, float avPenLen, float avDipAng, float maxPenLen)
+		{
+			rotationsParams[x][y][z].avPenLen = avPenLen;
+			rotationsParams[x][y][z].avDipAng = avDipAng;
+			rotationsParams[x][y][z].maxPenLen = maxPenLen;
+			placementsParams[x][z].avPenLen += rotationsParams[x][y][z].avPenLen;
+			placementsParams[x][z].avDipAng += rotationsParams[x][y][z].avDipAng;
+			if (rotationsParams[x][y][z].maxPenLen > placementsParams[x][z].maxPenLen)
+			{
+				placementsParams[x][z].maxPenLen = rotationsParams[x][y][z].maxPenLen;
+			}
+		};
+		auto finishPlacement = [this, paramIndex](int x, int z)
+		{
+			placementsParams[x][z].avPenLen /= renderCntY;
+			placementsParams[x][z].avDipAng /= renderCntY;
+			float cur_param = 0.0f;
+			switch(paramIndex)
+			{
+			case 0://av. penetratoin length
+				cur_param=stngs.COLORING_COEF*placementsParams[x][z].avPenLen;
+				break;
+			case 1://dip angle cos
+				cur_param = (1-placementsParams[x][z].avDipAng);
+				break;
+			case 2://max penetratoin length
+				cur_param=stngs.COLORING_COEF*placementsParams[x][z].maxPenLen;
+				break;
+			case 3://bad area percentage
+				cur_param=stngs.COLORING_COEF*placementsParams[x][z].badAreaPercentage;
+				break;
+			default:
+				break;
+			}
+			if (cur_param > 1.f)
+			{
+				cur_param = 1.f;
+			}
+			//Pixel lencol = (lenval << 16) + (0 << 8) + (255-lenval);
+			unsigned int lencol = ((unsigned int)(stngs.COL_RANGE_MIN_R+stngs.COL_RANGE_DR*cur_param) << 16) +
+				((unsigned int)(stngs.COL_RANGE_MIN_G+stngs.COL_RANGE_DG*cur_param) << 8) +
+				(unsigned int)(stngs.COL_RANGE_MIN_B+stngs.COL_RANGE_DB*cur_param);
+			viewsBuffer[x + z*renderCntX] = lencol;
+		};
+		// take over the orientations stored already, collect the ones still to render:
+		std::vector<iASweepOrientation> pending;
+		std::vector<int> missingY(renderCntX * renderCntZ, 0);       // per placement, the number of orientations still to render
+		std::vector<char> badAreaKnown(renderCntX * renderCntZ, 0);  // per placement, whether the bad area percentage is known
+		iARenderFromPosition stored;
 		for (int x=0; x< renderCntX; x++)
 		{
 			for (int z=0; z< renderCntZ; z++)
@@ -890,94 +987,123 @@ void iADreamCaster::RenderViewsSlot()
 				placementsParams[x][z]= iAparameters_t();
 				for (int y=0; y< renderCntY; y++)
 				{
-					if (isStopped)
-					{
-						return;
-					}
-					actor->SetOrientation(0,0,0);
-					actor->RotateWXYZ( vtkMath::DegreesFromRadians(minValX) + vtkMath::DegreesFromRadians(deltaX)*x	,1,0,0 );//degrees
-					actor->RotateWXYZ(                    vtkMath::DegreesFromRadians(deltaY)*y	,0,1,0 );
-					actor->RotateZ   ( vtkMath::DegreesFromRadians(minValZ) + vtkMath::DegreesFromRadians(deltaZ)*z);
-					actor->SetPosition(set_pos[0], set_pos[1], set_pos[2]);
-					cutAABActor->SetOrientation(0,0,0);
-					cutAABActor->RotateWXYZ( vtkMath::DegreesFromRadians(minValX) + vtkMath::DegreesFromRadians(deltaX)*x	,1,0,0 );//degrees
-					cutAABActor->RotateWXYZ(                    vtkMath::DegreesFromRadians(deltaY)*y	,0,1,0 );
-					cutAABActor->RotateZ   ( vtkMath::DegreesFromRadians(minValZ) + vtkMath::DegreesFromRadians(deltaZ)*z);
-					cutAABActor->SetPosition(set_pos[0], set_pos[1], set_pos[2]);
 					float rx = minValX + deltaX*x;
 					float ry =         + deltaY*y;
 					float rz = minValZ + deltaZ*z;
-					tracer->setRotations(rx, ry, rz);
 					rotations[x][y][z] = iArotation_t(rx/M_PI, ry/M_PI, rz/M_PI);
-					InitRender(vp_corners, vp_delta, &o);
-					if(ui.cb_RadonSA->currentIndex() == 1 && y == 0)
+					if (setFile.read(x, y, z, stored, false))
 					{
-						placementsParams[x][z].badAreaPercentage = RandonSpaceAnalysis();
+						addToPlacement(x, y, z, stored.avPenetrLen, stored.avDipAngle, stored.maxPenetrLen);
+						placementsParams[x][z].badAreaPercentage = stored.badAreaPercentage;
+						badAreaKnown[x + z*renderCntX] = 1;
 					}
-					QElapsedTimer localTime;
-					localTime.start();//int fstart = GetTickCount();
-					Render(vp_corners, vp_delta, &o, true);
-					int ftime = localTime.elapsed();// GetTickCount() - fstart;
-					char t[] = "00:00.000";
-					Time2Char(ftime, t);
-					ui.TimeLabel->setText(t);
-					totalTime = totalQTime.elapsed();//GetTickCount() - totalStart;
-					char t2[] = "00:00.000";
-					Time2Char(totalTime, t2);
-					double percentage = ((double)counter)/totalRends*100;
-					ui.simulationProgress->setValue((int)percentage);
-					ui.l_ttime->setText( QString(t2) + "  "+QString::number(percentage)+"%");
-					//remember bad area percentage
-					tracer->curRender.badAreaPercentage = placementsParams[x][z].badAreaPercentage;
-					//write data to file
-					tracer->curRender.write2BinaryFile(fptr, ui.cb_saveAdditionalData->isChecked());
-					rotationsParams[x][y][z].avPenLen = tracer->curRender.avPenetrLen;
-					rotationsParams[x][y][z].avDipAng = tracer->curRender.avDipAngle;
-					rotationsParams[x][y][z].maxPenLen = tracer->curRender.maxPenetrLen;
-					placementsParams[x][z].avPenLen += rotationsParams[x][y][z].avPenLen;
-					placementsParams[x][z].avDipAng += rotationsParams[x][y][z].avDipAng;
-					if (rotationsParams[x][y][z].maxPenLen > placementsParams[x][z].maxPenLen)
+					else
 					{
-						placementsParams[x][z].maxPenLen = rotationsParams[x][y][z].maxPenLen;
+						pending.push_back(iASweepOrientation{x, y, z, rx, ry, rz});
+						++missingY[x + z*renderCntX];
 					}
-
-					curRend++;
-					counter++;
 				}
-
-				placementsParams[x][z].avPenLen /= renderCntY;
-				placementsParams[x][z].avDipAng /= renderCntY;
-				float cur_param = 0.0f;
-				switch(paramIndex)
+				if (missingY[x + z*renderCntX] == 0)
 				{
-				case 0://av. penetratoin length
-					cur_param=stngs.COLORING_COEF*placementsParams[x][z].avPenLen;
-					break;
-				case 1://dip angle cos
-					cur_param = (1-placementsParams[x][z].avDipAng);
-					break;
-				case 2://max penetratoin length
-					cur_param=stngs.COLORING_COEF*placementsParams[x][z].maxPenLen;
-					break;
-				case 3://bad area percentage
-					cur_param=stngs.COLORING_COEF*placementsParams[x][z].badAreaPercentage;
-					break;
-				default:
-					break;
+					finishPlacement(x, z);
 				}
-				if (cur_param > 1.f)
+			}
+		}
+		long long const batchSize = std::max(1, QThread::idealThreadCount()) * OrientationsPerThread;
+		long long const pendingCount = static_cast<long long>(pending.size());
+		size_t doneCount = setFile.storedCount();
+		for (long long batchStart = 0; batchStart < pendingCount; batchStart += batchSize)
+		{
+			long long batchEnd = std::min(batchStart + batchSize, pendingCount);
+			// the bad area percentage depends on the rotation set in the engine, so it is computed beforehand:
+			for (long long i = batchStart; computeBadArea && i < batchEnd; ++i)
+			{
+				iASweepOrientation const & orient = pending[i];
+				if (!badAreaKnown[orient.x + orient.z*renderCntX])
 				{
-					cur_param = 1.f;
+					tracer->setRotations(orient.rx, 0, orient.rz);
+					placementsParams[orient.x][orient.z].badAreaPercentage = RandonSpaceAnalysis();
+					badAreaKnown[orient.x + orient.z*renderCntX] = 1;
 				}
-				//Pixel lencol = (lenval << 16) + (0 << 8) + (255-lenval);
-				unsigned int lencol = ((unsigned int)(stngs.COL_RANGE_MIN_R+stngs.COL_RANGE_DR*cur_param) << 16) +
-					((unsigned int)(stngs.COL_RANGE_MIN_G+stngs.COL_RANGE_DG*cur_param) << 8) +
-					(unsigned int)(stngs.COL_RANGE_MIN_B+stngs.COL_RANGE_DB*cur_param);
-				viewsBuffer[x + z*renderCntX] = lencol;
-				UpdateSlot();
-				RenderFrame->repaint();
-				stabilityView->repaint();
-				app->processEvents();
+			}
+			QElapsedTimer localTime;
+			localTime.start();//int fstart = GetTickCount();
+			bool writeFailed = false;
+#pragma omp parallel
+			{
+				iAOrientationScratch scratch;
+				std::vector<char> threadRecord;
+#pragma omp for schedule(dynamic)
+				for (long long i = batchStart; i < batchEnd; ++i)
+				{
+					iASweepOrientation & orient = pending[i];
+					tracer->RenderOrientation(orient.rx, orient.ry, orient.rz, saveAdditionalData, dipAsColor, scratch);
+					//remember bad area percentage
+					scratch.render.badAreaPercentage = placementsParams[orient.x][orient.z].badAreaPercentage;
+					iARenderSetFile::serialize(scratch.render, saveAdditionalData, threadRecord);
+					orient.avPenLen = scratch.render.avPenetrLen;
+					orient.avDipAng = scratch.render.avDipAngle;
+					orient.maxPenLen = scratch.render.maxPenetrLen;
+#pragma omp critical
+					{
+						if (!setFile.append(orient.x, orient.y, orient.z, threadRecord))
+						{
+							writeFailed = true;
+						}
+					}
+					if (i == batchEnd - 1)
+					{	// show the image of the last orientation in the batch
+						std::copy(scratch.image.begin(), scratch.image.end(), tracer->getBuffer());
+					}
+				}
+			}
+			if (writeFailed)
+			{
+				log(QString("Error! %1").arg(setFile.errorMessage()));
+				tracer->SetCutAABBList(0);
+				return;
+			}
+			for (long long i = batchStart; i < batchEnd; ++i)
+			{
+				iASweepOrientation const & orient = pending[i];
+				addToPlacement(orient.x, orient.y, orient.z, orient.avPenLen, orient.avDipAng, orient.maxPenLen);
+				if (--missingY[orient.x + orient.z*renderCntX] == 0)
+				{
+					finishPlacement(orient.x, orient.z);
+				}
+			}
+			doneCount += batchEnd - batchStart;
+			int ftime = localTime.elapsed() / (batchEnd - batchStart);// GetTickCount() - fstart;
+			char t[] = "00:00.000";
+			Time2Char(ftime, t);
+			ui.TimeLabel->setText(t);
+			totalTime = totalQTime.elapsed();//GetTickCount() - totalStart;
+			char t2[] = "00:00.000";
+			Time2Char(totalTime, t2);
+			double percentage = ((double)doneCount)/totalRends*100;
+			ui.simulationProgress->setValue((int)percentage);
+			ui.l_ttime->setText( QString(t2) + "  "+QString::number(percentage)+"%");
+			iASweepOrientation const & last = pending[batchEnd - 1];
+			actor->SetOrientation(0,0,0);
+			actor->RotateWXYZ( vtkMath::DegreesFromRadians(last.rx)	,1,0,0 );//degrees
+			actor->RotateWXYZ( vtkMath::DegreesFromRadians(last.ry)	,0,1,0 );
+			actor->RotateZ   ( vtkMath::DegreesFromRadians(last.rz));
+			actor->SetPosition(set_pos[0], set_pos[1], set_pos[2]);
+			cutAABActor->SetOrientation(0,0,0);
+			cutAABActor->RotateWXYZ( vtkMath::DegreesFromRadians(last.rx)	,1,0,0 );//degrees
+			cutAABActor->RotateWXYZ( vtkMath::DegreesFromRadians(last.ry)	,0,1,0 );
+			cutAABActor->RotateZ   ( vtkMath::DegreesFromRadians(last.rz));
+			cutAABActor->SetPosition(set_pos[0], set_pos[1], set_pos[2]);
+			UpdateSlot();
+			RenderFrame->repaint();
+			stabilityView->repaint();
+			app->processEvents();
+			if (isStopped)
+			{
+				log(QString("Sweep stopped, %1 of %2 orientations are stored in the set file; "
+					"rendering the views again with the same parameters resumes it.").arg(doneCount).arg(totalRends));
+				tracer->SetCutAABBList(0);
+				return;
 			}
 		}
 		totalTime = totalQTime.elapsed();//GetTickCount() - totalStart;
@@ -988,7 +1114,7 @@ void iADreamCaster::RenderViewsSlot()
 	}
 	tracer->SetCutAABBList(0);
 	datasetOpened = true;
-	fclose(fptr);
+	setFile.close();
 	UpdatePlotSlot();
 }
 
@@ -1133,121 +1259,22 @@ void iADreamCaster::SaveSlot()
 
 void iADreamCaster::readRenderFromBinaryFile(unsigned int x, unsigned int y, unsigned int z, iARenderFromPosition *rend)
 {
-	FILE *fptr = fopen( getLocalEncodingFileName(setFileName).c_str() ,"rb");
-	if(!fptr)
+	if (!renderSet->isOpen() && !renderSet->openForReading(setFileName))
 	{
-		log(QString("Error! Cannot open set file '%1' for reading.").arg(setFileName));
+		log(QString("Error! %1").arg(renderSet->errorMessage()));
 		return;
 	}
-
-	int cntX, cntY, cntZ;
-	float minValX, maxValX, minValZ, maxValZ;
-	if (fread(&cntX, sizeof(cntX), 1, fptr) != 1 ||
-		fread(&minValX, sizeof(minValX), 1, fptr) != 1 ||
-		fread(&maxValX, sizeof(maxValX), 1, fptr) != 1 ||
-		fread(&cntY, sizeof(cntY), 1, fptr) != 1 ||
-		fread(&cntZ, sizeof(cntZ), 1, fptr) != 1 ||
-		fread(&minValZ, sizeof(minValZ), 1, fptr) != 1 ||
-		fread(&maxValZ, sizeof(maxValZ), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-
-		setRangeSB( minValX, maxValX, minValZ, maxValZ );
-	int cutAABCount;
-	//skip cut AAB data
-	if (fread(&cutAABCount, sizeof(cutAABCount), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-	for (int i=0; i<cutAABCount; i++)
-	{
-		if (fseek(fptr, CutAABSkipedSize, SEEK_CUR) != 0)
-		{
-			this->log("fseek error in readRenderFromBinaryFile!");
-		}
-	}
-	//
-	if(x>=(unsigned int)cntX || y>=(unsigned int)cntY || z>=(unsigned int)cntZ)
+	iARenderSetHeader const & h = renderSet->header();
+	setRangeSB(h.minX, h.maxX, h.minZ, h.maxZ);
+	if(x>=(unsigned int)h.cntX || y>=(unsigned int)h.cntY || z>=(unsigned int)h.cntZ)
 	{
 		log("Error! Set reading. Invalid index.");
-		fclose(fptr);
 		return;
 	}
-	int curRend = cntZ*cntY*x + y + cntY*z;//cntX*y + x;
-	unsigned int raysSize;
-	unsigned int intersectionsSize;
-	for(int i=0; i<curRend; i++)
+	if (!renderSet->read(x, y, z, *rend))
 	{
-		if (fseek(fptr, RenderFromPositionSkipedSize, SEEK_CUR) != 0)//skip rotx, roty, rotz, avpenlen, avdipangle, maxpenlen, badAreaPercentage, position//20+4*3
-		{
-			this->log("fseek error in readRenderFromBinaryFile!");
-		}
-		if (fread(&raysSize, sizeof(raysSize), 1, fptr) < 1)
-		{
-			this->log("fread error in readRenderFromBinaryFile!");
-		}
-		if (fread(&intersectionsSize, sizeof(intersectionsSize), 1, fptr) < 1)
-		{
-			this->log("fread error in readRenderFromBinaryFile!");
-		}
+		log("Error! Set reading. The rendering is not contained in the set file, or the file is corrupt.");
 	}
-	//now reading part =)
-	if (fread(&rend->rotX, sizeof(rend->rotX), 1, fptr) != 1 ||
-		fread(&rend->rotY, sizeof(rend->rotY), 1, fptr) != 1 ||
-		fread(&rend->rotZ, sizeof(rend->rotY), 1, fptr) != 1 ||
-		fread(rend->pos, sizeof(rend->pos), 1, fptr) != 1 ||
-		fread(&rend->avPenetrLen, sizeof(rend->avPenetrLen), 1, fptr) != 1 ||
-		fread(&rend->avDipAngle, sizeof(rend->avDipAngle), 1, fptr) != 1 ||
-		fread(&rend->maxPenetrLen, sizeof(rend->maxPenetrLen), 1, fptr) != 1 ||
-		fread(&rend->badAreaPercentage, sizeof(rend->badAreaPercentage), 1, fptr) != 1 ||
-		fread(&rend->raysSize, sizeof(rend->raysSize), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-	//NOTE: let this code stay, saving additional data it is not used, but who knows
-	int rx,ry;
-	float rtpl, avpl;
-	unsigned int psize;
-	for (unsigned int i=0; i<rend->raysSize; i++)
-	{
-		if (fread(&rx, sizeof(rx), 1, fptr) != 1 ||
-			fread(&ry, sizeof(ry), 1, fptr) != 1 ||
-			fread(&rtpl, sizeof(rtpl), 1, fptr) != 1 ||
-			fread(&avpl, sizeof(avpl), 1, fptr) != 1 ||
-			fread(&psize, sizeof(psize), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
-		rend->rays.push_back(new iARayPenetration(rx,ry,rtpl,avpl));
-	}
-	if (fread(&rend->intersectionsSize, sizeof(rend->intersectionsSize), 1, fptr) != 1)
-	{
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-	int tri_index;
-	float cos_ang;
-	for (unsigned int i=0; i<rend->intersectionsSize; i++)
-	{
-		if (fread(&tri_index, sizeof(tri_index), 1, fptr) != 1 ||
-			fread(&cos_ang, sizeof(cos_ang), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
-		rend->intersections.push_back(new iAIntersection(tri_index, cos_ang));
-	}
-	fclose(fptr);
 }
 
 void iADreamCaster::closeEvent ( QCloseEvent * /*event*/ )
@@ -1543,50 +1570,27 @@ void iADreamCaster::pbGrab3DSlot()
 
 void iADreamCaster::UpdatePlotSlot()
 {
-	FILE *fptr = fopen( getLocalEncodingFileName(setFileName).c_str(),"rb");
-	if(!fptr)
+	if (!renderSet->openForReading(setFileName))
 	{
-		log(QString("Error! Cannot open set file '%1' for reading.").arg(setFileName));
+		log(QString("Error! %1").arg(renderSet->errorMessage()));
 		return;
 	}
 	ClearPrevData();
-	float minValX, maxValX, minValZ, maxValZ;
-
-	if (fread(&renderCntX, sizeof(renderCntX), 1, fptr) != 1 ||
-		fread(&minValX, sizeof(minValX), 1, fptr) != 1 ||
-		fread(&maxValX, sizeof(maxValX), 1, fptr) != 1 ||
-		fread(&renderCntY, sizeof(renderCntY), 1, fptr) != 1 ||
-		fread(&renderCntZ, sizeof(renderCntZ), 1, fptr) != 1 ||
-		fread(&minValZ, sizeof(minValZ), 1, fptr) != 1 ||
-		fread(&maxValZ, sizeof(maxValZ), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-
-	setRangeSB( minValX, maxValX, minValZ, maxValZ );
+	iARenderSetHeader const & header = renderSet->header();
+	renderCntX = header.cntX;
+	renderCntY = header.cntY;
+	renderCntZ = header.cntZ;
+	setRangeSB( header.minX, header.maxX, header.minZ, header.maxZ );
 	//read cut AABs
 	cutFigList->clear();
 	ui.listCutFig->clear();
-	int aabSize;
-	iAaabb box;
-	if (fread(&aabSize, sizeof(aabSize), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-	for (int i=0; i<aabSize; i++)
+	size_t const cutAABSize = iACutAAB::getSkipedSizeInFile();
+	for (int i=0; i<header.cutAABCount; i++)
 	{
 		iACutAAB *newCutAAB = new iACutAAB("BOX"+QString::number(i));
-		if (fread(&newCutAAB->box, sizeof(iAaabb), 1, fptr) != 1 ||
-			fread(newCutAAB->slidersValues, sizeof(int)* 6, 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
+		char const * cutAABData = header.cutAABs.data() + i * cutAABSize;
+		std::memcpy(&newCutAAB->box, cutAABData, sizeof(iAaabb));
+		std::memcpy(newCutAAB->slidersValues, cutAABData + sizeof(iAaabb), sizeof(newCutAAB->slidersValues));
 		int index = cutFigList->add(newCutAAB);
 		cutFigList->SetCurIndex(index);
 		ui.listCutFig->insertItem( ui.listCutFig->count(), newCutAAB->name()+": "+newCutAAB->GetDimString());
@@ -1618,12 +1622,6 @@ void iADreamCaster::UpdatePlotSlot()
 	std::fill(viewsBuffer, viewsBuffer+s, 0);
 
 	AllocateData();
-	unsigned int raysSize;
-	unsigned int isecSize;
-	float avpl;
-	float avang;
-	float maxpl;
-	float badArPrcnt;
 	float curParam = 0.0f;
 	double max_param=-1000;
 	double min_param = 10000;
@@ -1637,49 +1635,30 @@ void iADreamCaster::UpdatePlotSlot()
 			placementsParams[x][z] = iAparameters_t();
 		}
 	}
+	if (renderSet->storedCount() < header.renderCount())
+	{
+		log(QString("The set file only contains %1 of %2 orientations; rendering the views again with the same "
+			"parameters completes it.").arg(renderSet->storedCount()).arg(header.renderCount()));
+	}
+	iARenderFromPosition rend;
 	for (int x = 0; x < renderCntX; x++)
 	{
 		for (int z = 0; z < renderCntZ; z++)
 		{
 			for (int y = 0; y < renderCntY; y++)
 			{
-				if (fread(&rotations[x][y][z].rotX, sizeof(rotations[x][y][z].rotX), 1, fptr) != 1)
-				{
-					fclose(fptr);
-					log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-					return;
-				}
-				rotations[x][y][z].rotX /= M_PI;
-				if (fread(&rotations[x][y][z].rotY, sizeof(rotations[x][y][z].rotY), 1, fptr) != 1)
-				{
-					fclose(fptr);
-					log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-					return;
-				}
-				rotations[x][y][z].rotY /= M_PI;
-				if (fread(&rotations[x][y][z].rotZ, sizeof(rotations[x][y][z].rotZ), 1, fptr) != 1)
-				{
-					fclose(fptr);
-					log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-					return;
-				}
-				rotations[x][y][z].rotZ /= M_PI;
-				if (fread(&set_pos[0], sizeof(float), 1, fptr) != 1 ||
-					fread(&set_pos[1], sizeof(float), 1, fptr) != 1 ||
-					fread(&set_pos[2], sizeof(float), 1, fptr) != 1 ||
-					fread(&avpl, sizeof(avpl), 1, fptr) != 1 ||
-					fread(&avang, sizeof(avang), 1, fptr) != 1 ||
-					fread(&maxpl, sizeof(maxpl), 1, fptr) != 1 ||
-					fread(&badArPrcnt, sizeof(badArPrcnt), 1, fptr) != 1)
+				if (!renderSet->read(x, y, z, rend, false))
 				{
-					fclose(fptr);
-					log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-					return;
+					continue;
 				}
-				rotationsParams[x][y][z].avPenLen = avpl;
-				rotationsParams[x][y][z].avDipAng = avang;
-				rotationsParams[x][y][z].maxPenLen = maxpl;
-				rotationsParams[x][y][z].badAreaPercentage = badArPrcnt;
+				rotations[x][y][z].rotX = rend.rotX / M_PI;
+				rotations[x][y][z].rotY = rend.rotY / M_PI;
+				rotations[x][y][z].rotZ = rend.rotZ / M_PI;
+				std::copy(rend.pos, rend.pos + 3, set_pos);
+				rotationsParams[x][y][z].avPenLen = rend.avPenetrLen;
+				rotationsParams[x][y][z].avDipAng = rend.avDipAngle;
+				rotationsParams[x][y][z].maxPenLen = rend.maxPenetrLen;
+				rotationsParams[x][y][z].badAreaPercentage = rend.badAreaPercentage;
 				placementsParams[x][z].avPenLen += rotationsParams[x][y][z].avPenLen;
 				placementsParams[x][z].avDipAng += rotationsParams[x][y][z].avDipAng;
 				if (rotationsParams[x][y][z].maxPenLen > placementsParams[x][z].maxPenLen)
@@ -1687,14 +1666,6 @@ void iADreamCaster::UpdatePlotSlot()
 					placementsParams[x][z].maxPenLen = rotationsParams[x][y][z].maxPenLen;
 				}
 				placementsParams[x][z].badAreaPercentage = rotationsParams[x][y][z].badAreaPercentage;
-
-				if (fread(&raysSize, sizeof(raysSize), 1, fptr) != 1 ||
-					fread(&isecSize, sizeof(isecSize), 1, fptr) != 1)
-				{
-					fclose(fptr);
-					log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-					return;
-				}
 			}
 		}
 	}
@@ -1809,7 +1780,6 @@ void iADreamCaster::UpdatePlotSlot()
 		}
 	}
 	UpdateSlot();
-	fclose(fptr);
 }
 
 void iADreamCaster::SaveTree()
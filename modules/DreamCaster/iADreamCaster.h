@@ -28,6 +28,7 @@ struct iAParamWidget;
 struct iAParametersView;
 class iAPlot3DVtk;
 class iARenderFromPosition;
+class iARenderSetFile;
 class iAScreenBuffer;
 class iAStabilityWidget;
 
@@ -81,6 +82,7 @@ private:
 	iAStabilityWidget *stabilityView;   //!< Widget representing stability of current specimen orientation
 	QString modelFileName;              //!< filename of .stl file containing object
 	QString setFileName;                //!< filename of file containing current set of renderings
+	iARenderSetFile * renderSet;        //!< current set of renderings, opened for random access
 
 	// VTK classes instances for interactive 3D view
 	vtkPolyDataMapper *mapper, *originMapper, *planeMapper, *raysMapper, *raysProjMapper, *plateMapper, *cutAABMapper;
@@ -388,6 +388,34 @@ protected:
 	iATrace * t;
 };
 
+//! Stack used for traversing the tree with a packet of rays; the entries contain the parametric
+//! range of each ray inside the node and the mask of rays which reach the node.
+struct iAPacketTraverseStack
+{
+	struct iATrace {
+		unsigned int node;
+		unsigned int mask;
+		float tmin[iARayPacket::Size];
+		float tmax[iARayPacket::Size];
+	};
+	std::vector<iATrace> t;
+};
+
+//! Hits of the rays of a packet with triangles, separately for each ray (as structure of arrays).
+struct iAPacketHits
+{
+	void clear()
+	{
+		for (int l = 0; l < iARayPacket::Size; ++l)
+		{
+			tris[l].clear();
+			dists[l].clear();
+		}
+	}
+	std::vector<iATriPrim*> tris[iARayPacket::Size];
+	std::vector<float> dists[iARayPacket::Size];
+};
+
 //! Class representing a BSP-tree. Assigned with root node, level and AABB.
 class iABSPTree
 {
@@ -525,6 +553,99 @@ public:
 		}
 		return 1;
 	}
+	//! Finds all intersections between the rays of a packet and the primitives of the tree.
+	//! @note Each ray reaches exactly the nodes (with the same parametric range) it reaches in
+	//! GetIntersectionsNR, and the leaves are visited in the same order, so the hits of each ray are
+	//! the same and in the same order as if the ray was traced alone.
+	//! @param packet the rays
+	//! @param mask bit mask of the rays (lanes of the packet) to trace
+	//! @param[out] hits the hits of each ray are appended here
+	//! @param tr_stack stack memory used for the traversal
+	void GetPacketIntersectionsNR(iARayPacket & packet, unsigned int mask, iAPacketHits & hits, iAPacketTraverseStack & tr_stack) const
+	{
+		iAPacketTraverseStack::iATrace cur_t;
+		cur_t.node = 0;
+		cur_t.mask = 0;
+		for (int l = 0; l < iARayPacket::Size; ++l)
+		{
+			float tmin = 0, tmax = 100000.f;
+			if ((mask & (1u << l)) && IntersectAABB(packet.rays[l], m_aabb, tmin, tmax))
+			{
+				cur_t.mask |= 1u << l;
+			}
+			cur_t.tmin[l] = tmin;
+			cur_t.tmax[l] = tmax;
+		}
+		if (!cur_t.mask)
+		{
+			return;
+		}
+		tr_stack.t.clear();
+		tr_stack.t.push_back(cur_t);
+		float dists[iARayPacket::Size];
+		iAPacketTraverseStack::iATrace left_t, right_t;
+		while (!tr_stack.t.empty())
+		{
+			cur_t = tr_stack.t.back();
+			tr_stack.t.pop_back();
+			iABSPNode * cur_node = nodes[cur_t.node];
+			if (cur_node->isLeaf())
+			{
+				for (unsigned int i = 0; i < cur_node->tri_count(); i++)
+				{
+					iATriPrim * tri = (*m_triangles)[tri_ind[cur_node->tri_start() + i]];
+					unsigned int hitMask = tri->Intersect(packet, cur_t.mask, dists);
+					for (int l = 0; hitMask; ++l, hitMask >>= 1)
+					{
+						if (hitMask & 1)
+						{
+							hits.tris[l].push_back(tri);
+							hits.dists[l].push_back(dists[l]);
+						}
+					}
+				}
+				continue;
+			}
+			// per ray, the same decisions as in GetIntersectionState:
+			int axis = cur_node->axisInd();
+			float split = cur_node->splitCoord();
+			float const * org = packet.org[axis];
+			float const * dir = packet.dir[axis];
+			unsigned int leftMask = 0, rightMask = 0;
+			for (int l = 0; l < iARayPacket::Size; ++l)
+			{
+				float rd = dir[l];
+				if (!rd)
+					rd = 0.00000001f;
+				float t = (split - org[l]) / rd;
+				bool positive = (rd >= 0.0f);
+				bool before = t < cur_t.tmin[l];
+				bool after = !before && t > cur_t.tmax[l];
+				bool both = !before && !after;
+				bool toLeft = both || (before && !positive) || (after && positive);
+				bool toRight = both || (before && positive) || (after && !positive);
+				left_t.tmin[l]  = (both && !positive) ? t : cur_t.tmin[l];
+				left_t.tmax[l]  = (both &&  positive) ? t : cur_t.tmax[l];
+				right_t.tmin[l] = (both &&  positive) ? t : cur_t.tmin[l];
+				right_t.tmax[l] = (both && !positive) ? t : cur_t.tmax[l];
+				leftMask  |= static_cast<unsigned int>(toLeft)  << l;
+				rightMask |= static_cast<unsigned int>(toRight) << l;
+			}
+			// right before left, so that the left child is processed first, as in GetIntersectionsNR:
+			right_t.mask = rightMask & cur_t.mask;
+			if (right_t.mask && cur_node->has_right())
+			{
+				right_t.node = cur_node->offset() + 1;
+				tr_stack.t.push_back(right_t);
+			}
+			left_t.mask = leftMask & cur_t.mask;
+			if (left_t.mask && cur_node->has_left())
+			{
+				left_t.node = cur_node->offset();
+				tr_stack.t.push_back(left_t);
+			}
+		}
+	}
 	//! Saves tree in file specified by filename.
 	//! @note tree in file [splitLevel][aabb][num nodes][n0...nN][num tri inds][ti1...tiN]
 	//! @param filename filename of ouput file
@@ -99,6 +99,8 @@ public:
 	std::vector<iARayPenetration*> rays; //!<rays' penetrations data
 	std::vector<iARayPenetration*> rawPtrRaysVec;
 	std::vector<iAIntersection*> intersections; //!< intersections data
+	//! arrays the intersections point into; if empty, each intersection is allocated separately
+	std::vector<iAIntersection*> rawPtrIntersectionsVec;
 	unsigned int intersectionsSize; //!< number of intersections
 
 	//! Clears all statistical data (penetrations and intersectoins data).
@@ -110,10 +112,18 @@ public:
 		}
 		rawPtrRaysVec.clear();
 		rays.clear();
-		for (unsigned int i=0; i<intersections.size(); i++)
+		if (rawPtrIntersectionsVec.empty())
 		{
-			delete intersections[i];
+			for (unsigned int i=0; i<intersections.size(); i++)
+			{
+				delete intersections[i];
+			}
 		}
+		for (unsigned int i=0; i<rawPtrIntersectionsVec.size(); i++)
+		{
+			delete [] rawPtrIntersectionsVec[i];
+		}
+		rawPtrIntersectionsVec.clear();
 		intersections.clear();
 		intersectionsSize=0;
 		raysSize=0;
@@ -2,13 +2,14 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #pragma once
 
-#include <QThread>
-
 #include "iADreamCasterCommon.h"
 #include "iADataFormat.h"
 
 #include "cl_common.h"
 
+#include <memory>
+#include <vector>
+
 //! Class representing a ray in 3D.
 class iARay
 {
@@ -25,14 +26,46 @@ private:
 	iAVec3f m_Direction; //!< ray direction vector
 };
 
+//! Packet of rays which are traced through the scene together.
+//! Origins and directions are additionally stored as structure of arrays, so that the computations
+//! for all rays of the packet (in iABSPTree and iATriPrim) can be vectorized by the compiler.
+struct iARayPacket
+{
+	static const int Size = 8; //!< number of rays in a packet
+	//! Sets the ray at the given lane of the packet.
+	void set(int lane, iARay const & ray)
+	{
+		rays[lane] = ray;
+		for (int a = 0; a < 3; ++a)
+		{
+			org[a][lane] = ray.GetOrigin()[a];
+			dir[a][lane] = ray.GetDirection()[a];
+		}
+	}
+	iARay rays[Size];
+	float org[3][Size]; //!< per axis, the origin coordinate of all rays
+	float dir[3][Size]; //!< per axis, the direction coordinate of all rays
+};
+
 class iAScene;
-class iARaycastingThread;
+class iATriPrim;
+struct iARaycastingArena;
 struct iATraverseStack;
 
+//! Scratch memory for rendering a single orientation with iAEngine::RenderOrientation.
+//! Several orientations can be rendered concurrently, each with its own scratch.
+struct iAOrientationScratch
+{
+	iAOrientationScratch();
+	~iAOrientationScratch();
+	iARenderFromPosition render;       //!< statistical data about the orientation rendered last
+	std::vector<unsigned int> image;   //!< image of the orientation rendered last
+	std::vector<std::unique_ptr<iARaycastingArena>> arenas; //!< scratch memory for each rendering thread
+};
+
 //! Class in charge of the raycasting process; it is used to init the render system, start the rendering process and contains all scene data.
 class iAEngine
 {
-	friend class iARaycastingThread;
 public:
 	iAEngine(iADreamCasterSettings * settings, float * dc_cuda_avpl_buff,	float * dc_cuda_dipang_buff );
 	~iAEngine();
@@ -51,6 +84,8 @@ public:
 	//! @param vp_delta [out] plane's x and y axes' directions in 3D
 	//! @param o [out] ray's origin point in world coordinates
 	void InitRender(iAVec3f * vp_corners, iAVec3f * vp_delta, iAVec3f * o);
+	//! Computes the screen plane and the rays' origin for the given rotations (instead of the engine's current ones).
+	void InitRender(float a_X, float a_Y, float a_Z, iAVec3f * vp_corners, iAVec3f * vp_delta, iAVec3f * o) const;
 	//! Transforms vector corresponding to rotation and position
 	//! @param vec Vector to transform
 	void Transform(iAVec3f * vec);
@@ -64,8 +99,19 @@ public:
 	//! @param rasterization whether to use rasterization
 	//! @return true
 	bool Render(const iAVec3f * vp_corners, const iAVec3f * vp_delta, const iAVec3f * o, bool rememberData = true, bool dipAsColor = false, bool cuda_enabled=false, bool rasterization = false);
-	//! Render scene on CPU
+	//! Render scene on CPU. The screen is split into small tiles, which are distributed dynamically among the
+	//! threads of the OpenMP pool; inside a tile, rays are traced in packets of iARayPacket::Size rays.
 	bool RenderCPU(const iAVec3f * vp_corners, const iAVec3f * vp_delta, const iAVec3f * o, bool rememberData = true, bool dipAsColor = false);
+	//! Render scene for the given rotations on CPU, into the given scratch instead of curRender and the target canvas.
+	//! Does not change the state of the engine, so several orientations can be rendered concurrently (each
+	//! with its own scratch), as long as scene, position and cut AABBs are not modified meanwhile.
+	//! @param a_X rotation about x axis
+	//! @param a_Y rotation about y axis
+	//! @param a_Z rotation about z axis
+	//! @param rememberData whether to keep rays and intersections (averages and maximum are always computed)
+	//! @param dipAsColor draw image colored corresponding to dip angles.
+	//! @param scratch [out] scratch memory, receives the results
+	void RenderOrientation(float a_X, float a_Y, float a_Z, bool rememberData, bool dipAsColor, iAOrientationScratch & scratch) const;
 	//! Render scene on GPU
 	bool RenderGPU(const iAVec3f * vp_corners, const iAVec3f * vp_delta, const iAVec3f * o, bool rememberData = true, bool dipAsColor = false, bool rasterization = false);
 	bool RenderBatchGPU(unsigned int batchSize, iAVec3f *os, iAVec3f * corns, iAVec3f * deltaxs, iAVec3f * deltays, float * rotsX, float * rotsY, float * rotsZ, bool rememberData = true, bool dipAsColor = false);
@@ -126,6 +172,7 @@ protected:
 	float * cuda_avpl_buff;  //!<float buffer used by cuda to store the results recieved from DreamCaster
 	float * cuda_dipang_buff;//!<float buffer used by cuda to store the results recieved from DreamCaster
 	iADreamCasterSettings * s;
+	std::vector<std::unique_ptr<iARaycastingArena>> m_arenas; //!< scratch memory for each CPU rendering thread
 
 //! Properties and methods for OpenCL raycasting
 private://properties
@@ -146,6 +193,26 @@ private://properties
 
 private://methods
 	void InitOpenCL();
+	//! Whether the ray hits any of the cut AABBs (always true if no cut AABBs are set).
+	bool HitsCutAABBs(iARay const & ray) const;
+	//! Renders the screen tiles into render and dest, using the given arenas as scratch memory.
+	void RenderTiles(const iAVec3f * vp_corners, const iAVec3f * vp_delta, const iAVec3f * o, bool rememberData, bool dipAsColor,
+		iARenderFromPosition & render, unsigned int * dest, std::vector<std::unique_ptr<iARaycastingArena>> & arenas) const;
+	//! Computes penetration data and color of a ray from all of its hits with the scene's triangles.
+	//! @param ray the ray
+	//! @param tris the triangles hit by the ray (in order of traversal)
+	//! @param dists distance of each hit along the ray
+	//! @param hitCount number of hits
+	//! @param order scratch memory for sorting the hits
+	//! @param ray_p [out] penetration data of the ray
+	//! @param acc [out] color of the ray
+	//! @param dipAsColor whether to color by dip angle instead of by penetration length
+	//! @param isecTri [out] if not null, the triangle index of each intersection is appended
+	//! @param isecDip [out] if not null, the dip angle cos of each intersection is appended
+	//! @return 1 if the ray hit the scene, 0 otherwise
+	int ShadeRay(iARay & ray, iATriPrim * const * tris, float const * dists, size_t hitCount,
+		std::vector<unsigned int> & order, iARayPenetration * ray_p, iAVec3f & acc, bool dipAsColor,
+		std::vector<unsigned int> * isecTri, std::vector<float> * isecDip) const;
 public://TODO: qndh
 	void AllocateOpenCLBuffers();
 	void setup_nodes( void * data );
@@ -179,66 +246,3 @@ private:
 		float* out_res,
 		float * out_dip_res );
 };
-
-//! Class in charge of raycasting process. Executes raycastring on tile prescribed by X,Y screen coordinates ranges(in pixels).
-//! Used directly for rendering process. Has a pointer on parent Engine class, which is used to obtain scene data and to store some results.
-class iARaycastingThread : public QThread
-{
-public:
-	iARaycastingThread(iAEngine* a_engine){
-		e = a_engine;
-	};
-	iARaycastingThread(){
-		e = 0;
-		rays = 0;
-	};
-	~iARaycastingThread(){
-	};
-	//! Sets parent Engine pointer.
-	inline void setEngine(iAEngine* a_e)
-	{
-		e=a_e;
-	}
-	//! Sets position of plane and ray's origin.
-	inline void setPlaneAndOrigin( const iAVec3f *vp_corners, const iAVec3f *vp_delta, const iAVec3f *o)
-	{
-		m_o = o;
-		m_vp_corners = vp_corners;
-		m_vp_delta = vp_delta;
-	}
-	//! Gets rays' penetrations data.
-	inline iARayPenetration * getRays()
-	{
-		return rays;
-	}
-	//! Gets intersections data.
-	inline std::vector<iAIntersection*> * getIntersections()
-	{
-		return &intersections;
-	}
-	//! Runs thread, executes raycasting of thread's tile.
-	void run();
-	void stop()
-	{
-		stopped = true;
-	}
-	//! Free memory that has been allocated for rays and intersections.
-	void clearMemory()
-	{
-		if(rays)
-			delete [] rays;
-		for (unsigned int i=0; i<intersections.size(); i++)
-			delete intersections[i];
-	}
-	int x1,x2,y1,y2;
-	int rayCount;    //!< number of casted rays
-	bool dipAsColor; //!< image colored corresponding to dip angles
-private:
-	const iAVec3f *m_o;                       //!< rays' origin point
-	const iAVec3f *m_vp_corners;              //!< plane's corners in 3d
-	const iAVec3f *m_vp_delta;                //!< plane's x and y axes' directions in 3D
-	iAEngine* e;                                //!< parent Engine
-	iARayPenetration * rays;                    //!< rays' penetrations data
-	std::vector<iAIntersection*> intersections; //!< intersections data
-	volatile bool stopped;
-};
@@ -0,0 +1,105 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+class iARenderFromPosition;
+class iAScene;
+
+//! Parameters of an orientation sweep, as stored at the beginning of a set file.
+struct iARenderSetHeader
+{
+	int cntX = 0, cntY = 0, cntZ = 0;  //!< number of orientations about x, y and z axis
+	float minX = 0, maxX = 0;          //!< range of rotations about x axis (in multiples of pi)
+	float minZ = 0, maxZ = 0;          //!< range of rotations about z axis (in multiples of pi)
+	int cutAABCount = 0;               //!< number of cut AABBs
+	std::vector<char> cutAABs;         //!< box and slider values of each cut AABB, as written by iACutAAB::Write2File
+	// the following are only stored in indexed set files; they are used to check whether a sweep can be resumed:
+	unsigned int triangleCount = 0;    //!< number of triangles of the model
+	quint64 modelHash = 0;             //!< hash of the vertex coordinates of the model (see computeModelHash)
+	int radonMode = 0;                 //!< Radon space analysis mode (0: disabled, 1: enabled, 2: Radon analysis only)
+	float pos[3] = {0, 0, 0};          //!< position of the model
+	float originZ = 0, planeZ = 0;     //!< z coordinate of the rays' origin and of the screen plane
+	float planeHalfW = 0, planeHalfH = 0; //!< half width and height of the screen plane
+	int frameW = 0, frameH = 0;        //!< number of rays in x and y direction
+	int saveAdditionalData = 0;        //!< whether rays and intersections are stored for each orientation
+
+	//! number of orientations in the sweep
+	size_t renderCount() const;
+	//! whether the sweep described by the other header produces the same results as this one
+	bool matches(iARenderSetHeader const & other) const;
+	//! hash of the vertex coordinates of all triangles of the given scene, to detect a changed model
+	static quint64 computeModelHash(iAScene & scene);
+};
+
+//! Set file, storing the results of an orientation sweep (one iARenderFromPosition record per orientation).
+//!
+//! The header is followed by an index, which holds the file offset of the record of each orientation (0 for
+//! orientations not computed yet). Records are appended in the order in which they are finished, so orientations can
+//! be computed concurrently, and an interrupted sweep can be resumed by computing the orientations missing in the
+//! index. For reading, the file is memory-mapped, so that any orientation can be accessed directly.
+//! Set files in the former format (records of all orientations in sequential order, without index) can be read as
+//! well; their index is built by scanning the file once when opening it.
+class iARenderSetFile
+{
+public:
+	iARenderSetFile();
+	~iARenderSetFile();
+	//! Opens an existing set file for reading.
+	//! @return true if the file could be opened and its header and index are valid, false otherwise (see errorMessage)
+	bool openForReading(QString const & fileName);
+	//! Opens a set file for storing the results of a sweep.
+	//! @param fileName the name of the set file
+	//! @param header the parameters of the sweep
+	//! @param resume if true, and the file is an indexed set file of a sweep with matching parameters, the
+	//!        orientations stored in it are kept; otherwise a new file is created
+	//! @return true if the file could be opened or created, false otherwise (see errorMessage)
+	bool openForWriting(QString const & fileName, iARenderSetHeader const & header, bool resume);
+	void close();
+	bool isOpen() const;
+	QString const & errorMessage() const;
+	iARenderSetHeader const & header() const;
+	//! number of orientations stored in the file
+	size_t storedCount() const;
+	//! linear index of the given orientation (orientations about y axis vary fastest, those about x axis slowest)
+	size_t renderIndex(int x, int y, int z) const;
+	//! whether the results of the given orientation are stored in the file
+	bool contains(int x, int y, int z) const;
+	//! Reads the results of a single orientation.
+	//! @param x x-index of the orientation
+	//! @param y y-index of the orientation
+	//! @param z z-index of the orientation
+	//! @param[out] rend the results; previous contents are cleared
+	//! @param withAdditionalData whether to read rays and intersections (if stored); if false,
+	//!        only the parameters and averages are read, and rend contains no rays and intersections
+	bool read(int x, int y, int z, iARenderFromPosition & rend, bool withAdditionalData = true) const;
+	//! Writes a record (see serialize) to the end of the file, then stores its offset in the index.
+	//! Not thread-safe; the record is completely written before the index is updated, so a sweep interrupted
+	//! at any point can be resumed.
+	bool append(int x, int y, int z, std::vector<char> const & record);
+	//! Serializes the results of one orientation into a record; can be called concurrently.
+	//! @param rend the results of the orientation
+	//! @param saveAdditionalData whether to store rays and intersections
+	//! @param[out] record the serialized results
+	static void serialize(iARenderFromPosition const & rend, bool saveAdditionalData, std::vector<char> & record);
+
+private:
+	bool readBytes(qint64 offset, void * dst, qint64 size) const;
+	bool readHeader(qint64 & pos, bool & indexed);
+	bool buildSequentialIndex(qint64 pos);
+	bool fail(QString const & message);
+
+	mutable QFile m_file;
+	uchar * m_map;
+	qint64 m_size;
+	qint64 m_indexOffset;
+	bool m_writing;
+	iARenderSetHeader m_header;
+	std::vector<quint64> m_index;
+	size_t m_storedCount;
+	QString m_error;
+};
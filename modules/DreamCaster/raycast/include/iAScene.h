@@ -185,6 +185,12 @@ public:
 	}
 	float &d() {return m_d;}
 	int Intersect(iARay& a_Ray, float& a_Dist ) const;
+	//! Intersects all rays of a packet with the triangle; same results as Intersect for each ray separately.
+	//! @param packet the rays
+	//! @param mask bit mask of the rays (lanes of the packet) to consider
+	//! @param[out] dists for each ray hitting the triangle, the distance of the hit
+	//! @return bit mask of the rays hitting the triangle
+	unsigned int Intersect(iARayPacket const & packet, unsigned int mask, float * dists) const;
 	int Intersect(iAaabb &a_aabb, iAVec3f & a_BoxCentre, iAVec3f & a_BoxHalfsize) const;
 	int CenterInside(iAaabb &a_aabb) const;
 	inline float GetAngleCos(iARay& a_Ray){ return a_Ray.GetDirection()&m_Tri.N; }
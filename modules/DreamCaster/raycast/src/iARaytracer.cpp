@@ -7,7 +7,12 @@
 
 #include <QFile>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <algorithm>
+#include <numeric>
 #include <vector>
 
 #define MAX_CUT_AAB_COUNT 10
@@ -20,6 +25,60 @@ static const char * clDreamcaster_Source[] = {
 
 //namespace Raytracer {
 
+namespace
+{
+	//! edge length (in pixels) of the square screen tiles which are distributed among the CPU rendering threads
+	const int TileSize = 16;
+
+	//! results of rendering one screen tile on the CPU
+	struct iATileResult
+	{
+		size_t arena = 0;       //!< index of the arena holding the intersections of the tile
+		size_t isecStart = 0;   //!< index of the first intersection of the tile in its arena
+		size_t isecCount = 0;   //!< number of intersections of the tile
+		float penetrLenSum = 0; //!< sum of the penetration lengths of all rays penetrating the object
+		float maxPenetrLen = 0; //!< maximum penetration length of all rays
+		float dipAngleSum = 0;  //!< sum of absolute dip angle cos of all intersections
+		unsigned int penetratingRays = 0; //!< number of rays penetrating the object
+	};
+
+	int threadIndex()
+	{
+#ifdef _OPENMP
+		return omp_get_thread_num();
+#else
+		return 0;
+#endif
+	}
+
+	int maxThreadCount()
+	{
+#ifdef _OPENMP
+		return omp_get_max_threads();
+#else
+		return 1;
+#endif
+	}
+}
+
+//! Scratch memory of a CPU rendering thread, kept over renderings to avoid repeated allocations.
+struct iARaycastingArena
+{
+	iARayPacket packet;
+	iAPacketHits hits;
+	iAPacketTraverseStack stack;
+	std::vector<unsigned int> order; //!< used for sorting the hits of a ray
+	//! intersections found by this thread in the current rendering (structure of arrays):
+	std::vector<unsigned int> isecTri;
+	std::vector<float> isecDip;
+};
+
+iAOrientationScratch::iAOrientationScratch()
+{}
+
+iAOrientationScratch::~iAOrientationScratch()
+{}
+
 iARay::iARay( iAVec3f & a_Origin, iAVec3f & a_Dir ) :
 	m_Origin( a_Origin ),
 	m_Direction( a_Dir )
@@ -84,120 +143,127 @@ void iAEngine::SetTarget( unsigned int* a_Dest)
 	m_DY = (m_WY2 - m_WY1) / m_Height;
 }
 
-// -----------------------------------------------------------
-// iAEngine::Raytrace
-// Naive ray tracing: Intersects the ray with every primitive
-// in the scene to determine the closest intersection
-// -----------------------------------------------------------
-bool intersectionCompare(iAintersection *e1, iAintersection *e2 )
-{
-	return e1->dist < e2->dist;
-}
-
-int iAEngine::DepthRaytrace(iARay& a_Ray, iAVec3f & a_Acc, int a_Depth, float /*a_RIndex*/, float& a_Dist, iARayPenetration * ray_p, std::vector<iAIntersection*> &vecIntersections, iATraverseStack * stack, bool dipAsColor )
+bool iAEngine::HitsCutAABBs(iARay const & ray) const
 {
-	if (a_Depth > s->TRACEDEPTH) return 0;
-	// trace primary ray
-	a_Dist = 1000000.0f;
-	iAVec3f pi;
-	std::vector<iAintersection*> intersections;
-	// find intersections
-	unsigned int cutAABBListSize;
-	if(m_cutAABBList)
-		cutAABBListSize = m_cutAABBListSize;
-	else
-		cutAABBListSize = 0;
-	if(cutAABBListSize)
+	unsigned int cutAABBListSize = m_cutAABBList ? m_cutAABBListSize : 0;
+	if (!cutAABBListSize)
 	{
-		bool intersects = false;
-		for (unsigned int i=0; i<cutAABBListSize; i++)
+		return true;
+	}
+	for (unsigned int i=0; i<cutAABBListSize; i++)
+	{
+		float a,b;
+		//if(IntersectCyl(ray, *((*m_cutAABBList)[i]), a, b, 1))
+		if(IntersectAABB(ray, *((*m_cutAABBList)[i]), a, b))
 		{
-			float a,b;
-			//if(IntersectCyl(a_Ray, *((*m_cutAABBList)[i]), a, b, 1))
-			if(IntersectAABB(a_Ray, *((*m_cutAABBList)[i]), a, b))
-			{
-				intersects = true;
-				break;
-			}
+			return true;
 		}
-		if(!intersects)
-			return 0;
 	}
-	m_Scene->getBSPTree()->GetIntersectionsNR(a_Ray, intersections,stack);
-	if(intersections.size()==0)
+	return false;
+}
+
+int iAEngine::ShadeRay(iARay & ray, iATriPrim * const * tris, float const * dists, size_t hitCount,
+	std::vector<unsigned int> & order, iARayPenetration * ray_p, iAVec3f & acc, bool dipAsColor,
+	std::vector<unsigned int> * isecTri, std::vector<float> * isecDip) const
+{
+	if (hitCount == 0)
+	{
 		return 0;
-	std::sort(intersections.begin(), intersections.end(), intersectionCompare);
+	}
+	// sort by distance; sorting the indices takes the same steps as sorting the hits themselves:
+	order.resize(hitCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::sort(order.begin(), order.end(), [dists](unsigned int a, unsigned int b) { return dists[a] < dists[b]; });
 	//delete coincident intersections
-	//it happens when ray hits common edge of 2 neighboring triangles
-	ray_p->penetrationsSize=0;
-	ray_p->avDipAng=0;
-	for (int i=0; i<(int)intersections.size()-1; )
+	//it happens when ray hits common edge of 2 neighboring triangles; the last one of them is kept
+	//TODO: no triangles repeated?
+	size_t count = 0;
+	for (size_t i = 0; i < hitCount; ++i)
 	{
-		/*if( intersections[i+1]->dist == intersections[i]->dist )
-		{
-			delete intersections[i]; // Remove the object
-			intersections[i]=0;
-			intersections.erase(intersections.begin() + i);
-		}
-		else */
-		//TODO: no triangles repeated?
-		if( intersections[i+1]->tri->GetIndex() == intersections[i]->tri->GetIndex() )
+		if (i + 1 == hitCount || tris[order[i + 1]]->GetIndex() != tris[order[i]]->GetIndex())
 		{
-			delete intersections[i]; // Remove the object
-			intersections[i]=0;
-			intersections.erase(intersections.begin() + i);
+			order[count++] = order[i];
 		}
-		else
-			++i;
 	}
-	//
-	unsigned int intetsectSize = (unsigned int) intersections.size();
+	ray_p->penetrationsSize=0;
+	ray_p->avDipAng=0;
 	float penetrationDepth = 0;
 	//Sometimes it happens, yet lets have this workaround
-	if(intetsectSize%2 == 0)//TODO: temporary workaround
-	for (unsigned int i=0; i<intetsectSize; i++)
+	if(count%2 == 0)//TODO: temporary workaround
+	for (size_t i=0; i<count; i++)
 	{
 		if(i%2==1)
 		{
-			float dist = intersections[i]->dist - intersections[i-1]->dist;
+			float dist = dists[order[i]] - dists[order[i-1]];
 			penetrationDepth += dist;
-			//ray_p->penetrations[ray_p->penetrationsSize] = dist;
 			ray_p->penetrationsSize++;
 			ray_p->totalPenetrLen += dist;
 		}
-		//add intersection in intersections vector
-		iATriPrim* tri = intersections[i]->tri;
-		iAIntersection *isec = new iAIntersection(tri->GetIndex(), tri->GetAngleCos(a_Ray));
-		vecIntersections.push_back(isec);
-		ray_p->avDipAng+=fabs(isec->dip_angle);
+		iATriPrim* tri = tris[order[i]];
+		float dipAngle = tri->GetAngleCos(ray);
+		if (isecTri)
+		{
+			isecTri->push_back(tri->GetIndex());
+			isecDip->push_back(dipAngle);
+		}
+		ray_p->avDipAng+=fabs(dipAngle);
 	}
-	ray_p->avDipAng/=intersections.size();
-
-	//rayPenetr->totalPenetrLen/=(rayPenetr->penetrations.size());
-	for (unsigned int i=0; i<intersections.size(); i++)
-		delete intersections[i];
+	ray_p->avDipAng/=count;
 	float coef = penetrationDepth*s->COLORING_COEF;
 	if(dipAsColor)
 	{
-		a_Acc = iAVec3f((s->COL_RANGE_MIN_R+s->COL_RANGE_DR*(1-ray_p->avDipAng))/255.0,
+		acc = iAVec3f((s->COL_RANGE_MIN_R+s->COL_RANGE_DR*(1-ray_p->avDipAng))/255.0,
 			(s->COL_RANGE_MIN_G+s->COL_RANGE_DG*(1-ray_p->avDipAng))/255.0,
 			(s->COL_RANGE_MIN_B+s->COL_RANGE_DB*(1-ray_p->avDipAng))/255.0);
 	}
 	else
 	{
-		a_Acc = iAVec3f(coef, coef, coef);
+		acc = iAVec3f(coef, coef, coef);
 	}
-	// return pointer to primitive hit by primary ray
 	return 1;
 }
 
+int iAEngine::DepthRaytrace(iARay& a_Ray, iAVec3f & a_Acc, int a_Depth, float /*a_RIndex*/, float& a_Dist, iARayPenetration * ray_p, std::vector<iAIntersection*> &vecIntersections, iATraverseStack * stack, bool dipAsColor )
+{
+	if (a_Depth > s->TRACEDEPTH) return 0;
+	// trace primary ray
+	a_Dist = 1000000.0f;
+	if (!HitsCutAABBs(a_Ray))
+	{
+		return 0;
+	}
+	std::vector<iAintersection*> intersections;
+	m_Scene->getBSPTree()->GetIntersectionsNR(a_Ray, intersections,stack);
+	std::vector<iATriPrim*> tris(intersections.size());
+	std::vector<float> dists(intersections.size());
+	for (size_t i = 0; i < intersections.size(); ++i)
+	{
+		tris[i] = intersections[i]->tri;
+		dists[i] = intersections[i]->dist;
+		delete intersections[i];
+	}
+	std::vector<unsigned int> order, isecTri;
+	std::vector<float> isecDip;
+	int result = ShadeRay(a_Ray, tris.data(), dists.data(), tris.size(), order, ray_p, a_Acc, dipAsColor, &isecTri, &isecDip);
+	for (size_t i = 0; i < isecTri.size(); ++i)
+	{
+		vecIntersections.push_back(new iAIntersection(isecTri[i], isecDip[i]));
+	}
+	return result;
+}
+
 void iAEngine::InitRender(iAVec3f * vp_corners, iAVec3f * vp_delta, iAVec3f * o)
+{
+	InitRender(rotX, rotY, rotZ, vp_corners, vp_delta, o);
+}
+
+void iAEngine::InitRender(float a_X, float a_Y, float a_Z, iAVec3f * vp_corners, iAVec3f * vp_delta, iAVec3f * o) const
 {
 	//!@note rotations and translations are inversed, because we rotating plane and origin instead of object
 	float
-		irotX = -rotX,
-		irotY = -rotY,
-		irotZ = -rotZ;
+		irotX = -a_X,
+		irotY = -a_Y,
+		irotZ = -a_Z;
 	iAVec3f iposition = -position;
 	iAMat4 mrotx, mroty, mrotz;
 	mrotz = rotationZ(irotZ);
@@ -230,84 +296,179 @@ bool iAEngine::RenderCPU(const iAVec3f * vp_corners, const iAVec3f * vp_delta, c
 	curRender.rotZ = rotZ;
 	for(unsigned int i=0; i<3; i++)
 		curRender.pos[i] = position[i];
-	curRender.avPenetrLen = 0.f;
-	curRender.maxPenetrLen = 0.f;
-	curRender.avDipAngle = 0.f;
+	RenderTiles(vp_corners, vp_delta, o, rememberData, dipAsColor, curRender, m_Dest, m_arenas);
+	m_lastAvPenetrLen  = curRender.avPenetrLen;
+	m_lastAvDipAngle = curRender.avDipAngle;
+	if(!rememberData)
+	{
+		curRender.avPenetrLen = 0.f;
+		curRender.maxPenetrLen = 0.f;
+		curRender.avDipAngle = 0.f;
+	}
+	return true;
+}
+
+void iAEngine::RenderOrientation(float a_X, float a_Y, float a_Z, bool rememberData, bool dipAsColor, iAOrientationScratch & scratch) const
+{
+	iARenderFromPosition & render = scratch.render;
+	render.clear();
+	render.rotX = a_X;
+	render.rotY = a_Y;
+	render.rotZ = a_Z;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		render.pos[i] = position[i];
+	}
+	iAVec3f o;
+	iAVec3f vp_corners[2];
+	iAVec3f vp_delta[2];
+	InitRender(a_X, a_Y, a_Z, vp_corners, vp_delta, &o);
+	scratch.image.resize(static_cast<size_t>(m_Width) * m_Height);
+	RenderTiles(vp_corners, vp_delta, &o, rememberData, dipAsColor, render, scratch.image.data(), scratch.arenas);
+}
 
-	int threadCount = s->THREAD_GRID_X*s->THREAD_GRID_Y;
-	iARaycastingThread * threads = new iARaycastingThread[threadCount];
-	for (int x=0; x<s->THREAD_GRID_X; x++)
-		for (int y=0; y<s->THREAD_GRID_Y; y++)
+void iAEngine::RenderTiles(const iAVec3f * vp_corners, const iAVec3f * vp_delta, const iAVec3f * o, bool rememberData, bool dipAsColor,
+	iARenderFromPosition & render, unsigned int * dest, std::vector<std::unique_ptr<iARaycastingArena>> & arenas) const
+{
+	int tilesX = (m_Width + TileSize - 1) / TileSize;
+	int tilesY = (m_Height + TileSize - 1) / TileSize;
+	int tileCount = tilesX * tilesY;
+	std::vector<iATileResult> tiles(tileCount);
+	iARayPenetration * rays = rememberData ? new iARayPenetration[m_Width * m_Height] : nullptr;
+	bool trace = (1 <= s->TRACEDEPTH);
+	while (arenas.size() < static_cast<size_t>(maxThreadCount()))
+	{
+		arenas.push_back(std::make_unique<iARaycastingArena>());
+	}
+	for (auto & arena : arenas)
+	{
+		arena->isecTri.clear();
+		arena->isecDip.clear();
+	}
+	iABSPTree const * tree = m_Scene->getBSPTree();
+	// small tiles, dynamically scheduled, balance the load among threads even if the object covers only part of the screen:
+#pragma omp parallel for schedule(dynamic)
+	for (int tileIdx = 0; tileIdx < tileCount; ++tileIdx)
+	{
+		size_t arenaIdx = threadIndex();
+		iARaycastingArena & arena = *arenas[arenaIdx];
+		iATileResult & tile = tiles[tileIdx];
+		tile.arena = arenaIdx;
+		tile.isecStart = arena.isecTri.size();
+		int x1 = (tileIdx % tilesX) * TileSize, x2 = std::min(x1 + TileSize, m_Width);
+		int y1 = (tileIdx / tilesX) * TileSize, y2 = std::min(y1 + TileSize, m_Height);
+		for (int x = x1; x < x2; x++)
 		{
-			int tIndex = y*s->THREAD_GRID_X+x;
-			threads[tIndex].setEngine(this);
-			threads[tIndex].setPlaneAndOrigin(vp_corners, vp_delta, o);
-			threads[tIndex].dipAsColor=dipAsColor;
-			threads[tIndex].x1 =  x   *m_Width /s->THREAD_GRID_X;
-			threads[tIndex].x2 = (x+1)*m_Width /s->THREAD_GRID_X;
-			threads[tIndex].y1 =  y   *m_Height/s->THREAD_GRID_Y;
-			threads[tIndex].y2 = (y+1)*m_Height/s->THREAD_GRID_Y;
+			for (int yStart = y1; yStart < y2; yStart += iARayPacket::Size)
+			{
+				int rayCount = std::min(iARayPacket::Size, y2 - yStart);
+				unsigned int mask = 0;
+				for (int l = 0; l < iARayPacket::Size; ++l)
+				{
+					// unused lanes repeat the last ray, so that they compute valid values; they are masked out
+					int y = yStart + std::min(l, rayCount - 1);
+					iAVec3f dir = (vp_corners[0] + x*vp_delta[0] + y*vp_delta[1]) - (*o);
+					dir.normalize();
+					arena.packet.set(l, iARay(o, dir));
+					if (l < rayCount && trace && HitsCutAABBs(arena.packet.rays[l]))
+					{
+						mask |= 1u << l;
+					}
+				}
+				arena.hits.clear();
+				if (mask)
+				{
+					tree->GetPacketIntersectionsNR(arena.packet, mask, arena.hits, arena.stack);
+				}
+				for (int l = 0; l < rayCount; ++l)
+				{
+					int y = yStart + l;
+					iARayPenetration localRay;
+					iARayPenetration * ray_p = rays ? &rays[y * m_Width + x] : &localRay;
+					ray_p->m_X = x;
+					ray_p->m_Y = y;
+					ray_p->totalPenetrLen = 0.0f;
+					ray_p->avDipAng = 0.0f;
+					size_t isecBefore = arena.isecDip.size();
+					iAVec3f acc( 0, 0, 0 );
+					ShadeRay(arena.packet.rays[l], arena.hits.tris[l].data(), arena.hits.dists[l].data(),
+						arena.hits.tris[l].size(), arena.order, ray_p, acc, dipAsColor, &arena.isecTri, &arena.isecDip);
+					if (ray_p->penetrationsSize != 0)
+					{
+						tile.penetratingRays++;
+						tile.penetrLenSum += ray_p->totalPenetrLen;
+						tile.maxPenetrLen = std::max(tile.maxPenetrLen, ray_p->totalPenetrLen);
+					}
+					for (size_t i = isecBefore; i < arena.isecDip.size(); ++i)
+					{
+						tile.dipAngleSum += fabs(arena.isecDip[i]);
+					}
+					tile.isecCount += arena.isecDip.size() - isecBefore;
+					if (!rememberData)
+					{	// the intersections were only needed for the statistics
+						arena.isecTri.resize(isecBefore);
+						arena.isecDip.resize(isecBefore);
+					}
+					int red = (int)(acc[0] * 255);
+					int green = (int)(acc[1] * 255);
+					int blue = (int)(acc[2] * 255);
+					if (red > 255) red = 255;
+					if (green > 255) green = 255;
+					if (blue > 255) blue = 255;
+					//invert by y axis
+					dest[y*m_Width+(m_Width-x-1)] = (red << 16) + (green << 8) + blue;
+				}
+			}
 		}
-	for (int i=0; i<threadCount; i++)
-		threads[i].start();
-	for (int i=0; i<threadCount; i++)
-		threads[i].wait();
-	for (int i=0; i<threadCount; i++)
-		threads[i].stop();
-	//now extract all penetration data from threads
+	}
+	// combine the results in tile order, so that they do not depend on the number of threads:
 	float avPenetrLen=0;
 	float avDipAngle=0;
 	float maxPenetrLen=0;
 	float raysCount=0;
 	float isecCount=0;
-	for (int i=0; i<threadCount; i++)
+	for (auto const & tile : tiles)
 	{
-		if(rememberData)
-			curRender.rawPtrRaysVec.push_back(threads[i].getRays());
-		for (int j=0; j<threads[i].rayCount; j++)
+		raysCount += tile.penetratingRays;
+		avPenetrLen += tile.penetrLenSum;
+		maxPenetrLen = std::max(maxPenetrLen, tile.maxPenetrLen);
+		isecCount += tile.isecCount;
+		avDipAngle += tile.dipAngleSum;
+	}
+	if (rememberData)
+	{
+		render.rawPtrRaysVec.push_back(rays);
+		for (int i = 0; i < m_Width * m_Height; ++i)
 		{
-			if(threads[i].getRays()[j].penetrationsSize!=0)
+			if (rays[i].penetrationsSize != 0)
 			{
-				raysCount++;
-				if(rememberData)
-					curRender.rays.push_back(&threads[i].getRays()[j]);
-				//(*renders)[curRend]->m_avPenetrLen+=threads[i].getRays()[j].totalPenetrLen;
-				float curPenetrLen = threads[i].getRays()[j].totalPenetrLen;
-				avPenetrLen+=curPenetrLen;
-				if(curPenetrLen > maxPenetrLen)
-					maxPenetrLen = curPenetrLen;
+				render.rays.push_back(&rays[i]);
 			}
 		}
-		size_t intersectionsCount = threads[i].getIntersections()->size();
-		for (size_t j=0; j<intersectionsCount; j++)
+		// all intersections in one array, instead of allocating each separately:
+		size_t totalIsecCount = 0;
+		for (auto const & tile : tiles)
 		{
-			isecCount++;
-			if(rememberData)
-				curRender.intersections.push_back( ( *(threads[i].getIntersections()) )[j] );
-			avDipAngle+= fabs(( *(threads[i].getIntersections()) )[j]->dip_angle);
+			totalIsecCount += tile.isecCount;
+		}
+		iAIntersection * isecs = new iAIntersection[totalIsecCount];
+		render.rawPtrIntersectionsVec.push_back(isecs);
+		render.intersections.reserve(totalIsecCount);
+		for (auto const & tile : tiles)
+		{
+			auto const & arena = *arenas[tile.arena];
+			for (size_t i = tile.isecStart; i < tile.isecStart + tile.isecCount; ++i)
+			{
+				isecs->setData(arena.isecTri[i], arena.isecDip[i]);
+				render.intersections.push_back(isecs++);
+			}
 		}
 	}
-	curRender.raysSize = (unsigned int) curRender.rays.size();
-	curRender.intersectionsSize = (unsigned int) curRender.intersections.size();
-	avPenetrLen/=raysCount;
-	avDipAngle/=isecCount;
-	m_lastAvPenetrLen  = avPenetrLen;
-	m_lastAvDipAngle = avDipAngle;
-	//(*renders)[curRend]->m_avPenetrLen/=(*renders)[curRend]->rays.size();
-	if(rememberData)
-	{
-		curRender.avPenetrLen=avPenetrLen;
-		curRender.avDipAngle=avDipAngle;
-		curRender.maxPenetrLen=maxPenetrLen;
-		curRender.raysSize = (unsigned int) curRender.rays.size();
-	}
-	else
-	{
-		for (int i=0; i<threadCount; i++)
-			threads[i].clearMemory();
-	}
-	delete [] threads;
-	return true;
+	render.raysSize = (unsigned int) render.rays.size();
+	render.intersectionsSize = (unsigned int) render.intersections.size();
+	render.avPenetrLen = avPenetrLen / raysCount;
+	render.avDipAngle = avDipAngle / isecCount;
+	render.maxPenetrLen = maxPenetrLen;
 }
 
 bool iAEngine::RenderGPU(const iAVec3f * vp_corners, const iAVec3f * vp_delta, const iAVec3f * o, bool rememberData, bool dipAsColor, bool rasteriztion )
@@ -765,43 +926,4 @@ void iAEngine::raycast_single(
 	this->raycast_batch(a_aabb, a_o, a_c, a_dx, a_dy, w, h, 1, a_cut_aabbs, a_cut_aabbs_count, out_res, out_dip_res);
 }
 
-//////////////////////////////////////////////////////////////////////////
-// iARaycastingThread implementation
-//////////////////////////////////////////////////////////////////////////
-void iARaycastingThread::run()
-{
-	iATraverseStack * tr_stack = new iATraverseStack(e->scene()->getBSPTree()->splitLevel+1);
-	rayCount = (x2-x1)*(y2-y1);
-	delete [] rays;
-	rays = new iARayPenetration[rayCount];
-	unsigned int rayInd=0;
-	for(int x=x1; x<x2; x++)
-		for(int y=y1; y<y2; y++)
-		{
-			rays[rayInd].m_X=x;
-			rays[rayInd].m_Y=y;
-			rays[rayInd].totalPenetrLen=0.0f;
-			// fire primary ray
-			iAVec3f acc( 0, 0, 0 );
-			iAVec3f dir = (m_vp_corners[0] + x*m_vp_delta[0] + y*m_vp_delta[1]) - (*m_o);
-			dir.normalize();
-			iARay r( m_o, dir );
-			float dist;
-			e->DepthRaytrace( r, acc, 1, 1.0f, dist, &rays[rayInd], intersections, tr_stack, dipAsColor );
-			int red = (int)(acc[0] * 255);
-			int green = (int)(acc[1] * 255);
-			int blue = (int)(acc[2] * 255);
-			if (red > 255) red = 255;
-			if (green > 255) green = 255;
-			if (blue > 255) blue = 255;
-
-			//e->destMutex.lock();
-			//invert by y axis
-			e->m_Dest[y*e->m_Width+(e->m_Width-x-1)] = (red << 16) + (green << 8) + blue;
-			//e->destMutex.unlock();
-			rayInd++;
-		}
-	if(tr_stack)
-		delete tr_stack;
-}
 //}; // namespace Raytracer
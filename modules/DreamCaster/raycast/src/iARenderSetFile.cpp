@@ -0,0 +1,494 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "../include/iARenderSetFile.h"
+#include "../include/iACutFigList.h"
+#include "../include/iADataFormat.h"
+#include "../include/iAScene.h"
+
+#include <cstring>
+
+namespace
+{
+	//! identifies indexed set files (bytes "DSET"); files in the former format start with the number of orientations
+	const quint32 IndexedSetMagic = 0x54455344;
+	//! version 2 added the model hash and the Radon space analysis mode to the header
+	const quint32 IndexedSetVersion = 2;
+	//! size of a record without rays and intersections: rotations, position, averages, and number of rays
+	const qint64 RecordHeaderSize = 10 * sizeof(float) + sizeof(quint32);
+	//! size of a ray in a record: x, y, total penetration length, average dip angle, number of penetrations
+	const qint64 RaySize = 2 * sizeof(qint32) + 2 * sizeof(float) + sizeof(quint32);
+	//! size of an intersection in a record: triangle index, dip angle
+	const qint64 IntersectionSize = sizeof(quint32) + sizeof(float);
+
+	template <typename T>
+	void appendValue(std::vector<char> & buf, T const & value)
+	{
+		char const * bytes = reinterpret_cast<char const *>(&value);
+		buf.insert(buf.end(), bytes, bytes + sizeof(T));
+	}
+
+	template <typename T>
+	T nextValue(char const * & cur)
+	{
+		T value;
+		std::memcpy(&value, cur, sizeof(T));
+		cur += sizeof(T);
+		return value;
+	}
+}
+
+size_t iARenderSetHeader::renderCount() const
+{
+	return static_cast<size_t>(cntX) * cntY * cntZ;
+}
+
+bool iARenderSetHeader::matches(iARenderSetHeader const & other) const
+{
+	return cntX == other.cntX && cntY == other.cntY && cntZ == other.cntZ &&
+		minX == other.minX && maxX == other.maxX && minZ == other.minZ && maxZ == other.maxZ &&
+		cutAABCount == other.cutAABCount && cutAABs == other.cutAABs &&
+		triangleCount == other.triangleCount && modelHash == other.modelHash && radonMode == other.radonMode &&
+		pos[0] == other.pos[0] && pos[1] == other.pos[1] && pos[2] == other.pos[2] &&
+		originZ == other.originZ && planeZ == other.planeZ &&
+		planeHalfW == other.planeHalfW && planeHalfH == other.planeHalfH &&
+		frameW == other.frameW && frameH == other.frameH &&
+		saveAdditionalData == other.saveAdditionalData;
+}
+
+quint64 iARenderSetHeader::computeModelHash(iAScene & scene)
+{
+	// FNV-1a over the bytes of all vertex coordinates, in triangle order:
+	quint64 hash = 14695981039346656037ULL;
+	for (unsigned int t = 0; t < scene.getNrTriangles(); ++t)
+	{
+		for (int v = 0; v < 3; ++v)
+		{
+			iAVec3f const * vertex = scene.getTriangle(t)->getVertex(v);
+			float const coords[3] = { vertex->x(), vertex->y(), vertex->z() };
+			unsigned char const * bytes = reinterpret_cast<unsigned char const *>(coords);
+			for (size_t b = 0; b < sizeof(coords); ++b)
+			{
+				hash = (hash ^ bytes[b]) * 1099511628211ULL;
+			}
+		}
+	}
+	return hash;
+}
+
+iARenderSetFile::iARenderSetFile() :
+	m_map(nullptr),
+	m_size(0),
+	m_indexOffset(0),
+	m_writing(false),
+	m_storedCount(0)
+{}
+
+iARenderSetFile::~iARenderSetFile()
+{
+	close();
+}
+
+void iARenderSetFile::close()
+{
+	if (m_map)
+	{
+		m_file.unmap(m_map);
+		m_map = nullptr;
+	}
+	m_file.close();
+	m_size = 0;
+	m_indexOffset = 0;
+	m_writing = false;
+	m_header = iARenderSetHeader();
+	m_index.clear();
+	m_storedCount = 0;
+}
+
+bool iARenderSetFile::isOpen() const
+{
+	return m_file.isOpen();
+}
+
+QString const & iARenderSetFile::errorMessage() const
+{
+	return m_error;
+}
+
+iARenderSetHeader const & iARenderSetFile::header() const
+{
+	return m_header;
+}
+
+size_t iARenderSetFile::storedCount() const
+{
+	return m_storedCount;
+}
+
+size_t iARenderSetFile::renderIndex(int x, int y, int z) const
+{
+	return (static_cast<size_t>(x) * m_header.cntZ + z) * m_header.cntY + y;
+}
+
+bool iARenderSetFile::contains(int x, int y, int z) const
+{
+	return x >= 0 && x < m_header.cntX && y >= 0 && y < m_header.cntY && z >= 0 && z < m_header.cntZ &&
+		m_index[renderIndex(x, y, z)] != 0;
+}
+
+bool iARenderSetFile::fail(QString const & message)
+{
+	close();
+	m_error = message;
+	return false;
+}
+
+bool iARenderSetFile::readBytes(qint64 offset, void * dst, qint64 size) const
+{
+	if (offset < 0 || size < 0 || offset + size > m_size)
+	{
+		return false;
+	}
+	if (m_map)
+	{
+		std::memcpy(dst, m_map + offset, size);
+		return true;
+	}
+	return m_file.seek(offset) && m_file.read(static_cast<char*>(dst), size) == size;
+}
+
+bool iARenderSetFile::readHeader(qint64 & pos, bool & indexed)
+{
+	auto get = [this, &pos](auto & value) -> bool
+	{
+		bool result = readBytes(pos, &value, sizeof(value));
+		pos += sizeof(value);
+		return result;
+	};
+	iARenderSetHeader & h = m_header;
+	pos = 0;
+	quint32 magic = 0, version = 0;
+	if (!get(magic))
+	{
+		return false;
+	}
+	indexed = (magic == IndexedSetMagic);
+	if (indexed)
+	{
+		if (!get(version) || version < 1 || version > IndexedSetVersion)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		pos = 0;
+	}
+	if (!get(h.cntX) || !get(h.minX) || !get(h.maxX) || !get(h.cntY) || !get(h.cntZ) || !get(h.minZ) || !get(h.maxZ))
+	{
+		return false;
+	}
+	if (indexed && (!get(h.triangleCount) || !get(h.pos) || !get(h.originZ) || !get(h.planeZ) ||
+		!get(h.planeHalfW) || !get(h.planeHalfH) || !get(h.frameW) || !get(h.frameH) || !get(h.saveAdditionalData)))
+	{
+		return false;
+	}
+	// version 1 files don't store model hash and Radon mode; they are left at 0, so such sweeps are not resumed:
+	if (indexed && version >= 2 && (!get(h.modelHash) || !get(h.radonMode)))
+	{
+		return false;
+	}
+	qint64 const cutAABSize = iACutAAB::getSkipedSizeInFile();
+	if (!get(h.cutAABCount) || h.cutAABCount < 0 || h.cutAABCount * cutAABSize > m_size - pos)
+	{
+		return false;
+	}
+	h.cutAABs.resize(h.cutAABCount * cutAABSize);
+	if (!readBytes(pos, h.cutAABs.data(), h.cutAABs.size()))
+	{
+		return false;
+	}
+	pos += h.cutAABs.size();
+	return h.cntX > 0 && h.cntY > 0 && h.cntZ > 0;
+}
+
+bool iARenderSetFile::buildSequentialIndex(qint64 pos)
+{
+	// former format: records of all orientations in order of their linear index
+	for (size_t i = 0; i < m_index.size(); ++i)
+	{
+		quint32 raysSize, isecSize;
+		if (!readBytes(pos + RecordHeaderSize - sizeof(raysSize), &raysSize, sizeof(raysSize)) ||
+			!readBytes(pos + RecordHeaderSize + raysSize * RaySize, &isecSize, sizeof(isecSize)))
+		{
+			return false;
+		}
+		m_index[i] = pos;
+		pos += RecordHeaderSize + raysSize * RaySize + sizeof(isecSize) + isecSize * IntersectionSize;
+		if (pos > m_size)
+		{
+			return false;
+		}
+	}
+	m_storedCount = m_index.size();
+	return true;
+}
+
+bool iARenderSetFile::openForReading(QString const & fileName)
+{
+	close();
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::ReadOnly))
+	{
+		return fail(QString("Cannot open set file '%1' for reading: %2").arg(fileName).arg(m_file.errorString()));
+	}
+	m_size = m_file.size();
+	// if the file cannot be mapped (e.g. if it is too large for the address space), it is read in pieces instead:
+	m_map = m_file.map(0, m_size);
+	qint64 pos;
+	bool indexed;
+	if (!readHeader(pos, indexed))
+	{
+		return fail(QString("Invalid header in set file '%1'.").arg(fileName));
+	}
+	m_index.resize(m_header.renderCount(), 0);
+	if (!indexed)
+	{
+		if (!buildSequentialIndex(pos))
+		{
+			return fail(QString("Set file '%1' is truncated or corrupt.").arg(fileName));
+		}
+		return true;
+	}
+	m_indexOffset = pos;
+	if (!readBytes(m_indexOffset, m_index.data(), m_index.size() * sizeof(quint64)))
+	{
+		return fail(QString("Set file '%1' is truncated or corrupt.").arg(fileName));
+	}
+	for (auto offset : m_index)
+	{
+		if (offset != 0)
+		{
+			if (offset + RecordHeaderSize > static_cast<quint64>(m_size))
+			{
+				return fail(QString("Set file '%1' is truncated or corrupt.").arg(fileName));
+			}
+			++m_storedCount;
+		}
+	}
+	return true;
+}
+
+bool iARenderSetFile::openForWriting(QString const & fileName, iARenderSetHeader const & header, bool resume)
+{
+	close();
+	m_file.setFileName(fileName);
+	if (resume && m_file.exists() && m_file.open(QIODevice::ReadWrite))
+	{
+		m_size = m_file.size();
+		qint64 pos;
+		bool indexed;
+		if (readHeader(pos, indexed) && indexed && m_header.matches(header))
+		{
+			m_index.resize(m_header.renderCount(), 0);
+			m_indexOffset = pos;
+			if (readBytes(m_indexOffset, m_index.data(), m_index.size() * sizeof(quint64)))
+			{
+				for (auto & offset : m_index)
+				{
+					// an index entry is only written after its record, so this can only happen if the file was modified:
+					if (offset + RecordHeaderSize > static_cast<quint64>(m_size))
+					{
+						offset = 0;
+					}
+					m_storedCount += (offset != 0) ? 1 : 0;
+				}
+				m_writing = true;
+				return true;
+			}
+		}
+		close();
+		m_file.setFileName(fileName);
+	}
+	if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+	{
+		return fail(QString("Cannot open set file '%1' for writing: %2").arg(fileName).arg(m_file.errorString()));
+	}
+	m_header = header;
+	m_header.cutAABCount = static_cast<int>(m_header.cutAABs.size() / iACutAAB::getSkipedSizeInFile());
+	std::vector<char> buf;
+	appendValue(buf, IndexedSetMagic);
+	appendValue(buf, IndexedSetVersion);
+	iARenderSetHeader const & h = m_header;
+	appendValue(buf, h.cntX);
+	appendValue(buf, h.minX);
+	appendValue(buf, h.maxX);
+	appendValue(buf, h.cntY);
+	appendValue(buf, h.cntZ);
+	appendValue(buf, h.minZ);
+	appendValue(buf, h.maxZ);
+	appendValue(buf, h.triangleCount);
+	appendValue(buf, h.pos);
+	appendValue(buf, h.originZ);
+	appendValue(buf, h.planeZ);
+	appendValue(buf, h.planeHalfW);
+	appendValue(buf, h.planeHalfH);
+	appendValue(buf, h.frameW);
+	appendValue(buf, h.frameH);
+	appendValue(buf, h.saveAdditionalData);
+	appendValue(buf, h.modelHash);
+	appendValue(buf, h.radonMode);
+	appendValue(buf, h.cutAABCount);
+	buf.insert(buf.end(), h.cutAABs.begin(), h.cutAABs.end());
+	m_indexOffset = buf.size();
+	m_index.assign(m_header.renderCount(), 0);
+	buf.resize(buf.size() + m_index.size() * sizeof(quint64), 0);
+	if (m_file.write(buf.data(), buf.size()) != static_cast<qint64>(buf.size()) || !m_file.flush())
+	{
+		return fail(QString("Cannot write header of set file '%1': %2").arg(fileName).arg(m_file.errorString()));
+	}
+	m_size = buf.size();
+	m_writing = true;
+	return true;
+}
+
+bool iARenderSetFile::append(int x, int y, int z, std::vector<char> const & record)
+{
+	if (!m_writing || x < 0 || x >= m_header.cntX || y < 0 || y >= m_header.cntY || z < 0 || z >= m_header.cntZ)
+	{
+		return false;
+	}
+	size_t idx = renderIndex(x, y, z);
+	quint64 offset = m_size;
+	if (!m_file.seek(offset) ||
+		m_file.write(record.data(), record.size()) != static_cast<qint64>(record.size()) ||
+		!m_file.flush() ||
+		!m_file.seek(m_indexOffset + idx * sizeof(quint64)) ||
+		m_file.write(reinterpret_cast<char const *>(&offset), sizeof(offset)) != sizeof(offset) ||
+		!m_file.flush())
+	{
+		// a partially written record is not referenced by the index, and is overwritten by the next append
+		m_error = QString("Cannot write to set file '%1': %2").arg(m_file.fileName()).arg(m_file.errorString());
+		return false;
+	}
+	m_size += record.size();
+	m_storedCount += (m_index[idx] == 0) ? 1 : 0;
+	m_index[idx] = offset;
+	return true;
+}
+
+bool iARenderSetFile::read(int x, int y, int z, iARenderFromPosition & rend, bool withAdditionalData) const
+{
+	rend.clear();
+	if (!contains(x, y, z))
+	{
+		return false;
+	}
+	qint64 offset = m_index[renderIndex(x, y, z)];
+	char head[RecordHeaderSize];
+	if (!readBytes(offset, head, RecordHeaderSize))
+	{
+		return false;
+	}
+	char const * cur = head;
+	rend.rotX = nextValue<float>(cur);
+	rend.rotY = nextValue<float>(cur);
+	rend.rotZ = nextValue<float>(cur);
+	for (int i = 0; i < 3; ++i)
+	{
+		rend.pos[i] = nextValue<float>(cur);
+	}
+	rend.avPenetrLen = nextValue<float>(cur);
+	rend.avDipAngle = nextValue<float>(cur);
+	rend.maxPenetrLen = nextValue<float>(cur);
+	rend.badAreaPercentage = nextValue<float>(cur);
+	quint32 raysSize = nextValue<quint32>(cur);
+	if (!withAdditionalData)
+	{
+		return true;
+	}
+	quint32 isecSize;
+	qint64 raysOffset = offset + RecordHeaderSize;
+	qint64 isecOffset = raysOffset + raysSize * RaySize + sizeof(isecSize);
+	if (!readBytes(isecOffset - sizeof(isecSize), &isecSize, sizeof(isecSize)) ||
+		isecOffset + isecSize * IntersectionSize > m_size)
+	{
+		return false;
+	}
+	// parse directly from the mapped file if possible:
+	std::vector<char> buf;
+	char const * data = reinterpret_cast<char const *>(m_map) + raysOffset;
+	if (!m_map)
+	{
+		buf.resize(isecOffset + isecSize * IntersectionSize - raysOffset);
+		if (!readBytes(raysOffset, buf.data(), buf.size()))
+		{
+			return false;
+		}
+		data = buf.data();
+	}
+	cur = data;
+	if (raysSize > 0)
+	{
+		iARayPenetration * rays = new iARayPenetration[raysSize];
+		rend.rawPtrRaysVec.push_back(rays);
+		rend.rays.reserve(raysSize);
+		for (quint32 i = 0; i < raysSize; ++i)
+		{
+			rays[i].m_X = nextValue<qint32>(cur);
+			rays[i].m_Y = nextValue<qint32>(cur);
+			rays[i].totalPenetrLen = nextValue<float>(cur);
+			rays[i].avDipAng = nextValue<float>(cur);
+			rays[i].penetrationsSize = nextValue<quint32>(cur);
+			rend.rays.push_back(&rays[i]);
+		}
+	}
+	cur += sizeof(isecSize);
+	if (isecSize > 0)
+	{
+		iAIntersection * isecs = new iAIntersection[isecSize];
+		rend.rawPtrIntersectionsVec.push_back(isecs);
+		rend.intersections.reserve(isecSize);
+		for (quint32 i = 0; i < isecSize; ++i)
+		{
+			quint32 triIndex = nextValue<quint32>(cur);
+			float dipAngle = nextValue<float>(cur);
+			isecs[i].setData(triIndex, dipAngle);
+			rend.intersections.push_back(&isecs[i]);
+		}
+	}
+	rend.raysSize = raysSize;
+	rend.intersectionsSize = isecSize;
+	return true;
+}
+
+void iARenderSetFile::serialize(iARenderFromPosition const & rend, bool saveAdditionalData, std::vector<char> & record)
+{
+	record.clear();
+	quint32 raysSize = saveAdditionalData ? static_cast<quint32>(rend.rays.size()) : 0;
+	quint32 isecSize = saveAdditionalData ? static_cast<quint32>(rend.intersections.size()) : 0;
+	record.reserve(RecordHeaderSize + raysSize * RaySize + sizeof(isecSize) + isecSize * IntersectionSize);
+	appendValue(record, rend.rotX);
+	appendValue(record, rend.rotY);
+	appendValue(record, rend.rotZ);
+	appendValue(record, rend.pos);
+	appendValue(record, rend.avPenetrLen);
+	appendValue(record, rend.avDipAngle);
+	appendValue(record, rend.maxPenetrLen);
+	appendValue(record, rend.badAreaPercentage);
+	appendValue(record, raysSize);
+	for (quint32 i = 0; i < raysSize; ++i)
+	{
+		iARayPenetration const * ray = rend.rays[i];
+		appendValue(record, static_cast<qint32>(ray->m_X));
+		appendValue(record, static_cast<qint32>(ray->m_Y));
+		appendValue(record, ray->totalPenetrLen);
+		appendValue(record, ray->avDipAng);
+		appendValue(record, static_cast<quint32>(ray->penetrationsSize));
+	}
+	appendValue(record, isecSize);
+	for (quint32 i = 0; i < isecSize; ++i)
+	{
+		appendValue(record, static_cast<quint32>(rend.intersections[i]->tri_index));
+		appendValue(record, rend.intersections[i]->dip_angle);
+	}
+}
@@ -78,6 +78,36 @@ int iATriPrim::Intersect( iARay& a_Ray, float& a_Dist ) const
 	return ((D&m_WaldTri.m_N ) > 0)? INPRIM : HIT;
 }
 
+unsigned int iATriPrim::Intersect(iARayPacket const & packet, unsigned int mask, float * dists) const
+{
+	// same computations as in the single ray version above, written without branches to allow vectorization:
+	unsigned int k = m_WaldTri.k, u = ku, v = kv;
+	float const *Ok = packet.org[k], *Ou = packet.org[u], *Ov = packet.org[v];
+	float const *Dk = packet.dir[k], *Du = packet.dir[u], *Dv = packet.dir[v];
+	const float nu = m_WaldTri.nu, nv = m_WaldTri.nv, nd = m_WaldTri.nd;
+	const float Au = m_WaldTri.m_A[u], Av = m_WaldTri.m_A[v];
+	const float bnu = m_WaldTri.bnu, bnv = m_WaldTri.bnv, cnu = m_WaldTri.cnu, cnv = m_WaldTri.cnv;
+	float t[iARayPacket::Size];
+	unsigned int hit[iARayPacket::Size];
+	for (int l = 0; l < iARayPacket::Size; ++l)
+	{
+		const float lnd = 1.0f / (Dk[l] + nu * Du[l] + nv * Dv[l]);
+		t[l] = (nd - Ok[l] - nu * Ou[l] - nv * Ov[l]) * lnd;
+		float hu = Ou[l] + t[l] * Du[l] - Au;
+		float hv = Ov[l] + t[l] * Dv[l] - Av;
+		float beta = hv * bnu + hu * bnv;
+		float gamma = hu * cnu + hv * cnv;
+		hit[l] = (1000000.0f > t[l]) & (t[l] > 0) & !(beta < 0) & !(gamma < 0) & !((beta + gamma) > 1);
+	}
+	unsigned int hits = 0;
+	for (int l = 0; l < iARayPacket::Size; ++l)
+	{
+		dists[l] = t[l];
+		hits |= hit[l] << l;
+	}
+	return hits & mask;
+}
+
 bool PlaneBoxOverlap( iAVec3f & a_Normal, iAVec3f & a_Vert, iAVec3f & a_MaxBox )
 {
 	iAVec3f vmin, vmax;
@@ -13,6 +13,10 @@
 #include <vtkImageData.h>
 #include <vtkTable.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
 namespace
 {
 	const QString CsvFileName("CSV filename");
@@ -42,7 +46,7 @@ iASpatialFeatureSummary::iASpatialFeatureSummary():
 		"If you want the images to cover a specific extent (i.e. bounding box), "
 		"you can specify a <em>" + MinCorner + "</em> and a <em>" + MaxCorner + "</em> "
 		"(i.e., minimum and maximum x, y and z coordinates); leave all at 0 for them to be automatically computed from the loaded fibers. "
-		"", 0, 1)
+		"", 0, 1, true)
 {
 	// Potential for improvement:
 	//     - allow choosing CSV config
@@ -61,101 +65,47 @@ iASpatialFeatureSummary::iASpatialFeatureSummary():
 
 namespace
 {
-	std::vector<iAVec3i> findCellIdsBresenham3D(iAVec3i const& start, iAVec3i const& end)
+	//! Visits the cells on the line from start to end (both inclusive), as determined by an integer 3D DDA
+	//! (bresenham 3D, see http://www.ict.griffith.edu.au/anthony/info/graphics/bresenham.procs),
+	//! stepping one cell along the axis with the largest extent in each step.
+	template <typename Visitor>
+	void forEachCellDDA3D(iAVec3i const& start, iAVec3i const& end, Visitor visit)
 	{
-		//bresenham 3D
-		//http://www.ict.griffith.edu.au/anthony/info/graphics/bresenham.procs
-
-		int i, l, m, n, x_inc, y_inc, z_inc, err_1, err_2, dx2, dy2, dz2;
-		int id = 0;
-		std::vector<iAVec3i> cellIds;
-
-		iAVec3i pixel = start;
-		auto dir = end - start;
-		x_inc = (dir.x() < 0) ? -1 : 1;
-		l = std::abs(dir.x());
-		y_inc = (dir.y() < 0) ? -1 : 1;
-		m = std::abs(dir.y());
-		z_inc = (dir.z() < 0) ? -1 : 1;
-		n = std::abs(dir.z());
-		dx2 = l << 1;
-		dy2 = m << 1;
-		dz2 = n << 1;
-
-		if ((l >= m) && (l >= n))
+		int delta[3], inc[3];
+		for (int a = 0; a < 3; ++a)
 		{
-			err_1 = dy2 - l;
-			err_2 = dz2 - l;
-			for (i = 0; i < l; i++)
-			{
-				cellIds.push_back(pixel);
-				id++;
-				if (err_1 > 0)
-				{
-					pixel[1] += y_inc;
-					err_1 -= dx2;
-				}
-				if (err_2 > 0)
-				{
-					pixel[2] += z_inc;
-					err_2 -= dx2;
-				}
-				err_1 += dy2;
-				err_2 += dz2;
-				pixel[0] += x_inc;
-			}
+			int dir = end[a] - start[a];
+			inc[a] = (dir < 0) ? -1 : 1;
+			delta[a] = std::abs(dir);
 		}
-		else if ((m >= l) && (m >= n))
+		int major = (delta[0] >= delta[1] && delta[0] >= delta[2]) ? 0 : ((delta[1] >= delta[2]) ? 1 : 2);
+		int minor1 = (major == 0) ? 1 : 0;
+		int minor2 = (major == 2) ? 1 : 2;
+		int err1 = 2 * delta[minor1] - delta[major];
+		int err2 = 2 * delta[minor2] - delta[major];
+		iAVec3i cell = start;
+		for (int i = 0; i < delta[major]; ++i)
 		{
-			err_1 = dx2 - m;
-			err_2 = dz2 - m;
-			for (i = 0; i < m; i++)
+			visit(cell);
+			if (err1 > 0)
 			{
-				cellIds.push_back(pixel);
-				id++;
-				if (err_1 > 0)
-				{
-					pixel[0] += x_inc;
-					err_1 -= dy2;
-				}
-				if (err_2 > 0)
-				{
-					pixel[2] += z_inc;
-					err_2 -= dy2;
-				}
-				err_1 += dx2;
-				err_2 += dz2;
-				pixel[1] += y_inc;
+				cell[minor1] += inc[minor1];
+				err1 -= 2 * delta[major];
 			}
-		}
-		else
-		{
-			err_1 = dy2 - n;
-			err_2 = dx2 - n;
-			for (i = 0; i < n; i++)
+			if (err2 > 0)
 			{
-				cellIds.push_back(pixel);
-				id++;
-				if (err_1 > 0)
-				{
-					pixel[1] += y_inc;
-					err_1 -= dz2;
-				}
-				if (err_2 > 0)
-				{
-					pixel[0] += x_inc;
-					err_2 -= dz2;
-				}
-				err_1 += dy2;
-				err_2 += dx2;
-				pixel[2] += z_inc;
+				cell[minor2] += inc[minor2];
+				err2 -= 2 * delta[major];
 			}
+			err1 += 2 * delta[minor1];
+			err2 += 2 * delta[minor2];
+			cell[major] += inc[major];
 		}
-		cellIds.push_back(pixel);
-		id++;
-
-		return cellIds;
+		visit(cell);
 	}
+
+	//! number of fibers processed between two progress updates
+	const long long FiberBlockSize = 4096;
 }
 
 void iASpatialFeatureSummary::performWork(QVariantMap const & parameters)
@@ -215,73 +165,152 @@ void iASpatialFeatureSummary::performWork(QVariantMap const & parameters)
 		QString("origin: %1, %2, %3; ").arg(metaOrigin[0]).arg(metaOrigin[1]).arg(metaOrigin[2]));
 
 	
-	// determine number of fibers in each cell:
-	auto numberOfFibersImage = allocateImage(VTK_INT, metaDim.data(), metaSpacing.data());
-	auto numberOfPointsImage = allocateImage(VTK_INT, metaDim.data(), metaSpacing.data());
-	fillImage(numberOfFibersImage, 0.0);
-	fillImage(numberOfPointsImage, 0.0);
-	for (int o = 0; o < csvTable->GetNumberOfRows(); ++o)
+	// gather fiber end points and the values of all selected columns in one pass over the table:
+	long long const fiberCount = csvTable->GetNumberOfRows();
+	int const columnCount = columns.size();
+	std::vector<iAVec3i> startVoxels(fiberCount), endVoxels(fiberCount);
+	std::vector<double> values(fiberCount * columnCount);
+	for (long long o = 0; o < fiberCount; ++o)
+	{
+		startVoxels[o] = iAVec3i(iAVec3d(csvTable->GetValue(o, startIdx[0]).ToDouble(), csvTable->GetValue(o, startIdx[1]).ToDouble(), csvTable->GetValue(o, startIdx[2]).ToDouble()) / metaSpacing);
+		endVoxels[o] = iAVec3i(iAVec3d(csvTable->GetValue(o, endIdx[0]).ToDouble(), csvTable->GetValue(o, endIdx[1]).ToDouble(), csvTable->GetValue(o, endIdx[2]).ToDouble()) / metaSpacing);
+		for (int c = 0; c < columnCount; ++c)
+		{
+			values[o * columnCount + c] = csvTable->GetValue(o, columns[c]).ToDouble();
+		}
+	}
+
+	// accumulate number of fibers, number of start/end points and the sums of the column values in each cell;
+	// blocks of fibers are processed in parallel, each thread accumulating into its own grids:
+	int const dim[3] = { metaDim[0], metaDim[1], metaDim[2] };
+	size_t const cellCount = static_cast<size_t>(dim[0]) * dim[1] * dim[2];
+	auto isInside = [&dim](iAVec3i const& c)
+	{
+		return c[0] >= 0 && c[0] < dim[0] && c[1] >= 0 && c[1] < dim[1] && c[2] >= 0 && c[2] < dim[2];
+	};
+	auto cellIndex = [&dim](iAVec3i const& c)
+	{
+		return (static_cast<size_t>(c[2]) * dim[1] + c[1]) * dim[0] + c[0];
+	};
+	std::vector<int> fiberCounts(cellCount, 0), pointCounts(cellCount, 0);
+	std::vector<double> sums(cellCount * columnCount, 0.0);
+	long long invalidCells = 0;
+	iAVec3i firstInvalidCell;
+	long long const blockCount = (fiberCount + FiberBlockSize - 1) / FiberBlockSize;
+	long long blocksDone = 0;
+	int lastPercent = 0;
+#pragma omp parallel
 	{
-		iAVec3i startVoxel(iAVec3d(csvTable->GetValue(o, startIdx[0]).ToDouble(), csvTable->GetValue(o, startIdx[1]).ToDouble(), csvTable->GetValue(o, startIdx[2]).ToDouble()) / metaSpacing);
-		iAVec3i endVoxel(iAVec3d(csvTable->GetValue(o, endIdx[0]).ToDouble(), csvTable->GetValue(o, endIdx[1]).ToDouble(), csvTable->GetValue(o, endIdx[2]).ToDouble()) / metaSpacing);
-		numberOfPointsImage->SetScalarComponentFromDouble(startVoxel.x(), startVoxel.y(), startVoxel.z(), 0,
-			numberOfPointsImage->GetScalarComponentAsDouble(startVoxel.x(), startVoxel.y(), startVoxel.z(), 0) + 1);
-		numberOfPointsImage->SetScalarComponentFromDouble(endVoxel.x(), endVoxel.y(), endVoxel.z(), 0,
-			numberOfPointsImage->GetScalarComponentAsDouble(endVoxel.x(), endVoxel.y(), endVoxel.z(), 0) + 1);
-		auto cellIds = findCellIdsBresenham3D(startVoxel, endVoxel);
-		for (auto c : cellIds)
+		std::vector<int> threadFiberCounts(cellCount, 0), threadPointCounts(cellCount, 0);
+		std::vector<double> threadSums(cellCount * columnCount, 0.0);
+		long long threadInvalidCells = 0;
+		iAVec3i threadFirstInvalidCell;
+#pragma omp for schedule(dynamic, 1)
+		for (long long b = 0; b < blockCount; ++b)
 		{
-			if (c[0] < 0 || c[0] >= metaDim[0] || c[1] < 0 || c[1] >= metaDim[1] || c[2] < 0 || c[2] >= metaDim[2])
+			if (isAborted())
 			{
-				LOG(lvlWarn, QString("Invalid coordinate %1; given volume dimensions are probably too small to contain the fibers in the .csv!").arg(c.toString()));
-				if (parameters[ContinueOnError].toBool())
+				continue;
+			}
+			long long blockEnd = std::min((b + 1) * FiberBlockSize, fiberCount);
+			for (long long o = b * FiberBlockSize; o < blockEnd; ++o)
+			{
+				if (isInside(startVoxels[o]))
+				{
+					++threadPointCounts[cellIndex(startVoxels[o])];
+				}
+				if (isInside(endVoxels[o]))
 				{
-					continue;
+					++threadPointCounts[cellIndex(endVoxels[o])];
 				}
-				else
+				double const* fiberValues = values.data() + o * columnCount;
+				forEachCellDDA3D(startVoxels[o], endVoxels[o], [&](iAVec3i const& c)
 				{
-					return;
+					if (!isInside(c))
+					{
+						if (threadInvalidCells++ == 0)
+						{
+							threadFirstInvalidCell = c;
+						}
+						return;
+					}
+					size_t idx = cellIndex(c);
+					++threadFiberCounts[idx];
+					double* cellSums = threadSums.data() + idx * columnCount;
+					for (int col = 0; col < columnCount; ++col)
+					{
+						cellSums[col] += fiberValues[col];
+					}
+				});
+			}
+#pragma omp critical
+			{
+				++blocksDone;
+				int percent = static_cast<int>((100 * blocksDone) / blockCount);
+				if (percent > lastPercent)
+				{
+					lastPercent = percent;
+					progress()->emitProgress(percent);
 				}
 			}
-			numberOfFibersImage->SetScalarComponentFromDouble(c.x(), c.y(), c.z(), 0,
-				numberOfFibersImage->GetScalarComponentAsDouble(c.x(), c.y(), c.z(), 0) + 1);
+		}
+#pragma omp critical
+		{
+			for (size_t i = 0; i < cellCount; ++i)
+			{
+				fiberCounts[i] += threadFiberCounts[i];
+				pointCounts[i] += threadPointCounts[i];
+			}
+			for (size_t i = 0; i < sums.size(); ++i)
+			{
+				sums[i] += threadSums[i];
+			}
+			if (invalidCells == 0 && threadInvalidCells > 0)
+			{
+				firstInvalidCell = threadFirstInvalidCell;
+			}
+			invalidCells += threadInvalidCells;
 		}
 	}
+	if (isAborted())
+	{
+		return;
+	}
+	if (invalidCells > 0)
+	{
+		LOG(lvlWarn, QString("%1 invalid coordinates (first: %2); given volume dimensions are probably too small to contain the fibers in the .csv!")
+			.arg(invalidCells).arg(firstInvalidCell.toString()));
+		if (!parameters[ContinueOnError].toBool())
+		{
+			return;
+		}
+	}
+
+	auto numberOfFibersImage = allocateImage(VTK_INT, metaDim.data(), metaSpacing.data());
+	auto numberOfPointsImage = allocateImage(VTK_INT, metaDim.data(), metaSpacing.data());
+	std::copy(fiberCounts.begin(), fiberCounts.end(), static_cast<int*>(numberOfFibersImage->GetScalarPointer()));
+	std::copy(pointCounts.begin(), pointCounts.end(), static_cast<int*>(numberOfPointsImage->GetScalarPointer()));
+	numberOfFibersImage->Modified();
+	numberOfPointsImage->Modified();
 	addOutput(numberOfFibersImage);
 	addOutput(numberOfPointsImage);
 	auto r = numberOfFibersImage->GetScalarRange();
 	LOG(lvlDebug, QString("Number of fibers: from %1 to %2").arg(r[0]).arg(r[1]));
 
 	// determine characteristics averages:
-	auto curOutput = 2;
-	for (auto col : columns)
+	for (int col = 0; col < columnCount; ++col)
 	{
 		auto metaImage = allocateImage(VTK_DOUBLE, metaDim.data(), metaSpacing.data());
 		metaImage->SetOrigin(metaOrigin);
-		fillImage(metaImage, 0.0);
-		for (int o = 0; o < csvTable->GetNumberOfRows(); ++o)
+		auto averages = static_cast<double*>(metaImage->GetScalarPointer());
+		for (size_t i = 0; i < cellCount; ++i)
 		{
-			iAVec3i startVoxel(iAVec3d(csvTable->GetValue(o, startIdx[0]).ToDouble(), csvTable->GetValue(o, startIdx[1]).ToDouble(), csvTable->GetValue(o, startIdx[2]).ToDouble()) / metaSpacing);
-			iAVec3i endVoxel(iAVec3d(csvTable->GetValue(o, endIdx[0]).ToDouble(), csvTable->GetValue(o, endIdx[1]).ToDouble(), csvTable->GetValue(o, endIdx[2]).ToDouble()) / metaSpacing);
-			auto val = csvTable->GetValue(o, col).ToDouble();
-			auto cellIds = findCellIdsBresenham3D(startVoxel, endVoxel);
-			for (auto c : cellIds)
-			{
-				if (c[0] < 0 || c[0] >= metaDim[0] || c[1] < 0 || c[1] >= metaDim[1] || c[2] < 0 || c[2] >= metaDim[2])
-				{
-					LOG(lvlWarn, QString("Invalid coordinate %1").arg(c.toString()));
-					continue;
-				}
-				auto cellValue = metaImage->GetScalarComponentAsDouble(c.x(), c.y(), c.z(), 0);
-				auto numOfFibersInCell = numberOfFibersImage->GetScalarComponentAsDouble(c.x(), c.y(), c.z(), 0);
-				assert(numOfFibersInCell != 0); // should not happen, since above we visited the same cells
-				metaImage->SetScalarComponentFromDouble(c.x(), c.y(), c.z(), 0, cellValue + val / numOfFibersInCell	);
-			}
+			averages[i] = (fiberCounts[i] == 0) ? 0.0 : sums[i * columnCount + col] / fiberCounts[i];
 		}
-		setOutputName(curOutput, headers[col]);
+		metaImage->Modified();
+		setOutputName(2 + col, headers[columns[col]]);
 		addOutput(metaImage);
 		auto rng = metaImage->GetScalarRange();
-		LOG(lvlDebug, QString("Output %1: values from %2 to %3").arg(headers[col]).arg(rng[0]).arg(rng[1]));
-		++curOutput;
+		LOG(lvlDebug, QString("Output %1: values from %2 to %3").arg(headers[columns[col]]).arg(rng[0]).arg(rng[1]));
 	}
 }
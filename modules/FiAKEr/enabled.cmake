@@ -1,10 +1,10 @@
 if (openiA_TESTING_ENABLED)
 	get_filename_component(CoreSrcDir "../libs/base" REALPATH BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
 	get_filename_component(CoreBinDir "../libs" REALPATH BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
-	add_executable(MDSTest FiAKEr/iAMultiDimensionalScalingTest.cpp FiAKEr/iAMultidimensionalScaling.cpp)
+	add_executable(MDSTest FiAKEr/iAMultiDimensionalScalingTest.cpp FiAKEr/iAMultidimensionalScaling.cpp ${CoreSrcDir}/iASMACOF.cpp)
 	target_link_libraries(MDSTest PRIVATE Qt${QT_VERSION_MAJOR}::Core)
 	target_include_directories(MDSTest PRIVATE
-		${CoreSrcDir}                         # for iAStringHelper, required by MDS
+		${CoreSrcDir}                         # for iAStringHelper and iASMACOF, required by MDS
 		${CoreBinDir}                         # for iAbase_export.h
 		${CMAKE_CURRENT_BINARY_DIR}           # for _export.h
 	)
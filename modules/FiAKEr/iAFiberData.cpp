@@ -4,6 +4,7 @@
 
 #include "iACsvConfig.h"
 
+#include <iAAABB.h>
 #include <iALog.h>
 #include <iAMathUtility.h>
 
@@ -11,6 +12,8 @@
 #include <vtkTable.h>
 #include <vtkVariant.h>
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 
 
@@ -352,6 +355,163 @@ bool pointContainedInFiber(iAVec3f const& point, iAFiberData const& fiber)
 	}
 }
 
+namespace
+{
+	//! Collects the (linear) indices of all voxels in the range [minV, maxV) which have a corner inside
+	//! the cylinder around the given fiber segment. Only visits grid points close to the segment axis:
+	//! Along each row of grid points in the dominant direction of the segment, the interval inside the
+	//! cylinder is determined analytically, and only the grid points in that interval are tested exactly.
+	void rasterizeSegment(iAVec3f const& start, iAVec3f const& dir, double radius,
+		int const size[3], iAVec3d const& spacing, iAVec3d const& origin,
+		iAVec3i const& minV, iAVec3i const& maxV, std::vector<size_t>& voxels)
+	{
+		double length = dir.length();
+		if (length == 0)
+		{	// pointContainedInLineSegment never considers a point to be inside a zero-length segment
+			return;
+		}
+		iAVec3d s(start), d(dir);
+		iAVec3d u = d / length;
+		// range of grid points (voxel corners) that can lie inside the cylinder:
+		int lo[3], hi[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			double c0 = (std::min(s[i], s[i] + d[i]) - radius - origin[i]) / spacing[i];
+			double c1 = (std::max(s[i], s[i] + d[i]) + radius - origin[i]) / spacing[i];
+			lo[i] = std::max(minV[i], static_cast<int>(std::floor(clamp(-2.0, size[i] + 2.0, c0))) - 1);
+			hi[i] = std::min(maxV[i], static_cast<int>(std::ceil(clamp(-2.0, size[i] + 2.0, c1))) + 1);
+			if (lo[i] > hi[i])
+			{
+				return;
+			}
+		}
+		// walk rows along the axis in which the segment advances the most grid points:
+		int a = 0;
+		for (int i = 1; i < 3; ++i)
+		{
+			if (std::abs(u[i] / spacing[i]) > std::abs(u[a] / spacing[a]))
+			{
+				a = i;
+			}
+		}
+		int b = (a + 1) % 3, c = (a + 2) % 3;
+		// along a row, with t the grid index along a, the projection onto the axis is p0 + t * pe,
+		// and the squared distance to the axis is A * t^2 + B * t + C:
+		double pe = u[a] * spacing[a];
+		double A = spacing[a] * spacing[a] - pe * pe;
+		double r2 = radius * radius;
+		int idx[3];
+		for (idx[c] = lo[c]; idx[c] <= hi[c]; ++idx[c])
+		{
+			for (idx[b] = lo[b]; idx[b] <= hi[b]; ++idx[b])
+			{
+				iAVec3d v0;  // vector from segment start to the grid point with index 0 along a in this row
+				v0[a] = origin[a] - s[a];
+				v0[b] = origin[b] + idx[b] * spacing[b] - s[b];
+				v0[c] = origin[c] + idx[c] * spacing[c] - s[c];
+				double p0 = dotProduct(v0, u);
+				double B = 2 * (v0[a] * spacing[a] - p0 * pe);
+				double C = v0.sqrMagnitude() - p0 * p0;
+				double tMin = -p0 / pe, tMax = (length - p0) / pe;
+				if (tMin > tMax)
+				{
+					std::swap(tMin, tMax);
+				}
+				if (A > 1e-12 * spacing[a] * spacing[a])
+				{
+					double disc = B * B - 4 * A * (C - r2);
+					if (disc < 0)
+					{
+						continue;
+					}
+					double sq = std::sqrt(disc);
+					tMin = std::max(tMin, (-B - sq) / (2 * A));
+					tMax = std::min(tMax, (-B + sq) / (2 * A));
+				}
+				else if (C >= r2)
+				{	// row parallel to the segment axis, and outside of the cylinder
+					continue;
+				}
+				if (tMin > tMax)
+				{
+					continue;
+				}
+				// widen by one grid point to be safe against rounding differences; the exact test follows:
+				int t0 = std::max(lo[a], static_cast<int>(std::floor(clamp(-2.0, size[a] + 2.0, tMin))) - 1);
+				int t1 = std::min(hi[a], static_cast<int>(std::ceil(clamp(-2.0, size[a] + 2.0, tMax))) + 1);
+				for (idx[a] = t0; idx[a] <= t1; ++idx[a])
+				{
+					// same computation of the corner coordinates as in a brute-force check over all voxel corners:
+					iAVec3f pt = origin + iAVec3d(idx[0], idx[1], idx[2]) * spacing;
+					if (!pointContainedInLineSegment(start, dir, radius, pt))
+					{
+						continue;
+					}
+					// all voxels having this grid point as corner are covered:
+					for (int z = std::max(minV[2], idx[2] - 1); z <= idx[2] && z < maxV[2]; ++z)
+					{
+						for (int y = std::max(minV[1], idx[1] - 1); y <= idx[1] && y < maxV[1]; ++y)
+						{
+							for (int x = std::max(minV[0], idx[0] - 1); x <= idx[0] && x < maxV[0]; ++x)
+							{
+								voxels.push_back(x + static_cast<size_t>(size[0]) * (y + static_cast<size_t>(size[1]) * z));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void rasterizeFibers(std::vector<iAFiberData> const& fibers, std::vector<iAAABB> const& fiberBBs, float* buffer,
+	int const size[3], iAVec3d const& spacing, iAVec3d const& origin, bool const* aborted)
+{
+	long long fiberCount = static_cast<long long>(fibers.size());
+#pragma omp parallel
+	{
+		std::vector<size_t> voxels;  // per-thread buffer for the voxels covered by the current fiber
+#pragma omp for schedule(dynamic, 16)
+		for (long long f = 0; f < fiberCount; ++f)
+		{
+			if (aborted && *aborted)
+			{
+				continue;
+			}
+			auto const& fiber = fibers[f];
+			iAVec3i minV = (fiberBBs[f].minCorner() - origin) / spacing, maxV = (fiberBBs[f].maxCorner() - origin) / spacing;
+			for (int i = 0; i < 3; ++i)
+			{
+				minV[i] = clamp(0, size[i], minV[i]);
+				maxV[i] = clamp(0, size[i], maxV[i]);
+			}
+			voxels.clear();
+			double radius = fiber.diameter / 2.0;
+			if (fiber.curvedPoints.empty())
+			{
+				rasterizeSegment(fiber.pts[PtStart], fiber.pts[PtEnd] - fiber.pts[PtStart], radius,
+					size, spacing, origin, minV, maxV, voxels);
+			}
+			else
+			{
+				for (size_t i = 0; i < fiber.curvedPoints.size() - 1; ++i)
+				{
+					rasterizeSegment(fiber.curvedPoints[i], fiber.curvedPoints[i + 1] - fiber.curvedPoints[i], radius,
+						size, spacing, origin, minV, maxV, voxels);
+				}
+			}
+			// a voxel is counted only once per fiber, even if several of its corners are inside:
+			std::sort(voxels.begin(), voxels.end());
+			voxels.erase(std::unique(voxels.begin(), voxels.end()), voxels.end());
+			for (size_t v : voxels)
+			{
+#pragma omp atomic
+				buffer[v] += 1;
+			}
+		}
+	}
+}
+
 void samplePoints(iAFiberData const& fiber, std::vector<iAVec3f>& result, size_t numSamples, double RadiusFactor)
 {
 	result.reserve(numSamples);
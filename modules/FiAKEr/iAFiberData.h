@@ -8,6 +8,7 @@
 
 #include <vector>
 
+class iAAABB;
 class vtkTable;
 
 enum {
@@ -34,6 +35,19 @@ struct iAFiberData
 
 //! check if a point is contained in a fiber
 bool pointContainedInFiber(iAVec3f const& point, iAFiberData const& fiber);
+//! Rasterizes fibers into a regular voxel grid: increments each voxel covered by a fiber by 1, where a voxel
+//! counts as covered if at least one of its 8 corners lies inside the fiber (see pointContainedInFiber).
+//! Gives the same result as testing all voxels in the bounding box of each fiber, but only visits the
+//! grid points close to the fiber axis; fibers are processed in parallel.
+//! @param fibers the fibers to rasterize
+//! @param fiberBBs the bounding boxes of the fibers; only voxels within the bounding box of a fiber are considered
+//! @param buffer the voxel values (size[0] * size[1] * size[2] values, x index running fastest)
+//! @param size the number of voxels in each dimension
+//! @param spacing the size of a voxel
+//! @param origin the position of the first corner of the grid
+//! @param aborted if given, rasterization stops as soon as this is set to true
+void rasterizeFibers(std::vector<iAFiberData> const& fibers, std::vector<iAAABB> const& fiberBBs, float* buffer,
+	int const size[3], iAVec3d const& spacing, iAVec3d const& origin, bool const* aborted = nullptr);
 //! Samples points inside of the cylinder spanned by a single fiber
 void samplePoints(iAFiberData const& fiber, std::vector<iAVec3f>& result, size_t numSamples = DefaultSamplePoints, double RadiusFactor = 1.0);
 
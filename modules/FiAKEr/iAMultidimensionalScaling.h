@@ -23,11 +23,8 @@ iADistanceMetricID stringToDistanceMetric(QString const & string);
 */
 QString matrixToString(iAMatrixType const& input);
 
-//! Multidimensional scaling (MDS) with SMACOF
-//! This code re-implements Michael Bronstein's SMACOF in his Matlab Toolbox for Surface Comparison and Analysis
-//! The Matlab SMACOF can be downloaded at http://tosca.cs.technion.ac.il/
-//! [1] A. M. Bronstein, M. M. Bronstein, R. Kimmel,"Numerical geometry of nonrigid shapes", Springer, 2008.
-//! TODO: Move to core!
+//! Multidimensional scaling (MDS) with SMACOF, for a distance matrix given as vector of rows.
+//! Convenience wrapper around computeSMACOF (see iASMACOF.h), which works on flat, row-major matrices.
 iAMatrixType computeMDS(iAMatrixType const& distanceMatrix, int outputDimensions, int iterations,
 	double maxError = 0.0 /*, iADistanceMetricID distanceMetric*/, bool initRandom = true);
 
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iASensitivityData.h"
 
+#include "iAFiberData.h"
 #include "iAFiberResult.h"
 #include "iARefDistCompute.h"    // for CacheFileQtDataStreamVersion, etc.
 
@@ -25,19 +26,34 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <numeric>
 
 namespace
 {
 	using HistogramType = QVector<double>;
 
+	//! suffix for cache file names of spatial overview images; empty for the default size to keep existing caches valid
+	QString sizeSuffix(int volSize)
+	{
+		return (volSize == iASensitivityData::SpatialOverviewSize) ? QString() : QString("-%1").arg(volSize);
+	}
+
 	const QString DissimilarityMatrixCacheFileIdentifier("DissimilarityMatrixCache");
-	const quint32 DissimilarityMatrixCacheFileVersion(3);
+	const quint32 DissimilarityMatrixCacheFileVersion(4);
 	// change from v1 to v2:
 	//   - changed data types in iAFiberSimilarity:
 	//     - index        : quint64 -> quint32
 	//     - dissimilarity: double -> float
 	// change from v2 to v3:
 	//   - non-symmetric matrix (to find respective, "directed" best matches in the other result)
+	// change from v3 to v4:
+	//   - instead of the full matrix, a sequence of records per result pair (identified by result file names),
+	//     each containing the dissimilarities of both directions for a set of measures; appended as soon as
+	//     a pair is computed, so that interrupted computations can be resumed, and only pairs involving
+	//     new results or measures need to be computed
 
 	double distributionDifference(HistogramType const& distr1, HistogramType const& distr2, int diffType)
 	{
@@ -184,69 +200,6 @@ namespace
 	}
 	*/
 
-	void projectFiberToImage(iAFiberData const& fiberData, iAAABB const& bb, vtkSmartPointer<vtkImageData> img,
-		int const size[3], iAVec3d const& spacing, iAVec3d const& origin)
-	{
-		// naive / brute force way:
-		// for each voxel v
-		//     check if any part of v is covered by current fiber (by checking all edge points?)
-		//     output: covered ? 1 : 0
-		//  (variant: instead of 1/0, check percentage to which voxel is covered by fiber?) -> probably hard to do
-
-		// optimization:
-		//     take AABB for fiber
-		//     compute index range for AABB
-		// only iterate over this range
-		iAVec3i minC = (bb.minCorner() - origin) / spacing, maxC = (bb.maxCorner() - origin) / spacing;
-		for (int i = 0; i < 3; ++i)
-		{
-			if (minC[i] < 0 || minC[i] > size[i] || maxC[i] < 0 || maxC[i] > size[i])
-			{
-				LOG(lvlDebug, QString("Interesting fiber: outside bb!"));
-			}
-			minC[i] = clamp(0, size[i] + 1, minC[i]);
-			maxC[i] = clamp(0, size[i] + 1, maxC[i]);
-		}
-
-#pragma omp parallel for
-		for (int x = minC[0]; x < maxC[0]; ++x)
-		{
-			for (int y = minC[1]; y < maxC[1]; ++y)
-			{
-				for (int z = minC[2]; z < maxC[2]; ++z)
-				{
-					iAVec3d coord(x, y, z);
-					// get the 8 corners of the voxel cube (in no particular order, just based on offsets)
-					const size_t CornerCount = 8;
-					iAVec3f corners[CornerCount];
-					corners[0] = origin + coord * spacing;
-					for (int i = 0; i < 3; ++i)
-					{
-						iAVec3d tmpcoord(coord);
-						tmpcoord[i] += 1;
-						corners[1 + i] = origin + tmpcoord * spacing;
-						tmpcoord[(i + 1) % 3] += 1;
-						corners[4 + i] = origin + tmpcoord * spacing;
-					}
-					corners[7] = origin + (coord + 1) * spacing;
-					bool match = false;
-					for (size_t c = 0; c < CornerCount; ++c)
-					{
-						if (pointContainedInFiber(corners[c], fiberData))
-						{
-							match = true;
-							break;
-						}
-					}
-					if (match)
-					{
-						img->SetScalarComponentFromDouble(x, y, z, 0, img->GetScalarComponentAsDouble(x, y, z, 0) + 1);
-					}
-				}
-			}
-		}
-	}
-
 }  // namespace
 
 
@@ -264,6 +217,41 @@ QDataStream& operator>>(QDataStream& in, iAResultPairInfo& pairInfo)
 	return in;
 }
 
+namespace
+{
+	//! copy the dissimilarities for some measures from one result pair info to another
+	//! @param dst the result pair info to copy to
+	//! @param src the result pair info to copy from
+	//! @param srcIdx indices of the measures to copy, in src
+	//! @param dstIdx indices of the measures to copy, in dst (same order as srcIdx)
+	//! @param dstMeasureCount overall number of measures in dst
+	void mergePairInfo(iAResultPairInfo& dst, iAResultPairInfo const& src,
+		std::vector<int> const& srcIdx, std::vector<int> const& dstIdx, int dstMeasureCount)
+	{
+		dst.avgDissim.resize(dstMeasureCount);
+		if (dst.fiberDissim.size() < src.fiberDissim.size())
+		{
+			dst.fiberDissim.resize(src.fiberDissim.size());
+		}
+		for (size_t k = 0; k < srcIdx.size(); ++k)
+		{
+			dst.avgDissim[dstIdx[k]] = src.avgDissim[srcIdx[k]];
+		}
+		for (qvectorsizetype f = 0; f < static_cast<qvectorsizetype>(src.fiberDissim.size()); ++f)
+		{
+			if (src.fiberDissim[f].size() == 0)
+			{	// no fibers with intersecting bounding box
+				continue;
+			}
+			dst.fiberDissim[f].resize(dstMeasureCount);
+			for (size_t k = 0; k < srcIdx.size(); ++k)
+			{
+				dst.fiberDissim[f][dstIdx[k]] = src.fiberDissim[f][srcIdx[k]];
+			}
+		}
+	}
+}
+
 
 iASensitivityData::iASensitivityData(QSharedPointer<iAFiberResultsCollection> data, QStringList const& paramNames,
 	std::vector<std::vector<double>> const& paramValues) :
@@ -756,124 +744,10 @@ void iASensitivityData::compute(iAProgress* progress)
 		}
 	}
 
-	progress->setStatus("Loading cached dissimilarities between all result pairs.");
-	progress->emitProgress(0);
-	QVector<int> measures;
-
-	if (readDissimilarityMatrixCache(measures))
-	{
-		m_resultDissimMeasures.clear();
-		for (auto m : measures)
-		{
-			m_resultDissimMeasures.push_back(std::make_pair(m, true));
-		}
-	}
-	else
+	computeDissimilarityMatrix(progress);
+	if (m_aborted)
 	{
-		progress->setStatus("Computing dissimilarity between all result pairs.");
-		// Thoughts on per-object sensitivity:
-		// required: 1-1 match between fibers
-		// currently compute on the fly, based on bounding boxes of fibers;
-		// for further improvement, spatial subdivision structure would be required
-
-		// Questions:
-		// options for characteristic comparison:
-		//    1. compute characteristic distribution difference
-		//        - advantage: dissimilarity measure independent
-		//        - disadvantage: distribution could be same even if lots of differences for single fibers
-		//    2. compute matching fibers; then compute characteristic difference; then average this
-		//        - advantage: represents actual differences better
-		//        - disadvantage: depending on dissimilarity measure (since best match could be computed per dissimiliarity measure
-		//    example: compare
-		//         - result 1 with fibers a (len=5), b (len=3) and c (len=2)
-		//         - result 2 with fibers A (len 3), B (len=2) and C (len=5)
-		//         - best matches between result1&2: a <-> A, b <-> B, c <-> C
-		//         - option 1 -> exactly the same, 1x5, 1x3, 1x2
-		//         - option 2 -> length differences: 2, 1, 3
-		int measureCount = static_cast<int>(m_resultDissimMeasures.size());
-		int resultCount = static_cast<int>(m_data->result.size());
-		m_resultDissimMatrix = iADissimilarityMatrixType(
-			resultCount,
-			QVector<iAResultPairInfo>(resultCount, iAResultPairInfo(measureCount)));
-
-		for (size_t m = 0; m < m_resultDissimMeasures.size(); ++m)
-		{
-			measures.push_back(m_resultDissimMeasures[m].first);
-		}
-
-		//double overallPairs = resultCount * (resultCount - 1) / 2;
-		// for all result pairs r1 and r2, for every fiber f in r1 find those fibers in r2 which best match f
-		double overallPairs = static_cast<double>(resultCount) * resultCount;
-		size_t curCheckedPairs = 0;
-		for (int r1 = 0; r1 < resultCount && !m_aborted; ++r1)
-		{
-			auto& res1 = m_data->result[r1];
-			auto const& mapping = *res1.mapping.data();
-			// TODO: only center -> should use bounding box instead!
-			double const* cxr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterX]),
-				* cyr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterY]),
-				* czr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterZ]);
-			double a = cxr[1] - cxr[0], b = cyr[1] - cyr[0], c = czr[1] - czr[0];
-			double diagonalLength = std::sqrt(std::pow(a, 2) + std::pow(b, 2) + std::pow(c, 2));
-			double const* lengthRange = m_data->spmData->paramRange(mapping[iACsvConfig::Length]);
-			double maxLength = lengthRange[1] - lengthRange[0];
-			for (int r2 = 0; r2 < resultCount && !m_aborted; ++r2)
-			{
-				auto& mat = m_resultDissimMatrix[r1][r2];
-				for (int m = 0; m < measureCount; ++m)
-				{
-					mat.avgDissim[m] = 0;
-				}
-				if (r1 == r2)
-				{
-					continue;
-				}
-				progress->setStatus(QString("Computing dissimilarity between results %1 and %2.").arg(r1).arg(r2));
-				int r1FibCount = static_cast<int>(m_data->result[r1].fiberCount);
-				std::vector<int> r2MatchCount(measureCount, 0);
-				auto& dissimilarities = mat.fiberDissim;
-				dissimilarities.resize(r1FibCount);
-				// not ideal: for loop seems to be not ideally parallelizable,
-				// one spike where 100% is used, then going down to nearly 0, until next loop starts
-				int noCanDo = 0;
-				size_t candSum = 0;
-#pragma omp parallel for reduction(+ : noCanDo, candSum)
-				for (int fiberID = 0; fiberID < r1FibCount; ++fiberID)
-				{
-					auto candidates = intersectingBoundingBox(m_data->result[r1].fiberBB[fiberID], m_data->result[r2].fiberBB);
-					if (candidates.size() == 0)
-					{
-						++noCanDo; // thread-safe
-						continue;
-					}
-					candSum += candidates.size();
-					getBestMatches2(m_data->result[r1].fiberData[fiberID], m_data->result[r2].fiberData,
-						dissimilarities[fiberID], candidates, diagonalLength, maxLength,
-						m_resultDissimMeasures);
-					for (int m = 0; m < measureCount; ++m)
-					{
-						if (dissimilarities[fiberID][m].size() > 0)
-						{
-							++r2MatchCount[m];
-							mat.avgDissim[m] += dissimilarities[fiberID][m][0].dissimilarity;
-						}
-					}
-				}
-				LOG(lvlDebug, QString("Result %1x%2: %3 candidates on average, %4 with no bounding box intersections out of %5")
-					.arg(r1).arg(r2).arg(static_cast<double>(candSum) / r1FibCount).arg(noCanDo).arg(r1FibCount));
-				for (int m = 0; m < measureCount; ++m)
-				{
-					mat.avgDissim[m] /= r2MatchCount[m];
-				}
-				++curCheckedPairs;
-				progress->emitProgress(curCheckedPairs * 100.0 / overallPairs);
-			}
-		}
-		if (m_aborted)
-		{
-			return;
-		}
-		writeDissimilarityMatrixCache(measures);
+		return;
 	}
 	if (m_resultDissimMatrix.size() == 0)
 	{
@@ -1193,7 +1067,7 @@ double iASensitivityData::characteristicsDifference(int charIdx, qvectorsizetype
 	// compute geometric average
 }
 
-void iASensitivityData::computeSpatialOverview(iAProgress* progress)
+void iASensitivityData::computeSpatialOverview(iAProgress* progress, int volSize)
 {
 	// initialize 3D overview:
 	// required: for each result, and each fiber - quality of match to best-matching fiber in all others
@@ -1202,7 +1076,6 @@ void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 	// 	   Q: how to handle no match?
 	// 	   Q:
 	size_t resultCount = m_data->result.size();
-	int const volSize = 128;
 	int const size[3] = {volSize, volSize, volSize};
 	// find bounding box that accomodates all results:
 	std::vector<iAAABB> resultBBs;
@@ -1231,11 +1104,11 @@ void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 	progress->emitProgress(0);
 	iAVec3d origin = overallBB.minCorner();
 
-	QFile volPercentOutFile(volumePercentageCacheFileName());
-	if (volPercentOutFile.exists() && QFile::exists(averageFiberVoxelCacheFileName()))
+	QFile volPercentOutFile(volumePercentageCacheFileName(volSize));
+	if (volPercentOutFile.exists() && QFile::exists(averageFiberVoxelCacheFileName(volSize)))
 	{
-		progress->setStatus(QString("Loading average fiber volume coverage cache from %1.").arg(averageFiberVoxelCacheFileName()));
-		readImage(averageFiberVoxelCacheFileName(), false, m_averageFiberVoxel);
+		progress->setStatus(QString("Loading average fiber volume coverage cache from %1.").arg(averageFiberVoxelCacheFileName(volSize)));
+		readImage(averageFiberVoxelCacheFileName(volSize), false, m_averageFiberVoxel);
 	}
 	else
 	{
@@ -1246,11 +1119,11 @@ void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 		{
 			LOG(lvlError,
 				QString("FIAKER fiber volume percentage: Cannot open file %1 for writing!")
-					.arg(volumePercentageCacheFileName()));
+					.arg(volumePercentageCacheFileName(volSize)));
 			return;
 		}
 		QTextStream volPercentOut(&volPercentOutFile);
-		size_t overallVoxels = volSize * volSize * volSize;
+		size_t overallVoxels = static_cast<size_t>(volSize) * volSize * volSize;
 		if (volPercentOutFile.size() == 0)		// to support resuming
 		{
 			volPercentOut << "ResultID,Percentage,FiberVoxel(overall=" << overallVoxels << ")" << Qt::endl;
@@ -1259,7 +1132,7 @@ void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 		{
 			progress->setStatus(QString("Computing fiber volume coverage for result %1.").arg(r));
 			vtkSmartPointer<vtkImageData> resultFiberImg;
-			QString resultCacheFileName = resultFiberCacheFileName(r);
+			QString resultCacheFileName = resultFiberCacheFileName(r, volSize);
 			if (QFile::exists(resultCacheFileName))
 			{
 				readImage(resultCacheFileName, false, resultFiberImg);
@@ -1270,23 +1143,10 @@ void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 				resultFiberImg->SetOrigin(origin.data());
 				fillImage(resultFiberImg, 0);
 				auto const& d = m_data->result[r];
-				for (size_t f = 0; f < d.fiberCount && !m_aborted; ++f)
-				{
-					projectFiberToImage(d.fiberData[f], d.fiberBB[f], resultFiberImg, size, spacing, origin);
-				}
+				auto fiberBuf = static_cast<float*>(resultFiberImg->GetScalarPointer());
+				rasterizeFibers(d.fiberData, d.fiberBB, fiberBuf, size, spacing, origin, &m_aborted);
 				// count voxels != 0:
-				size_t fiberVoxels = 0;
-				FOR_VTKIMG_PIXELS(resultFiberImg, x, y, z)
-				{
-					if (resultFiberImg->GetScalarComponentAsDouble(x, y, z, 0) != 0)
-					{
-						++fiberVoxels;
-					}
-					if (m_aborted)
-					{
-						break;
-					}
-				}
+				size_t fiberVoxels = std::count_if(fiberBuf, fiberBuf + overallVoxels, [](float v) { return v != 0; });
 				if (m_aborted)
 				{	// on aborting, also skip writing volume percentage and result fiber image, as they might be incorrect anyway.
 					break;
@@ -1311,7 +1171,7 @@ void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 			return;
 		}
 		multiplyImage(m_averageFiberVoxel, 1.0 / resultCount);
-		storeImage(m_averageFiberVoxel, averageFiberVoxelCacheFileName());
+		storeImage(m_averageFiberVoxel, averageFiberVoxelCacheFileName(volSize));
 	}
 	if (m_aborted)
 	{
@@ -1423,7 +1283,8 @@ void iASensitivityData::computeSpatialOverview(iAProgress* progress)
 				break;
 			}
 			auto const& r = m_data->result[s.first];
-			projectFiberToImage(r.fiberData[s.second], r.fiberBB[s.second], uniqueFiberVarImg, size, spacing, origin);
+			rasterizeFibers({r.fiberData[s.second]}, {r.fiberBB[s.second]},
+				static_cast<float*>(uniqueFiberVarImg->GetScalarPointer()), size, spacing, origin, &m_aborted);
 		}
 		multiplyImage(uniqueFiberVarImg, 1.0 / u.size());
 		perUniqueFiberVars.push_back(uniqueFiberVarImg);
@@ -1461,9 +1322,9 @@ QString iASensitivityData::dissimilarityMatrixCacheFileName() const
 	return cacheFileName("dissimilarityMatrix.cache");
 }
 
-QString iASensitivityData::volumePercentageCacheFileName() const
+QString iASensitivityData::volumePercentageCacheFileName(int volSize) const
 {
-	return cacheFileName("volumePercentages.csv");
+	return cacheFileName(QString("volumePercentages%1.csv").arg(sizeSuffix(volSize)));
 }
 
 QString iASensitivityData::spatialOverviewCacheFileName() const
@@ -1471,9 +1332,9 @@ QString iASensitivityData::spatialOverviewCacheFileName() const
 	return cacheFileName("spatialOverview-v0.mhd");
 }
 
-QString iASensitivityData::averageFiberVoxelCacheFileName() const
+QString iASensitivityData::averageFiberVoxelCacheFileName(int volSize) const
 {
-	return cacheFileName("averageFiberVoxels-v0.mhd");
+	return cacheFileName(QString("averageFiberVoxels%1-v0.mhd").arg(sizeSuffix(volSize)));
 }
 
 QString iASensitivityData::uniqueFiberVarCacheFileName(size_t uIdx) const
@@ -1481,15 +1342,211 @@ QString iASensitivityData::uniqueFiberVarCacheFileName(size_t uIdx) const
 	return cacheFileName(QString("uniqueFiberVar-%1-v0.mhd").arg(uIdx));
 }
 
-QString iASensitivityData::resultFiberCacheFileName(size_t rIdx) const
+QString iASensitivityData::resultFiberCacheFileName(size_t rIdx, int volSize) const
+{
+	return cacheFileName(QString("result-%1%2-v0.mhd").arg(rIdx).arg(sizeSuffix(volSize)));
+}
+
+QString iASensitivityData::resultCacheName(int resultIdx) const
+{
+	return QDir(m_data->folder).relativeFilePath(m_data->result[resultIdx].fileName);
+}
+
+void iASensitivityData::computeDissimilarityMatrix(iAProgress* progress)
+{
+	progress->setStatus("Loading cached dissimilarities between all result pairs.");
+	progress->emitProgress(0);
+	QVector<int> cachedMeasures;
+	bool cacheValid = readDissimilarityMatrixCacheHeader(cachedMeasures);
+	if (m_resultDissimMeasures.empty())
+	{	// no measures selected -> use the ones from the cache:
+		for (auto m : cachedMeasures)
+		{
+			m_resultDissimMeasures.push_back(std::make_pair(m, true));
+		}
+	}
+	QVector<int> measures;
+	for (auto m : m_resultDissimMeasures)
+	{
+		measures.push_back(m.first);
+	}
+	int measureCount = static_cast<int>(m_resultDissimMeasures.size());
+	int resultCount = static_cast<int>(m_data->result.size());
+	m_resultDissimMatrix = iADissimilarityMatrixType(
+		resultCount,
+		QVector<iAResultPairInfo>(resultCount, iAResultPairInfo(measureCount)));
+	std::vector<std::vector<char>> pairDone(static_cast<size_t>(resultCount) * resultCount, std::vector<char>(measureCount, 0));
+	int fileRecords = cacheValid ? readDissimilarityMatrixCache(pairDone) : 0;
+	if (!cacheValid || cachedMeasures != measures)
+	{	// start new cache file (keeping all still applicable cached dissimilarities) for the current measures:
+		fileRecords = writeDissimilarityMatrixCache(pairDone);
+	}
+
+	// Thoughts on per-object sensitivity:
+	// required: 1-1 match between fibers
+	// currently compute on the fly, based on bounding boxes of fibers;
+	// for further improvement, spatial subdivision structure would be required
+
+	// Questions:
+	// options for characteristic comparison:
+	//    1. compute characteristic distribution difference
+	//        - advantage: dissimilarity measure independent
+	//        - disadvantage: distribution could be same even if lots of differences for single fibers
+	//    2. compute matching fibers; then compute characteristic difference; then average this
+	//        - advantage: represents actual differences better
+	//        - disadvantage: depending on dissimilarity measure (since best match could be computed per dissimiliarity measure
+	//    example: compare
+	//         - result 1 with fibers a (len=5), b (len=3) and c (len=2)
+	//         - result 2 with fibers A (len 3), B (len=2) and C (len=5)
+	//         - best matches between result1&2: a <-> A, b <-> B, c <-> C
+	//         - option 1 -> exactly the same, 1x5, 1x3, 1x2
+	//         - option 2 -> length differences: 2, 1, 3
+
+	// one task per unordered result pair, computing both directions for all measures not available from cache:
+	struct PairTask
+	{
+		int r1, r2;
+		std::vector<int> measureIdx;
+	};
+	std::vector<PairTask> tasks;
+	for (int r1 = 0; r1 < resultCount; ++r1)
+	{
+		for (int r2 = r1 + 1; r2 < resultCount; ++r2)
+		{
+			PairTask task{r1, r2, {}};
+			for (int m = 0; m < measureCount; ++m)
+			{
+				if (!pairDone[r1 * resultCount + r2][m])
+				{
+					task.measureIdx.push_back(m);
+				}
+			}
+			if (!task.measureIdx.empty())
+			{
+				tasks.push_back(task);
+			}
+		}
+	}
+	long long pairCount = static_cast<long long>(resultCount) * (resultCount - 1) / 2;
+	LOG(lvlInfo, QString("Dissimilarity matrix: %1 of %2 result pairs available from cache, computing %3.")
+		.arg(pairCount - static_cast<long long>(tasks.size())).arg(pairCount).arg(tasks.size()));
+	if (tasks.empty())
+	{
+		return;
+	}
+	progress->setStatus("Computing dissimilarity between all result pairs.");
+	// each finished pair is appended to the cache immediately, so that an aborted computation can be resumed:
+	QFile cacheFile(dissimilarityMatrixCacheFileName());
+	if (!cacheFile.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		LOG(lvlWarn, QString("Couldn't open file %1 for writing, dissimilarities will not be cached!").arg(cacheFile.fileName()));
+	}
+	QDataStream out(&cacheFile);
+	out.setVersion(CacheFileQtDataStreamVersion);
+	// with enough pairs, compute pairs in parallel, otherwise parallelize over the fibers within a pair:
+	bool parallelPairs = tasks.size() >= static_cast<size_t>(QThread::idealThreadCount());
+	long long taskCount = static_cast<long long>(tasks.size());
+	long long finishedTasks = 0;
+#pragma omp parallel for schedule(dynamic) if (parallelPairs)
+	for (long long t = 0; t < taskCount; ++t)
+	{
+		if (m_aborted)
+		{
+			continue;
+		}
+		auto const& task = tasks[t];
+		std::vector<std::pair<int, bool>> taskMeasures;
+		QVector<int> taskMeasureIDs;
+		for (auto m : task.measureIdx)
+		{
+			taskMeasures.push_back(m_resultDissimMeasures[m]);
+			taskMeasureIDs.push_back(m_resultDissimMeasures[m].first);
+		}
+		iAResultPairInfo info12, info21;
+		computeResultPairDissimilarity(task.r1, task.r2, taskMeasures, info12, !parallelPairs);
+		computeResultPairDissimilarity(task.r2, task.r1, taskMeasures, info21, !parallelPairs);
+		std::vector<int> subIdx(task.measureIdx.size());
+		std::iota(subIdx.begin(), subIdx.end(), 0);
+#pragma omp critical
+		{
+			mergePairInfo(m_resultDissimMatrix[task.r1][task.r2], info12, subIdx, task.measureIdx, measureCount);
+			mergePairInfo(m_resultDissimMatrix[task.r2][task.r1], info21, subIdx, task.measureIdx, measureCount);
+			for (auto m : task.measureIdx)
+			{
+				pairDone[task.r1 * resultCount + task.r2][m] = 1;
+			}
+			if (cacheFile.isOpen())
+			{
+				out << resultCacheName(task.r1) << resultCacheName(task.r2) << taskMeasureIDs << info12 << info21;
+				cacheFile.flush();
+				++fileRecords;
+			}
+			++finishedTasks;
+			progress->setStatus(QString("Computed dissimilarity between results %1 and %2.").arg(task.r1).arg(task.r2));
+			progress->emitProgress(finishedTasks * 100.0 / taskCount);
+		}
+	}
+	cacheFile.close();
+	if (!m_aborted && fileRecords != pairCount)
+	{	// cache contains partial records (e.g. from added measures) or records of results not loaded anymore -> compact it:
+		writeDissimilarityMatrixCache(pairDone);
+	}
+}
+
+void iASensitivityData::computeResultPairDissimilarity(int r1, int r2, std::vector<std::pair<int, bool>> measures,
+	iAResultPairInfo& result, bool parallel) const
 {
-	return cacheFileName(QString("result-%1-v0.mhd").arg(rIdx));
+	auto& res1 = m_data->result[r1];
+	auto const& mapping = *res1.mapping.data();
+	// TODO: only center -> should use bounding box instead!
+	double const* cxr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterX]),
+		* cyr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterY]),
+		* czr = m_data->spmData->paramRange(mapping[iACsvConfig::CenterZ]);
+	double a = cxr[1] - cxr[0], b = cyr[1] - cyr[0], c = czr[1] - czr[0];
+	double diagonalLength = std::sqrt(std::pow(a, 2) + std::pow(b, 2) + std::pow(c, 2));
+	double const* lengthRange = m_data->spmData->paramRange(mapping[iACsvConfig::Length]);
+	double maxLength = lengthRange[1] - lengthRange[0];
+
+	int measureCount = static_cast<int>(measures.size());
+	int r1FibCount = static_cast<int>(res1.fiberCount);
+	result = iAResultPairInfo(measureCount);
+	auto& dissimilarities = result.fiberDissim;
+	dissimilarities.resize(r1FibCount);
+	int noCanDo = 0;
+	size_t candSum = 0;
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : noCanDo, candSum) if (parallel)
+	for (int fiberID = 0; fiberID < r1FibCount; ++fiberID)
+	{
+		auto candidates = intersectingBoundingBox(res1.fiberBB[fiberID], m_data->result[r2].fiberBB);
+		if (candidates.size() == 0)
+		{
+			++noCanDo;
+			continue;
+		}
+		candSum += candidates.size();
+		getBestMatches2(res1.fiberData[fiberID], m_data->result[r2].fiberData,
+			dissimilarities[fiberID], candidates, diagonalLength, maxLength, measures);
+	}
+	LOG(lvlDebug, QString("Result %1x%2: %3 candidates on average, %4 with no bounding box intersections out of %5")
+		.arg(r1).arg(r2).arg(static_cast<double>(candSum) / r1FibCount).arg(noCanDo).arg(r1FibCount));
+	for (int m = 0; m < measureCount; ++m)
+	{
+		int matchCount = 0;
+		for (int fiberID = 0; fiberID < r1FibCount; ++fiberID)
+		{
+			if (dissimilarities[fiberID].size() > 0 && dissimilarities[fiberID][m].size() > 0)
+			{
+				++matchCount;
+				result.avgDissim[m] += dissimilarities[fiberID][m][0].dissimilarity;
+			}
+		}
+		result.avgDissim[m] /= matchCount;
+	}
 }
 
-bool iASensitivityData::readDissimilarityMatrixCache(QVector<int>& measures)
+bool iASensitivityData::readDissimilarityMatrixCacheHeader(QVector<int>& measures) const
 {
 	QFile cacheFile(dissimilarityMatrixCacheFileName());
-	// unify with verifyOpenCacheFile?
 	if (!cacheFile.exists())
 	{
 		return false;
@@ -1508,7 +1565,7 @@ bool iASensitivityData::readDissimilarityMatrixCache(QVector<int>& measures)
 	{
 		LOG(lvlError,
 			QString("FIAKER cache file '%1': Unknown cache file format - found identifier %2 does not match expected "
-					"identifier %3. Please delete file and let it be recreated!")
+					"identifier %3. The file will be recreated!")
 				.arg(cacheFile.fileName())
 				.arg(identifier)
 				.arg(DissimilarityMatrixCacheFileIdentifier));
@@ -1518,9 +1575,9 @@ bool iASensitivityData::readDissimilarityMatrixCache(QVector<int>& measures)
 	in >> version;
 	if (version < DissimilarityMatrixCacheFileVersion)
 	{
-		LOG(lvlError,
+		LOG(lvlWarn,
 			QString("FIAKER cache file '%1': Too old, incompatible cache version %2; "
-					"")
+					"the file will be recreated!")
 				.arg(cacheFile.fileName())
 				.arg(version));
 		return false;
@@ -1528,41 +1585,163 @@ bool iASensitivityData::readDissimilarityMatrixCache(QVector<int>& measures)
 	if (version > DissimilarityMatrixCacheFileVersion)
 	{
 		LOG(lvlError,
-			QString("FIAKER cache file '%1': Invalid or too high version number (%2), expected %3 or less. Please "
-					"delete file and let it be recreated!")
+			QString("FIAKER cache file '%1': Invalid or too high version number (%2), expected %3 or less. "
+					"The file will be recreated!")
 				.arg(cacheFile.fileName())
 				.arg(version)
 				.arg(DissimilarityMatrixCacheFileVersion));
 		return false;
 	}
 	in >> measures;
-	in >> m_resultDissimMatrix;
-	cacheFile.close();
-	return true;
+	return in.status() == QDataStream::Ok;
 }
 
-void iASensitivityData::writeDissimilarityMatrixCache(QVector<int> const& measures) const
+int iASensitivityData::readDissimilarityMatrixCache(std::vector<std::vector<char>>& pairDone)
+{
+	QFile cacheFile(dissimilarityMatrixCacheFileName());
+	if (!cacheFile.open(QFile::ReadOnly))
+	{
+		LOG(lvlError, QString("Couldn't open file %1 for reading!").arg(cacheFile.fileName()));
+		return 0;
+	}
+	QDataStream in(&cacheFile);
+	in.setVersion(CacheFileQtDataStreamVersion);
+	QString identifier;
+	quint32 version;
+	QVector<int> headerMeasures;
+	in >> identifier >> version >> headerMeasures;    // already checked in readDissimilarityMatrixCacheHeader
+	int resultCount = static_cast<int>(m_data->result.size());
+	QMap<QString, int> resultIdx;
+	for (int r = 0; r < resultCount; ++r)
+	{
+		resultIdx.insert(resultCacheName(r), r);
+	}
+	int measureCount = static_cast<int>(m_resultDissimMeasures.size());
+	int records = 0;
+	qint64 lastRecordEnd = cacheFile.pos();
+	while (!in.atEnd())
+	{
+		QString name1, name2;
+		QVector<int> recordMeasures;
+		iAResultPairInfo info12, info21;
+		in >> name1 >> name2 >> recordMeasures >> info12 >> info21;
+		if (in.status() != QDataStream::Ok)
+		{	// incomplete last record, e.g. from an interrupted computation; cut it off so that new records can be appended
+			LOG(lvlWarn, QString("FIAKER cache file '%1': Incomplete record at position %2, discarding it.")
+				.arg(cacheFile.fileName()).arg(lastRecordEnd));
+			cacheFile.close();
+			QFile::resize(dissimilarityMatrixCacheFileName(), lastRecordEnd);
+			break;
+		}
+		lastRecordEnd = cacheFile.pos();
+		++records;
+		if (!resultIdx.contains(name1) || !resultIdx.contains(name2))
+		{	// result not loaded anymore
+			continue;
+		}
+		int r1 = resultIdx[name1], r2 = resultIdx[name2];
+		if (r1 == r2)
+		{
+			continue;
+		}
+		if (r1 > r2)
+		{
+			std::swap(r1, r2);
+			std::swap(info12, info21);
+		}
+		if (static_cast<size_t>(info12.fiberDissim.size()) != m_data->result[r1].fiberCount ||
+			static_cast<size_t>(info21.fiberDissim.size()) != m_data->result[r2].fiberCount ||
+			info12.avgDissim.size() != recordMeasures.size() || info21.avgDissim.size() != recordMeasures.size())
+		{
+			LOG(lvlWarn, QString("FIAKER cache file '%1': Cached dissimilarities for results %2 and %3 do not match "
+				"their current fiber count, ignoring them.").arg(cacheFile.fileName()).arg(name1).arg(name2));
+			continue;
+		}
+		auto& done = pairDone[r1 * resultCount + r2];
+		std::vector<int> recordIdx, matrixIdx;
+		for (int k = 0; k < static_cast<int>(recordMeasures.size()); ++k)
+		{
+			auto it = std::find_if(m_resultDissimMeasures.begin(), m_resultDissimMeasures.end(),
+				[&recordMeasures, k](std::pair<int, bool> const& m) { return m.first == recordMeasures[k]; });
+			if (it != m_resultDissimMeasures.end() && !done[it - m_resultDissimMeasures.begin()])
+			{
+				recordIdx.push_back(k);
+				matrixIdx.push_back(static_cast<int>(it - m_resultDissimMeasures.begin()));
+				done[matrixIdx.back()] = 1;
+			}
+		}
+		mergePairInfo(m_resultDissimMatrix[r1][r2], info12, recordIdx, matrixIdx, measureCount);
+		mergePairInfo(m_resultDissimMatrix[r2][r1], info21, recordIdx, matrixIdx, measureCount);
+	}
+	return records;
+}
+
+int iASensitivityData::writeDissimilarityMatrixCache(std::vector<std::vector<char>> const& pairDone) const
 {
 	QFileInfo fi(QFileInfo(dissimilarityMatrixCacheFileName()).absolutePath());
 	if ((fi.exists() && !fi.isDir()) || !QDir(fi.absoluteFilePath()).mkpath("."))
 	{
 		LOG(lvlError, QString("Could not create output directory '%1'").arg(fi.absoluteFilePath()));
-		return;
+		return 0;
 	}
-	QFile cacheFile(dissimilarityMatrixCacheFileName());
+	// write to temporary file first, to not lose the existing cache in case of an error:
+	QString tmpFileName = dissimilarityMatrixCacheFileName() + ".tmp";
+	QFile cacheFile(tmpFileName);
 	if (!cacheFile.open(QFile::WriteOnly))
 	{
 		LOG(lvlError, QString("Couldn't open file %1 for writing!").arg(cacheFile.fileName()));
-		return;
+		return 0;
 	}
 	QDataStream out(&cacheFile);
 	out.setVersion(CacheFileQtDataStreamVersion);
 	// write header:
 	out << DissimilarityMatrixCacheFileIdentifier;
 	out << DissimilarityMatrixCacheFileVersion;
-
+	QVector<int> measures;
+	for (auto m : m_resultDissimMeasures)
+	{
+		measures.push_back(m.first);
+	}
 	out << measures;
-	out << m_resultDissimMatrix;
+	// one record per result pair, with all measures available for this pair:
+	int resultCount = static_cast<int>(m_data->result.size());
+	int records = 0;
+	for (int r1 = 0; r1 < resultCount; ++r1)
+	{
+		for (int r2 = r1 + 1; r2 < resultCount; ++r2)
+		{
+			auto const& done = pairDone[r1 * resultCount + r2];
+			std::vector<int> matrixIdx, recordIdx;
+			QVector<int> recordMeasures;
+			for (int m = 0; m < static_cast<int>(done.size()); ++m)
+			{
+				if (done[m])
+				{
+					matrixIdx.push_back(m);
+					recordIdx.push_back(static_cast<int>(recordIdx.size()));
+					recordMeasures.push_back(measures[m]);
+				}
+			}
+			if (matrixIdx.empty())
+			{
+				continue;
+			}
+			iAResultPairInfo info12, info21;
+			int recordMeasureCount = static_cast<int>(matrixIdx.size());
+			mergePairInfo(info12, m_resultDissimMatrix[r1][r2], matrixIdx, recordIdx, recordMeasureCount);
+			mergePairInfo(info21, m_resultDissimMatrix[r2][r1], matrixIdx, recordIdx, recordMeasureCount);
+			out << resultCacheName(r1) << resultCacheName(r2) << recordMeasures << info12 << info21;
+			++records;
+		}
+	}
+	cacheFile.close();
+	QFile::remove(dissimilarityMatrixCacheFileName());
+	if (!QFile::rename(tmpFileName, dissimilarityMatrixCacheFileName()))
+	{
+		LOG(lvlError, QString("Couldn't rename file %1 to %2!").arg(tmpFileName).arg(dissimilarityMatrixCacheFileName()));
+		return 0;
+	}
+	return records;
 }
 
 void iASensitivityData::abort()
@@ -33,12 +33,18 @@ public:
 		std::vector<std::vector<double>> const& paramValues);
 	//! compute characteristics
 	void compute(iAProgress* progress);
+	//! number of voxels per dimension of the spatial overview images
+	static const int SpatialOverviewSize = 128;
+	//! number of voxels per dimension of the quickly computed, low-resolution preview of the spatial overview images
+	static const int SpatialOverviewPreviewSize = 32;
 	//! compute voxelized spatial overview over sensitivity (utilizing unique fibers)
-	void computeSpatialOverview(iAProgress* p);
+	//! @param p progress indicator
+	//! @param volSize number of voxels per dimension of the overview images
+	void computeSpatialOverview(iAProgress* p, int volSize = SpatialOverviewSize);
 	//! name of the cache file for the spatial overview image
 	QString spatialOverviewCacheFileName() const;
-	//! name of the cache file for the average fiber/voxel image (basically ~ mean objects)
-	QString averageFiberVoxelCacheFileName() const;
+	//! name of the cache file for the average fiber/voxel image (basically ~ mean objects) of the given size
+	QString averageFiberVoxelCacheFileName(int volSize = SpatialOverviewSize) const;
 	//! name of the cache file for the dissimilarity matrix
 	QString dissimilarityMatrixCacheFileName() const;
 	//! abort the sensitivity computation in case one is running
@@ -223,10 +229,27 @@ public:
 private:
 	QString cacheFileName(QString fileName) const;
 	QString uniqueFiberVarCacheFileName(size_t uIdx) const;
-	QString resultFiberCacheFileName(size_t uIdx) const;
-	QString volumePercentageCacheFileName() const;
-	bool readDissimilarityMatrixCache(QVector<int>& measures);
-	void writeDissimilarityMatrixCache(QVector<int> const& measures) const;
+	QString resultFiberCacheFileName(size_t uIdx, int volSize) const;
+	QString volumePercentageCacheFileName(int volSize) const;
+	//! name under which a result is identified in the cache (file name relative to the results folder)
+	QString resultCacheName(int resultIdx) const;
+	//! compute the dissimilarities between all result pairs, for all pairs and measures not available from the cache
+	void computeDissimilarityMatrix(iAProgress* progress);
+	//! compute the best matches in result r2 for all fibers of result r1, and their average dissimilarity
+	void computeResultPairDissimilarity(int r1, int r2, std::vector<std::pair<int, bool>> measures,
+		iAResultPairInfo& result, bool parallel) const;
+	//! check whether a valid dissimilarity matrix cache exists, and read the measures listed in its header
+	bool readDissimilarityMatrixCacheHeader(QVector<int>& measures) const;
+	//! read all records from the dissimilarity matrix cache which apply to the current results and measures
+	//! into m_resultDissimMatrix
+	//! @param pairDone for each result pair (index r1 * resultCount + r2, r1 < r2) and measure (index in
+	//!     m_resultDissimMeasures), set to 1 if the dissimilarities were read from the cache
+	//! @return the number of records in the cache file
+	int readDissimilarityMatrixCache(std::vector<std::vector<char>>& pairDone);
+	//! (re-)write the dissimilarity matrix cache, with one record per result pair containing all available measures
+	//! @param pairDone which result pairs / measures are available (see readDissimilarityMatrixCache)
+	//! @return the number of records written
+	int writeDissimilarityMatrixCache(std::vector<std::vector<char>> const& pairDone) const;
 
 	double characteristicsDifference(int charIdx, qvectorsizetype r1Idx, qvectorsizetype r2Idx, int measureIdx);
 
@@ -1087,14 +1087,9 @@ void iASensitivityInfo::createGUI()
 	}
 	m_gui.reset(new iASensitivityGUI(this, dpR));
 
-	iAProgress* spatP = new iAProgress();
-	auto spatialVariationComputation = runAsync([this, spatP] { data().computeSpatialOverview(spatP); },
-		[this, spatP] {
-			showSpatialOverview();
-			delete spatP;
-		},
-		m_child);
-	iAJobListView::get()->addJob("Computing spatial overview", spatP, spatialVariationComputation, this);
+	// unless the full resolution is cached already, first show a quickly computed, low-resolution preview:
+	computeSpatialOverview(QFile::exists(data().averageFiberVoxelCacheFileName()) ?
+		iASensitivityData::SpatialOverviewSize : iASensitivityData::SpatialOverviewPreviewSize);
 
 	m_gui->m_settings = new iASensitivitySettingsView(this);
 	auto dwSettings = new iADockWidgetWrapper(m_gui->m_settings, "Sensitivity Settings", "foeSensitivitySettings");
@@ -1272,27 +1267,53 @@ void iASensitivityInfo::createGUI()
 	}
 }
 
-void iASensitivityInfo::showSpatialOverview()
+void iASensitivityInfo::computeSpatialOverview(int volSize)
+{
+	iAProgress* spatP = new iAProgress();
+	auto spatialVariationComputation = runAsync([this, spatP, volSize] { data().computeSpatialOverview(spatP, volSize); },
+		[this, spatP, volSize] {
+			showSpatialOverview(volSize);
+			delete spatP;
+			if (volSize != iASensitivityData::SpatialOverviewSize && !m_aborted)
+			{
+				computeSpatialOverview(iASensitivityData::SpatialOverviewSize);
+			}
+		},
+		m_child);
+	iAJobListView::get()->addJob(volSize == iASensitivityData::SpatialOverviewSize ?
+		"Computing spatial overview" : "Computing spatial overview preview", spatP, spatialVariationComputation, this);
+}
+
+void iASensitivityInfo::showSpatialOverview(int volSize)
 {
 	if (!m_data->m_spatialOverview && !m_data->m_averageFiberVoxel)	// the computation of any of the two images (or both) might have been aborted
 	{
 		return;
 	}
-	connect(m_child, &iAMdiChild::dataSetPrepared, this, &iASensitivityInfo::setSpatialOverviewTF);
-	connect(m_child, &iAMdiChild::dataSetRendered, this, &iASensitivityInfo::spatialOverviewVisibilityChanged);
+	// replace images shown previously (i.e., the preview):
+	for (auto dataSetIdx : m_spatialOverviewDataSets)
+	{
+		if (m_child->dataSetMap().find(dataSetIdx) != m_child->dataSetMap().end())
+		{
+			m_child->removeDataSet(dataSetIdx);
+		}
+	}
+	m_spatialOverviewDataSets.clear();
+	connect(m_child, &iAMdiChild::dataSetPrepared, this, &iASensitivityInfo::setSpatialOverviewTF, Qt::UniqueConnection);
+	connect(m_child, &iAMdiChild::dataSetRendered, this, &iASensitivityInfo::spatialOverviewVisibilityChanged, Qt::UniqueConnection);
 	if (m_data->m_spatialOverview)
 	{
 		auto spatialOverviewDataSet = std::make_shared<iAImageData>(m_data->m_spatialOverview);
 		spatialOverviewDataSet->setMetaData(iADataSet::NameKey, "Avg unique fiber/voxel");
 		spatialOverviewDataSet->setMetaData(iADataSet::FileNameKey, data().spatialOverviewCacheFileName());
-		m_child->addDataSet(spatialOverviewDataSet);
+		m_spatialOverviewDataSets.push_back(m_child->addDataSet(spatialOverviewDataSet));
 	}
 	if (m_data->m_averageFiberVoxel)
 	{
 		auto averageFiberVoxelDataSet = std::make_shared<iAImageData>(m_data->m_averageFiberVoxel);
 		averageFiberVoxelDataSet->setMetaData(iADataSet::NameKey, "Mean objects (fibers/voxel)");
-		averageFiberVoxelDataSet->setMetaData(iADataSet::FileNameKey, data().averageFiberVoxelCacheFileName());
-		m_child->addDataSet(averageFiberVoxelDataSet);
+		averageFiberVoxelDataSet->setMetaData(iADataSet::FileNameKey, data().averageFiberVoxelCacheFileName(volSize));
+		m_spatialOverviewDataSets.push_back(m_child->addDataSet(averageFiberVoxelDataSet));
 	}
 }
 
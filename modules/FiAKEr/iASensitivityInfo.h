@@ -61,7 +61,9 @@ private:
 	QWidget* setupMatrixView(QVector<int> const& measures);
 
 	void updateDifferenceView();
-	void showSpatialOverview();
+	//! start the (asynchronous) computation of the spatial overview images with given size
+	void computeSpatialOverview(int volSize);
+	void showSpatialOverview(int volSize);
 	QVector<QVector<double>> currentAggregatedSensitivityMatrix();
 
 	QString m_parameterFileName;
@@ -74,6 +76,8 @@ private:
 
 	// for computation:
 	bool m_aborted;
+	//! indices of the datasets in m_child showing the spatial overview images (to replace preview images)
+	std::vector<size_t> m_spatialOverviewDataSets;
 	//! "temporary" copy of project to load:
 	QVariantMap m_projectToLoad;
 
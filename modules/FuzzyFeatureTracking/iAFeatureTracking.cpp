@@ -4,11 +4,14 @@
 
 #include <iAFileUtils.h>
 #include <iALog.h>
+#include <iAMathUtility.h>
 
 #include <vtkTable.h>
 #include <vtkTypeUInt32Array.h>
-#include <vtkVariantArray.h>
 
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <sstream>
 
 #define VTK_CREATE(type,name) \
@@ -99,23 +102,6 @@ vtkSmartPointer<vtkTable> iAFeatureTracking::readTableFromFile(const QString& fi
 	return t;
 }
 
-void iAFeatureTracking::sortCorrespondencesByOverlap(std::vector<iAFeatureTrackingCorrespondence>& correspondences)
-{
-	iAFeatureTrackingCorrespondence* temp;
-	for (size_t i = correspondences.size(); i > 1; i--)
-	{
-		for (size_t j = 0; j < i - 1; j++)
-		{
-			if (correspondences.at(j).overlap < correspondences.at(j + 1).overlap)
-			{
-				temp = new iAFeatureTrackingCorrespondence(correspondences.at(j));
-				correspondences.at(j) = correspondences.at(j + 1);
-				correspondences.at(j + 1) = *temp;
-			}
-		}
-	}
-}
-
 int nrOfOccurences(std::vector<int>& v, int occurence)
 {
 	int result = 0;
@@ -129,120 +115,304 @@ int nrOfOccurences(std::vector<int>& v, int occurence)
 	return result;
 }
 
-std::vector<iAFeatureTrackingCorrespondence>& iAFeatureTracking::getCorrespondences(
-	const vtkVariantArray& row,
-	vtkTable& table,
-	int maxSearchValue,
-	bool useZ)
+namespace
 {
-	auto correspondences = new std::vector<iAFeatureTrackingCorrespondence>();
-
-	int inputCenterX = row.GetValue(1).ToInt();
-	int inputCenterY = row.GetValue(2).ToInt();
-	int inputCenterZ = row.GetValue(3).ToInt();
-	int inputVolume = row.GetValue(4).ToInt();
-	int inputDimensionX = row.GetValue(5).ToInt();
-	int inputDimensionY = row.GetValue(6).ToInt();
-	int inputDimensionZ = row.GetValue(7).ToInt();
-	int inputMinX = inputCenterX - inputDimensionX / 2;
-	int inputMaxX = inputCenterX + inputDimensionX / 2;
-	int inputMinY = inputCenterY - inputDimensionY / 2;
-	int inputMaxY = inputCenterY + inputDimensionY / 2;
-	int inputMinZ = inputCenterZ - inputDimensionZ / 2;
-	int inputMaxZ = inputCenterZ + inputDimensionZ / 2;
-
-	for (int i = 0; i < table.GetNumberOfRows(); i++)
-	{
-		auto currentRow = table.GetRow(i);
-		int currentCenterX = currentRow->GetValue(1).ToInt();
-		int currentCenterY = currentRow->GetValue(2).ToInt();
-		int currentCenterZ = currentRow->GetValue(3).ToInt();
-		int currentVolume = currentRow->GetValue(4).ToInt();
-		int currentDimensionX = currentRow->GetValue(5).ToInt();
-		int currentDimensionY = currentRow->GetValue(6).ToInt();
-		int currentDimensionZ = currentRow->GetValue(7).ToInt();
-		int currentMinX = currentCenterX - currentDimensionX / 2 - (maxSearchValue);
-		int currentMaxX = currentCenterX + currentDimensionX / 2 + (maxSearchValue);
-		int currentMinY = currentCenterY - currentDimensionY / 2 - (maxSearchValue);
-		int currentMaxY = currentCenterY + currentDimensionY / 2 + (maxSearchValue);
-		int currentMinZ = currentCenterZ - currentDimensionZ / 2 - (maxSearchValue);
-		int currentMaxZ = currentCenterZ + currentDimensionZ / 2 + (maxSearchValue);
-		/*currentMinX = currentCenterX - currentDimensionX / 2;
-		currentMaxX = currentCenterX + currentDimensionX / 2;
-		currentMinY = currentCenterY - currentDimensionY / 2;
-		currentMaxY = currentCenterY + currentDimensionY / 2;
-		currentMinZ = currentCenterZ - currentDimensionZ / 2;
-		currentMaxZ = currentCenterZ + currentDimensionZ / 2;*/
-
-		if ((
-			(currentMinX < inputMaxX && currentMinX >= inputMinX) ||
-			(currentMaxX > inputMinX&& currentMaxX <= inputMaxX) ||
-			(currentMinX <= inputMinX && currentMaxX >= inputMaxX)
-			) && (
-			(currentMinY < inputMaxY && currentMinY >= inputMinY) ||
-				(currentMaxY > inputMinY&& currentMaxY <= inputMaxY) ||
-				(currentMinY <= inputMinY && currentMaxY >= inputMaxY)
-				) && (
-				(currentMinZ < inputMaxZ && currentMinZ >= inputMinZ) ||
-					(currentMaxZ > inputMinZ&& currentMaxZ <= inputMaxZ) ||
-					(currentMinZ <= inputMinZ && currentMaxZ >= inputMaxZ)
-					))
+	enum PoreColumn
+	{
+		ColCenterX = 1,
+		ColCenterY,
+		ColCenterZ,
+		ColVolume,
+		ColDimX,
+		ColDimY,
+		ColDimZ,
+		PoreColumnCount
+	};
+
+	//! the columns of a pore table required for tracking, extracted once into plain vectors
+	struct iAPoreColumns
+	{
+		std::vector<int> col[PoreColumnCount];
+		int value(vtkIdType row, PoreColumn c) const
 		{
-			float xOverlap = 1.f;
-			float yOverlap = 1.f;
-			float zOverlap = 1.f;
+			return col[c][row];
+		}
+	};
 
-			if (currentMinX > inputMinX)
+	iAPoreColumns extractPoreColumns(vtkTable& table)
+	{
+		iAPoreColumns result;
+		vtkIdType rowCount = table.GetNumberOfRows();
+		for (int c = ColCenterX; c < PoreColumnCount; ++c)
+		{
+			auto& col = result.col[c];
+			col.resize(rowCount);
+			auto typedArray = vtkTypeUInt32Array::SafeDownCast(table.GetColumn(c));
+			for (vtkIdType r = 0; r < rowCount; ++r)
 			{
-				xOverlap -= (currentMinX - inputMinX) / (inputDimensionX * 1.f);
+				// same conversion as vtkVariant::ToInt for the columns as created by readTableFromFile:
+				col[r] = typedArray ? static_cast<int>(typedArray->GetValue(r)) : table.GetValue(r, c).ToInt();
 			}
+		}
+		return result;
+	}
 
-			if (currentMaxX < inputMaxX)
+	//! Uniform grid over axis-aligned boxes, for retrieving all boxes possibly overlapping a query box.
+	//! Boxes spanning too many cells are kept in a separate list which is checked for every query.
+	class iABoxGrid
+	{
+	public:
+		//! @param boxes per box, lower (0..2) and upper (3..5) coordinates (inclusive) in x, y and z
+		iABoxGrid(std::vector<std::array<int, 6>> const& boxes) : m_cellCount(0)
+		{
+			if (boxes.empty())
 			{
-				xOverlap -= (inputMaxX - currentMaxX) / (inputDimensionX * 1.f);
+				return;
 			}
-
-			if (currentMinY > inputMinY)
+			long long extentSum[3] = {0, 0, 0};
+			for (int a = 0; a < 3; ++a)
 			{
-				yOverlap -= (currentMinY - inputMinY) / (inputDimensionY * 1.f);
+				m_min[a] = std::numeric_limits<long long>::max();
+				long long maxCoord = std::numeric_limits<long long>::lowest();
+				for (auto const& b : boxes)
+				{
+					m_min[a] = std::min(m_min[a], static_cast<long long>(b[a]));
+					maxCoord = std::max(maxCoord, static_cast<long long>(b[a + 3]));
+					extentSum[a] += static_cast<long long>(b[a + 3]) - b[a] + 1;
+				}
+				m_cellSize[a] = std::max(1LL, extentSum[a] / static_cast<long long>(boxes.size()));
+				m_dim[a] = (maxCoord - m_min[a]) / m_cellSize[a] + 1;
 			}
-
-			if (currentMaxY < inputMaxY)
+			long long const maxCells = 8 * static_cast<long long>(boxes.size()) + 64;
+			while (m_dim[0] * m_dim[1] * m_dim[2] > maxCells)
 			{
-				yOverlap -= (inputMaxY - currentMaxY) / (inputDimensionY * 1.f);
+				for (int a = 0; a < 3; ++a)
+				{
+					m_cellSize[a] *= 2;
+					m_dim[a] = (m_dim[a] + 1) / 2;
+				}
 			}
-
-			if (currentMinZ > inputMinZ)
+			m_cellCount = m_dim[0] * m_dim[1] * m_dim[2];
+			// two passes (count, fill) to store the box indices of all cells contiguously:
+			m_cellStart.assign(m_cellCount + 1, 0);
+			for (int pass = 0; pass < 2; ++pass)
 			{
-				zOverlap -= (currentMinZ - inputMinZ) / (inputDimensionZ * 1.f);
+				std::vector<long long> fillPos;
+				if (pass == 1)
+				{
+					for (long long c = 0; c < m_cellCount; ++c)
+					{
+						m_cellStart[c + 1] += m_cellStart[c];
+					}
+					m_cellBoxes.resize(m_cellStart[m_cellCount]);
+					fillPos.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+				}
+				for (size_t i = 0; i < boxes.size(); ++i)
+				{
+					long long lo[3], hi[3];
+					cellRange(boxes[i].data(), boxes[i].data() + 3, lo, hi);
+					if ((hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1) > MaxCellsPerBox)
+					{
+						if (pass == 0)
+						{
+							m_largeBoxes.push_back(static_cast<int>(i));
+						}
+						continue;
+					}
+					for (long long z = lo[2]; z <= hi[2]; ++z)
+					{
+						for (long long y = lo[1]; y <= hi[1]; ++y)
+						{
+							for (long long x = lo[0]; x <= hi[0]; ++x)
+							{
+								long long c = (z * m_dim[1] + y) * m_dim[0] + x;
+								if (pass == 0)
+								{
+									++m_cellStart[c + 1];
+								}
+								else
+								{
+									m_cellBoxes[fillPos[c]++] = static_cast<int>(i);
+								}
+							}
+						}
+					}
+				}
 			}
-
-			if (currentMaxZ < inputMaxZ)
+		}
+		//! indices of all boxes whose cells overlap the given query box, in ascending order
+		void candidates(int const queryLo[3], int const queryHi[3], std::vector<int>& result) const
+		{
+			result.assign(m_largeBoxes.begin(), m_largeBoxes.end());
+			if (m_cellCount == 0)
 			{
-				zOverlap -= (inputMaxZ - currentMaxZ) / (inputDimensionZ * 1.f);
+				return;
 			}
-
-			float overlap;
-			if (useZ)
+			long long lo[3], hi[3];
+			cellRange(queryLo, queryHi, lo, hi);
+			for (long long z = lo[2]; z <= hi[2]; ++z)
 			{
-				overlap = xOverlap * yOverlap * zOverlap;
+				for (long long y = lo[1]; y <= hi[1]; ++y)
+				{
+					for (long long x = lo[0]; x <= hi[0]; ++x)
+					{
+						long long c = (z * m_dim[1] + y) * m_dim[0] + x;
+						result.insert(result.end(), m_cellBoxes.begin() + m_cellStart[c], m_cellBoxes.begin() + m_cellStart[c + 1]);
+					}
+				}
 			}
-			else
+			std::sort(result.begin(), result.end());
+			result.erase(std::unique(result.begin(), result.end()), result.end());
+		}
+	private:
+		//! range of cells covered by the given coordinates; coordinates outside of the grid are clamped to it
+		void cellRange(int const lo[3], int const hi[3], long long cellLo[3], long long cellHi[3]) const
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				cellLo[a] = clamp(0LL, m_dim[a] - 1, (lo[a] - m_min[a]) / m_cellSize[a]);
+				cellHi[a] = clamp(0LL, m_dim[a] - 1, (hi[a] - m_min[a]) / m_cellSize[a]);
+			}
+		}
+		static const long long MaxCellsPerBox = 64;
+		long long m_min[3], m_cellSize[3], m_dim[3], m_cellCount;
+		std::vector<long long> m_cellStart;
+		std::vector<int> m_cellBoxes;
+		std::vector<int> m_largeBoxes;
+	};
+
+	void sortCorrespondencesByOverlap(std::vector<iAFeatureTrackingCorrespondence>& correspondences)
+	{
+		// stable, so correspondences with equal overlap stay in order of their ids:
+		std::stable_sort(correspondences.begin(), correspondences.end(),
+			[](iAFeatureTrackingCorrespondence const& a, iAFeatureTrackingCorrespondence const& b)
+			{
+				return a.overlap > b.overlap;
+			});
+	}
+
+	std::vector<iAFeatureTrackingCorrespondence> getCorrespondences(
+		iAPoreColumns const& inputPores,
+		vtkIdType inputIdx,
+		iAPoreColumns const& pores,
+		iABoxGrid const& poreGrid,
+		int maxSearchValue,
+		bool useZ,
+		std::vector<int>& candidates)
+	{
+		std::vector<iAFeatureTrackingCorrespondence> correspondences;
+
+		int inputCenterX = inputPores.value(inputIdx, ColCenterX);
+		int inputCenterY = inputPores.value(inputIdx, ColCenterY);
+		int inputCenterZ = inputPores.value(inputIdx, ColCenterZ);
+		int inputVolume = inputPores.value(inputIdx, ColVolume);
+		int inputDimensionX = inputPores.value(inputIdx, ColDimX);
+		int inputDimensionY = inputPores.value(inputIdx, ColDimY);
+		int inputDimensionZ = inputPores.value(inputIdx, ColDimZ);
+		int inputMinX = inputCenterX - inputDimensionX / 2;
+		int inputMaxX = inputCenterX + inputDimensionX / 2;
+		int inputMinY = inputCenterY - inputDimensionY / 2;
+		int inputMaxY = inputCenterY + inputDimensionY / 2;
+		int inputMinZ = inputCenterZ - inputDimensionZ / 2;
+		int inputMaxZ = inputCenterZ + inputDimensionZ / 2;
+
+		// any pore fulfilling the overlap condition below overlaps the input box (as closed intervals):
+		int queryLo[3] = {std::min(inputMinX, inputMaxX), std::min(inputMinY, inputMaxY), std::min(inputMinZ, inputMaxZ)};
+		int queryHi[3] = {std::max(inputMinX, inputMaxX), std::max(inputMinY, inputMaxY), std::max(inputMinZ, inputMaxZ)};
+		poreGrid.candidates(queryLo, queryHi, candidates);
+
+		for (int i : candidates)
+		{
+			int currentCenterX = pores.value(i, ColCenterX);
+			int currentCenterY = pores.value(i, ColCenterY);
+			int currentCenterZ = pores.value(i, ColCenterZ);
+			int currentVolume = pores.value(i, ColVolume);
+			int currentDimensionX = pores.value(i, ColDimX);
+			int currentDimensionY = pores.value(i, ColDimY);
+			int currentDimensionZ = pores.value(i, ColDimZ);
+			int currentMinX = currentCenterX - currentDimensionX / 2 - (maxSearchValue);
+			int currentMaxX = currentCenterX + currentDimensionX / 2 + (maxSearchValue);
+			int currentMinY = currentCenterY - currentDimensionY / 2 - (maxSearchValue);
+			int currentMaxY = currentCenterY + currentDimensionY / 2 + (maxSearchValue);
+			int currentMinZ = currentCenterZ - currentDimensionZ / 2 - (maxSearchValue);
+			int currentMaxZ = currentCenterZ + currentDimensionZ / 2 + (maxSearchValue);
+			/*currentMinX = currentCenterX - currentDimensionX / 2;
+			currentMaxX = currentCenterX + currentDimensionX / 2;
+			currentMinY = currentCenterY - currentDimensionY / 2;
+			currentMaxY = currentCenterY + currentDimensionY / 2;
+			currentMinZ = currentCenterZ - currentDimensionZ / 2;
+			currentMaxZ = currentCenterZ + currentDimensionZ / 2;*/
+
+			if ((
+				(currentMinX < inputMaxX && currentMinX >= inputMinX) ||
+				(currentMaxX > inputMinX&& currentMaxX <= inputMaxX) ||
+				(currentMinX <= inputMinX && currentMaxX >= inputMaxX)
+				) && (
+				(currentMinY < inputMaxY && currentMinY >= inputMinY) ||
+					(currentMaxY > inputMinY&& currentMaxY <= inputMaxY) ||
+					(currentMinY <= inputMinY && currentMaxY >= inputMaxY)
+					) && (
+					(currentMinZ < inputMaxZ && currentMinZ >= inputMinZ) ||
+						(currentMaxZ > inputMinZ&& currentMaxZ <= inputMaxZ) ||
+						(currentMinZ <= inputMinZ && currentMaxZ >= inputMaxZ)
+						))
 			{
-				overlap = xOverlap * yOverlap;
+				float xOverlap = 1.f;
+				float yOverlap = 1.f;
+				float zOverlap = 1.f;
+
+				if (currentMinX > inputMinX)
+				{
+					xOverlap -= (currentMinX - inputMinX) / (inputDimensionX * 1.f);
+				}
+
+				if (currentMaxX < inputMaxX)
+				{
+					xOverlap -= (inputMaxX - currentMaxX) / (inputDimensionX * 1.f);
+				}
+
+				if (currentMinY > inputMinY)
+				{
+					yOverlap -= (currentMinY - inputMinY) / (inputDimensionY * 1.f);
+				}
+
+				if (currentMaxY < inputMaxY)
+				{
+					yOverlap -= (inputMaxY - currentMaxY) / (inputDimensionY * 1.f);
+				}
+
+				if (currentMinZ > inputMinZ)
+				{
+					zOverlap -= (currentMinZ - inputMinZ) / (inputDimensionZ * 1.f);
+				}
+
+				if (currentMaxZ < inputMaxZ)
+				{
+					zOverlap -= (inputMaxZ - currentMaxZ) / (inputDimensionZ * 1.f);
+				}
+
+				float overlap;
+				if (useZ)
+				{
+					overlap = xOverlap * yOverlap * zOverlap;
+				}
+				else
+				{
+					overlap = xOverlap * yOverlap;
+				}
+				correspondences.push_back(
+					iAFeatureTrackingCorrespondence(i + 1,
+						overlap,
+						inputVolume / (float)currentVolume,
+						false,
+						0.f,
+						Continuation)
+				);
 			}
-			correspondences->push_back(
-				*new iAFeatureTrackingCorrespondence(i + 1,
-					overlap,
-					inputVolume / (float)currentVolume,
-					false,
-					0.f,
-					Continuation)
-			);
 		}
+		sortCorrespondencesByOverlap(correspondences);
+		return correspondences;
 	}
-	sortCorrespondencesByOverlap(*correspondences);
-	return *correspondences;
 }
 
 // public methods
@@ -305,14 +475,39 @@ void iAFeatureTracking::TrackFeatures()
 	auto splitCandidates = new std::vector<std::pair<vtkIdType, std::vector<iAFeatureTrackingCorrespondence> > >();
 	auto continuatedAfterMergeTest = new std::vector<std::pair<vtkIdType, std::vector<iAFeatureTrackingCorrespondence> > >();
 
-	vtkVariantArray* row = vtkVariantArray::New();
-
 	// main computation ==============================================================================================
-	for (int i = 0; i < u->GetNumberOfRows(); i++)
+	auto uPores = extractPoreColumns(*u);
+	auto vPores = extractPoreColumns(*v);
+	// boxes of all pores in v, enlarged by the search distance (as in getCorrespondences):
+	std::vector<std::array<int, 6>> vBoxes(v->GetNumberOfRows());
+	for (vtkIdType i = 0; i < v->GetNumberOfRows(); ++i)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			int center = vPores.value(i, static_cast<PoreColumn>(ColCenterX + a));
+			int dim = vPores.value(i, static_cast<PoreColumn>(ColDimX + a));
+			int minCoord = center - dim / 2 - m_maxSearchValue;
+			int maxCoord = center + dim / 2 + m_maxSearchValue;
+			vBoxes[i][a] = std::min(minCoord, maxCoord);
+			vBoxes[i][a + 3] = std::max(minCoord, maxCoord);
+		}
+	}
+	iABoxGrid vGrid(vBoxes);
+	int uCount = static_cast<int>(u->GetNumberOfRows());
+	std::vector<std::vector<iAFeatureTrackingCorrespondence>> uCorrespondences(uCount);
+#pragma omp parallel
+	{
+		std::vector<int> candidates;
+#pragma omp for schedule(dynamic, 64)
+		for (int i = 0; i < uCount; i++)
+		{
+			uCorrespondences[i] = getCorrespondences(uPores, i, vPores, vGrid, m_maxSearchValue, true, candidates);
+		}
+	}
+	uToV->reserve(uCount);
+	for (int i = 0; i < uCount; i++)
 	{
-		u->GetRow(i, row);
-		auto result = &getCorrespondences(*row, *v, m_maxSearchValue, true);
-		uToV->push_back(std::make_pair(i + 1, *result));
+		uToV->push_back(std::make_pair(i + 1, std::move(uCorrespondences[i])));
 	}
 
 	// compute vToU out of uToV ======================================================================================
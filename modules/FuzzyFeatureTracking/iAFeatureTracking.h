@@ -12,7 +12,6 @@
 #include <vector>
 
 class vtkTable;
-class vtkVariantArray;
 
 class iAFeatureTracking
 {
@@ -32,8 +31,6 @@ private:
 	std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems);
 	std::vector<std::string> split(const std::string &s, char delim);
 	vtkSmartPointer<vtkTable> readTableFromFile(const QString &filename, int dataLineOffset);
-	void sortCorrespondencesByOverlap(std::vector<iAFeatureTrackingCorrespondence> &correspondences);
-	std::vector<iAFeatureTrackingCorrespondence>& getCorrespondences(const vtkVariantArray &row, vtkTable &table, int maxSearchValue, bool useZ);
 	void ComputeOverallMatchingPercentage();
 
 public:
@@ -22,3 +22,20 @@ foreach (VR_INSTALL_DIR_IDX RANGE ${VR_INSTALL_DIRS_COUNT})
 	endforeach()
 	install(DIRECTORY "${VR_INSTALL_SRC_DIR}" DESTINATION ${VR_DST_SUBDIR})
 endforeach()
+
+if (openiA_TESTING_ENABLED)
+	get_filename_component(CoreSrcDir "../libs/base" REALPATH BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
+	add_executable(OctreeCoverageTest ImNDT/iAOctreeCoverageTest.cpp ImNDT/iAOctreeCoverage.cpp)
+	target_link_libraries(OctreeCoverageTest PRIVATE Qt${QT_VERSION_MAJOR}::Core)   # for QString, required by iAVec3
+	target_include_directories(OctreeCoverageTest PRIVATE ${CoreSrcDir})
+	target_compile_definitions(OctreeCoverageTest PRIVATE NO_DLL_LINKAGE)
+	add_test(NAME OctreeCoverageTest COMMAND OctreeCoverageTest)
+	if (MSVC)
+		string(REGEX REPLACE "/" "\\\\" QT_WIN_DLL_DIR ${QT_LIB_DIR})
+		set_tests_properties(OctreeCoverageTest PROPERTIES ENVIRONMENT "PATH=${QT_WIN_DLL_DIR};$ENV{PATH}")
+		set_target_properties(OctreeCoverageTest PROPERTIES VS_DEBUGGER_ENVIRONMENT "PATH=${QT_WIN_DLL_DIR};$ENV{PATH}")
+	endif()
+	if (openiA_USE_IDE_FOLDERS)
+		set_property(TARGET OctreeCoverageTest PROPERTY FOLDER "Tests")
+	endif()
+endif()
@@ -76,7 +76,8 @@ iAImNDTMain::iAImNDTMain(iAVREnvironment* vrEnv, iAImNDTInteractorStyle* style,
 	m_modelInMiniature->setFiberCoverageData(m_fiberCoverageCalc->getObjectCoverage());
 	fiberMetrics->setFiberCoverageData(m_fiberCoverageCalc->getObjectCoverage());
 	histogramMetrics->setFiberCoverageData(m_fiberCoverageCalc->getObjectCoverage());
-	fiberMetrics->getMaxCoverageFiberPerRegion();
+	fiberMetrics->setCoverageLevelMetrics(m_fiberCoverageCalc->getMaxCoverageObjectPerRegion(),
+		m_fiberCoverageCalc->getMaxNumberOfObjectsInRegion());
 
 	//Add InteractorStyle
 	m_style->setVRMain(this);
@@ -0,0 +1,275 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAOctreeCoverage.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	//! coverage of an object in a region of a level, as computed per object
+	struct iALevelCoverage
+	{
+		int level;
+		int region;
+		double coverage;
+	};
+}
+
+iAOctreeCoverage::iAOctreeCoverage(double const bounds[6], int maxLevel) :
+	m_maxLevel(std::max(0, maxLevel)),
+	m_cellRegions(m_maxLevel + 1),
+	m_regionCount(m_maxLevel + 1),
+	m_maxObjectsInRegion(m_maxLevel + 1, 0)
+{
+	int n = cellsPerAxis(m_maxLevel);
+	for (int a = 0; a < 3; ++a)
+	{
+		m_origin[a] = bounds[2 * a];
+		m_cellSize[a] = std::max(0.0, bounds[2 * a + 1] - bounds[2 * a]) / n;
+	}
+	for (int level = 0; level <= m_maxLevel; ++level)
+	{
+		size_t cellCount = static_cast<size_t>(cellsPerAxis(level)) * cellsPerAxis(level) * cellsPerAxis(level);
+		m_cellRegions[level].resize(cellCount);
+		for (size_t cell = 0; cell < cellCount; ++cell)
+		{
+			m_cellRegions[level][cell] = static_cast<int>(cell);
+		}
+		m_regionCount[level] = static_cast<int>(cellCount);
+	}
+	m_coverage.resize(m_maxLevel + 1);
+	for (int level = 0; level <= m_maxLevel; ++level)
+	{
+		m_coverage[level].resize(m_regionCount[level]);
+	}
+}
+
+int iAOctreeCoverage::maxLevel() const
+{
+	return m_maxLevel;
+}
+
+int iAOctreeCoverage::cellsPerAxis(int level) const
+{
+	return 1 << level;
+}
+
+size_t iAOctreeCoverage::cellIndex(int level, int x, int y, int z) const
+{
+	size_t n = cellsPerAxis(level);
+	return (static_cast<size_t>(z) * n + y) * n + x;
+}
+
+void iAOctreeCoverage::cellCenter(int level, size_t cell, double center[3]) const
+{
+	size_t n = cellsPerAxis(level);
+	size_t coord[3] = {cell % n, (cell / n) % n, cell / (n * n)};
+	double scale = static_cast<double>(cellsPerAxis(m_maxLevel - level));
+	for (int a = 0; a < 3; ++a)
+	{
+		center[a] = m_origin[a] + (coord[a] + 0.5) * m_cellSize[a] * scale;
+	}
+}
+
+void iAOctreeCoverage::setRegions(int level, std::vector<int> const& cellRegions, int regionCount)
+{
+	assert(cellRegions.size() == m_cellRegions[level].size());
+	m_cellRegions[level] = cellRegions;
+	m_regionCount[level] = regionCount;
+	m_coverage[level].clear();
+	m_coverage[level].resize(regionCount);
+}
+
+int iAOctreeCoverage::regionCount(int level) const
+{
+	return m_regionCount[level];
+}
+
+void iAOctreeCoverage::finestCell(iAVec3d const& point, int cell[3]) const
+{
+	double lastCell = cellsPerAxis(m_maxLevel) - 1;
+	for (int a = 0; a < 3; ++a)
+	{
+		double c = (m_cellSize[a] > 0) ? std::floor((point[a] - m_origin[a]) / m_cellSize[a]) : 0.0;
+		cell[a] = static_cast<int>(std::min(std::max(c, 0.0), lastCell));    // also maps NaN to 0
+	}
+}
+
+void iAOctreeCoverage::traverseSegment(iAVec3d const& start, iAVec3d const& end,
+	std::vector<std::pair<size_t, double>>& parts) const
+{
+	const double Infinity = std::numeric_limits<double>::infinity();
+	int n = cellsPerAxis(m_maxLevel);
+	iAVec3d dir = end - start;
+	double segmentLength = dir.length();
+	if (segmentLength == 0)
+	{
+		return;
+	}
+	int cell[3];
+	finestCell(start, cell);
+	// segment parameter t (0..1) at which the next cell boundary is crossed along each axis; only boundaries between
+	// cells are considered, parts outside of the bounds are assigned to the outermost cells
+	double tNext[3], tDelta[3];
+	int step[3];
+	for (int a = 0; a < 3; ++a)
+	{
+		step[a] = 0;
+		tNext[a] = Infinity;
+		tDelta[a] = Infinity;
+		if (dir[a] > 0 && m_cellSize[a] > 0)
+		{
+			step[a] = 1;
+			tDelta[a] = m_cellSize[a] / dir[a];
+			if (cell[a] + 1 < n)
+			{
+				tNext[a] = (m_origin[a] + (cell[a] + 1) * m_cellSize[a] - start[a]) / dir[a];
+			}
+		}
+		else if (dir[a] < 0 && m_cellSize[a] > 0)
+		{
+			step[a] = -1;
+			tDelta[a] = -m_cellSize[a] / dir[a];
+			if (cell[a] > 0)
+			{
+				tNext[a] = (m_origin[a] + cell[a] * m_cellSize[a] - start[a]) / dir[a];
+			}
+		}
+	}
+	double t = 0.0;
+	while (true)
+	{
+		int axis = (tNext[0] < tNext[1]) ? ((tNext[0] < tNext[2]) ? 0 : 2) : ((tNext[1] < tNext[2]) ? 1 : 2);
+		double tEnd = std::min(tNext[axis], 1.0);
+		if (tEnd > t)
+		{
+			parts.push_back(std::make_pair(cellIndex(m_maxLevel, cell[0], cell[1], cell[2]), (tEnd - t) * segmentLength));
+			t = tEnd;
+		}
+		if (tNext[axis] >= 1.0)
+		{
+			break;
+		}
+		cell[axis] += step[axis];
+		bool boundaryAhead = (step[axis] > 0) ? (cell[axis] + 1 < n) : (cell[axis] > 0);
+		tNext[axis] = boundaryAhead ? tNext[axis] + tDelta[axis] : Infinity;
+	}
+}
+
+void iAOctreeCoverage::compute(std::vector<iACoverageObject> const& objects)
+{
+	long long const objectCount = static_cast<long long>(objects.size());
+	size_t const n = cellsPerAxis(m_maxLevel);
+	std::vector<std::vector<iALevelCoverage>> objectCoverage(objects.size());
+	m_maxCoverageRegion.assign(m_maxLevel + 1, std::vector<int>(objects.size(), 0));
+#pragma omp parallel
+	{
+		std::vector<std::pair<size_t, double>> parts;      // parts of the object in the cells of the deepest level
+		std::vector<std::pair<int, double>> regionParts;   // the same parts, assigned to the regions of one level
+#pragma omp for schedule(dynamic, 64)
+		for (long long o = 0; o < objectCount; ++o)
+		{
+			iACoverageObject const& object = objects[o];
+			parts.clear();
+			bool pointObject = object.length <= 0;
+			if (pointObject)
+			{
+				if (!object.segmentPoints.empty())
+				{
+					int cell[3];
+					finestCell(object.segmentPoints[0], cell);
+					parts.push_back(std::make_pair(cellIndex(m_maxLevel, cell[0], cell[1], cell[2]), 1.0));
+				}
+			}
+			else
+			{
+				for (size_t s = 0; s + 1 < object.segmentPoints.size(); s += 2)
+				{
+					traverseSegment(object.segmentPoints[s], object.segmentPoints[s + 1], parts);
+				}
+			}
+			std::vector<iALevelCoverage>& result = objectCoverage[o];
+			result.push_back(iALevelCoverage{0, 0, 1.0});
+			for (int level = 1; level <= m_maxLevel; ++level)
+			{
+				int shift = m_maxLevel - level;
+				regionParts.clear();
+				for (auto const& part : parts)
+				{
+					int x = static_cast<int>(part.first % n) >> shift;
+					int y = static_cast<int>((part.first / n) % n) >> shift;
+					int z = static_cast<int>(part.first / (n * n)) >> shift;
+					regionParts.push_back(std::make_pair(m_cellRegions[level][cellIndex(level, x, y, z)], part.second));
+				}
+				// sorting also fixes the summation order, so the result does not depend on the traversal order:
+				std::sort(regionParts.begin(), regionParts.end());
+				double maxCoverage = -1.0;
+				for (size_t i = 0; i < regionParts.size();)
+				{
+					int region = regionParts[i].first;
+					double length = 0.0;
+					for (; i < regionParts.size() && regionParts[i].first == region; ++i)
+					{
+						length += regionParts[i].second;
+					}
+					double coverage = pointObject ? length : length / object.length;
+					result.push_back(iALevelCoverage{level, region, coverage});
+					if (coverage > maxCoverage)
+					{
+						maxCoverage = coverage;
+						m_maxCoverageRegion[level][o] = region;
+					}
+				}
+			}
+		}
+	}
+	// regroup the results by region; objects are visited in ascending order, so each region's entries are sorted:
+	std::vector<std::vector<size_t>> entryCount(m_maxLevel + 1);
+	for (int level = 0; level <= m_maxLevel; ++level)
+	{
+		entryCount[level].assign(m_regionCount[level], 0);
+	}
+	for (auto const& result : objectCoverage)
+	{
+		for (auto const& c : result)
+		{
+			++entryCount[c.level][c.region];
+		}
+	}
+	for (int level = 0; level <= m_maxLevel; ++level)
+	{
+		m_coverage[level].assign(m_regionCount[level], std::vector<Entry>());
+		for (int region = 0; region < m_regionCount[level]; ++region)
+		{
+			m_coverage[level][region].reserve(entryCount[level][region]);
+		}
+		m_maxObjectsInRegion[level] = entryCount[level].empty() ? 0 :
+			*std::max_element(entryCount[level].begin(), entryCount[level].end());
+	}
+	for (size_t o = 0; o < objectCoverage.size(); ++o)
+	{
+		for (auto const& c : objectCoverage[o])
+		{
+			m_coverage[c.level][c.region].push_back(std::make_pair(o, c.coverage));
+		}
+		std::vector<iALevelCoverage>().swap(objectCoverage[o]);
+	}
+}
+
+std::vector<iAOctreeCoverage::Entry> const& iAOctreeCoverage::regionCoverage(int level, int region) const
+{
+	return m_coverage[level][region];
+}
+
+size_t iAOctreeCoverage::maxObjectsInRegion(int level) const
+{
+	return m_maxObjectsInRegion[level];
+}
+
+int iAOctreeCoverage::maxCoverageRegion(int level, size_t object) const
+{
+	return m_maxCoverageRegion[level][object];
+}
@@ -0,0 +1,79 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <iAVec3.h>
+
+#include <cstddef>    // for size_t
+#include <utility>
+#include <vector>
+
+//! Geometry of an object for the coverage computation.
+struct iACoverageObject
+{
+	//! start and end point of each line segment of the object (i.e., two points per segment)
+	std::vector<iAVec3d> segmentPoints;
+	//! the length the coverage of the segment parts is related to (e.g. the curved length of a fiber)
+	double length = 0.0;
+};
+
+//! Computes the coverage of objects (consisting of line segments) in the regions of all levels of an octree.
+//!
+//! Independent of VR and VTK: the octree is implicit, level L divides the bounds into 2^L cells along each axis.
+//! Each segment is traversed through the cells of the deepest level (3D DDA, i.e. from one cell boundary crossing
+//! to the next), and the lengths of its parts are summed up per cell of every level in the same pass.
+//! Cells can be grouped into regions per level (see setRegions), to reproduce an octree in which not all
+//! regions are subdivided down to the deepest level. Objects are processed in parallel.
+class iAOctreeCoverage
+{
+public:
+	//! coverage (0..1) of an object (given by its index) in a region
+	typedef std::pair<size_t, double> Entry;
+
+	//! @param bounds the bounds of the octree (xmin, xmax, ymin, ymax, zmin, zmax)
+	//! @param maxLevel the deepest level of the octree
+	iAOctreeCoverage(double const bounds[6], int maxLevel);
+	int maxLevel() const;
+	//! number of cells along each axis on the given level
+	int cellsPerAxis(int level) const;
+	//! linear index of a cell on the given level (x fastest, then y, then z)
+	size_t cellIndex(int level, int x, int y, int z) const;
+	//! center point of the cell with the given linear index
+	void cellCenter(int level, size_t cell, double center[3]) const;
+	//! Groups the cells of the given level into regions; by default, each cell forms its own region.
+	//! @param level the octree level
+	//! @param cellRegions for each cell of the level (see cellIndex), the region (0..regionCount-1) containing it
+	//! @param regionCount the number of regions on the level
+	void setRegions(int level, std::vector<int> const& cellRegions, int regionCount);
+	int regionCount(int level) const;
+
+	//! Computes the coverage of the given objects in the regions of all levels.
+	//! The coverage of an object in a region is the summed up length of its segment parts inside of the region,
+	//! divided by the object length. On level 0, each object covers the single region completely (coverage 1);
+	//! an object with length 0 is assigned completely to the region containing its first point.
+	void compute(std::vector<iACoverageObject> const& objects);
+
+	//! the coverage of all objects in the given region, sorted by object index
+	std::vector<Entry> const& regionCoverage(int level, int region) const;
+	//! the maximum number of objects in any region of the given level
+	size_t maxObjectsInRegion(int level) const;
+	//! the region of the given level in which the given object has its highest coverage
+	//! (the one with the lowest index in case of ties; 0 for objects not covering any region)
+	int maxCoverageRegion(int level, size_t object) const;
+
+private:
+	//! index of the cell on the deepest level containing the given point; points outside the bounds are
+	//! assigned to the closest cell
+	void finestCell(iAVec3d const& point, int cell[3]) const;
+	//! adds the lengths of the parts of the given segment in the cells of the deepest level
+	void traverseSegment(iAVec3d const& start, iAVec3d const& end, std::vector<std::pair<size_t, double>>& parts) const;
+
+	double m_origin[3];
+	double m_cellSize[3];    //!< cell size on the deepest level
+	int m_maxLevel;
+	std::vector<std::vector<int>> m_cellRegions;                //!< per level, the region of each cell
+	std::vector<int> m_regionCount;                             //!< per level, the number of regions
+	std::vector<std::vector<std::vector<Entry>>> m_coverage;    //!< per level and region, the covered objects
+	std::vector<std::vector<int>> m_maxCoverageRegion;          //!< per level and object, see maxCoverageRegion
+	std::vector<size_t> m_maxObjectsInRegion;                   //!< per level, see maxObjectsInRegion
+};
@@ -0,0 +1,171 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "iAOctreeCoverage.h"
+
+#include <random>
+
+namespace
+{
+	iACoverageObject segmentObject(iAVec3d const& start, iAVec3d const& end, double length)
+	{
+		iACoverageObject result;
+		result.segmentPoints.push_back(start);
+		result.segmentPoints.push_back(end);
+		result.length = length;
+		return result;
+	}
+
+	double coverageOf(iAOctreeCoverage const& cov, int level, int region, size_t object)
+	{
+		for (auto const& entry : cov.regionCoverage(level, region))
+		{
+			if (entry.first == object)
+			{
+				return entry.second;
+			}
+		}
+		return 0.0;
+	}
+
+	//! length of the part of the segment inside the given box (slab clipping)
+	double clippedLength(iAVec3d const& start, iAVec3d const& end, double const bounds[6])
+	{
+		double t0 = 0.0, t1 = 1.0;
+		iAVec3d dir = end - start;
+		for (int a = 0; a < 3; ++a)
+		{
+			if (dir[a] == 0)
+			{
+				if (start[a] < bounds[2 * a] || start[a] > bounds[2 * a + 1])
+				{
+					return 0.0;
+				}
+				continue;
+			}
+			double ta = (bounds[2 * a] - start[a]) / dir[a];
+			double tb = (bounds[2 * a + 1] - start[a]) / dir[a];
+			t0 = std::max(t0, std::min(ta, tb));
+			t1 = std::min(t1, std::max(ta, tb));
+		}
+		return (t1 > t0) ? (t1 - t0) * dir.length() : 0.0;
+	}
+}
+
+BEGIN_TEST
+{
+	double bounds[6] = {0, 4, 0, 4, 0, 4};
+
+	// straight segment along x, through the centers of the cells:
+	iAOctreeCoverage cov(bounds, 2);
+	TestEqual(4, cov.cellsPerAxis(2));
+	TestEqual(64, cov.regionCount(2));
+	std::vector<iACoverageObject> objects;
+	objects.push_back(segmentObject(iAVec3d(0.5, 0.5, 0.5), iAVec3d(3.5, 0.5, 0.5), 3.0));
+	// diagonal through the whole octree:
+	objects.push_back(segmentObject(iAVec3d(0, 0, 0), iAVec3d(4, 4, 4), std::sqrt(48.0)));
+	// point object:
+	objects.push_back(segmentObject(iAVec3d(2.5, 3.5, 1.5), iAVec3d(2.5, 3.5, 1.5), 0.0));
+	// segment starting outside the bounds:
+	objects.push_back(segmentObject(iAVec3d(-1, 0.5, 0.5), iAVec3d(1.5, 0.5, 0.5), 2.5));
+	cov.compute(objects);
+
+	TestEqualFloatingPoint(1.0, coverageOf(cov, 0, 0, 0));
+	TestEqualFloatingPoint(0.5 / 3, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, 0, 0, 0)), 0));
+	TestEqualFloatingPoint(1.0 / 3, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, 1, 0, 0)), 0));
+	TestEqualFloatingPoint(1.0 / 3, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, 2, 0, 0)), 0));
+	TestEqualFloatingPoint(0.5 / 3, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, 3, 0, 0)), 0));
+	TestEqualFloatingPoint(0.5, coverageOf(cov, 1, static_cast<int>(cov.cellIndex(1, 0, 0, 0)), 0));
+	TestEqualFloatingPoint(0.5, coverageOf(cov, 1, static_cast<int>(cov.cellIndex(1, 1, 0, 0)), 0));
+	// ties are resolved to the region with lowest index:
+	TestEqual(static_cast<int>(cov.cellIndex(2, 1, 0, 0)), cov.maxCoverageRegion(2, 0));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		TestEqualFloatingPoint(0.25, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, i, i, i)), 1));
+	}
+	TestEqualFloatingPoint(0.5, coverageOf(cov, 1, static_cast<int>(cov.cellIndex(1, 1, 1, 1)), 1));
+
+	TestEqualFloatingPoint(1.0, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, 2, 3, 1)), 2));
+	TestEqualFloatingPoint(1.0, coverageOf(cov, 1, static_cast<int>(cov.cellIndex(1, 1, 1, 0)), 2));
+
+	TestEqualFloatingPoint(0.8, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, 0, 0, 0)), 3));
+	TestEqualFloatingPoint(0.2, coverageOf(cov, 2, static_cast<int>(cov.cellIndex(2, 1, 0, 0)), 3));
+	TestEqual(static_cast<int>(cov.cellIndex(2, 0, 0, 0)), cov.maxCoverageRegion(2, 3));
+	TestEqual(static_cast<size_t>(3), cov.maxObjectsInRegion(2));    // objects 0, 1 and 3 in cell (0, 0, 0)
+	TestEqual(static_cast<size_t>(4), cov.maxObjectsInRegion(0));
+
+	// regions spanning several cells (x < 2 in region 0, others in region 1):
+	iAOctreeCoverage grouped(bounds, 2);
+	std::vector<int> cellRegions(64);
+	for (int z = 0; z < 4; ++z)
+	{
+		for (int y = 0; y < 4; ++y)
+		{
+			for (int x = 0; x < 4; ++x)
+			{
+				cellRegions[grouped.cellIndex(2, x, y, z)] = (x < 2) ? 0 : 1;
+			}
+		}
+	}
+	grouped.setRegions(2, cellRegions, 2);
+	grouped.compute(objects);
+	TestEqual(2, grouped.regionCount(2));
+	TestEqualFloatingPoint(0.5, coverageOf(grouped, 2, 0, 0));
+	TestEqualFloatingPoint(0.5, coverageOf(grouped, 2, 1, 0));
+	TestEqualFloatingPoint(1.0, coverageOf(grouped, 2, 1, 2));
+	TestEqualFloatingPoint(1.0, coverageOf(grouped, 2, 0, 3));
+	TestEqual(static_cast<size_t>(3), grouped.maxObjectsInRegion(2));
+
+	// random polylines, compared to clipping each segment against each cell:
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> pos(0.0, 4.0);
+	std::vector<iACoverageObject> polylines;
+	for (int o = 0; o < 200; ++o)
+	{
+		iACoverageObject object;
+		iAVec3d last(pos(rng), pos(rng), pos(rng));
+		for (int s = 0; s < 5; ++s)
+		{
+			iAVec3d next(pos(rng), pos(rng), pos(rng));
+			object.segmentPoints.push_back(last);
+			object.segmentPoints.push_back(next);
+			object.length += (next - last).length();
+			last = next;
+		}
+		polylines.push_back(object);
+	}
+	iAOctreeCoverage random(bounds, 2);
+	random.compute(polylines);
+	double maxError = 0.0;
+	for (int level = 1; level <= 2; ++level)
+	{
+		int n = random.cellsPerAxis(level);
+		double cellSize = 4.0 / n;
+		for (int z = 0; z < n; ++z)
+		{
+			for (int y = 0; y < n; ++y)
+			{
+				for (int x = 0; x < n; ++x)
+				{
+					double cellBounds[6] = {x * cellSize, (x + 1) * cellSize, y * cellSize, (y + 1) * cellSize,
+						z * cellSize, (z + 1) * cellSize};
+					int region = static_cast<int>(random.cellIndex(level, x, y, z));
+					for (size_t o = 0; o < polylines.size(); ++o)
+					{
+						double length = 0.0;
+						for (size_t s = 0; s < polylines[o].segmentPoints.size(); s += 2)
+						{
+							length += clippedLength(polylines[o].segmentPoints[s], polylines[o].segmentPoints[s + 1], cellBounds);
+						}
+						double expected = length / polylines[o].length;
+						maxError = std::max(maxError, std::abs(expected - coverageOf(random, level, region, o)));
+					}
+				}
+			}
+		}
+	}
+	TestAssert(maxError < 1e-9);
+}
+END_TEST
@@ -7,11 +7,14 @@
 #include <vtkTable.h>
 
 #include <unordered_map>
+#include <vector>
 
 #include "iACsvIO.h"
 #include "iAVRObjectModel.h"
 #include "iAVROctree.h"
 
+struct iACoverageObject;
+
 /*
 * This class calculates the coverage of objects inside octree regions
 */
@@ -21,6 +24,10 @@ public:
 	iAVRObjectCoverage(vtkTable* objectTable, iACsvIO io, iACsvConfig csvConfig, std::vector<iAVROctree*>* octrees, iAVRObjectModel* volume);
 	void calculateObjectCoverage();
 	std::vector<std::vector<std::unordered_map<vtkIdType, double>*>>* getObjectCoverage();
+	//! for each [octree level] and [octree region], the objects which have their highest coverage in that region
+	std::vector<std::vector<std::vector<vtkIdType>>> const& getMaxCoverageObjectPerRegion() const;
+	//! for each octree level, the maximum number of objects in any of its regions
+	std::vector<double> const& getMaxNumberOfObjectsInRegion() const;
 	vtkIdType getObjectiD(vtkIdType polyPoint);
 
 private:
@@ -31,17 +38,15 @@ private:
 	iAVRObjectModel* m_volume;
 	//Stores for the [octree level] in an [octree region] a map of its objectIDs with their coverage
 	std::vector<std::vector<std::unordered_map<vtkIdType, double>*>>* m_objectCoverage;
+	std::vector<std::vector<std::vector<vtkIdType>>> m_maxCoverageObjects;
+	std::vector<double> m_maxNumberOfObjectsInRegion;
 
 	void initialize();
 	void calculateLineCoverage();
 	void calculateCurvedLineCoverage();
 	void calculateEllipseCoverage();
-	vtkSmartPointer<vtkPoints> getOctreeFiberCoverage(double startPoint[3], double endPoint[3], vtkIdType octreeLevel, vtkIdType fiber, double fiberLength);
-	bool checkIntersectionWithBox(double startPoint[3], double endPoint[3], double bounds[6], double intersection[3]);
-	double calculateLineCoverageRatio(double startPoint[3], double endPoint[3], double lineLength);
-	void storeObjectCoverage(vtkIdType octreeLevel, vtkIdType region, vtkIdType fiber, double coverage);
+	void computeCoverage(std::vector<iACoverageObject> const& objects);
 	bool checkEqualArrays(float pos1[3], float pos2[3]);
 	bool checkEqualArrays(double pos1[3], double pos2[3]);
-	void createPlanePoint(int plane, double bounds[6], iAVec3d* planeOrigin, iAVec3d* planeP1, iAVec3d* planeP2);
 	void printObjectCoverage();
 };
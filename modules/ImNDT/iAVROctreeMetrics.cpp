@@ -133,6 +133,13 @@ double iAVROctreeMetrics::getMaxNumberOfFibersInRegion(vtkIdType octreeLevel)
 	return m_maxNumberOffibersInRegions->at(octreeLevel);
 }
 
+void iAVROctreeMetrics::setCoverageLevelMetrics(std::vector<std::vector<std::vector<vtkIdType>>> const& maxCoverageFiberPerRegion,
+	std::vector<double> const& maxNumberOfFibersInRegion)
+{
+	*m_maxCoverage = maxCoverageFiberPerRegion;
+	*m_maxNumberOffibersInRegions = maxNumberOfFibersInRegion;
+}
+
 //! Returns a vector which stores for each fiber its region with the strongest coverage fo every level
 //! So every fiber is only stored once for a level!
 void iAVROctreeMetrics::calculateMaxCoverageFiberPerRegion()
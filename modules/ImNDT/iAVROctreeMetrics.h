@@ -18,6 +18,10 @@ public:
 	std::vector<double> getRegionValues(vtkIdType octreeLevel, vtkIdType region, vtkIdType feature);
 	std::vector<std::vector<std::vector<double>>>* getJaccardIndex(vtkIdType octreeLevel);
 	double getMaxNumberOfFibersInRegion(vtkIdType octreeLevel);
+	//! Sets the level metrics computed along with the fiber coverage (see iAVRObjectCoverage), so that they
+	//! are not computed again from the coverage maps
+	void setCoverageLevelMetrics(std::vector<std::vector<std::vector<vtkIdType>>> const& maxCoverageFiberPerRegion,
+		std::vector<double> const& maxNumberOfFibersInRegion);
 
 private:
 	//Stores for the [octree level] in an [octree region] the fibers which have the max coverage (Every Fiber can only be in one region)
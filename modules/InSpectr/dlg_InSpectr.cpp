@@ -339,20 +339,16 @@ int findCharEnergy(QVector<iACharacteristicEnergy> const& energies, QString cons
 
 void updateSpectrumData(QSharedPointer<iAHistogramData> histData, QSharedPointer<iAXRFData> xrfData, int x, int y, int z)
 {
-	int extent[6];
-	xrfData->GetExtent(extent);
-	if (x < extent[0] || x > extent[1] || y < extent[2] || y > extent[3] || z < extent[4] || z > extent[5])
+	auto const & cube = xrfData->SpectralCube();
+	if (!cube.contains(x, y, z))
 	{
 		histData->clear();
 		return;
 	}
-	iAXRFData::Iterator it = xrfData->begin();
-	int idx = 0;
-	while (it != xrfData->end())
+	auto spectrum = cube.spectrum(x, y, z);
+	for (size_t idx = 0; idx < spectrum.size(); ++idx)
 	{
-		histData->setBin(idx, static_cast<iAPlotData::DataType>((*it)->GetScalarComponentAsFloat(x, y, z, 0)));
-		++it;
-		++idx;
+		histData->setBin(idx, static_cast<iAPlotData::DataType>(spectrum[idx]));
 	}
 }
 
@@ -121,16 +121,6 @@ void iAAccumulatedXRFData::retrieveHistData( long numBin_in, DataType * &data_ou
 
 namespace
 {
-	iASpectrumFunction * createSpectrumFunction(QSharedPointer<iAXRFData const> xrfData, int x, int y, int z)
-	{
-		iASpectrumFunction *result = new iASpectrumFunction();
-		for (size_t i=0; i<xrfData->size(); ++i)
-		{
-			result->insert(std::make_pair(i, static_cast<unsigned int>(xrfData->image(i)->GetScalarComponentAsFloat(x, y, z, 0))));
-		}
-		return result;
-	}
-
 	template <typename T>
 	void calculateLevelStats(void* dataVoidPtr, int count, double &avg, double &max, double &min)
 	{
@@ -210,41 +200,30 @@ void iAAccumulatedXRFData::calculateStatistics()
 	}
 }
 
-void iAAccumulatedXRFData::createSpectrumFunctions()
+void iAAccumulatedXRFData::calculateFunctionBoxplots()
 {
-	vtkSmartPointer<vtkImageData> img = m_xrfData->image(0);
-	int extent[6];
-	img->GetExtent(extent);
-	for (int x = extent[0]; x <= extent[1]; ++x)
+	assert(!m_functionalBoxplotData);
+	// the spectrum of each voxel is a function of the channel index; its values are copied from the spectral cube
+	// directly into a dense matrix, instead of creating a separate function object for each voxel:
+	auto const & cube = m_xrfData->SpectralCube();
+	std::vector<size_t> channels(cube.channelCount());
+	for (size_t c = 0; c < channels.size(); ++c)
 	{
-		for (int y = extent[2]; y <= extent[3]; ++y)
-		{
-			for (int z = extent[4]; z <= extent[5]; ++z)
-			{
-				iASpectrumFunction *wrap = createSpectrumFunction(m_xrfData, x, y, z);
-				m_spectrumFunctions.push_back(wrap);
-			}
-		}
+		channels[c] = c;
 	}
-	//size_t numSpectra = (extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
-}
-
-std::vector<iAFunction<size_t, unsigned int> *> const & iAAccumulatedXRFData::spectrumFunctions()
-{
-	if (m_spectrumFunctions.size() == 0)
+	iAFunctionMatrix<size_t, unsigned int> spectra(channels, cube.voxelCount());
+	long long const channelCount = static_cast<long long>(cube.channelCount());
+#pragma omp parallel for
+	for (long long c = 0; c < channelCount; ++c)
 	{
-		createSpectrumFunctions();
+		iASpectrumView const channel = cube.channel(c);
+		unsigned int* values = spectra.argValues(c);
+		for (size_t v = 0; v < channel.size(); ++v)
+		{
+			values[v] = static_cast<unsigned int>(channel[v]);
+		}
 	}
-	return m_spectrumFunctions;
-}
-
-void iAAccumulatedXRFData::calculateFunctionBoxplots()
-{
-	assert(!m_functionalBoxplotData);
-	iAModifiedDepthMeasure<size_t, unsigned int> measure;
-	std::vector<iAFunction<size_t, unsigned int> *> functions = spectrumFunctions();
-	m_functionalBoxplotData = new iAFunctionalBoxplot<size_t, unsigned int>(
-		functions, &measure, 2);
+	m_functionalBoxplotData = new iAFunctionalBoxplot<size_t, unsigned int>(spectra);
 }
 
 FunctionalBoxPlot* iAAccumulatedXRFData::functionalBoxPlot()
@@ -9,6 +9,16 @@
 
 #include <vtkImageData.h>
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace
+{
+	//! number of voxels fitted together in one parallel work item
+	const long long DecompositionBlockSize = 1024;
+}
+
 iADecompositionCalculator::iADecompositionCalculator(
 	QSharedPointer<iAElementConcentrations> data,
 	QSharedPointer<iAXRFData const> xrfData,
@@ -65,34 +75,66 @@ void iADecompositionCalculator::run()
 
 	m_data->initImages(m_elements.size(), extent, spacing, origin);
 
-	iAElementConcentrations::VoxelConcentrationType concentration;
-	concentration.reserve(m_elements.size());
-	int width = extent[1]-extent[0]+1;
-	int height = extent[3]-extent[2]+1;
-	int depth = extent[5]-extent[4]+1;
-	int pixelCount = width * height * depth;
-	for (int x=extent[0]; x<=extent[1] && !m_stopped; ++x)
+	auto const & cube = m_xrfData->SpectralCube();
+	iASpectrumBatchFitter fitter(adaptedElementSpectra, threshold, cube.channelCount());
+	size_t const elementCount = m_elements.size();
+	std::vector<float*> concentrationImages(elementCount);
+	for (size_t e = 0; e < elementCount; ++e)
 	{
-		for (int y=extent[2]; y<=extent[3] && !m_stopped; ++y)
+		concentrationImages[e] = static_cast<float*>(m_data->m_ElementConcentration[e]->GetScalarPointer());
+	}
+	long long const voxelCount = static_cast<long long>(cube.voxelCount());
+	long long const blockCount = (voxelCount + DecompositionBlockSize - 1) / DecompositionBlockSize;
+	std::atomic<long long> finishedBlocks(0);
+#pragma omp parallel
+	{
+		std::vector<double> blockConcentrations(DecompositionBlockSize * elementCount);
+		iAElementConcentrations::VoxelConcentrationType concentration;
+		iAEnergySpectrum unknownSpectrum;
+#pragma omp for schedule(dynamic)
+		for (long long b = 0; b < blockCount; ++b)
 		{
-#pragma omp parallel for private (concentration)
-			for (int z=extent[4]; z<=extent[5]; ++z)
+			if (m_stopped)
 			{
-				iAEnergySpectrum unknownSpectrum;
-				iAXRFData::Iterator it= m_xrfData->begin();
-				while (it != m_xrfData->end())
+				continue;
+			}
+			size_t const firstVoxel = b * DecompositionBlockSize;
+			size_t const voxels = static_cast<size_t>(std::min(DecompositionBlockSize, voxelCount - b * DecompositionBlockSize));
+			if (fitter.isValid())
+			{
+				fitter.fit(cube.spectrum(firstVoxel).data(), voxels, blockConcentrations.data());
+			}
+			else
+			{	// the batch fitter cannot handle this set of element spectra, fit each voxel on its own:
+				for (size_t v = 0; v < voxels; ++v)
 				{
-					unknownSpectrum.push_back(static_cast<unsigned int>((*it)->GetScalarComponentAsFloat(x, y, z, 0)));
-					++it;
+					auto spectrum = cube.spectrum(firstVoxel + v);
+					unknownSpectrum.clear();
+					for (size_t i = 0; i < spectrum.size(); ++i)
+					{
+						unknownSpectrum.push_back(static_cast<unsigned int>(spectrum[i]));
+					}
+					concentration.clear();
+					fitSpectrum(unknownSpectrum, adaptedElementSpectra, threshold, concentration);
+					for (size_t e = 0; e < elementCount; ++e)
+					{
+						blockConcentrations[v * elementCount + e] =
+							(static_cast<int>(e) < concentration.size()) ? concentration[e] : 0.0;
+					}
 				}
-				concentration.clear();
-				fitSpectrum(unknownSpectrum, adaptedElementSpectra, threshold, concentration);
-				for (int i=0; i<concentration.size() && !m_stopped; ++i)
+			}
+			for (size_t v = 0; v < voxels; ++v)
+			{
+				for (size_t e = 0; e < elementCount; ++e)
 				{
-					m_data->m_ElementConcentration[i]->SetScalarComponentFromDouble(x, y, z, 0, concentration[i]);
+					concentrationImages[e][firstVoxel + v] = static_cast<float>(blockConcentrations[v * elementCount + e]);
 				}
 			}
-			m_progress.emitProgress((x * height * depth + y * depth) * 100.0 / pixelCount);
+			auto finished = ++finishedBlocks;
+#pragma omp critical
+			{
+				m_progress.emitProgress(finished * 100.0 / blockCount);
+			}
 		}
 	}
 	if (!m_stopped)
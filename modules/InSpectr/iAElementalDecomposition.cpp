@@ -7,6 +7,8 @@
 #include <vtkMath.h>
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace
 {
@@ -116,3 +118,301 @@ bool fitSpectrum(
 
 	return true;
 }
+
+namespace
+{
+	//! counts are considered as unsigned int in the fit (as in fitSpectrum); negative counts are treated as 0
+	double truncatedCount(double value)
+	{
+		return (value <= 0) ? 0.0 : static_cast<double>(static_cast<unsigned int>(value));
+	}
+
+	//! Cholesky decomposition of the symmetric n x n matrix a; stores the lower triangle in l
+	//! @return false if a is not (numerically) positive definite
+	bool choleskyFactorize(double const* a, size_t n, double* l)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (size_t j = 0; j <= i; ++j)
+			{
+				double sum = a[i * n + j];
+				for (size_t k = 0; k < j; ++k)
+				{
+					sum -= l[i * n + k] * l[j * n + k];
+				}
+				if (i == j)
+				{
+					if (sum <= 1e-12 * std::abs(a[i * n + i]) || sum <= 0)
+					{
+						return false;
+					}
+					l[i * n + i] = std::sqrt(sum);
+				}
+				else
+				{
+					l[i * n + j] = sum / l[j * n + j];
+				}
+			}
+		}
+		return true;
+	}
+
+	//! solve (l * l^T) x = b, with l from choleskyFactorize; b is overwritten by x
+	void choleskySolve(double const* l, size_t n, double* b)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (size_t k = 0; k < i; ++k)
+			{
+				b[i] -= l[i * n + k] * b[k];
+			}
+			b[i] /= l[i * n + i];
+		}
+		for (size_t i = n; i-- > 0;)
+		{
+			for (size_t k = i + 1; k < n; ++k)
+			{
+				b[i] -= l[k * n + i] * b[k];
+			}
+			b[i] /= l[i * n + i];
+		}
+	}
+}
+
+iASpectrumBatchFitter::iASpectrumBatchFitter(QSharedPointer<QVector<QSharedPointer<iAEnergySpectrum> > > elements,
+	CountType threshold, size_t channelCount) :
+	m_elementCount(elements ? elements->size() : 0),
+	m_channelCount(channelCount),
+	m_threshold(threshold),
+	m_valid(false)
+{
+	if (m_elementCount == 0 || static_cast<size_t>((*elements)[0]->size()) != channelCount)
+	{
+		return;
+	}
+	size_t const n = m_elementCount;
+	m_elementCounts.resize(channelCount * n);
+	for (size_t c = 0; c < channelCount; ++c)
+	{
+		bool anyAbove = false, anyNonZero = false;
+		for (size_t e = 0; e < n; ++e)
+		{
+			double count = (*(*elements)[e])[c];
+			anyAbove |= count > threshold;
+			m_elementCounts[c * n + e] = truncatedCount(count);
+			anyNonZero |= m_elementCounts[c * n + e] != 0;
+		}
+		if (anyAbove)
+		{
+			m_fixedPoints.push_back(static_cast<int>(c));
+		}
+		else if (anyNonZero)
+		{
+			m_extraPoints.push_back(static_cast<int>(c));
+		}
+	}
+	size_t const fixedCount = m_fixedPoints.size();
+	m_fixedElements.resize(n * fixedCount);
+	m_gram.assign(n * n, 0.0);
+	for (size_t f = 0; f < fixedCount; ++f)
+	{
+		double const* x = m_elementCounts.data() + m_fixedPoints[f] * n;
+		for (size_t e1 = 0; e1 < n; ++e1)
+		{
+			m_fixedElements[e1 * fixedCount + f] = x[e1];
+			for (size_t e2 = 0; e2 < n; ++e2)
+			{
+				m_gram[e1 * n + e2] += x[e1] * x[e2];
+			}
+		}
+	}
+	m_cholesky.assign(n * n, 0.0);
+	m_valid = choleskyFactorize(m_gram.data(), n, m_cholesky.data());
+}
+
+bool iASpectrumBatchFitter::isValid() const
+{
+	return m_valid;
+}
+
+size_t iASpectrumBatchFitter::elementCount() const
+{
+	return m_elementCount;
+}
+
+void iASpectrumBatchFitter::fit(float const* spectra, size_t spectrumCount, double* concentrations) const
+{
+	assert(m_valid);
+	size_t const n = m_elementCount;
+	size_t const fixedCount = m_fixedPoints.size();
+	std::vector<double> fixedValues(fixedCount), rhs(n), gram, cholesky(n * n);
+	for (size_t s = 0; s < spectrumCount; ++s)
+	{
+		float const* spectrum = spectra + s * m_channelCount;
+		double* result = concentrations + s * n;
+		bool relevant = false;
+		for (size_t c = 0; c < m_channelCount && !relevant; ++c)
+		{
+			relevant = truncatedCount(spectrum[c]) > m_threshold;
+		}
+		if (!relevant)
+		{
+			std::fill(result, result + n, 0.0);
+			continue;
+		}
+		for (size_t f = 0; f < fixedCount; ++f)
+		{
+			fixedValues[f] = truncatedCount(spectrum[m_fixedPoints[f]]);
+		}
+		// right-hand side of the normal equations, X^T * y:
+		for (size_t e = 0; e < n; ++e)
+		{
+			double const* x = m_fixedElements.data() + e * fixedCount;
+			double sum = 0;
+			for (size_t f = 0; f < fixedCount; ++f)
+			{
+				sum += x[f] * fixedValues[f];
+			}
+			rhs[e] = sum;
+		}
+		// data points only considered because of the spectrum itself being above threshold there:
+		bool adapted = false;
+		for (int c : m_extraPoints)
+		{
+			double y = truncatedCount(spectrum[c]);
+			if (y <= m_threshold)
+			{
+				continue;
+			}
+			if (!adapted)
+			{
+				gram = m_gram;
+				adapted = true;
+			}
+			double const* x = m_elementCounts.data() + c * n;
+			for (size_t e1 = 0; e1 < n; ++e1)
+			{
+				rhs[e1] += x[e1] * y;
+				for (size_t e2 = 0; e2 < n; ++e2)
+				{
+					gram[e1 * n + e2] += x[e1] * x[e2];
+				}
+			}
+		}
+		if (adapted)
+		{	// adding positive semi-definite terms keeps the matrix positive definite:
+			choleskyFactorize(gram.data(), n, cholesky.data());
+		}
+		solveNonNegative(adapted ? gram : m_gram, adapted ? cholesky : m_cholesky, rhs);
+		std::copy(rhs.begin(), rhs.end(), result);
+	}
+}
+
+void iASpectrumBatchFitter::solveNonNegative(std::vector<double> const& gram, std::vector<double> const& cholesky,
+	std::vector<double>& rhs) const
+{
+	size_t const n = m_elementCount;
+	std::vector<double> x(rhs);
+	choleskySolve(cholesky.data(), n, x.data());
+	if (std::all_of(x.begin(), x.end(), [](double v) { return v >= 0; }))
+	{
+		rhs = x;
+		return;
+	}
+	// active set method by Lawson and Hanson, on the normal equations:
+	double maxRhs = 0;
+	for (double b : rhs)
+	{
+		maxRhs = std::max(maxRhs, std::abs(b));
+	}
+	double const tolerance = 1e-12 * std::max(1.0, maxRhs);
+	std::vector<char> passive(n, 0);
+	std::vector<double> z(n), subGram, subCholesky, subRhs;
+	std::vector<size_t> passiveIdx;
+	std::fill(x.begin(), x.end(), 0.0);
+	for (size_t outer = 0; outer < 3 * n; ++outer)
+	{
+		// gradient direction; the element with the largest one becomes passive (i.e., is allowed to be non-zero):
+		size_t best = n;
+		double bestW = tolerance;
+		for (size_t e = 0; e < n; ++e)
+		{
+			if (passive[e])
+			{
+				continue;
+			}
+			double w = rhs[e];
+			for (size_t e2 = 0; e2 < n; ++e2)
+			{
+				w -= gram[e * n + e2] * x[e2];
+			}
+			if (w > bestW)
+			{
+				bestW = w;
+				best = e;
+			}
+		}
+		if (best == n)
+		{
+			break;
+		}
+		passive[best] = 1;
+		for (size_t inner = 0; inner < 3 * n; ++inner)
+		{
+			// unconstrained solution for the passive elements:
+			passiveIdx.clear();
+			for (size_t e = 0; e < n; ++e)
+			{
+				if (passive[e])
+				{
+					passiveIdx.push_back(e);
+				}
+			}
+			size_t const p = passiveIdx.size();
+			subGram.resize(p * p);
+			subCholesky.assign(p * p, 0.0);
+			subRhs.resize(p);
+			for (size_t i = 0; i < p; ++i)
+			{
+				subRhs[i] = rhs[passiveIdx[i]];
+				for (size_t j = 0; j < p; ++j)
+				{
+					subGram[i * p + j] = gram[passiveIdx[i] * n + passiveIdx[j]];
+				}
+			}
+			choleskyFactorize(subGram.data(), p, subCholesky.data());
+			choleskySolve(subCholesky.data(), p, subRhs.data());
+			std::fill(z.begin(), z.end(), 0.0);
+			bool feasible = true;
+			for (size_t i = 0; i < p; ++i)
+			{
+				z[passiveIdx[i]] = subRhs[i];
+				feasible &= subRhs[i] > 0;
+			}
+			if (feasible)
+			{
+				x = z;
+				break;
+			}
+			// move from x towards z as far as possible while staying feasible:
+			double alpha = 1.0;
+			for (size_t e : passiveIdx)
+			{
+				if (z[e] <= 0)
+				{
+					alpha = std::min(alpha, x[e] / (x[e] - z[e]));
+				}
+			}
+			for (size_t e = 0; e < n; ++e)
+			{
+				x[e] += alpha * (z[e] - x[e]);
+				if (passive[e] && x[e] <= tolerance)
+				{
+					passive[e] = 0;
+					x[e] = 0;
+				}
+			}
+		}
+	}
+	rhs = x;
+}
@@ -6,6 +6,8 @@
 
 #include <QSharedPointer>
 
+#include <vector>
+
 class iAElementSpectralInfo;
 
 //! Determine the distribution of given elements in the given spectrum.
@@ -22,3 +24,44 @@ bool fitSpectrum(
 	QSharedPointer<QVector<QSharedPointer<iAEnergySpectrum> > > elements,
 	CountType threshold,
 	QVector<double> & result);
+
+//! Fits many spectra against the same element spectra, with the same result as fitSpectrum for each of them,
+//! except for the handling of negative concentrations: instead of clamping the unconstrained least-squares
+//! solution to zero, the non-negative least-squares solution is computed.
+//! The normal equations of all data points in which any element spectrum is above threshold are the same
+//! for all spectra; they are set up and factorized (Cholesky) once. For each spectrum, the right-hand side
+//! is computed as a product with the element spectra; only for spectra which are above threshold in a data
+//! point in which all element spectra are below threshold (but not all zero), the system is adapted.
+class iASpectrumBatchFitter
+{
+public:
+	//! @param elements the spectra of the elements the fitted spectra are composed of
+	//! @param threshold the minimum count to consider, see fitSpectrum
+	//! @param channelCount the number of energy channels of the spectra to fit
+	iASpectrumBatchFitter(QSharedPointer<QVector<QSharedPointer<iAEnergySpectrum> > > elements,
+		CountType threshold, size_t channelCount);
+	//! whether the fitter could be set up; if not (e.g. if the element spectra are linearly dependent
+	//! in the considered data points), fitSpectrum needs to be used instead
+	bool isValid() const;
+	size_t elementCount() const;
+	//! Fit the given spectra. Spectrum values are truncated to unsigned int as in fitSpectrum.
+	//! @param spectra the spectra to fit (spectrumCount x channelCount values, each spectrum contiguous)
+	//! @param spectrumCount the number of spectra to fit
+	//! @param concentrations storage for the result (spectrumCount x elementCount() values); a spectrum
+	//!     without any value above threshold gets all concentrations 0
+	void fit(float const* spectra, size_t spectrumCount, double* concentrations) const;
+private:
+	//! solve the normal equations (gram, rhs) with non-negativity constraints; rhs is overwritten by the result
+	void solveNonNegative(std::vector<double> const& gram, std::vector<double> const& cholesky,
+		std::vector<double>& rhs) const;
+
+	size_t m_elementCount, m_channelCount;
+	CountType m_threshold;
+	bool m_valid;
+	std::vector<int> m_fixedPoints;          //!< data points in which any element spectrum is above threshold
+	std::vector<double> m_fixedElements;     //!< element counts at the fixed data points (elementCount x fixed points)
+	std::vector<int> m_extraPoints;          //!< data points with all element counts below threshold, but not all zero
+	std::vector<double> m_elementCounts;     //!< element counts at all data points (channelCount x elementCount)
+	std::vector<double> m_gram;              //!< normal equations matrix of the fixed data points
+	std::vector<double> m_cholesky;          //!< Cholesky factor (lower triangle) of m_gram
+};
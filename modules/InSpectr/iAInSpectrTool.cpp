@@ -90,6 +90,7 @@ iAInSpectrTool::iAInSpectrTool( iAMainWindow * mainWnd, iAMdiChild * child ) : i
 				auto imgDS = dynamic_cast<iAImageData*>(ds.get());
 				dlgXRF->GetXRFData()->GetDataContainer().push_back(imgDS->vtkImage());
 			}
+			dlgXRF->GetXRFData()->UpdateSpectralCube();
 			*energyRangeStr = collection->metaData("energy_range").toString();
 		},
 		[this, energyRangeStr]() {
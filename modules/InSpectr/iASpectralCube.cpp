@@ -0,0 +1,166 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASpectralCube.h"
+
+#include <iATypedCallHelper.h>
+
+#include <vtkImageData.h>
+
+#include <QString>    // required by VTK_TYPED_CALL
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	//! number of voxels copied at once; the spectra of a block are written together to keep the writes cache-local
+	const size_t VoxelBlockSize = 256;
+
+	template <typename T>
+	void copyChannelValues(void const* scalarPtr, size_t firstVoxel, size_t endVoxel, float* dst, size_t dstStride)
+	{
+		T const* src = static_cast<T const*>(scalarPtr);
+		for (size_t v = firstVoxel; v < endVoxel; ++v)
+		{
+			dst[(v - firstVoxel) * dstStride] = static_cast<float>(src[v]);
+		}
+	}
+
+	typedef void (*CopyFunction)(void const*, size_t, size_t, float*, size_t);
+
+	template <typename T>
+	void selectCopyFunction(CopyFunction& copyFunction)
+	{
+		copyFunction = copyChannelValues<T>;
+	}
+}
+
+iASpectralCube::iASpectralCube() :
+	m_voxelCount(0),
+	m_channelCount(0),
+	m_extent{0, -1, 0, -1, 0, -1}
+{}
+
+void iASpectralCube::build(std::vector<vtkSmartPointer<vtkImageData>> const& channels, bool channelMajorMirror)
+{
+	clear();
+	if (channels.empty())
+	{
+		return;
+	}
+	channels[0]->GetExtent(m_extent);
+	m_channelCount = channels.size();
+	m_voxelCount = static_cast<size_t>(m_extent[1] - m_extent[0] + 1) *
+		(m_extent[3] - m_extent[2] + 1) * (m_extent[5] - m_extent[4] + 1);
+	// resolve the scalar types up front, so that no exception can be thrown in the parallel loops below:
+	std::vector<CopyFunction> copyFunctions(m_channelCount);
+	std::vector<void const*> scalars(m_channelCount);
+	for (size_t c = 0; c < m_channelCount; ++c)
+	{
+		assert(channels[c]->GetNumberOfScalarComponents() == 1);
+		assert(static_cast<size_t>(channels[c]->GetNumberOfPoints()) == m_voxelCount);
+		VTK_TYPED_CALL(selectCopyFunction, channels[c]->GetScalarType(), copyFunctions[c]);
+		scalars[c] = channels[c]->GetScalarPointer();
+	}
+	m_voxelMajor.resize(m_voxelCount * m_channelCount);
+	long long blockCount = static_cast<long long>((m_voxelCount + VoxelBlockSize - 1) / VoxelBlockSize);
+#pragma omp parallel for schedule(dynamic)
+	for (long long b = 0; b < blockCount; ++b)
+	{
+		size_t firstVoxel = b * VoxelBlockSize;
+		size_t endVoxel = std::min(firstVoxel + VoxelBlockSize, m_voxelCount);
+		for (size_t c = 0; c < m_channelCount; ++c)
+		{
+			copyFunctions[c](scalars[c], firstVoxel, endVoxel, m_voxelMajor.data() + firstVoxel * m_channelCount + c,
+				m_channelCount);
+		}
+	}
+	if (channelMajorMirror)
+	{
+		m_channelMajor.resize(m_voxelCount * m_channelCount);
+		long long channelCount = static_cast<long long>(m_channelCount);
+#pragma omp parallel for
+		for (long long c = 0; c < channelCount; ++c)
+		{
+			copyFunctions[c](scalars[c], 0, m_voxelCount, m_channelMajor.data() + c * m_voxelCount, 1);
+		}
+	}
+}
+
+void iASpectralCube::clear()
+{
+	m_voxelMajor.clear();
+	m_voxelMajor.shrink_to_fit();
+	m_channelMajor.clear();
+	m_channelMajor.shrink_to_fit();
+	m_voxelCount = 0;
+	m_channelCount = 0;
+}
+
+bool iASpectralCube::empty() const
+{
+	return m_voxelMajor.empty();
+}
+
+size_t iASpectralCube::voxelCount() const
+{
+	return m_voxelCount;
+}
+
+size_t iASpectralCube::channelCount() const
+{
+	return m_channelCount;
+}
+
+bool iASpectralCube::hasChannelMajorMirror() const
+{
+	return !m_channelMajor.empty();
+}
+
+int const* iASpectralCube::extent() const
+{
+	return m_extent;
+}
+
+bool iASpectralCube::contains(int x, int y, int z) const
+{
+	return x >= m_extent[0] && x <= m_extent[1] && y >= m_extent[2] && y <= m_extent[3] &&
+		z >= m_extent[4] && z <= m_extent[5];
+}
+
+size_t iASpectralCube::voxelIndex(int x, int y, int z) const
+{
+	assert(contains(x, y, z));
+	size_t width = m_extent[1] - m_extent[0] + 1;
+	size_t height = m_extent[3] - m_extent[2] + 1;
+	return (static_cast<size_t>(z - m_extent[4]) * height + (y - m_extent[2])) * width + (x - m_extent[0]);
+}
+
+iASpectrumView iASpectralCube::spectrum(size_t voxelIdx) const
+{
+	return iASpectrumView(m_voxelMajor.data() + voxelIdx * m_channelCount, m_channelCount);
+}
+
+iASpectrumView iASpectralCube::spectrum(int x, int y, int z) const
+{
+	return spectrum(voxelIndex(x, y, z));
+}
+
+iASpectrumView iASpectralCube::channel(size_t channelIdx) const
+{
+	if (hasChannelMajorMirror())
+	{
+		return iASpectrumView(m_channelMajor.data() + channelIdx * m_voxelCount, m_voxelCount);
+	}
+	return iASpectrumView(m_voxelMajor.data() + channelIdx, m_voxelCount, m_channelCount);
+}
+
+iASpectralCube::ValueType iASpectralCube::value(size_t voxelIdx, size_t channelIdx) const
+{
+	return m_voxelMajor[voxelIdx * m_channelCount + channelIdx];
+}
+
+iASpectralCube::ValueType const* iASpectralCube::data() const
+{
+	return m_voxelMajor.data();
+}
@@ -0,0 +1,83 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <vtkSmartPointer.h>
+
+#include <cstddef>    // for size_t
+#include <vector>
+
+class vtkImageData;
+
+//! Lightweight, non-owning view on a sequence of values in an iASpectralCube,
+//! e.g. the spectrum of one voxel, or the counts of one energy channel for all voxels.
+//! Only valid as long as the cube it was taken from is not modified or destroyed.
+class iASpectrumView
+{
+public:
+	typedef float ValueType;
+	iASpectrumView(ValueType const* data, size_t size, size_t stride = 1) :
+		m_data(data), m_size(size), m_stride(stride)
+	{}
+	size_t size() const
+	{
+		return m_size;
+	}
+	ValueType operator[](size_t idx) const
+	{
+		return m_data[idx * m_stride];
+	}
+	//! whether the values are stored contiguously (i.e. data() can be used to iterate over them)
+	bool contiguous() const
+	{
+		return m_stride == 1;
+	}
+	ValueType const* data() const
+	{
+		return m_data;
+	}
+private:
+	ValueType const* m_data;
+	size_t m_size;
+	size_t m_stride;
+};
+
+//! Contiguous copy of spectral data given as one image per energy channel.
+//! Values are stored voxel-major (i.e. the spectrum of each voxel is contiguous in memory);
+//! optionally, a channel-major mirror is kept, in which the values of each channel are contiguous.
+//! Voxels are indexed in the same order as the scalars of a vtkImageData (x fastest, then y, then z).
+class iASpectralCube
+{
+public:
+	typedef iASpectrumView::ValueType ValueType;
+	iASpectralCube();
+	//! Copy the values of the given channel images into the cube, which are required to have a single
+	//! component and the same extent.
+	//! @param channels one image per energy channel
+	//! @param channelMajorMirror whether to additionally store the values in channel-major order
+	void build(std::vector<vtkSmartPointer<vtkImageData>> const& channels, bool channelMajorMirror = false);
+	void clear();
+	bool empty() const;
+	size_t voxelCount() const;
+	size_t channelCount() const;
+	bool hasChannelMajorMirror() const;
+	//! the extent of the images the cube was built from
+	int const* extent() const;
+	//! whether the given coordinates lie inside the extent
+	bool contains(int x, int y, int z) const;
+	//! linear index of the voxel at the given coordinates (which need to lie inside the extent)
+	size_t voxelIndex(int x, int y, int z) const;
+	//! the spectrum of the voxel with the given linear index
+	iASpectrumView spectrum(size_t voxelIdx) const;
+	iASpectrumView spectrum(int x, int y, int z) const;
+	//! the values of the given channel for all voxels (contiguous if a channel-major mirror is available)
+	iASpectrumView channel(size_t channelIdx) const;
+	ValueType value(size_t voxelIdx, size_t channelIdx) const;
+	//! the voxel-major values (voxelCount() x channelCount())
+	ValueType const* data() const;
+private:
+	std::vector<ValueType> m_voxelMajor;
+	std::vector<ValueType> m_channelMajor;
+	size_t m_voxelCount, m_channelCount;
+	int m_extent[6];
+};
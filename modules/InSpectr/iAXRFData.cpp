@@ -211,25 +211,17 @@ vtkSmartPointer<vtkDiscretizableColorTransferFunction> iAXRFData::GetColorTransf
 	return m_colorTransfer;
 }
 
-template <typename T>
-void isInRange(void* data, double const & minVal, double const & maxVal, bool & inRange)
-{
-	T value = *static_cast<char*>(data);
-	inRange = (value >= minVal && value <= maxVal);
-}
-
-bool isInRange(vtkSmartPointer<vtkImageData> const & img, int x, int y, int z, double const & minVal, double const & maxVal)
+bool iAXRFData::CheckFilters(int x, int y, int z, QVector<iASpectrumFilter> const & filter, iAFilterMode mode) const
 {
-	bool inRange = false;
-	VTK_TYPED_CALL(isInRange, img->GetScalarType(), img->GetScalarPointer(x, y, z), minVal, maxVal, inRange);
-	return inRange;
+	return CheckFilters(m_spectralCube.spectrum(x, y, z), filter, mode);
 }
 
-bool iAXRFData::CheckFilters(int x, int y, int z, QVector<iASpectrumFilter> const & filter, iAFilterMode mode) const
+bool iAXRFData::CheckFilters(iASpectrumView const & spectrum, QVector<iASpectrumFilter> const & filter, iAFilterMode mode)
 {
 	for (QVector<iASpectrumFilter>::const_iterator it = filter.begin(); it != filter.end(); ++it)
 	{
-		bool inRange = isInRange(m_data[it->binIdx], x, y, z, it->minVal, it->maxVal);
+		double value = spectrum[it->binIdx];
+		bool inRange = (value >= it->minVal && value <= it->maxVal);
 		switch (mode)
 		{
 			case filter_AND: if (!inRange) { return 0; } break;
@@ -257,16 +249,12 @@ vtkSmartPointer<vtkImageData> iAXRFData::FilterSpectrum(QVector<iASpectrumFilter
 	result->SetSpacing(spacing);
 	result->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
 
+	unsigned char* mask = static_cast<unsigned char*>(result->GetScalarPointer());
+	long long voxelCount = static_cast<long long>(m_spectralCube.voxelCount());
 #pragma omp parallel for
-	for (int x=extent[0]; x<=extent[1]; ++x)
+	for (long long v = 0; v < voxelCount; ++v)
 	{
-		for (int y=extent[2]; y<=extent[3]; ++y)
-		{
-			for (int z=extent[4]; z<=extent[5]; ++z)
-			{
-				*(static_cast<unsigned char*>(result->GetScalarPointer(x, y, z))) = CheckFilters(x, y, z, filter, mode) ? 1 : 0;
-			}
-		}
+		mask[v] = CheckFilters(m_spectralCube.spectrum(v), filter, mode) ? 1 : 0;
 	}
 	return result;
 }
@@ -287,3 +275,13 @@ double iAXRFData::GetMaxEnergy() const
 {
 	return m_maxEnergy;
 }
+
+void iAXRFData::UpdateSpectralCube(bool channelMajorMirror)
+{
+	m_spectralCube.build(m_data, channelMajorMirror);
+}
+
+iASpectralCube const & iAXRFData::SpectralCube() const
+{
+	return m_spectralCube;
+}
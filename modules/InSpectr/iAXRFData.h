@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #pragma once
 
+#include "iASpectralCube.h"
+
 #include <vtkSmartPointer.h>
 
 #include <QObject>
@@ -41,6 +43,7 @@ public:
 	//! the [min,max] interval specified in the filter
 	vtkSmartPointer<vtkImageData> FilterSpectrum(QVector<iASpectrumFilter> const & filter, iAFilterMode mode);
 	bool CheckFilters(int x, int y, int z, QVector<iASpectrumFilter> const & filter, iAFilterMode mode) const;
+	static bool CheckFilters(iASpectrumView const & spectrum, QVector<iASpectrumFilter> const & filter, iAFilterMode mode);
 
 	void SetColorTransferFunction(vtkSmartPointer<vtkDiscretizableColorTransferFunction> ctf);
 	void SetCombinedImage(vtkSmartPointer<vtkImageData> combinedVolume);
@@ -48,8 +51,15 @@ public:
 	void SetEnergyRange(double minEnergy, double maxEnergy);
 	double GetMinEnergy() const;
 	double GetMaxEnergy() const;
+
+	//! (re-)build the spectral cube from the current channel images; needs to be called after modifying the
+	//! data container, before any of the spectrum-based functionality is used
+	void UpdateSpectralCube(bool channelMajorMirror = false);
+	//! contiguous copy of all channel images, for fast access to the spectra of single voxels
+	iASpectralCube const & SpectralCube() const;
 private:
 	Container m_data;
+	iASpectralCube m_spectralCube;
 	vtkSmartPointer<vtkImageData> m_combinedVolume;
 	vtkSmartPointer<vtkDiscretizableColorTransferFunction> m_colorTransfer;
 	double m_minEnergy, m_maxEnergy;
@@ -8,6 +8,7 @@
 // base
 #include <iAAttributeDescriptor.h>
 #include <iAConnector.h>
+#include <iADataSet.h>
 #include <iAFileUtils.h>
 #include <iAFilterDefault.h>
 #include <iAFilterRegistry.h>
@@ -15,10 +16,175 @@
 #include <iAProgress.h>
 #include <iAStringHelper.h>
 
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+#include <QScopeGuard>
 #include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+
+namespace
+{
+	//! A file passing through the stages of the batch pipeline.
+	struct iABatchJob
+	{
+		size_t index = 0;                                  //!< index of the file in the list of files to process
+		std::shared_ptr<iADataSet> input;                  //!< the loaded input (empty for folders / filters without image input)
+		std::vector<std::shared_ptr<iADataSet>> outputs;   //!< the outputs produced by the filter
+		qint64 memory = 0;                                 //!< memory reserved for this job in the memory budget, in bytes
+	};
+
+	//! Bounded, thread-safe FIFO queue connecting two stages of the batch pipeline.
+	//! pop blocks until an item is available, or until all producers have called producerDone.
+	template <typename T>
+	class iABoundedQueue
+	{
+	public:
+		iABoundedQueue(size_t capacity, int producers) :
+			m_capacity(std::max(static_cast<size_t>(1), capacity)), m_producers(producers), m_cancelled(false)
+		{}
+		//! Add an item, blocks while the queue is full. Returns false if the queue was cancelled.
+		bool push(T&& item)
+		{
+			QMutexLocker lock(&m_mutex);
+			while (m_items.size() >= m_capacity && !m_cancelled)
+			{
+				m_notFull.wait(&m_mutex);
+			}
+			if (m_cancelled)
+			{
+				return false;
+			}
+			m_items.push_back(std::move(item));
+			m_notEmpty.wakeOne();
+			return true;
+		}
+		//! Take the next item, blocks while the queue is empty.
+		//! Returns false if all producers are done and the queue is drained, or if the queue was cancelled.
+		bool pop(T& item)
+		{
+			QMutexLocker lock(&m_mutex);
+			while (m_items.empty() && m_producers > 0 && !m_cancelled)
+			{
+				m_notEmpty.wait(&m_mutex);
+			}
+			if (m_items.empty() || m_cancelled)
+			{
+				return false;
+			}
+			item = std::move(m_items.front());
+			m_items.pop_front();
+			m_notFull.wakeOne();
+			return true;
+		}
+		//! Called by each producer when it will not push any more items.
+		void producerDone()
+		{
+			QMutexLocker lock(&m_mutex);
+			--m_producers;
+			m_notEmpty.wakeAll();
+		}
+		//! Drop all items and wake up all waiting threads (on abort / error).
+		void cancel()
+		{
+			QMutexLocker lock(&m_mutex);
+			m_cancelled = true;
+			m_items.clear();
+			m_notEmpty.wakeAll();
+			m_notFull.wakeAll();
+		}
+	private:
+		QMutex m_mutex;
+		QWaitCondition m_notEmpty, m_notFull;
+		std::deque<T> m_items;
+		size_t m_capacity;
+		int m_producers;
+		bool m_cancelled;
+	};
+
+	//! Limits the amount of memory held by datasets in flight in the batch pipeline.
+	//! A reservation is always granted if nothing else is reserved, so a single dataset
+	//! larger than the budget does not stall the pipeline.
+	class iAMemoryBudget
+	{
+	public:
+		//! @param limit the budget in bytes; 0 means unlimited
+		iAMemoryBudget(qint64 limit) : m_limit(limit), m_used(0), m_cancelled(false)
+		{}
+		//! Reserve the given amount of memory, blocks until it is available.
+		void acquire(qint64 bytes)
+		{
+			QMutexLocker lock(&m_mutex);
+			while (m_limit > 0 && m_used > 0 && m_used + bytes > m_limit && !m_cancelled)
+			{
+				m_released.wait(&m_mutex);
+			}
+			m_used += bytes;
+		}
+		//! Reserve additional memory for a job that is already in flight, never blocks.
+		void add(qint64 bytes)
+		{
+			QMutexLocker lock(&m_mutex);
+			m_used += bytes;
+		}
+		void release(qint64 bytes)
+		{
+			QMutexLocker lock(&m_mutex);
+			m_used -= bytes;
+			m_released.wakeAll();
+		}
+		void cancel()
+		{
+			QMutexLocker lock(&m_mutex);
+			m_cancelled = true;
+			m_released.wakeAll();
+		}
+	private:
+		QMutex m_mutex;
+		QWaitCondition m_released;
+		qint64 m_limit, m_used;
+		bool m_cancelled;
+	};
+
+	qint64 dataSetMemory(std::shared_ptr<iADataSet> dataSet)
+	{
+		if (auto imgData = dynamic_cast<iAImageData*>(dataSet.get()))
+		{
+			return static_cast<qint64>(imgData->vtkImage()->GetActualMemorySize()) * 1024;
+		}
+		if (auto collection = dynamic_cast<iADataCollection*>(dataSet.get()))
+		{
+			qint64 result = 0;
+			for (auto d : collection->dataSets())
+			{
+				result += dataSetMemory(d);
+			}
+			return result;
+		}
+		return 0;
+	}
+
+	//! Output values of a single processed file.
+	struct iABatchResult
+	{
+		bool done = false;         //!< whether the filter was successfully run on this file
+		QStringList captions;      //!< names of the output values
+		QStringList values;        //!< output values (including file name if requested)
+	};
+}
 
 IAFILTER_DEFAULT_CLASS(iABatchFilter)
 
@@ -60,7 +226,20 @@ iABatchFilter::iABatchFilter():
 		"in case there is an error. If it is disabled, an error will interrupt the whole batch run. "
 		"Under <em>Work on</em> it can be specified whether the batched filter should get passed "
 		"only files, only folders, or both files and folders."
-		"<em>Output format</em> specifies the file format for the output image(s)."
+		"<em>Output format</em> specifies the file format for the output image(s).<br/>"
+		"Files are processed in a pipeline: <em>Loader threads</em> threads load the input files, "
+		"<em>Concurrent filters</em> instances of the filter process them in parallel "
+		"(0 means to use as many as there are processor cores), and the outputs are written "
+		"as soon as they are available. The <em>Memory budget (MB)</em> limits the amount of memory "
+		"held by loaded inputs and not yet written outputs (0 means unlimited); loading is paused "
+		"while the budget is exhausted. Rows in the output csv file are always in the order of the "
+		"processed files, independent of the order in which the files finish processing.<br/>"
+		"If <em>Skip existing</em> is enabled, files for which all outputs already exist are not processed again, "
+		"e.g. when restarting an interrupted batch run; the outputs of a file are considered to exist if all "
+		"its output images exist (with the names they would get without overwrite suffix), and if the "
+		"output csv file contains a row for it (this requires <em>Add filename</em>). "
+		"The existing output csv file is then taken as output of the interrupted run, i.e. its rows are kept "
+		"instead of appended to, and it is also written if the batch run is aborted or stopped by an error."
 		).arg(spnContinueOnError), 0, 0, true)
 {
 	QStringList filesFoldersBoth;
@@ -84,6 +263,10 @@ iABatchFilter::iABatchFilter():
 	outputFormat << "Same as input"
 		<< "MetaImage (*.mhd)";
 	addParameter("Output format", iAValueType::Categorical, outputFormat);
+	addParameter("Concurrent filters", iAValueType::Discrete, 1, 0);
+	addParameter("Loader threads", iAValueType::Discrete, 1, 1);
+	addParameter("Memory budget (MB)", iAValueType::Discrete, 4096, 0);
+	addParameter("Skip existing", iAValueType::Boolean, false);
 }
 
 void iABatchFilter::performWork(QVariantMap const & parameters)
@@ -125,8 +308,18 @@ void iABatchFilter::performWork(QVariantMap const & parameters)
 	}
 
 	QString outputFile = parameters["Output csv file"].toString();
+	bool addFileName = parameters["Add filename"].toBool();
+	bool skipExisting = parameters["Skip existing"].toBool();
+	if (skipExisting && !outputFile.isEmpty() && !addFileName)
+	{
+		addMsg("Batch: 'Skip existing' requires 'Add filename' to be enabled if an output csv file is given, "
+			"otherwise the rows of the existing output csv file cannot be assigned to the processed files!");
+		return;
+	}
 	QStringList outputBuffer;
-	if (parameters["Append to output"].toBool() && QFile(outputFile).exists())
+	QString previousHeader;
+	QMap<QString, QString> previousRows;    // for "Skip existing": rows of the existing csv, by relative file name
+	if ((parameters["Append to output"].toBool() || skipExisting) && QFile(outputFile).exists())
 	{
 		QFile file(outputFile);
 		if (file.open(QIODevice::ReadOnly | QIODevice::Text))
@@ -138,6 +331,15 @@ void iABatchFilter::performWork(QVariantMap const & parameters)
 			}
 			file.close();
 		}
+		if (skipExisting)
+		{
+			for (int l = 1; l < outputBuffer.size(); ++l)
+			{
+				previousRows.insert(outputBuffer[l].section(",", 0, 0), outputBuffer[l]);
+			}
+			previousHeader = outputBuffer.empty() ? QString() : outputBuffer[0];
+			outputBuffer.clear();
+		}
 	}
 	filter->setLogger(logger());
 
@@ -184,150 +386,352 @@ void iABatchFilter::performWork(QVariantMap const & parameters)
 	QString outSuffix = parameters["Output suffix"].toString();
 	bool overwrite = parameters[spnOverwriteOutput].toBool();
 	bool useCompression = parameters[spnCompressOutput].toBool();
-	int curLine = 0;
-	for (QString fileName : files)
+	bool continueOnError = parameters[spnContinueOnError].toBool();
+	bool metaImageOutput = parameters["Output format"].toString().contains("MetaImage");
+
+	// name of the output image with the given index; overwriteSuffix < 0 means no overwrite suffix
+	auto outputName = [&](QString const& fileName, size_t o, size_t outputCount, int overwriteSuffix)
 	{
-		progress()->setStatus(QString("Processing file %1...").arg(fileName));
-		try
+		QFileInfo fi(outDir + "/" + MakeRelative(batchDir, fileName));
+		QString multiFileSuffix = outputCount > 1 ? QString::number(o) : "";
+		return QString("%1/%2%3%4%5.%6").arg(fi.absolutePath())
+			.arg(metaImageOutput ? fi.fileName() : fi.baseName())
+			.arg(outSuffix).arg(multiFileSuffix)
+			.arg(overwriteSuffix < 0 ? QString() : QString("-%1").arg(overwriteSuffix))
+			.arg(metaImageOutput ? "mhd" : fi.completeSuffix());
+	};
+
+	// determine which files still need processing:
+	std::vector<size_t> toProcess;
+	for (int i = 0; i < files.size(); ++i)
+	{
+		if (skipExisting)
+		{
+			size_t outputCount = filter->plannedOutputCount();
+			bool allExist = outputCount > 0 || !outputFile.isEmpty();
+			for (size_t o = 0; o < outputCount && allExist; ++o)
+			{
+				allExist = QFile::exists(outputName(files[i], o, outputCount, -1));
+			}
+			if (allExist && (outputFile.isEmpty() || previousRows.contains(MakeRelative(batchDir, files[i]))))
+			{
+				continue;
+			}
+		}
+		toProcess.push_back(i);
+	}
+	if (skipExisting)
+	{
+		LOG(lvlInfo, QString("Batch: Skipping %1 of %2 files, since their outputs already exist.")
+			.arg(files.size() - toProcess.size()).arg(files.size()));
+	}
+
+	int numFilters = parameters["Concurrent filters"].toInt();
+	if (numFilters <= 0)
+	{
+		numFilters = std::max(1, QThread::idealThreadCount());
+	}
+	bool allImages = std::all_of(inputImages.begin(), inputImages.end(),
+		[](std::shared_ptr<iADataSet> const& d) { return dynamic_cast<iAImageData*>(d.get()) != nullptr; });
+	if (!allImages && numFilters > 1)
+	{
+		LOG(lvlInfo, "Batch: Additional input contains datasets other than images, which cannot be copied for concurrent filters; "
+			"running only one filter at a time.");
+		numFilters = 1;
+	}
+	int numLoaders = std::max(1, parameters["Loader threads"].toInt());
+	// one filter instance per filter stage worker, since filters store their in- and outputs; also, each worker gets
+	// its own copy of the additional input images, since filters update the pipeline state (e.g. the requested
+	// region) of their inputs. The copies are shallow, i.e. separate image objects sharing the same voxel buffer:
+	std::vector<std::shared_ptr<iAFilter>> workerFilters(numFilters);
+	std::vector<std::vector<std::shared_ptr<iADataSet>>> workerInputs(numFilters);
+	for (int t = 0; t < numFilters; ++t)
+	{
+		workerFilters[t] = (t == 0) ? filter : iAFilterRegistry::filter(parameters[spnFilter].toString());
+		workerFilters[t]->setLogger(logger());
+		for (auto const& dataSet : inputImages)
+		{
+			if (t == 0)
+			{
+				workerInputs[t].push_back(dataSet);
+				continue;
+			}
+			auto img = vtkSmartPointer<vtkImageData>::New();
+			img->ShallowCopy(dynamic_cast<iAImageData*>(dataSet.get())->vtkImage());
+			workerInputs[t].push_back(std::make_shared<iAImageData>(img));
+		}
+	}
+
+	iAMemoryBudget memoryBudget(parameters["Memory budget (MB)"].toLongLong() * 1024 * 1024);
+	iABoundedQueue<iABatchJob> loadedQueue(numFilters, numLoaders);   // loader stage -> filter stage
+	iABoundedQueue<iABatchJob> filteredQueue(numFilters, numFilters); // filter stage -> writer stage
+	std::vector<iABatchResult> results(files.size());
+	std::atomic<size_t> nextLoad(0);
+	std::atomic<bool> stopped(false);
+	std::exception_ptr error;
+	QMutex errorMutex;
+	auto stop = [&]()
+	{
+		stopped = true;
+		loadedQueue.cancel();
+		filteredQueue.cancel();
+		memoryBudget.cancel();
+	};
+	// must be called from within a catch block, since it stores the currently handled exception:
+	auto handleError = [&](size_t idx, QString const& what)
+	{
+		LOG(lvlError, QString("Batch processing: Error while processing file '%1': %2").arg(files[idx]).arg(what));
+		if (!continueOnError)
 		{
-			filter->clearInput();
-			if (QFileInfo(fileName).isDir())
+			QMutexLocker lock(&errorMutex);
+			if (!error)
 			{
-				filterParams["Folder name"] = fileName;
+				error = std::current_exception();
 			}
-			else
+			stop();
+		}
+	};
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(numLoaders + numFilters);
+	// loader stage:
+	for (int l = 0; l < numLoaders; ++l)
+	{
+		pool.start([&]()
+		{
+			// the filter stage must learn that this loader is done on every exit path, otherwise it waits forever:
+			auto done = qScopeGuard([&loadedQueue] { loadedQueue.producerDone(); });
+			for (size_t t = nextLoad++; t < toProcess.size() && !stopped && !isAborted(); t = nextLoad++)
 			{
-				if (filter->requiredImages() > 0)
+				iABatchJob job;
+				job.index = toProcess[t];
+				QString fileName = files[job.index];
+				try
 				{
-					auto io = iAFileTypeRegistry::createIO(fileName, iAFileIO::Load);
-					QVariantMap dummyParams;    // TODO: CHECK whether I/O requires other parameters and error in that case!
-					auto dataSet = io->load(fileName, dummyParams);
-					filter->addInput(dataSet);
-					for (size_t i = 0; i < inputImages.size(); ++i)
+					if (!QFileInfo(fileName).isDir() && filter->requiredImages() > 0)
 					{
-						filter->addInput(inputImages[i]);
+						auto io = iAFileTypeRegistry::createIO(fileName, iAFileIO::Load);
+						QVariantMap dummyParams;    // TODO: CHECK whether I/O requires other parameters and error in that case!
+						job.input = io->load(fileName, dummyParams);
+						job.memory = dataSetMemory(job.input);
 					}
 				}
-				/*
-				// attempt to make input filename accessible to filter,
-				// in order for filters to be able to deduce their output names automatically
-				// -> now rather FileNameSave parameters get set by Batch and Sample filters!
-				for (int i = 0; i < inputImages.size(); ++i)
+				catch (std::exception& e)
 				{
-					filterParams[QString("Input file %1").arg(i)] = fileName;
+					handleError(job.index, e.what());
+					continue;
+				}
+				catch (...)
+				{
+					handleError(job.index, "Unknown error");
+					continue;
+				}
+				memoryBudget.acquire(job.memory);
+				if (!loadedQueue.push(std::move(job)))
+				{
+					break;
 				}
-				*/
 			}
-			for (auto const& param: filter->parameters())
+		});
+	}
+	// filter stage:
+	for (int f = 0; f < numFilters; ++f)
+	{
+		auto workerFilter = workerFilters[f];
+		pool.start([&, workerFilter, f]()
+		{
+			// the writer stage must learn that this filter is done on every exit path, otherwise it waits forever:
+			auto done = qScopeGuard([&filteredQueue] { filteredQueue.producerDone(); });
+			iABatchJob job;
+			while (loadedQueue.pop(job))
 			{
-				if (param->valueType() == iAValueType::FileNameSave)
-				{	// all output file names need to be adapted to output file name;
-					// merge with code in iASampleBuiltInFilterOperation?
-					auto value = pathFileBaseName(QFileInfo(fileName)) + param->defaultValue().toString();
-					if (QFile::exists(value) && !overwrite)
+				QString fileName = files[job.index];
+				progress()->setStatus(QString("Processing file %1...").arg(fileName));
+				try
+				{
+					workerFilter->clearInput();
+					QVariantMap jobParams(filterParams);
+					if (QFileInfo(fileName).isDir())
+					{
+						jobParams["Folder name"] = fileName;
+					}
+					else if (filter->requiredImages() > 0)
 					{
-						LOG(lvlError, QString("Output file '%1' already exists! Aborting. "
-							"Check '%2' to overwrite existing files.").arg(value).arg(spnOverwriteOutput));
-						return;
+						workerFilter->addInput(job.input);
+						for (auto const& additionalInput : workerInputs[f])
+						{
+							workerFilter->addInput(additionalInput);
+						}
+					}
+					for (auto const& param : workerFilter->parameters())
+					{
+						if (param->valueType() == iAValueType::FileNameSave)
+						{	// all output file names need to be adapted to output file name;
+							// merge with code in iASampleBuiltInFilterOperation?
+							auto value = pathFileBaseName(QFileInfo(fileName)) + param->defaultValue().toString();
+							if (QFile::exists(value) && !overwrite)
+							{
+								throw std::runtime_error(QString("Output file '%1' already exists! "
+									"Check '%2' to overwrite existing files.").arg(value).arg(spnOverwriteOutput).toStdString());
+							}
+							jobParams[param->name()] = value;
+						}
+					}
+					workerFilter->run(jobParams);
+					auto& result = results[job.index];
+					if (addFileName)
+					{
+						result.captions << "filename";
+						result.values << MakeRelative(batchDir, fileName);
+					}
+					for (auto outValue : workerFilter->outputValues())
+					{
+						QString curCap(outValue.first);
+						curCap.replace(",", "");
+						result.captions << curCap;
+						result.values << outValue.second.toString();
+					}
+					result.done = true;
+					job.outputs = workerFilter->outputs();
+					for (auto const& o : job.outputs)
+					{
+						qint64 outMem = dataSetMemory(o);
+						memoryBudget.add(outMem);
+						job.memory += outMem;
 					}
-					filterParams[param->name()] = value;
 				}
-			}
-			filter->run(filterParams);
-			if (curLine == 0)
-			{
-				QStringList captions;
-				if (parameters["Add filename"].toBool())
+				catch (std::exception& e)
 				{
-					captions << "filename";
+					memoryBudget.release(job.memory);
+					handleError(job.index, e.what());
+					continue;
 				}
-				for (auto outValue : filter->outputValues())
+				catch (...)
 				{
-					QString curCap(outValue.first);
-					curCap.replace(",", "");
-					captions << curCap;
+					memoryBudget.release(job.memory);
+					handleError(job.index, "Unknown error");
+					continue;
 				}
-				if (outputBuffer.empty())
+				// drop the reference to the input, so that its memory can be freed:
+				workerFilter->clearInput();
+				job.input.reset();
+				if (!filteredQueue.push(std::move(job)))
 				{
-					outputBuffer.append("");
+					break;
 				}
-				outputBuffer[0] += (outputBuffer[0].isEmpty() || captions.empty() ? "" : ",") + captions.join(",");
-				++curLine;
 			}
-			if (curLine >= outputBuffer.size())
-			{
-				outputBuffer.append("");
-			}
-			QStringList values;
-			QString relFileName = MakeRelative(batchDir, fileName);
-			if (parameters["Add filename"].toBool())
-			{
-				values << relFileName;
-			}
-			for (auto outValue : filter->outputValues())
-			{
-				values.append(outValue.second.toString());
-			}
-			QString textToAdd = (outputBuffer[curLine].isEmpty() || values.empty() ? "" : ",") + values.join(",");
-			outputBuffer[curLine] += textToAdd;
-			++curLine;
-			for (size_t o = 0; o < filter->finalOutputCount(); ++o)
+		});
+	}
+	// writer stage, runs in this thread:
+	size_t finished = files.size() - toProcess.size();
+	iABatchJob job;
+	while (filteredQueue.pop(job))
+	{
+		QString fileName = files[job.index];
+		try
+		{
+			for (size_t o = 0; o < job.outputs.size(); ++o)
 			{
-				QFileInfo fi(outDir + "/" + relFileName);
-				QString multiFileSuffix = filter->finalOutputCount() > 1 ? QString::number(o) : "";
-				QString outName = QString("%1/%2%3%4.%5").arg(fi.absolutePath()).arg(
-					parameters["Output format"].toString().contains("MetaImage") ? fi.fileName() : fi.baseName())
-					.arg(outSuffix).arg(multiFileSuffix).arg(
-						parameters["Output format"].toString().contains("MetaImage")? "mhd" :	fi.completeSuffix());
+				QString outName = outputName(fileName, o, job.outputs.size(), -1);
 				int overwriteSuffix = 0;
 				while (!overwrite && QFile(outName).exists())
 				{
-					outName = QString("%1/%2%3%4-%5.%6").arg(fi.absolutePath()).arg(
-						parameters["Output format"].toString().contains("MetaImage") ? fi.fileName() : fi.baseName())
-						.arg(outSuffix).arg(multiFileSuffix).arg(overwriteSuffix).arg(
-							parameters["Output format"].toString().contains("MetaImage") ? "mhd" :	fi.completeSuffix());
+					outName = outputName(fileName, o, job.outputs.size(), overwriteSuffix);
 					++overwriteSuffix;
 				}
-				if (!QDir(fi.absolutePath()).exists() && !QDir(fi.absolutePath()).mkpath("."))
+				QString outPath = QFileInfo(outName).absolutePath();
+				if (!QDir(outPath).exists() && !QDir(outPath).mkpath("."))
 				{
 					addMsg(QString("Error creating output directory %1, skipping writing output file %2")
-						.arg(fi.absolutePath()).arg(outName));
+						.arg(outPath).arg(outName));
 				}
 				else
 				{
 					auto io = iAFileTypeRegistry::createIO(fileName, iAFileIO::Save);
 					QVariantMap writeParamValues;    // TODO: CHECK whether I/O requires other parameters and error in that case!
 					writeParamValues[iAFileIO::CompressionStr] = useCompression;
-					io->save(outName, filter->output(o), writeParamValues);
+					io->save(outName, job.outputs[o], writeParamValues);
 				}
 			}
 		}
-		catch (std::exception & e)
+		catch (std::exception& e)
 		{
-			LOG(lvlError, QString("Batch processing: Error while processing file '%1': %2").arg(fileName).arg(e.what()));
-			if (!parameters["Continue on error"].toBool())
-			{
-				throw;
-			}
+			handleError(job.index, e.what());
+		}
+		catch (...)
+		{
+			handleError(job.index, "Unknown error");
 		}
-		progress()->emitProgress( (curLine - 1.0) * 100.0 / files.size() );
+		job.outputs.clear();
+		memoryBudget.release(job.memory);
+		++finished;
+		progress()->emitProgress(finished * 100.0 / files.size());
 		if (isAborted())
 		{
-			break;
+			stop();
 		}
 	}
+	pool.waitForDone();
 
-	if (!isAborted() && !outputFile.isEmpty())
+	// assemble csv, rows in the order of the files:
+	if (outputFile.isEmpty() || ((isAborted() || error) && !skipExisting))
 	{
-		QFile file(outputFile);
-		if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+		if (error)
 		{
-			QTextStream textStream(&file);
-			for (QString line : outputBuffer)
+			std::rethrow_exception(error);
+		}
+		return;
+	}
+	auto firstDone = std::find_if(results.begin(), results.end(), [](iABatchResult const& r) { return r.done; });
+	if (skipExisting)
+	{
+		outputBuffer.append(firstDone != results.end() ? firstDone->captions.join(",") : previousHeader);
+		for (int i = 0; i < files.size(); ++i)
+		{
+			if (results[i].done)
 			{
-				textStream << line << Qt::endl;
+				outputBuffer.append(results[i].values.join(","));
+			}
+			else if (previousRows.contains(MakeRelative(batchDir, files[i])))
+			{
+				outputBuffer.append(previousRows[MakeRelative(batchDir, files[i])]);
 			}
-			file.close();
 		}
 	}
+	else if (firstDone != results.end())
+	{
+		if (outputBuffer.empty())
+		{
+			outputBuffer.append("");
+		}
+		outputBuffer[0] += (outputBuffer[0].isEmpty() || firstDone->captions.empty() ? "" : ",") + firstDone->captions.join(",");
+		int curLine = 1;
+		for (auto const& result : results)
+		{
+			if (!result.done)
+			{
+				continue;
+			}
+			if (curLine >= outputBuffer.size())
+			{
+				outputBuffer.append("");
+			}
+			outputBuffer[curLine] += (outputBuffer[curLine].isEmpty() || result.values.empty() ? "" : ",") + result.values.join(",");
+			++curLine;
+		}
+	}
+	QFile file(outputFile);
+	if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		QTextStream textStream(&file);
+		for (QString line : outputBuffer)
+		{
+			textStream << line << Qt::endl;
+		}
+		file.close();
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
 }
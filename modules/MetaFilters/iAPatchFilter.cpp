@@ -23,6 +23,10 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QTextStream>
+#include <QThread>
+
+#include <atomic>
+#include <exception>
 
 IAFILTER_DEFAULT_CLASS(iAPatchFilter)
 
@@ -103,9 +107,6 @@ namespace
 				inputImages.push_back(dataSet);
 			}
 		}
-		QStringList outputBuffer;
-
-		int curOp = 0;
 		size_t patchSize[3] = {
 			parameters["Patch size X"].toULongLong(),
 			parameters["Patch size Y"].toULongLong(),
@@ -125,142 +126,225 @@ namespace
 			outputSpacing[i] = inputSpacing[i] * stepSize[i];
 			patchSizeHalf[i] = patchSize[i] / 2;
 		}
-		int totalOps = blockCount[0] * blockCount[1] * blockCount[2];
 		bool center = parameters["Center patch"].toBool();
 		bool doImage = parameters["Write output value image"].toBool();
 		bool compress = parameters[spnCompressOutput].toBool();
 		bool overwrite = parameters[spnOverwriteOutput].toBool();
 		bool continueOnError = parameters[spnContinueOnError].toBool();
+		QFileInfo outBaseFI(parameters["Output image base name"].toString());
 		QVector<iAITKIO::ImagePointer> outputImages;
+		std::vector<double*> outputBuffers;
 		QStringList outputNames;
 		if (doImage)
 		{
 			while (outputImages.size() < filter->outputValueNames().size())
 			{
 				outputImages.push_back(allocateImage(blockCount, outputSpacing, iAITKIO::ScalarType::DOUBLE));
+				outputBuffers.push_back(dynamic_cast<OutputImageType*>(outputImages.back().GetPointer())->GetBufferPointer());
 				outputNames << filter->outputValueNames()[outputImages.size() - 1];
 			}
 		}
-		filter->setLogger(patchFilter->logger());
-		// iterate over all patches:
-		itk::Index<DIM> outIdx; outIdx[0] = 0;
-		for (size_t x = 0; x < size[0] && !patchFilter->isAborted(); x += stepSize[0])
+		// collect all patches to process:
+		struct iAPatch
+		{
+			size_t pos[3], extractIndex[3], extractSize[3];
+			size_t outOffset;    //!< offset of the output value of this patch in the output images
+		};
+		std::vector<iAPatch> patches;
+		for (size_t x = 0, outX = 0; x < size[0]; x += stepSize[0], ++outX)
 		{
-			outIdx[1] = 0;
-			size_t extractIndex[3], extractSize[3];
-			extractIndex[0] = getLeft(x, patchSizeHalf[0], center);
-			extractSize[0] = getSize(x, extractIndex[0], size[0], patchSizeHalf[0], patchSize[0], center);
-			for (size_t y = 0; y < size[1] && !patchFilter->isAborted(); y += stepSize[1])
+			for (size_t y = 0, outY = 0; y < size[1]; y += stepSize[1], ++outY)
 			{
-				outIdx[2] = 0;
-				extractIndex[1] = getLeft(y, patchSizeHalf[1], center);
-				extractSize[1] = getSize(y, extractIndex[1], size[1], patchSizeHalf[1], patchSize[1], center);
-				for (size_t z = 0; z < size[2] && !patchFilter->isAborted(); z += stepSize[2])
+				for (size_t z = 0, outZ = 0; z < size[2]; z += stepSize[2], ++outZ)
 				{
-					extractIndex[2] = getLeft(z, patchSizeHalf[2], center);
-					extractSize[2] = getSize(z, extractIndex[2], size[2], patchSizeHalf[2], patchSize[2], center);
-					/*
-					LOG(lvlInfo, QString("Working on patch: upper left=(%1, %2, %3), dim=(%4, %5, %6), outIdx=(%10,%11,%12).")
-						.arg(extractParams["Index X"].toUInt())
-						.arg(extractParams["Index Y"].toUInt())
-						.arg(extractParams["Index Z"].toUInt())
-						.arg(extractParams["Size X"].toUInt())
-						.arg(extractParams["Size Y"].toUInt())
-						.arg(extractParams["Size Z"].toUInt())
-						.arg(outIdx[0]).arg(outIdx[1]).arg(outIdx[2]));
-					*/
+					iAPatch p;
+					p.pos[0] = x; p.pos[1] = y; p.pos[2] = z;
+					size_t outIdx[3] = { outX, outY, outZ };
+					for (int i = 0; i < DIM; ++i)
+					{
+						p.extractIndex[i] = getLeft(p.pos[i], patchSizeHalf[i], center);
+						p.extractSize[i] = getSize(p.pos[i], p.extractIndex[i], size[i], patchSizeHalf[i], patchSize[i], center);
+					}
 					// apparently some ITK filters (e.g. statistics) have problems with images
 					// with a size of 1 in one dimension, so let's skip such patches for the moment...
-					if (extractSize[0] <= 1 || extractSize[1] <= 1 || extractSize[2] <= 1)
+					if (p.extractSize[0] <= 1 || p.extractSize[1] <= 1 || p.extractSize[2] <= 1)
 					{
-						//LOG(lvlInfo, "    skipping because one side <= 1.");
 						continue;
 					}
-					try
+					p.outOffset = outIdx[0] + blockCount[0] * (outIdx[1] + blockCount[1] * outIdx[2]);
+					patches.push_back(p);
+				}
+			}
+		}
+		// one filter instance per worker thread, since filters store their in- and outputs:
+		int numThreads = parameters["Concurrent patches"].toInt();
+		if (numThreads <= 0)
+		{
+			numThreads = std::max(1, QThread::idealThreadCount());
+		}
+		std::vector<std::shared_ptr<iAFilter>> workerFilters(numThreads);
+		for (int t = 0; t < numThreads; ++t)
+		{
+			workerFilters[t] = (t == 0) ? filter : iAFilterRegistry::filter(parameters[spnFilter].toString());
+			workerFilters[t]->setLogger(patchFilter->logger());
+		}
+		// per patch output; assembled in patch order after all patches are processed:
+		std::vector<QString> patchLines(patches.size());
+		std::vector<QStringList> patchValueNames(patches.size());
+		std::atomic<int> nextFilter(0);
+		std::atomic<long long> finishedPatches(0);
+		std::atomic<bool> failed(false);
+		QString errorMsg;
+		long long patchCount = static_cast<long long>(patches.size());
+		// dynamic scheduling, so that idle workers pick up the remaining patches:
+#pragma omp parallel num_threads(numThreads)
+		{
+			auto threadFilter = workerFilters[nextFilter++];
+#pragma omp for schedule(dynamic)
+			for (long long curOp = 0; curOp < patchCount; ++curOp)
+			{
+				if (patchFilter->isAborted() || failed)
+				{
+					continue;
+				}
+				auto const& p = patches[curOp];
+				try
+				{
+					// extract patch from all inputs and add to filter input; the extraction updates the pipeline
+					// state (e.g. the requested region) of the shared input images, so only one thread may do it at a time:
+					threadFilter->clearInput();
+					std::exception_ptr extractError;
+#pragma omp critical
 					{
-						// extract patch from all inputs and add to filter input:
-						filter->clearInput();
-						for (size_t i = 0; i < inputImages.size(); ++i)
+						try
 						{
-							auto itkExtractImg = extractImage(dynamic_cast<iAImageData*>(inputImages[i].get())->itkImage(), extractIndex, extractSize);
-							// maybe modify original filename to reflect that only a patch of it is passed on?
-							filter->addInput(std::make_shared<iAImageData>(itkExtractImg));
+							for (size_t i = 0; i < inputImages.size(); ++i)
+							{
+								auto itkExtractImg = extractImage(dynamic_cast<iAImageData*>(inputImages[i].get())->itkImage(),
+									p.extractIndex, p.extractSize);
+								// maybe modify original filename to reflect that only a patch of it is passed on?
+								threadFilter->addInput(std::make_shared<iAImageData>(itkExtractImg));
+							}
 						}
-						// run filter on inputs:
-						filter->run(filterParams);
+						catch (...)
+						{   // exceptions must not leave the critical section
+							extractError = std::current_exception();
+						}
+					}
+					if (extractError)
+					{
+						std::rethrow_exception(extractError);
+					}
+					// run filter on inputs:
+					threadFilter->run(filterParams);
 
-						// get output images and values from filter:
-						for (size_t o = 0; o < filter->finalOutputCount(); ++o)
+					// get output images and values from filter:
+					for (size_t o = 0; o < threadFilter->finalOutputCount(); ++o)
+					{
+						QString outFileName = QString("%1/%2-patch%3%4.%5")
+							.arg(outBaseFI.absolutePath())
+							.arg(outBaseFI.baseName())
+							.arg(curOp)
+							.arg(threadFilter->finalOutputCount() == 1 ? "" : "-" + threadFilter->outputName(o))
+							.arg(outBaseFI.completeSuffix());
+						if (QFile::exists(outFileName))
 						{
-							QFileInfo fi(parameters["Output image base name"].toString());
-							QString outFileName = QString("%1/%2-patch%3%4.%5")
-								.arg(fi.absolutePath())
-								.arg(fi.baseName())
-								.arg(curOp)
-								.arg(filter->finalOutputCount() == 1 ? "" : "-"+filter->outputName(o))
-								.arg(fi.completeSuffix());
-							if (QFile::exists(outFileName))
+							LOG(lvlWarn, QString("Output file %1 already exists; if you want to overwrite it, "
+								"you need to set the '%2' parameter to true.")
+								.arg(outFileName).arg(spnOverwriteOutput));
+							if (!continueOnError)
 							{
-								LOG(lvlWarn, QString("Output file %1 already exists; if you want to overwrite it, "
-									"you need to set the '%2' parameter to true.")
-									.arg(outFileName).arg(spnOverwriteOutput));
-								if (!continueOnError)
-								{
-									throw std::runtime_error(QString("Aborting patch filter since an output file already existed, "
-										"and '%1' and '%2' are disabled.")
-										.arg(spnOverwriteOutput)
-										.arg(spnContinueOnError).toStdString());
-								}
+								throw std::runtime_error(QString("Aborting patch filter since an output file already existed, "
+									"and '%1' and '%2' are disabled.")
+									.arg(spnOverwriteOutput)
+									.arg(spnContinueOnError).toStdString());
 							}
-							storeImage(filter->imageOutput(o)->itkImage(), outFileName, compress);
 						}
-						if (filter->outputValues().size() > 0)
+						storeImage(threadFilter->imageOutput(o)->itkImage(), outFileName, compress);
+					}
+					if (threadFilter->outputValues().size() > 0)
+					{
+						QStringList values;
+						values << QString::number(p.pos[0]) << QString::number(p.pos[1]) << QString::number(p.pos[2]);
+						for (auto outValue : threadFilter->outputValues())
 						{
-							if (curOp == 0)
-							{
-								QStringList captions;
-								captions << "x" << "y" << "z";
-								for (auto outValue : filter->outputValues())
-								{
-									captions << outValue.first;
-								}
-								outputBuffer.append(captions.join(","));
-							}
-							QStringList values;
-							values << QString::number(x) << QString::number(y) << QString::number(z);
-							for (auto outValue : filter->outputValues())
-							{
-								values.append(outValue.second.toString());
-							}
-							outputBuffer.append(values.join(","));
-							if (doImage)
+							patchValueNames[curOp].append(outValue.first);
+							values.append(outValue.second.toString());
+						}
+						patchLines[curOp] = values.join(",");
+						if (doImage)
+						{   // each patch writes to a different output pixel, so no synchronization required:
+							for (int i = 0; i < threadFilter->outputValues().size(); ++i)
 							{
-								for (int i = 0; i < filter->outputValues().size(); ++i)
-								{
-									(dynamic_cast<OutputImageType*>(outputImages[i].GetPointer()))->SetPixel(outIdx, filter->outputValues()[i].second.toDouble());
-								}
+								outputBuffers[i][p.outOffset] = threadFilter->outputValues()[i].second.toDouble();
 							}
 						}
 					}
-					catch (std::exception& e)
+				}
+				// exceptions cannot be propagated out of an OpenMP parallel region (that would terminate the
+				// process); each of them is therefore caught here, and either reported or remembered and rethrown below
+				catch (std::exception& e)
+				{
+					if (continueOnError)
+					{
+						LOG(lvlError, QString("Patch filter: An error has occurred: %1, continueing anyway.").arg(e.what()));
+					}
+					else
 					{
-						if (continueOnError)
+#pragma omp critical
 						{
-							LOG(lvlError, QString("Patch filter: An error has occurred: %1, continueing anyway.").arg(e.what()));
+							if (!failed)
+							{
+								errorMsg = e.what();
+								failed = true;
+							}
 						}
-						else
+					}
+				}
+				catch (...)
+				{
+					if (continueOnError)
+					{
+						LOG(lvlError, QString("Patch filter: An unknown error has occurred in patch %1, continueing anyway.").arg(curOp));
+					}
+					else
+					{
+#pragma omp critical
 						{
-							throw;
+							if (!failed)
+							{
+								errorMsg = QString("An unknown error has occurred in patch %1.").arg(curOp);
+								failed = true;
+							}
 						}
 					}
-
-					patchFilter->progress()->emitProgress(curOp * 100.0 / totalOps);
-					++curOp;
-					++outIdx[2];
 				}
-				++outIdx[1];
+				auto finished = ++finishedPatches;
+#pragma omp critical
+				{
+					patchFilter->progress()->emitProgress(finished * 100.0 / patchCount);
+				}
+			}
+		}
+		if (failed)
+		{
+			throw std::runtime_error(errorMsg.toStdString());
+		}
+		QStringList outputBuffer;
+		for (size_t curOp = 0; curOp < patches.size(); ++curOp)
+		{
+			if (patchLines[curOp].isEmpty())
+			{
+				continue;
+			}
+			if (outputBuffer.isEmpty())
+			{
+				QStringList captions;
+				captions << "x" << "y" << "z";
+				captions.append(patchValueNames[curOp]);
+				outputBuffer.append(captions.join(","));
 			}
-			++outIdx[0];
+			outputBuffer.append(patchLines[curOp]);
 		}
 		if (patchFilter->isAborted())
 		{
@@ -289,12 +373,11 @@ namespace
 		}
 		for (int i = 0; i < outputImages.size(); ++i)
 		{
-			QFileInfo fi(parameters["Output image base name"].toString());
 			QString outFileName = QString("%1/%2%3.%4")
-				.arg(fi.absolutePath())
-				.arg(fi.baseName())
+				.arg(outBaseFI.absolutePath())
+				.arg(outBaseFI.baseName())
 				.arg(outputNames[i])
-				.arg(fi.completeSuffix());
+				.arg(outBaseFI.completeSuffix());
 			storeImage(outputImages[i], outFileName, compress);
 			//LOG(lvlInfo, QString("Storing output for '%1' in file '%2'").arg(outputNames[i]).arg(outFileName));
 		}
@@ -309,7 +392,12 @@ iAPatchFilter::iAPatchFilter():
 		"you can choose the 'Copy' operation as <em>%1</em> parameter. "
 		"<em>%2</em> determines whether output images are compressed (.mhd + .zraw) or uncompressed (.mhd + .raw). "
 		"When <em>%3</em> is enabled, then batch processing will continue with the next file "
-		"in case there is an error. If it is disabled, an error will interrupt the whole batch run. ")
+		"in case there is an error. If it is disabled, an error will interrupt the whole batch run. "
+		"<em>Concurrent patches</em> determines how many patches are processed in parallel "
+		"(each by its own instance of the filter). The default of 1 processes the patches sequentially; "
+		"only use more if the chosen filter supports running several instances at the same time, "
+		"and keep in mind that many filters already use multiple threads themselves. "
+		"0 means to use as many as there are processor cores.")
 		.arg(spnFilter)
 		.arg(spnCompressOutput)
 		.arg(spnContinueOnError)
@@ -331,6 +419,7 @@ iAPatchFilter::iAPatchFilter():
 	addParameter(spnCompressOutput, iAValueType::Boolean, true);
 	addParameter(spnContinueOnError, iAValueType::Boolean, false);
 	addParameter(spnOverwriteOutput, iAValueType::Boolean, false);
+	addParameter("Concurrent patches", iAValueType::Discrete, 1, 0);
 }
 
 void iAPatchFilter::performWork(QVariantMap const & parameters)
@@ -0,0 +1,9 @@
+if (openiA_TESTING_ENABLED)
+	get_filename_component(CoreSrcDir "../libs/base" REALPATH BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
+	add_executable(SimilarityKernelTest Metrics/iASimilarityKernelTest.cpp)
+	target_include_directories(SimilarityKernelTest PRIVATE ${CoreSrcDir})   # for iASimpleTester.h
+	add_test(NAME SimilarityKernelTest COMMAND SimilarityKernelTest)
+	if (openiA_USE_IDE_FOLDERS)
+		set_property(TARGET SimilarityKernelTest PROPERTY FOLDER "Tests")
+	endif()
+endif()
@@ -2,247 +2,96 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iASimilarity.h"
 
+#include "iASimilarityKernel.h"
+
 #include <defines.h>          // for DIM
-#include <iAConnector.h>
 #include <iADataSet.h>        // for iAImageData
-#include <iAProgress.h>
-#include <iAToolsITK.h>
 #include <iAToolsVTK.h>       // for adjustIndexAndSizeToImage
 #include <iATypedCallHelper.h>
-#include <iAMdiChild.h>
 #include <iAValueTypeVectorHelpers.h>
 
-#include <itkCastImageFilter.h>
-#include <itkExtractImageFilter.h>
-#include <itkImageRegionConstIterator.h>
-#include <itkImageToHistogramFilter.h>
-#include <itkJoinImageFilter.h>
-#include <itkNormalizedCorrelationImageToImageMetric.h>
-#include <itkMeanSquaresImageToImageMetric.h>
-#include <itkStatisticsImageFilter.h>
-#include <itkTranslationTransform.h>
+#include <itkImage.h>
 
 #include <vtkImageData.h>
 
-//! Custom image similarity metric - "equal pixel rate", i.e.
-//!     number of equal pixels / number of total pixels
-template<class ImageType>
-double computeEqualPixelRate(typename ImageType::Pointer img, typename ImageType::Pointer ref)
-{
-	typename ImageType::RegionType reg = ref->GetLargestPossibleRegion();
-	int size = reg.GetSize()[0] * reg.GetSize()[1] * reg.GetSize()[2];
-	double sumEqual = 0.0f;
-#pragma omp parallel for reduction(+:sumEqual)
-	for (int i = 0; i < size; ++i)
-	{
-		if (img->GetBufferPointer()[i] != 0 &&
-			img->GetBufferPointer()[i] == ref->GetBufferPointer()[i])
-			++sumEqual;
-	}
-	return sumEqual / size;
-}
-
 template<class T>
 void similarity_metrics(iAFilter* filter, QVariantMap const & parameters)
 {
 	typedef itk::Image< T, DIM > ImageType;
-	size_t size[3], index[3];
+	size_t size[3], index[3], dim[3];
 	setFromVectorVariant<int>(size, parameters["Size"]);
 	setFromVectorVariant<int>(index, parameters["Index"]);
-	auto activeExtract = extractImage(filter->imageInput(0)->itkImage(), index, size);
-	auto nonActiveExtract = extractImage(filter->imageInput(1)->itkImage(), index, size);
-	ImageType* img = dynamic_cast<ImageType*>(activeExtract.GetPointer());
-	ImageType* ref = dynamic_cast<ImageType*>(nonActiveExtract.GetPointer());
-	typedef itk::TranslationTransform < double, DIM > TransformType;
-	typedef itk::LinearInterpolateImageFunction<ImageType, double >	InterpolatorType;
-	auto transform = TransformType::New();
-	transform->SetIdentity();
-	auto interpolator = InterpolatorType::New();
-	interpolator->SetInputImage(img);
-	typename TransformType::ParametersType params(transform->GetNumberOfParameters());
-	double range = 0, imgMean = 0, imgVar = 0, refMean = 0, refVar = 0, mse = 0;
-	if (parameters["Peak Signal-to-Noise Ratio"].toBool() ||
-		parameters["Structural Similarity Index"].toBool() ||
-		parameters["Normalized RMSE"].toBool())
+	auto img = dynamic_cast<ImageType*>(filter->imageInput(0)->itkImage());
+	auto ref = dynamic_cast<ImageType*>(filter->imageInput(1)->itkImage());
+	if (!ref)
 	{
-		double imgMin, imgMax, refMin, refMax;
-		getStatistics(img, &imgMin, &imgMax, &imgMean, nullptr, &imgVar);
-		getStatistics(ref, &refMin, &refMax, &refMean, nullptr, &refVar);
-		range = std::max(refMax, imgMax) - std::min(refMin, imgMin);
+		throw itk::ExceptionObject(__FILE__, __LINE__, "Similarity: Both images need to have the same data type!");
 	}
-	if (parameters["Mean Squared Error"].toBool() ||
-		parameters["RMSE"].toBool() ||
-		parameters["Normalized RMSE"].toBool() ||
-		parameters["Peak Signal-to-Noise Ratio"].toBool())
+	auto imgSize = img->GetBufferedRegion().GetSize();
+	auto refSize = ref->GetBufferedRegion().GetSize();
+	for (int i = 0; i < 3; ++i)
 	{
-		typedef itk::MeanSquaresImageToImageMetric<	ImageType, ImageType > MSMetricType;
-		auto msmetric = MSMetricType::New();
-		msmetric->SetFixedImage(img);
-		msmetric->SetFixedImageRegion(img->GetLargestPossibleRegion());
-		msmetric->SetMovingImage(ref);
-		msmetric->SetTransform(transform);
-		msmetric->SetInterpolator(interpolator);
-		params.Fill(0.0);
-		msmetric->Initialize();
-		mse = msmetric->GetValue(params);
-		if (parameters["Mean Squared Error"].toBool())
-			filter->addOutputValue("Mean Squared Error", mse);
-		if (parameters["RMSE"].toBool())
-			filter->addOutputValue("RMSE", std::sqrt(mse));
-		if (parameters["Normalized RMSE"].toBool())
-			filter->addOutputValue("Normalized RMSE", std::sqrt(mse) / range);
-
+		dim[i] = imgSize[i];
+		if (refSize[i] != imgSize[i] || index[i] + size[i] > dim[i])
+		{
+			throw itk::ExceptionObject(__FILE__, __LINE__,
+				"Similarity: Both images need to have the same size, and the region needs to be inside of them!");
+		}
+	}
+	// all measures are computed directly on the two image buffers, in one pass (plus a second one for histograms
+	// and covariance, which depend on the data ranges and means):
+	auto v = computeSimilarity(img->GetBufferPointer(), ref->GetBufferPointer(), dim, index, size,
+		parameters["Histogram Bins"].toInt(), parameters["Mutual Information"].toBool(),
+		parameters["Structural Similarity Index"].toBool());
+	double range = std::max(v.refMax, v.imgMax) - std::min(v.refMin, v.imgMin);
+	if (parameters["Mean Squared Error"].toBool())
+	{
+		filter->addOutputValue("Mean Squared Error", v.mse);
+	}
+	if (parameters["RMSE"].toBool())
+	{
+		filter->addOutputValue("RMSE", std::sqrt(v.mse));
+	}
+	if (parameters["Normalized RMSE"].toBool())
+	{
+		filter->addOutputValue("Normalized RMSE", std::sqrt(v.mse) / range);
 	}
 	if (parameters["Peak Signal-to-Noise Ratio"].toBool())
 	{
-		double psnr = 20 * std::log10(range) - 10 * std::log10(mse);
+		double psnr = 20 * std::log10(range) - 10 * std::log10(v.mse);
 		filter->addOutputValue("Peak Signal-to-Noise Ratio", psnr);
 	}
 	if (parameters["Mean Absolute Error"].toBool())
 	{
-		itk::ImageRegionConstIterator<ImageType> imgIt(img, img->GetLargestPossibleRegion());
-		itk::ImageRegionConstIterator<ImageType> refIt(ref, ref->GetLargestPossibleRegion());
-		imgIt.GoToBegin(); refIt.GoToBegin();
-		double diffSum = 0;	size_t count = 0;
-		while (!imgIt.IsAtEnd() && !refIt.IsAtEnd())
-		{
-			diffSum += std::abs(static_cast<double>(refIt.Get() - imgIt.Get()));
-			++imgIt; ++refIt; ++count;
-		}
-		filter->addOutputValue("Mean Absolute Error", diffSum / count);
+		filter->addOutputValue("Mean Absolute Error", v.mae);
 	}
 	if (parameters["Normalized Correlation"].toBool())
 	{
-		typedef itk::NormalizedCorrelationImageToImageMetric< ImageType, ImageType > NCMetricType;
-		auto ncmetric = NCMetricType::New();
-		ncmetric->SetFixedImage(img);
-		ncmetric->SetFixedImageRegion(img->GetLargestPossibleRegion());
-		ncmetric->SetMovingImage(ref);
-		ncmetric->SetTransform(transform);
-		ncmetric->SetInterpolator(interpolator);
-		params.Fill(0.0);
-		ncmetric->Initialize();
-		double ncVal = ncmetric->GetValue(params);
-		filter->addOutputValue("Normalized Correlation Metric", ncVal);
+		filter->addOutputValue("Normalized Correlation Metric", v.normalizedCorrelation);
 	}
 	if (parameters["Mutual Information"].toBool())
 	{
-		//ITK-Example: https://itk.org/Doxygen/html/Examples_2Statistics_2ImageMutualInformation1_8cxx-example.html
-		typedef itk::JoinImageFilter< ImageType, ImageType > JoinFilterType;
-		auto joinFilter = JoinFilterType::New();
-		joinFilter->SetInput1(img);
-		joinFilter->SetInput2(ref);
-		joinFilter->Update();
-
-		typedef typename JoinFilterType::OutputImageType  VectorImageType;
-		typedef itk::Statistics::ImageToHistogramFilter<VectorImageType >  HistogramFilterType;
-		auto histogramFilter = HistogramFilterType::New();
-		histogramFilter->SetInput(joinFilter->GetOutput());
-		histogramFilter->SetMarginalScale(10.0);
-		typedef typename HistogramFilterType::HistogramSizeType   HistogramSizeType;
-		HistogramSizeType histSize(2);
-		histSize[0] = parameters["Histogram Bins"].toDouble();  // number of bins for the first  channel
-		histSize[1] = parameters["Histogram Bins"].toDouble();  // number of bins for the second channel
-		histogramFilter->SetHistogramSize(histSize);
-		/*
-		typedef typename HistogramFilterType::HistogramMeasurementVectorType HistogramMeasurementVectorType;
-		HistogramMeasurementVectorType binMinimum(3);
-		HistogramMeasurementVectorType binMaximum(3);
-		// shouldn't this be the min and max DATA values?
-		binMinimum[0] = -0.5;
-		binMinimum[1] = -0.5;
-		binMinimum[2] = -0.5;
-		binMaximum[0] = miHistoBins + 0.5;
-		binMaximum[1] = miHistoBins + 0.5;
-		binMaximum[2] = miHistoBins + 0.5;
-		histogramFilter->SetHistogramBinMinimum(binMinimum);
-		histogramFilter->SetHistogramBinMaximum(binMaximum);
-		*/
-		histogramFilter->SetAutoMinimumMaximum(true);
-		histogramFilter->Update();
-		typedef typename HistogramFilterType::HistogramType  HistogramType;
-		const HistogramType * histogram = histogramFilter->GetOutput();
-		auto itr = histogram->Begin();
-		auto end = histogram->End();
-		const double Sum = histogram->GetTotalFrequency();
-		double jointEntr = 0;
-		while (itr != end)
-		{
-			const double count = itr.GetFrequency();
-			if (count > 0.0)
-			{
-				const double probability = count / Sum;
-				jointEntr += -probability * std::log(probability) / std::log(2.0);
-			}
-			++itr;
-		}
-
-		histSize[0] = parameters["Histogram Bins"].toDouble();  // number of bins for the first  channel
-		histSize[1] = 1;  // number of bins for the second channel
-		histogramFilter->SetHistogramSize(histSize);
-		histogramFilter->Update();
-		itr = histogram->Begin();
-		end = histogram->End();
-		double entr1 = 0;
-		while (itr != end)
-		{
-			const double count = itr.GetFrequency();
-			if (count > 0.0)
-			{
-				const double probability = count / Sum;
-				entr1 += -probability * std::log(probability) / std::log(2.0);
-			}
-			++itr;
-		}
-
-		histSize[0] = 1;  // number of bins for the first channel
-		histSize[1] = parameters["Histogram Bins"].toDouble();  // number of bins for the second channel
-		histogramFilter->SetHistogramSize(histSize);
-		histogramFilter->Update();
-		itr = histogram->Begin();
-		end = histogram->End();
-		double entr2 = 0;
-		while (itr != end)
-		{
-			const double count = itr.GetFrequency();
-			if (count > 0.0)
-			{
-				const double probability = count / Sum;
-				entr2 += -probability * std::log(probability) / std::log(2.0);
-			}
-			++itr;
-		}
-		double mutInf = entr1 + entr2 - jointEntr;
-		double norMutInf1 = 2.0 * mutInf / (entr1 + entr2);
-		double norMutInf2 = (entr1 + entr2) / jointEntr;
-		filter->addOutputValue("Image 1 Entropy", entr1);
-		filter->addOutputValue("Image 2 Entropy", entr2);
-		filter->addOutputValue("Joint Entropy", jointEntr);
+		double mutInf = v.imgEntropy + v.refEntropy - v.jointEntropy;
+		double norMutInf1 = 2.0 * mutInf / (v.imgEntropy + v.refEntropy);
+		double norMutInf2 = (v.imgEntropy + v.refEntropy) / v.jointEntropy;
+		filter->addOutputValue("Image 1 Entropy", v.imgEntropy);
+		filter->addOutputValue("Image 2 Entropy", v.refEntropy);
+		filter->addOutputValue("Joint Entropy", v.jointEntropy);
 		filter->addOutputValue("Mutual Information", mutInf);
 		filter->addOutputValue("Normalized Mutual Information 1", norMutInf1);
 		filter->addOutputValue("Normalized Mutual Information 2", norMutInf2);
 	}
 	if (parameters["Structural Similarity Index"].toBool())
 	{
-		itk::ImageRegionConstIterator<ImageType> imgIt(img, img->GetLargestPossibleRegion());
-		itk::ImageRegionConstIterator<ImageType> refIt(ref, ref->GetLargestPossibleRegion());
-		imgIt.GoToBegin(); refIt.GoToBegin();
-		double covSum = 0;	size_t count = 0;
-		while (!imgIt.IsAtEnd() && !refIt.IsAtEnd())
-		{
-			covSum += (imgIt.Get() - imgMean) * (refIt.Get() - refMean);
-			++imgIt; ++refIt; ++count;
-		}
-		double covariance = covSum / count;
 		double c1 = std::pow(parameters["Structural Similarity k1"].toDouble() * range, 2);
 		double c2 = std::pow(parameters["Structural Similarity k2"].toDouble() * range, 2);
-		double ssim = ((2 * imgMean * refMean + c1) * (2 * covariance + c2)) /
-			((imgMean * imgMean + refMean * refMean + c1) * (imgVar + refVar + c2));
+		double ssim = ((2 * v.imgMean * v.refMean + c1) * (2 * v.covariance + c2)) /
+			((v.imgMean * v.imgMean + v.refMean * v.refMean + c1) * (v.imgVariance + v.refVariance + c2));
 		filter->addOutputValue("Structural Similarity Index", ssim);
 	}
 	if (parameters["Equal pixel rate"].toBool())
 	{
-		filter->addOutputValue("Equal pixel rate", computeEqualPixelRate<ImageType>(img, ref));
+		filter->addOutputValue("Equal pixel rate", v.equalPixelRate);
 	}
 }
 
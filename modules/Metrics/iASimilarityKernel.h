@@ -0,0 +1,354 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>    // for size_t
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+//! Similarity measures between two images, as computed by computeSimilarity.
+struct iASimilarityValues
+{
+	size_t count = 0;                       //!< number of compared voxels
+	double imgMin = 0.0, imgMax = 0.0;
+	double refMin = 0.0, refMax = 0.0;
+	double imgMean = 0.0, refMean = 0.0;
+	double imgVariance = 0.0;               //!< sample variance, as computed by itk::StatisticsImageFilter
+	double refVariance = 0.0;               //!< sample variance, as computed by itk::StatisticsImageFilter
+	double mse = 0.0;                       //!< mean squared error
+	double mae = 0.0;                       //!< mean absolute error
+	double normalizedCorrelation = 0.0;     //!< as itk::NormalizedCorrelationImageToImageMetric (no mean subtraction)
+	double equalPixelRate = 0.0;            //!< fraction of voxels which are non-zero and equal in both images
+	double covariance = 0.0;                //!< only computed if requested
+	double imgEntropy = 0.0;                //!< only computed if histograms are requested
+	double refEntropy = 0.0;                //!< only computed if histograms are requested
+	double jointEntropy = 0.0;              //!< only computed if histograms are requested
+};
+
+namespace iASimilarityDetail
+{
+	//! The marginal scale used by the similarity filter for itk::ImageToHistogramFilter
+	const double MarginalScale = 10.0;
+
+	//! Upper bound of the histogram range for the given data range, as set by itk::ImageToHistogramFilter
+	//! (with automatic minimum/maximum) before initializing the histogram with the given number of bins.
+	inline double histogramUpperBound(double minValue, double maxValue, int bins)
+	{
+		return maxValue + ((maxValue - minValue) / bins) / MarginalScale;
+	}
+
+	//! One dimension of an itk::Statistics::Histogram as initialized by itk::ImageToHistogramFilter;
+	//! the bin boundaries (including their single precision interval) and the assignment of values to
+	//! bins are reproduced exactly, so that the histogram counts are identical.
+	class Binning
+	{
+	public:
+		Binning(double minValue, double maxValue, int bins) :
+			m_mins(bins),
+			m_upper(histogramUpperBound(minValue, maxValue, bins)),
+			m_interval(static_cast<float>(static_cast<float>(m_upper - minValue) / static_cast<double>(bins)))
+		{
+			for (int j = 0; j < bins; ++j)
+			{
+				m_mins[j] = minValue + (static_cast<float>(j) * m_interval);
+			}
+		}
+		//! the bin containing the given value, -1 if the value is outside of the histogram range
+		int bin(double value) const
+		{
+			int last = static_cast<int>(m_mins.size()) - 1;
+			if (!(value >= m_mins[0]) || value >= m_upper)
+			{
+				return -1;
+			}
+			double guess = (m_interval > 0) ? (value - m_mins[0]) / m_interval : 0.0;
+			int j = static_cast<int>(std::min(guess, static_cast<double>(last)));
+			while (j > 0 && value < m_mins[j])
+			{
+				--j;
+			}
+			while (j < last && value >= m_mins[j + 1])
+			{
+				++j;
+			}
+			return j;
+		}
+	private:
+		std::vector<double> m_mins;
+		double m_upper;
+		float m_interval;
+	};
+
+	//! Maps voxel values to histogram bins; for pixel types with at most 16 bit, via a table over the value range.
+	template <typename T, bool SmallInteger = std::is_integral<T>::value && sizeof(T) <= 2>
+	class BinLookup
+	{
+	public:
+		BinLookup(double minValue, double maxValue, int bins) : m_binning(minValue, maxValue, bins)
+		{}
+		int operator()(T value) const
+		{
+			return m_binning.bin(static_cast<double>(value));
+		}
+	private:
+		Binning m_binning;
+	};
+
+	template <typename T>
+	class BinLookup<T, true>
+	{
+	public:
+		BinLookup(double minValue, double maxValue, int bins) :
+			m_min(static_cast<int>(minValue)),
+			m_table(static_cast<int>(maxValue) - static_cast<int>(minValue) + 1)
+		{
+			Binning binning(minValue, maxValue, bins);
+			for (size_t i = 0; i < m_table.size(); ++i)
+			{
+				m_table[i] = binning.bin(m_min + static_cast<double>(i));
+			}
+		}
+		//! value needs to be inside the range the lookup was created for
+		int operator()(T value) const
+		{
+			return m_table[static_cast<int>(value) - m_min];
+		}
+	private:
+		int m_min;
+		std::vector<int> m_table;
+	};
+
+	//! Sums and extrema of a block of voxels, collected in the first pass
+	struct Moments
+	{
+		double imgMin = std::numeric_limits<double>::max(), imgMax = std::numeric_limits<double>::lowest();
+		double refMin = std::numeric_limits<double>::max(), refMax = std::numeric_limits<double>::lowest();
+		double imgSum = 0.0, refSum = 0.0, imgSumSq = 0.0, refSumSq = 0.0;
+		double sqDiffSum = 0.0, absDiffSum = 0.0, productSum = 0.0;
+		size_t equalCount = 0;
+	};
+
+	inline double entropyTerm(uint64_t count, double total)
+	{
+		if (count == 0)
+		{
+			return 0.0;
+		}
+		const double probability = count / total;
+		return -probability * std::log(probability) / std::log(2.0);
+	}
+}
+
+//! Computes all measures of the iASimilarity filter for a region of two images of the same pixel type and size,
+//! directly on the image buffers (no extracted or joined copies).
+//!
+//! Ranges, moments and all difference measures are collected in a single multi-threaded pass. Only if the
+//! histogram-based measures or the covariance are requested, a second pass follows, since those depend on the
+//! ranges and means; it fills one joint and two marginal histograms per thread, which are merged in the end.
+//! The histograms reproduce itk::ImageToHistogramFilter with automatic minimum/maximum and a marginal scale of 10
+//! (as applied to the image joined by itk::JoinImageFilter), so the entropies are identical to the ones computed
+//! via three separate histogram filter runs. Partial sums are combined in a fixed order, so results do not depend
+//! on the number of threads.
+//! @param img buffer of the first image
+//! @param ref buffer of the second image
+//! @param dim the size of both image buffers
+//! @param index the start of the region to compare
+//! @param size the size of the region to compare
+//! @param histogramBins the number of histogram bins per image
+//! @param computeHistograms whether to compute the (joint) entropies
+//! @param computeCovariance whether to compute the covariance
+template <typename T>
+iASimilarityValues computeSimilarity(T const* img, T const* ref, size_t const dim[3], size_t const index[3],
+	size_t const size[3], int histogramBins, bool computeHistograms, bool computeCovariance)
+{
+	using namespace iASimilarityDetail;
+	iASimilarityValues result;
+	result.count = size[0] * size[1] * size[2];
+	if (result.count == 0)
+	{
+		return result;
+	}
+	// the region is processed in blocks of whole rows of about 64k voxels each:
+	const size_t rowLength = size[0];
+	const size_t rowCount = size[1] * size[2];
+	const size_t blockRows = std::max(static_cast<size_t>(1), static_cast<size_t>(65536) / rowLength);
+	const long long blockCount = static_cast<long long>((rowCount + blockRows - 1) / blockRows);
+	auto rowOffset = [&](size_t row) -> size_t
+	{
+		size_t z = row / size[1], y = row % size[1];
+		return ((index[2] + z) * dim[1] + index[1] + y) * dim[0] + index[0];
+	};
+
+	std::vector<Moments> blockMoments(blockCount);
+#pragma omp parallel for schedule(dynamic, 1)
+	for (long long b = 0; b < blockCount; ++b)
+	{
+		Moments m;
+		size_t rowBegin = static_cast<size_t>(b) * blockRows;
+		size_t rowEnd = std::min(rowCount, rowBegin + blockRows);
+		for (size_t row = rowBegin; row < rowEnd; ++row)
+		{
+			T const* imgRow = img + rowOffset(row);
+			T const* refRow = ref + rowOffset(row);
+			for (size_t x = 0; x < rowLength; ++x)
+			{
+				const double f = static_cast<double>(imgRow[x]);
+				const double r = static_cast<double>(refRow[x]);
+				m.imgMin = std::min(m.imgMin, f);
+				m.imgMax = std::max(m.imgMax, f);
+				m.refMin = std::min(m.refMin, r);
+				m.refMax = std::max(m.refMax, r);
+				m.imgSum += f;
+				m.refSum += r;
+				m.imgSumSq += f * f;
+				m.refSumSq += r * r;
+				const double diff = r - f;
+				m.sqDiffSum += diff * diff;
+				m.absDiffSum += std::abs(diff);
+				m.productSum += f * r;
+				m.equalCount += (imgRow[x] != 0 && imgRow[x] == refRow[x]) ? 1 : 0;
+			}
+		}
+		blockMoments[b] = m;
+	}
+	Moments total;
+	for (auto const& m : blockMoments)
+	{
+		total.imgMin = std::min(total.imgMin, m.imgMin);
+		total.imgMax = std::max(total.imgMax, m.imgMax);
+		total.refMin = std::min(total.refMin, m.refMin);
+		total.refMax = std::max(total.refMax, m.refMax);
+		total.imgSum += m.imgSum;
+		total.refSum += m.refSum;
+		total.imgSumSq += m.imgSumSq;
+		total.refSumSq += m.refSumSq;
+		total.sqDiffSum += m.sqDiffSum;
+		total.absDiffSum += m.absDiffSum;
+		total.productSum += m.productSum;
+		total.equalCount += m.equalCount;
+	}
+	const double n = static_cast<double>(result.count);
+	result.imgMin = total.imgMin;
+	result.imgMax = total.imgMax;
+	result.refMin = total.refMin;
+	result.refMax = total.refMax;
+	result.imgMean = total.imgSum / n;
+	result.refMean = total.refSum / n;
+	result.imgVariance = (total.imgSumSq - (total.imgSum * total.imgSum / n)) / (n - 1);
+	result.refVariance = (total.refSumSq - (total.refSum * total.refSum / n)) / (n - 1);
+	result.mse = total.sqDiffSum / n;
+	result.mae = total.absDiffSum / n;
+	const double denominator = -std::sqrt(total.imgSumSq * total.refSumSq);
+	result.normalizedCorrelation = (denominator != 0.0) ? total.productSum / denominator : 0.0;
+	result.equalPixelRate = total.equalCount / n;
+
+	if (!computeHistograms && !computeCovariance)
+	{
+		return result;
+	}
+	const size_t bins = computeHistograms ? static_cast<size_t>(histogramBins) : 0;
+	const BinLookup<T> imgBins(result.imgMin, result.imgMax, std::max(histogramBins, 1));
+	const BinLookup<T> refBins(result.refMin, result.refMax, std::max(histogramBins, 1));
+	// in the marginal histograms, the other image is covered by a single bin; as all values lie inside its
+	// range, this only leaves out voxels if the range is empty:
+	const bool imgInSingleBin = result.imgMax < histogramUpperBound(result.imgMin, result.imgMax, 1);
+	const bool refInSingleBin = result.refMax < histogramUpperBound(result.refMin, result.refMax, 1);
+	std::vector<uint64_t> joint(bins * bins, 0), imgMarginal(bins, 0), refMarginal(bins, 0);
+	std::vector<double> blockCovariance(computeCovariance ? blockCount : 0, 0.0);
+#pragma omp parallel
+	{
+		std::vector<uint64_t> threadJoint(bins * bins, 0), threadImgMarginal(bins, 0), threadRefMarginal(bins, 0);
+#pragma omp for schedule(dynamic, 1)
+		for (long long b = 0; b < blockCount; ++b)
+		{
+			double covSum = 0.0;
+			size_t rowBegin = static_cast<size_t>(b) * blockRows;
+			size_t rowEnd = std::min(rowCount, rowBegin + blockRows);
+			for (size_t row = rowBegin; row < rowEnd; ++row)
+			{
+				T const* imgRow = img + rowOffset(row);
+				T const* refRow = ref + rowOffset(row);
+				for (size_t x = 0; x < rowLength; ++x)
+				{
+					if (computeHistograms)
+					{
+						const int imgBin = imgBins(imgRow[x]);
+						const int refBin = refBins(refRow[x]);
+						if (imgBin >= 0 && refBin >= 0)
+						{
+							++threadJoint[static_cast<size_t>(refBin) * bins + imgBin];
+						}
+						if (imgBin >= 0 && refInSingleBin)
+						{
+							++threadImgMarginal[imgBin];
+						}
+						if (refBin >= 0 && imgInSingleBin)
+						{
+							++threadRefMarginal[refBin];
+						}
+					}
+					if (computeCovariance)
+					{
+						covSum += (imgRow[x] - result.imgMean) * (refRow[x] - result.refMean);
+					}
+				}
+			}
+			if (computeCovariance)
+			{
+				blockCovariance[b] = covSum;
+			}
+		}
+		if (computeHistograms)
+		{
+#pragma omp critical
+			{
+				for (size_t i = 0; i < joint.size(); ++i)
+				{
+					joint[i] += threadJoint[i];
+				}
+				for (size_t i = 0; i < bins; ++i)
+				{
+					imgMarginal[i] += threadImgMarginal[i];
+					refMarginal[i] += threadRefMarginal[i];
+				}
+			}
+		}
+	}
+	if (computeCovariance)
+	{
+		double covSum = 0.0;
+		for (double c : blockCovariance)
+		{
+			covSum += c;
+		}
+		result.covariance = covSum / n;
+	}
+	if (computeHistograms)
+	{
+		// all entropies relate to the total frequency of the joint histogram; bins are visited in the order
+		// of the itk::Statistics::Histogram iterator (first dimension fastest):
+		uint64_t jointTotal = 0;
+		for (uint64_t c : joint)
+		{
+			jointTotal += c;
+		}
+		const double totalFrequency = static_cast<double>(jointTotal);
+		for (uint64_t c : joint)
+		{
+			result.jointEntropy += entropyTerm(c, totalFrequency);
+		}
+		for (size_t i = 0; i < bins; ++i)
+		{
+			result.imgEntropy += entropyTerm(imgMarginal[i], totalFrequency);
+		}
+		for (size_t i = 0; i < bins; ++i)
+		{
+			result.refEntropy += entropyTerm(refMarginal[i], totalFrequency);
+		}
+	}
+	return result;
+}
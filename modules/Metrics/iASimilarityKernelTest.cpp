@@ -0,0 +1,317 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "iASimilarityKernel.h"
+
+#include <chrono>
+#include <random>
+#include <utility>
+
+namespace
+{
+	//! Reference implementation following the previous, ITK-based computation of iASimilarity:
+	//! a separate pass per measure, a joined copy of both images, and three histogram runs
+	//! (binning and bin lookup as in itk::ImageToHistogramFilter / itk::Statistics::Histogram).
+	template <typename T>
+	class MultiPassReference
+	{
+	public:
+		MultiPassReference(std::vector<T> const& img, std::vector<T> const& ref, int bins) :
+			m_img(img), m_ref(ref), m_bins(bins)
+		{}
+		iASimilarityValues compute()
+		{
+			iASimilarityValues v;
+			v.count = m_img.size();
+			const double n = static_cast<double>(v.count);
+			statistics(m_img, v.imgMin, v.imgMax, v.imgMean, v.imgVariance);
+			statistics(m_ref, v.refMin, v.refMax, v.refMean, v.refVariance);
+			double sqDiffSum = 0.0;
+			for (size_t i = 0; i < m_img.size(); ++i)
+			{
+				double diff = static_cast<double>(m_ref[i]) - m_img[i];
+				sqDiffSum += diff * diff;
+			}
+			v.mse = sqDiffSum / n;
+			double absDiffSum = 0.0;
+			for (size_t i = 0; i < m_img.size(); ++i)
+			{
+				absDiffSum += std::abs(static_cast<double>(m_ref[i]) - m_img[i]);
+			}
+			v.mae = absDiffSum / n;
+			double sff = 0.0, smm = 0.0, sfm = 0.0;
+			for (size_t i = 0; i < m_img.size(); ++i)
+			{
+				sff += static_cast<double>(m_img[i]) * m_img[i];
+				smm += static_cast<double>(m_ref[i]) * m_ref[i];
+				sfm += static_cast<double>(m_img[i]) * m_ref[i];
+			}
+			double denom = -std::sqrt(sff * smm);
+			v.normalizedCorrelation = (denom != 0.0) ? sfm / denom : 0.0;
+
+			std::vector<std::pair<T, T>> joined(m_img.size());
+			for (size_t i = 0; i < m_img.size(); ++i)
+			{
+				joined[i] = std::make_pair(m_img[i], m_ref[i]);
+			}
+			std::vector<uint64_t> joint = histogram(joined, m_bins, m_bins);
+			double total = 0.0;
+			for (auto c : joint)
+			{
+				total += c;
+			}
+			v.jointEntropy = entropy(joint, total);
+			v.imgEntropy = entropy(histogram(joined, m_bins, 1), total);
+			v.refEntropy = entropy(histogram(joined, 1, m_bins), total);
+
+			double covSum = 0.0;
+			for (size_t i = 0; i < m_img.size(); ++i)
+			{
+				covSum += (m_img[i] - v.imgMean) * (m_ref[i] - v.refMean);
+			}
+			v.covariance = covSum / n;
+			double equal = 0.0;
+			for (size_t i = 0; i < m_img.size(); ++i)
+			{
+				if (m_img[i] != 0 && m_img[i] == m_ref[i])
+				{
+					++equal;
+				}
+			}
+			v.equalPixelRate = equal / n;
+			return v;
+		}
+
+	private:
+		static void statistics(std::vector<T> const& data, double& min, double& max, double& mean, double& variance)
+		{
+			min = std::numeric_limits<double>::max();
+			max = std::numeric_limits<double>::lowest();
+			double sum = 0.0, sumSq = 0.0;
+			for (T value : data)
+			{
+				min = std::min(min, static_cast<double>(value));
+				max = std::max(max, static_cast<double>(value));
+				sum += value;
+				sumSq += static_cast<double>(value) * value;
+			}
+			double n = static_cast<double>(data.size());
+			mean = sum / n;
+			variance = (sumSq - (sum * sum / n)) / (n - 1);
+		}
+		struct Axis
+		{
+			std::vector<double> mins, maxs;
+		};
+		static Axis axis(double minValue, double maxValue, int size)
+		{
+			double upper = maxValue + ((maxValue - minValue) / size) / 10.0;
+			float interval = static_cast<float>(upper - minValue) / static_cast<double>(size);
+			Axis a;
+			for (int j = 0; j < size - 1; ++j)
+			{
+				a.mins.push_back(minValue + (static_cast<float>(j) * interval));
+				a.maxs.push_back(minValue + ((static_cast<float>(j) + 1) * interval));
+			}
+			a.mins.push_back(minValue + ((static_cast<float>(size) - 1) * interval));
+			a.maxs.push_back(upper);
+			return a;
+		}
+		//! bin search as in itk::Statistics::Histogram::GetIndex
+		static int index(Axis const& a, double value)
+		{
+			if (value < a.mins[0])
+			{
+				return -1;
+			}
+			int begin = 0, end = static_cast<int>(a.mins.size()) - 1;
+			if (value >= a.maxs[end])
+			{
+				return -1;
+			}
+			int mid = (end + 1) / 2;
+			double median = a.mins[mid];
+			while (true)
+			{
+				if (value < median)
+				{
+					end = mid - 1;
+				}
+				else if (value > median)
+				{
+					if (value < a.maxs[mid] && value >= a.mins[mid])
+					{
+						return mid;
+					}
+					begin = mid + 1;
+				}
+				else
+				{
+					return mid;
+				}
+				mid = begin + (end - begin) / 2;
+				median = a.mins[mid];
+			}
+		}
+		static std::vector<uint64_t> histogram(std::vector<std::pair<T, T>> const& joined, int size0, int size1)
+		{
+			double min0 = std::numeric_limits<double>::max(), max0 = std::numeric_limits<double>::lowest();
+			double min1 = min0, max1 = max0;
+			for (auto const& p : joined)
+			{
+				min0 = std::min(min0, static_cast<double>(p.first));
+				max0 = std::max(max0, static_cast<double>(p.first));
+				min1 = std::min(min1, static_cast<double>(p.second));
+				max1 = std::max(max1, static_cast<double>(p.second));
+			}
+			Axis a0 = axis(min0, max0, size0), a1 = axis(min1, max1, size1);
+			std::vector<uint64_t> result(static_cast<size_t>(size0) * size1, 0);
+			for (auto const& p : joined)
+			{
+				int i0 = index(a0, p.first);
+				if (i0 < 0)
+				{
+					continue;
+				}
+				int i1 = index(a1, p.second);
+				if (i1 < 0)
+				{
+					continue;
+				}
+				++result[static_cast<size_t>(i1) * size0 + i0];
+			}
+			return result;
+		}
+		static double entropy(std::vector<uint64_t> const& hist, double total)
+		{
+			double result = 0.0;
+			for (auto c : hist)
+			{
+				if (c > 0)
+				{
+					const double probability = c / total;
+					result += -probability * std::log(probability) / std::log(2.0);
+				}
+			}
+			return result;
+		}
+		std::vector<T> const& m_img;
+		std::vector<T> const& m_ref;
+		int m_bins;
+	};
+
+	bool relativeEqual(double expected, double actual)
+	{
+		return std::abs(expected - actual) <= 1e-9 * std::max(1.0, std::abs(expected));
+	}
+
+	template <typename T>
+	void compareToReference(std::vector<T> const& img, std::vector<T> const& ref, size_t const dim[3], int bins,
+		char const* name, bool printTimes)
+	{
+		size_t index[3] = {0, 0, 0};
+		auto start = std::chrono::steady_clock::now();
+		auto fused = computeSimilarity(img.data(), ref.data(), dim, index, dim, bins, true, true);
+		auto middle = std::chrono::steady_clock::now();
+		auto expected = MultiPassReference<T>(img, ref, bins).compute();
+		auto end = std::chrono::steady_clock::now();
+		if (printTimes)
+		{
+			std::cout << name << ", " << img.size() << " voxels: fused "
+				<< std::chrono::duration<double>(middle - start).count() << " s, multi-pass "
+				<< std::chrono::duration<double>(end - middle).count() << " s" << std::endl;
+		}
+		TestEqual(expected.count, fused.count);
+		TestEqual(expected.imgMin, fused.imgMin);
+		TestEqual(expected.imgMax, fused.imgMax);
+		TestEqual(expected.refMin, fused.refMin);
+		TestEqual(expected.refMax, fused.refMax);
+		TestAssert(relativeEqual(expected.imgMean, fused.imgMean));
+		TestAssert(relativeEqual(expected.refMean, fused.refMean));
+		TestAssert(relativeEqual(expected.imgVariance, fused.imgVariance));
+		TestAssert(relativeEqual(expected.refVariance, fused.refVariance));
+		TestAssert(relativeEqual(expected.mse, fused.mse));
+		TestAssert(relativeEqual(expected.mae, fused.mae));
+		TestAssert(relativeEqual(expected.normalizedCorrelation, fused.normalizedCorrelation));
+		TestAssert(relativeEqual(expected.covariance, fused.covariance));
+		TestEqual(expected.equalPixelRate, fused.equalPixelRate);
+		// histogram counts are identical, and so are the entropies computed from them:
+		TestEqual(expected.imgEntropy, fused.imgEntropy);
+		TestEqual(expected.refEntropy, fused.refEntropy);
+		TestEqual(expected.jointEntropy, fused.jointEntropy);
+	}
+
+	//! two correlated noisy images
+	template <typename T>
+	void createImages(size_t count, double minValue, double maxValue, std::vector<T>& img, std::vector<T>& ref)
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<double> value(minValue, maxValue);
+		std::normal_distribution<double> noise(0.0, (maxValue - minValue) / 20);
+		img.resize(count);
+		ref.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			double v = value(rng);
+			img[i] = static_cast<T>(v);
+			ref[i] = static_cast<T>(std::min(maxValue, std::max(minValue, v + noise(rng))));
+		}
+	}
+}
+
+BEGIN_TEST
+{
+	// identical images:
+	{
+		std::vector<unsigned char> img = {0, 1, 2, 3, 4, 5, 6, 7};
+		size_t dim[3] = {2, 2, 2}, index[3] = {0, 0, 0};
+		auto v = computeSimilarity(img.data(), img.data(), dim, index, dim, 8, true, true);
+		TestEqual(0.0, v.mse);
+		TestEqual(0.0, v.mae);
+		TestEqualFloatingPoint(-1.0, v.normalizedCorrelation);
+		TestEqual(7.0 / 8, v.equalPixelRate);
+		TestEqualFloatingPoint(3.0, v.imgEntropy);
+		TestEqualFloatingPoint(3.0, v.jointEntropy);
+		TestEqualFloatingPoint(v.imgVariance, v.covariance * 8 / 7);
+	}
+	// sub-region:
+	{
+		std::vector<short> img(4 * 3 * 2), ref(4 * 3 * 2, 0);
+		for (size_t i = 0; i < img.size(); ++i)
+		{
+			img[i] = static_cast<short>(i);
+		}
+		size_t dim[3] = {4, 3, 2}, index[3] = {1, 1, 1}, size[3] = {2, 2, 1};
+		auto v = computeSimilarity(img.data(), ref.data(), dim, index, size, 4, false, false);
+		TestEqual(static_cast<size_t>(4), v.count);
+		TestEqual(17.0, v.imgMin);   // (1, 1, 1) -> 12 + 4 + 1
+		TestEqual(22.0, v.imgMax);   // (2, 2, 1) -> 12 + 8 + 2
+		TestEqualFloatingPoint((17.0 + 18 + 21 + 22) / 4, v.mae);
+	}
+	// random images of different types, compared to the multi-pass computation:
+	size_t dim[3] = {97, 64, 40};
+	size_t count = dim[0] * dim[1] * dim[2];
+	{
+		std::vector<unsigned char> img, ref;
+		createImages(count, 0, 255, img, ref);
+		compareToReference(img, ref, dim, 256, "unsigned char", true);
+		compareToReference(img, ref, dim, 100, "unsigned char, 100 bins", false);
+	}
+	{
+		std::vector<unsigned short> img, ref;
+		createImages(count, 1000, 40000, img, ref);
+		compareToReference(img, ref, dim, 256, "unsigned short", true);
+	}
+	{
+		std::vector<float> img, ref;
+		createImages(count, -1.5, 2.5, img, ref);
+		compareToReference(img, ref, dim, 128, "float", true);
+	}
+	{
+		std::vector<int> img, ref;
+		createImages(count, -70000, 70000, img, ref);
+		compareToReference(img, ref, dim, 256, "int", true);
+	}
+}
+END_TEST
@@ -0,0 +1,9 @@
+if (openiA_TESTING_ENABLED)
+	get_filename_component(CoreSrcDir "../libs/base" REALPATH BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
+	add_executable(NModalPCAKernelTest NModalTF/iANModalPCAKernelTest.cpp)
+	target_include_directories(NModalPCAKernelTest PRIVATE ${CoreSrcDir})   # for iASimpleTester.h
+	add_test(NAME NModalPCAKernelTest COMMAND NModalPCAKernelTest)
+	if (openiA_USE_IDE_FOLDERS)
+		set_property(TARGET NModalPCAKernelTest PROPERTY FOLDER "Tests")
+	endif()
+endif()
@@ -3,6 +3,8 @@
 
 #include "iANModalPCADataSetReducer.h"
 
+#include "iANModalPCAKernel.h"
+
 #include <iADataSet.h>
 #include <iAPerformanceHelper.h>
 #include <iATypedCallHelper.h>
@@ -163,30 +165,18 @@ void iANModalPCADataSetReducer::ownPCA(std::vector<iAConnector>& c)
 	{
 		numVoxels *= size[dim_i];
 	}
-	if (numVoxels >= std::numeric_limits<int>::max())
-	{
-		LOG(lvlWarn, QString("Input image (number of voxels: %1) exceeds size that can be handled "
-			"(current voxel number maximum: %2)!").arg(numVoxels).arg(std::numeric_limits<int>::max()));
-	}
 	if (numInputs >= std::numeric_limits<int>::max())
 	{
 		LOG(lvlWarn, QString("Number of input images (%1) exceeds size that can be handled "
 			"(current limit: %2)!").arg(numInputs).arg(std::numeric_limits<int>::max()));
 	}
 
-	// Set up input matrix
-	vnl_matrix<double> inputs(numInputs, numVoxels);
+	// Access input buffers directly
+	std::vector<T const*> inputs(numInputs);
 	for (size_t row_i = 0; row_i < numInputs; row_i++)
 	{
 		auto input = dynamic_cast<const ImageType*>(c[row_i].itkImage());
-		auto iterator = itk::ImageRegionConstIterator<ImageType>(input, input->GetBufferedRegion());
-		iterator.GoToBegin();
-
-		for (size_t col_i = 0; col_i < numVoxels; col_i++)
-		{
-			inputs[row_i][col_i] = iterator.Get();
-			++iterator;
-		}
+		inputs[row_i] = input->GetBufferPointer();
 
 #ifndef NDEBUG
 		//storeImage(c[row_i].itkImage(), "pca_input_itk_" + QString::number(row_i) + ".mhd", true);
@@ -204,193 +194,51 @@ void iANModalPCADataSetReducer::ownPCA(std::vector<iAConnector>& c)
 	LOG(lvlDebug, QString::number(numThreads) + " threads available\n");
 #endif
 
-	// Calculate means
-	vnl_vector<double> means;
-	means.set_size(numInputs);
-
-	// Calculate inner product (lower triangle) (for covariance matrix)
-	vnl_matrix<double> innerProd;
-	innerProd.set_size(numInputs, numInputs);
-	innerProd.fill(0);
-
-	// Initialize the reconstructed matrix (with zeros)
-	vnl_matrix<double> reconstructed(numOutputs, numVoxels);
-
-	// Eigenvectors
-	vnl_matrix<double> evecs_innerProd;
-
-	// Normalize row-wise (i.e. image-wise) to range 0..1
-	double max_val = -DBL_MAX;
-	double min_val = DBL_MAX;
-
-#pragma omp parallel
+	// Calculate means and inner product (for covariance matrix), all in one pass
+	auto stats = iANModalPCA::computeStatistics(inputs, static_cast<long long>(numVoxels));
+	vnl_vector<double> means(stats.means.data(), numInputs);
+	vnl_matrix<double> innerProd(numInputs, numInputs);
+	for (size_t ix = 0; ix < numInputs; ix++)
 	{
-		// Calculate means
-		for (size_t img_i = 0; img_i < numInputs; img_i++)
-		{
-			double mean = 0;
-			// TODO: Use omp reduction?
-#pragma omp for nowait
-			for (int i = 0; i < static_cast<int>(numVoxels); i++)
-			{
-				//means[img_i] += inputs[img_i][i];
-				mean += inputs[img_i][i];
-			}
-#pragma omp single
-			means[img_i] = 0;
-#pragma omp barrier
-#pragma omp atomic
-			means[img_i] += mean;
-#pragma omp barrier
-#pragma omp single
-			means[img_i] /= numVoxels;
-		}
-
-#ifndef NDEBUG
-#pragma omp single
-		DEBUG_LOG_VECTOR(means, "Means");
-#endif
-
-		// Calculate inner product (lower triangle) (for covariance matrix)
-		for (size_t ix = 0; ix < numInputs; ix++)
+		for (size_t iy = 0; iy < numInputs; iy++)
 		{
-			for (size_t iy = 0; iy <= ix; iy++)
-			{
-				double innerProd_thread = 0;
-#pragma omp for nowait
-				for (int i = 0; i < static_cast<int>(numVoxels); i++)
-				{
-					auto mx = inputs[ix][i] - means[ix];
-					auto my = inputs[iy][i] - means[iy];
-					//innerProd[ix][iy] += (mx * my); // Product takes place!
-					innerProd_thread += (mx * my);
-				}
-#pragma omp single
-				innerProd[ix][iy] = 0;
-#pragma omp barrier
-#pragma omp atomic
-				innerProd[ix][iy] += innerProd_thread;
-			}
-		}
-
-		// Fill upper triangle (make symmetric)
-#pragma omp for
-		for (int ix = 0; ix < static_cast<int>(numInputs - 1); ix++)
-		{
-			for (size_t iy = ix + 1; iy < numInputs; iy++)
-			{
-				innerProd[ix][iy] = innerProd[iy][ix];
-			}
-		}
-
-#ifndef NDEBUG
-#pragma omp single
-		DEBUG_LOG_MATRIX(innerProd, "Inner product");
-#endif
-
-#pragma omp single
-		{
-			// Make covariance matrix (divide by N-1)
-			if (numInputs - 1 != 0)
-			{
-				innerProd /= (numVoxels - 1);
-			}
-			else
-			{
-				innerProd.fill(0);
-			}
-
-#ifndef NDEBUG
-			DEBUG_LOG_MATRIX(innerProd, "Covariance matrix");
-#endif
-
-			// Solve eigenproblem
-			vnl_matrix<double> eye(numInputs, numInputs);  // (eye)dentity matrix
-			eye.set_identity();
-			//DEBUG_LOG_MATRIX(eye, "Identity");
-			vnl_generalized_eigensystem evecs_evals_innerProd(innerProd, eye);
-			evecs_innerProd = evecs_evals_innerProd.V;
-			evecs_innerProd.fliplr();  // Flipped because VNL sorts eigenvectors in ascending order
-			if (numInputs != numOutputs)
-				evecs_innerProd.extract(numInputs, numOutputs);  // Keep only 'numOutputs' columns
-				//auto evals_innerProd = evecs_evals_innerProd.D.diagonal();
-
-#ifndef NDEBUG
-			DEBUG_LOG_MATRIX(evecs_innerProd, "Eigenvectors");
-			DEBUG_LOG_VECTOR(evecs_evals_innerProd.D.diagonal(), "Eigenvalues");
-#endif
-		}
-
-		// Initialize the reconstructed matrix (with zeros)
-		for (size_t row_i = 0; row_i < numOutputs; row_i++)
-		{
-#pragma omp for nowait
-			for (int col_i = 0; col_i < static_cast<int>(numVoxels); col_i++)
-			{
-				reconstructed[row_i][col_i] = 0;
-			}
+			innerProd[ix][iy] = stats.comoment(ix, iy);
 		}
+	}
 
-#pragma omp barrier
+	DEBUG_LOG_VECTOR(means, "Means");
+	DEBUG_LOG_MATRIX(innerProd, "Inner product");
 
-		// Transform images to principal components
-		for (size_t row_i = 0; row_i < numInputs; row_i++)
-		{
-			for (size_t vec_i = 0; vec_i < numOutputs; vec_i++)
-			{
-				auto evec_elem = evecs_innerProd[row_i][vec_i];
-				//double reconstructed_thread = 0;
-#pragma omp for nowait
-				for (int col_i = 0; col_i < static_cast<int>(numVoxels); col_i++)
-				{
-					auto voxel_value = inputs[row_i][col_i];
-					reconstructed[vec_i][col_i] += (voxel_value * evec_elem);
-				}
-			}
-		}
+	// Make covariance matrix (divide by N-1)
+	if (numInputs - 1 != 0)
+	{
+		innerProd /= (numVoxels - 1);
+	}
+	else
+	{
+		innerProd.fill(0);
+	}
 
-#pragma omp barrier
+	DEBUG_LOG_MATRIX(innerProd, "Covariance matrix");
 
-		// Normalize row-wise (i.e. image-wise) to range 0..1
-		for (size_t vec_i = 0; vec_i < numOutputs; vec_i++)
-		{
-			double max_thread = -DBL_MAX;
-			double min_thread = DBL_MAX;
-
-#pragma omp for
-			for (int i = 0; i < static_cast<int>(numVoxels); i++)
-			{
-				auto rec = reconstructed[vec_i][i];
-				//max_val = max_val > rec ? max_val : rec;
-				//min_val = min_val < rec ? min_val : rec;
-				max_thread = max_thread > rec ? max_thread : rec;
-				min_thread = min_thread < rec ? min_thread : rec;
-			}
-			// Implicit barrier
-
-#pragma omp critical  // Unfortunatelly, no atomic max :(
-			max_val = max_thread > max_val ? max_thread : max_val;
-#pragma omp critical  // Unfortunatelly, no atomic min :(
-			min_val = min_thread < min_val ? min_thread : min_val;
-
-#pragma omp barrier
-
-#pragma omp for nowait
-			for (int i = 0; i < static_cast<int>(numVoxels); i++)
-			{
-				auto old = reconstructed[vec_i][i];
-				reconstructed[vec_i][i] = (old - min_val) / (max_val - min_val) * 65535.0;
-			}
-		}
+	// Solve eigenproblem
+	vnl_matrix<double> eye(numInputs, numInputs);  // (eye)dentity matrix
+	eye.set_identity();
+	vnl_generalized_eigensystem evecs_evals_innerProd(innerProd, eye);
+	vnl_matrix<double> evecs_innerProd = evecs_evals_innerProd.V;
+	evecs_innerProd.fliplr();  // Flipped because VNL sorts eigenvectors in ascending order
+	if (numInputs != numOutputs)
+		evecs_innerProd = evecs_innerProd.extract(numInputs, numOutputs);  // Keep only 'numOutputs' columns
 
-	}  // end of parallel block
+	DEBUG_LOG_MATRIX(evecs_innerProd, "Eigenvectors");
+	DEBUG_LOG_VECTOR(evecs_evals_innerProd.D.diagonal(), "Eigenvalues");
 
-	// Reshape reconstructed vectors into image
+	// Create output images
 	c.resize(numOutputs);
+	std::vector<typename ImageType::PixelType*> outputBuffers(numOutputs);
+	std::vector<typename ImageType::Pointer> outputs(numOutputs);
 	for (size_t out_i = 0; out_i < numOutputs; out_i++)
 	{
-		auto recvec = reconstructed.get_row(out_i);
-
 		auto output = ImageType::New();
 		typename ImageType::RegionType region;
 		region.SetSize(itkImg0->GetLargestPossibleRegion().GetSize());
@@ -398,25 +246,21 @@ void iANModalPCADataSetReducer::ownPCA(std::vector<iAConnector>& c)
 		output->SetRegions(region);
 		output->SetSpacing(itkImg0->GetSpacing());
 		output->Allocate();
-		auto ite = itk::ImageRegionIterator<ImageType>(output, region);
+		outputBuffers[out_i] = output->GetBufferPointer();
+		outputs[out_i] = output;
+	}
 
-		unsigned int i = 0;
-		ite.GoToBegin();
-		while (!ite.IsAtEnd())
-		{
-			double rec = recvec[i];
-			typename ImageType::PixelType rec_cast = static_cast<typename ImageType::PixelType>(rec);
-			ite.Set(rec_cast);
-
-			++ite;
-			++i;
-		}
+	// Transform images to principal components, normalized image-wise to range 0..65535
+	std::vector<double> evecs(evecs_innerProd.data_block(), evecs_innerProd.data_block() + numInputs * numOutputs);
+	iANModalPCA::projectNormalized(inputs, static_cast<long long>(numVoxels), evecs, outputBuffers, 65535.0);
 
+	for (size_t out_i = 0; out_i < numOutputs; out_i++)
+	{
 #ifndef NDEBUG
-		//storeImage(output, "pca_output_before_conversion_" + QString::number(out_i) + ".mhd", true);
-		storeImage(output, "pca_output_" + QString::number(out_i) + ".mhd", true);
+		//storeImage(outputs[out_i], "pca_output_before_conversion_" + QString::number(out_i) + ".mhd", true);
+		storeImage(outputs[out_i], "pca_output_" + QString::number(out_i) + ".mhd", true);
 #endif
 
-		c[out_i].setImage(output);
+		c[out_i].setImage(outputs[out_i]);
 	}
 }
@@ -0,0 +1,231 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <algorithm>
+#include <cstddef>    // for size_t
+#include <limits>
+#include <vector>
+
+//! Kernels of the principal component analysis in iANModalPCADataSetReducer, working on raw channel buffers.
+namespace iANModalPCA
+{
+	//! number of voxels processed together; the values of all channels for one block should fit into cache
+	const long long BlockSize = 1024;
+
+	//! Means and co-moments (sums of products of deviations from the mean) of a number of channels.
+	struct Statistics
+	{
+		explicit Statistics(size_t channelCount) :
+			count(0),
+			means(channelCount, 0.0),
+			comoments(channelCount * (channelCount + 1) / 2, 0.0)
+		{}
+		//! index of the co-moment of channels i and j (i <= j) in comoments
+		size_t index(size_t i, size_t j) const
+		{
+			return i * means.size() - i * (i + 1) / 2 + j;
+		}
+		//! the co-moment of channels i and j (any order)
+		double comoment(size_t i, size_t j) const
+		{
+			return (i <= j) ? comoments[index(i, j)] : comoments[index(j, i)];
+		}
+		//! Adds the statistics of another set of voxels, using the pairwise update of Chan et al.
+		//! (numerically stable, since only deviations from the means are ever summed).
+		void add(Statistics const& other)
+		{
+			if (other.count == 0)
+			{
+				return;
+			}
+			double const n = static_cast<double>(count + other.count);
+			double const factor = static_cast<double>(count) * other.count / n;
+			std::vector<double> delta(means.size());
+			for (size_t c = 0; c < means.size(); ++c)
+			{
+				delta[c] = other.means[c] - means[c];
+			}
+			for (size_t i = 0; i < means.size(); ++i)
+			{
+				for (size_t j = i; j < means.size(); ++j)
+				{
+					comoments[index(i, j)] += other.comoments[index(i, j)] + delta[i] * delta[j] * factor;
+				}
+			}
+			for (size_t c = 0; c < means.size(); ++c)
+			{
+				means[c] += delta[c] * other.count / n;
+			}
+			count += other.count;
+		}
+
+		long long count;                //!< number of voxels
+		std::vector<double> means;      //!< mean of each channel
+		std::vector<double> comoments;  //!< upper triangle (including diagonal) of the co-moment matrix, row by row
+	};
+
+	//! Computes means and co-moments of all channels in a single pass over the voxels.
+	//! Blocks of voxels are processed in parallel; the statistics of a block are computed from the block
+	//! (which is in cache by then) and combined into per-thread statistics, which are combined at the end.
+	//! @param channels the voxel buffers of all channels
+	//! @param voxelCount the number of voxels in each channel
+	template <typename T>
+	Statistics computeStatistics(std::vector<T const*> const& channels, long long voxelCount)
+	{
+		size_t const channelCount = channels.size();
+		Statistics result(channelCount);
+		long long const blockCount = (voxelCount + BlockSize - 1) / BlockSize;
+#pragma omp parallel
+		{
+			Statistics threadStats(channelCount);
+			Statistics blockStats(channelCount);
+			std::vector<double> deviations(channelCount * BlockSize);
+#pragma omp for schedule(static)
+			for (long long b = 0; b < blockCount; ++b)
+			{
+				long long const begin = b * BlockSize;
+				int const blockVoxels = static_cast<int>(std::min(BlockSize, voxelCount - begin));
+				for (size_t c = 0; c < channelCount; ++c)
+				{
+					T const* values = channels[c] + begin;
+					double sum = 0;
+					for (int v = 0; v < blockVoxels; ++v)
+					{
+						sum += values[v];
+					}
+					double const mean = sum / blockVoxels;
+					blockStats.means[c] = mean;
+					double* dev = deviations.data() + c * BlockSize;
+					for (int v = 0; v < blockVoxels; ++v)
+					{
+						dev[v] = values[v] - mean;
+					}
+				}
+				for (size_t i = 0; i < channelCount; ++i)
+				{
+					double const* devI = deviations.data() + i * BlockSize;
+					size_t j = i;
+					// four channels at a time, for independent accumulators and fewer loads of devI:
+					for (; j + 4 <= channelCount; j += 4)
+					{
+						double const* devJ = deviations.data() + j * BlockSize;
+						double prod0 = 0, prod1 = 0, prod2 = 0, prod3 = 0;
+						for (int v = 0; v < blockVoxels; ++v)
+						{
+							double const d = devI[v];
+							prod0 += d * devJ[v];
+							prod1 += d * devJ[BlockSize + v];
+							prod2 += d * devJ[2 * BlockSize + v];
+							prod3 += d * devJ[3 * BlockSize + v];
+						}
+						blockStats.comoments[blockStats.index(i, j)] = prod0;
+						blockStats.comoments[blockStats.index(i, j + 1)] = prod1;
+						blockStats.comoments[blockStats.index(i, j + 2)] = prod2;
+						blockStats.comoments[blockStats.index(i, j + 3)] = prod3;
+					}
+					for (; j < channelCount; ++j)
+					{
+						double const* devJ = deviations.data() + j * BlockSize;
+						double prod = 0;
+						for (int v = 0; v < blockVoxels; ++v)
+						{
+							prod += devI[v] * devJ[v];
+						}
+						blockStats.comoments[blockStats.index(i, j)] = prod;
+					}
+				}
+				blockStats.count = blockVoxels;
+				threadStats.add(blockStats);
+			}
+#pragma omp critical
+			result.add(threadStats);
+		}
+		return result;
+	}
+
+	//! Projects the values of a block of voxels onto the given vectors.
+	//! @param projections receives the projections, BlockSize values per vector
+	template <typename T>
+	void projectBlock(std::vector<T const*> const& channels, long long begin, int blockVoxels,
+		std::vector<double> const& vectors, size_t vectorCount, double* projections)
+	{
+		std::fill(projections, projections + vectorCount * BlockSize, 0.0);
+		for (size_t c = 0; c < channels.size(); ++c)
+		{
+			T const* values = channels[c] + begin;
+			for (size_t p = 0; p < vectorCount; ++p)
+			{
+				double const factor = vectors[c * vectorCount + p];
+				double* proj = projections + p * BlockSize;
+				for (int v = 0; v < blockVoxels; ++v)
+				{
+					proj[v] += values[v] * factor;
+				}
+			}
+		}
+	}
+
+	//! Projects all voxels onto the given vectors (e.g. principal components), and scales each projection to the
+	//! range 0..maxValue. One pass determines the range of each projection, a second one writes the scaled outputs.
+	//! @param channels the voxel buffers of all channels
+	//! @param voxelCount the number of voxels in each channel
+	//! @param vectors the vectors to project onto, row-major with one row per channel and one column per vector
+	//! @param outputs the voxel buffers receiving the scaled projections, one per vector
+	//! @param maxValue the value the maximum of each projection is mapped to
+	template <typename T, typename TOut>
+	void projectNormalized(std::vector<T const*> const& channels, long long voxelCount,
+		std::vector<double> const& vectors, std::vector<TOut*> const& outputs, double maxValue)
+	{
+		size_t const vectorCount = outputs.size();
+		long long const blockCount = (voxelCount + BlockSize - 1) / BlockSize;
+		std::vector<double> minValues(vectorCount, std::numeric_limits<double>::max());
+		std::vector<double> maxValues(vectorCount, std::numeric_limits<double>::lowest());
+#pragma omp parallel
+		{
+			std::vector<double> projections(vectorCount * BlockSize);
+			std::vector<double> threadMin(vectorCount, std::numeric_limits<double>::max());
+			std::vector<double> threadMax(vectorCount, std::numeric_limits<double>::lowest());
+#pragma omp for schedule(static)
+			for (long long b = 0; b < blockCount; ++b)
+			{
+				long long const begin = b * BlockSize;
+				int const blockVoxels = static_cast<int>(std::min(BlockSize, voxelCount - begin));
+				projectBlock(channels, begin, blockVoxels, vectors, vectorCount, projections.data());
+				for (size_t p = 0; p < vectorCount; ++p)
+				{
+					double const* proj = projections.data() + p * BlockSize;
+					for (int v = 0; v < blockVoxels; ++v)
+					{
+						threadMin[p] = std::min(threadMin[p], proj[v]);
+						threadMax[p] = std::max(threadMax[p], proj[v]);
+					}
+				}
+			}
+#pragma omp critical
+			for (size_t p = 0; p < vectorCount; ++p)
+			{
+				minValues[p] = std::min(minValues[p], threadMin[p]);
+				maxValues[p] = std::max(maxValues[p], threadMax[p]);
+			}
+#pragma omp barrier
+#pragma omp for schedule(static)
+			for (long long b = 0; b < blockCount; ++b)
+			{
+				long long const begin = b * BlockSize;
+				int const blockVoxels = static_cast<int>(std::min(BlockSize, voxelCount - begin));
+				projectBlock(channels, begin, blockVoxels, vectors, vectorCount, projections.data());
+				for (size_t p = 0; p < vectorCount; ++p)
+				{
+					double const* proj = projections.data() + p * BlockSize;
+					double const range = maxValues[p] - minValues[p];
+					TOut* out = outputs[p] + begin;
+					for (int v = 0; v < blockVoxels; ++v)
+					{
+						out[v] = static_cast<TOut>((range == 0) ? 0.0 : (proj[v] - minValues[p]) / range * maxValue);
+					}
+				}
+			}
+		}
+	}
+}
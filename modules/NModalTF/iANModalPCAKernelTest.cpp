@@ -0,0 +1,177 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "iANModalPCAKernel.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	//! Reference following the previous computation in iANModalPCADataSetReducer:
+	//! one pass for the means, then one pass over all voxels per pair of channels.
+	template <typename T>
+	std::vector<double> multiPassCovariance(std::vector<std::vector<T>> const& channels)
+	{
+		size_t n = channels.size();
+		size_t voxelCount = channels[0].size();
+		std::vector<double> means(n, 0.0);
+		for (size_t c = 0; c < n; ++c)
+		{
+			for (size_t v = 0; v < voxelCount; ++v)
+			{
+				means[c] += channels[c][v];
+			}
+			means[c] /= voxelCount;
+		}
+		std::vector<double> result(n * n);
+		for (size_t ix = 0; ix < n; ++ix)
+		{
+			for (size_t iy = 0; iy <= ix; ++iy)
+			{
+				double prod = 0;
+				for (size_t v = 0; v < voxelCount; ++v)
+				{
+					prod += (channels[ix][v] - means[ix]) * (channels[iy][v] - means[iy]);
+				}
+				result[ix * n + iy] = result[iy * n + ix] = prod;
+			}
+		}
+		return result;
+	}
+
+	//! Reference projection: a full double image per component, then scaling of each component to 0..maxValue
+	template <typename T>
+	std::vector<std::vector<T>> separateProjection(std::vector<std::vector<T>> const& channels,
+		std::vector<double> const& vectors, size_t vectorCount, double maxValue)
+	{
+		size_t voxelCount = channels[0].size();
+		std::vector<std::vector<T>> result(vectorCount, std::vector<T>(voxelCount));
+		for (size_t p = 0; p < vectorCount; ++p)
+		{
+			std::vector<double> proj(voxelCount, 0.0);
+			for (size_t c = 0; c < channels.size(); ++c)
+			{
+				for (size_t v = 0; v < voxelCount; ++v)
+				{
+					proj[v] += channels[c][v] * vectors[c * vectorCount + p];
+				}
+			}
+			double minVal = *std::min_element(proj.begin(), proj.end());
+			double maxVal = *std::max_element(proj.begin(), proj.end());
+			for (size_t v = 0; v < voxelCount; ++v)
+			{
+				result[p][v] = static_cast<T>((proj[v] - minVal) / (maxVal - minVal) * maxValue);
+			}
+		}
+		return result;
+	}
+
+	//! correlated channels (a common signal plus noise), with a large offset to challenge numerical stability
+	std::vector<std::vector<unsigned short>> createChannels(size_t channelCount, size_t voxelCount)
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<double> signal(0.0, 1000.0);
+		std::normal_distribution<double> noise(0.0, 100.0);
+		std::vector<std::vector<unsigned short>> result(channelCount, std::vector<unsigned short>(voxelCount));
+		for (size_t v = 0; v < voxelCount; ++v)
+		{
+			double s = signal(rng);
+			for (size_t c = 0; c < channelCount; ++c)
+			{
+				double value = 30000 + s * (c % 3 + 1) + noise(rng);
+				result[c][v] = static_cast<unsigned short>(std::max(0.0, std::min(65535.0, value)));
+			}
+		}
+		return result;
+	}
+
+	template <typename T>
+	std::vector<T const*> pointers(std::vector<std::vector<T>> const& channels)
+	{
+		std::vector<T const*> result;
+		for (auto const& c : channels)
+		{
+			result.push_back(c.data());
+		}
+		return result;
+	}
+}
+
+BEGIN_TEST
+{
+	// small example: two perfectly correlated channels, one constant channel
+	{
+		std::vector<std::vector<unsigned short>> channels = {{1, 2, 3, 4, 5}, {2, 4, 6, 8, 10}, {7, 7, 7, 7, 7}};
+		auto stats = iANModalPCA::computeStatistics(pointers(channels), 5);
+		TestEqual(stats.count, 5LL);
+		TestEqualFloatingPoint(stats.means[0], 3.0);
+		TestEqualFloatingPoint(stats.means[1], 6.0);
+		TestEqualFloatingPoint(stats.means[2], 7.0);
+		TestEqualFloatingPoint(stats.comoment(0, 0), 10.0);
+		TestEqualFloatingPoint(stats.comoment(0, 1), 20.0);
+		TestEqualFloatingPoint(stats.comoment(1, 0), 20.0);
+		TestEqualFloatingPoint(stats.comoment(1, 1), 40.0);
+		TestEqualFloatingPoint(stats.comoment(2, 2), 0.0);
+		std::vector<double> vectors = {1.0, 0.0, 0.0};   // project onto first channel only
+		std::vector<unsigned short> out(5);
+		std::vector<unsigned short*> outputs = {out.data()};
+		iANModalPCA::projectNormalized(pointers(channels), 5, vectors, outputs, 100.0);
+		TestEqual(out[0], static_cast<unsigned short>(0));
+		TestEqual(out[2], static_cast<unsigned short>(50));
+		TestEqual(out[4], static_cast<unsigned short>(100));
+	}
+	// sweep over number of modalities and volume size, compared to the multi-pass computation:
+	for (size_t channelCount : {2, 5, 10, 20})
+	{
+		for (size_t edge : {32, 64, 96})
+		{
+			size_t voxelCount = edge * edge * edge;
+			auto channels = createChannels(channelCount, voxelCount);
+			auto start = std::chrono::steady_clock::now();
+			auto stats = iANModalPCA::computeStatistics(pointers(channels), static_cast<long long>(voxelCount));
+			auto middle = std::chrono::steady_clock::now();
+			auto expected = multiPassCovariance(channels);
+			auto end = std::chrono::steady_clock::now();
+			double maxDiff = 0, maxValue = 0;
+			for (size_t i = 0; i < channelCount; ++i)
+			{
+				for (size_t j = 0; j < channelCount; ++j)
+				{
+					maxDiff = std::max(maxDiff, std::abs(expected[i * channelCount + j] - stats.comoment(i, j)));
+					maxValue = std::max(maxValue, std::abs(expected[i * channelCount + j]));
+				}
+			}
+			TestAssert(maxDiff <= 1e-9 * maxValue);
+
+			// arbitrary orthonormal-ish vectors are enough for comparing the projection:
+			size_t vectorCount = std::min(channelCount, static_cast<size_t>(3));
+			std::vector<double> vectors(channelCount * vectorCount);
+			for (size_t i = 0; i < vectors.size(); ++i)
+			{
+				vectors[i] = std::sin(static_cast<double>(i + 1));
+			}
+			std::vector<std::vector<unsigned short>> projected(vectorCount, std::vector<unsigned short>(voxelCount));
+			std::vector<unsigned short*> outputs;
+			for (auto& p : projected)
+			{
+				outputs.push_back(p.data());
+			}
+			auto projStart = std::chrono::steady_clock::now();
+			iANModalPCA::projectNormalized(pointers(channels), static_cast<long long>(voxelCount), vectors, outputs, 65535.0);
+			auto projMiddle = std::chrono::steady_clock::now();
+			auto expectedProjection = separateProjection(channels, vectors, vectorCount, 65535.0);
+			auto projEnd = std::chrono::steady_clock::now();
+			TestAssert(projected == expectedProjection);
+
+			std::cout << channelCount << " modalities, " << edge << "^3 voxels: covariance single pass "
+				<< std::chrono::duration<double>(middle - start).count() << " s, multi-pass "
+				<< std::chrono::duration<double>(end - middle).count() << " s; projection fused "
+				<< std::chrono::duration<double>(projMiddle - projStart).count() << " s, separate "
+				<< std::chrono::duration<double>(projEnd - projMiddle).count() << " s" << std::endl;
+		}
+	}
+}
+END_TEST
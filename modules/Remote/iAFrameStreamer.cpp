@@ -0,0 +1,80 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iAFrameStreamer.h"
+
+#include "iAImagegenerator.h"
+
+#include <vtkImageData.h>
+
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <algorithm>
+
+iAFrameStreamer::iAFrameStreamer(QObject* parent) :
+	QObject(parent)
+{
+	// leave one core for the GUI thread (which grabs the frames and sends them out):
+	m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+iAFrameStreamer::~iAFrameStreamer()
+{
+	m_pool.waitForDone();
+}
+
+void iAFrameStreamer::submit(QString const& viewID, vtkSmartPointer<vtkImageData> image, int quality, double ratio)
+{
+	++m_stats.submitted;
+	auto& view = m_views[viewID];
+	Frame frame{image, quality, ratio};
+	if (view.busy)
+	{
+		if (view.hasPending)
+		{
+			++m_stats.dropped;
+		}
+		view.pending = frame;
+		view.hasPending = true;
+		return;
+	}
+	startEncoding(viewID, frame);
+}
+
+void iAFrameStreamer::startEncoding(QString const& viewID, Frame const& frame)
+{
+	m_views[viewID].busy = true;
+	m_pool.start([this, viewID, frame]()
+	{
+		QElapsedTimer t; t.start();
+		auto img = iAImagegenerator::encodeImage(frame.image, frame.quality, frame.ratio);
+		auto encodeMS = t.elapsed();
+		// hand result back to GUI thread:
+		QMetaObject::invokeMethod(this, [this, viewID, img, encodeMS]()
+		{
+			encodingFinished(viewID, img, encodeMS);
+		}, Qt::QueuedConnection);
+	});
+}
+
+void iAFrameStreamer::encodingFinished(QString const& viewID, QByteArray const& img, qint64 encodeMS)
+{
+	++m_stats.encoded;
+	m_stats.bytes += img.size();
+	m_stats.encodeMS += encodeMS;
+	auto& view = m_views[viewID];
+	view.busy = false;
+	if (view.hasPending)
+	{
+		view.hasPending = false;
+		Frame next = view.pending;
+		view.pending = Frame();
+		startEncoding(viewID, next);
+	}
+	emit imageEncoded(img, viewID);
+}
+
+iAFrameStreamer::Statistics const& iAFrameStreamer::statistics() const
+{
+	return m_stats;
+}
@@ -0,0 +1,66 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include <vtkSmartPointer.h>
+
+#include <QByteArray>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+class vtkImageData;
+
+//! Encodes the frames grabbed from the remote views on a pool of worker threads.
+//! Frames are coalesced per view: At most one frame per view is encoded at a time;
+//! while it is being encoded, only the most recently submitted frame of that view
+//! is kept, older ones are dropped as stale.
+class iAFrameStreamer: public QObject
+{
+	Q_OBJECT
+public:
+	iAFrameStreamer(QObject* parent = nullptr);
+	~iAFrameStreamer();
+	//! Submit a new frame of a view for encoding; needs to be called from the GUI thread.
+	//! @param viewID the ID of the view the frame belongs to
+	//! @param image the grabbed frame
+	//! @param quality the JPEG quality (0..100)
+	//! @param ratio the scaling factor to apply to the frame before encoding (0..1])
+	void submit(QString const& viewID, vtkSmartPointer<vtkImageData> image, int quality, double ratio);
+
+	//! Statistics on the encoded frames, for benchmarking
+	struct Statistics
+	{
+		qint64 submitted = 0;    //!< number of frames submitted
+		qint64 dropped = 0;      //!< number of frames dropped because a newer frame of the same view was submitted
+		qint64 encoded = 0;      //!< number of frames encoded
+		qint64 bytes = 0;        //!< total size of all encoded frames, in bytes
+		qint64 encodeMS = 0;     //!< total time spent encoding (summed over all worker threads), in milliseconds
+	};
+	Statistics const& statistics() const;
+
+Q_SIGNALS:
+	//! emitted (in the GUI thread) whenever encoding a frame of a view has finished
+	void imageEncoded(QByteArray img, QString viewID);
+
+private:
+	struct Frame
+	{
+		vtkSmartPointer<vtkImageData> image;
+		int quality = 100;
+		double ratio = 1.0;
+	};
+	struct ViewState
+	{
+		bool busy = false;       //!< whether a frame of this view is currently being encoded
+		bool hasPending = false; //!< whether pending contains a frame waiting to be encoded
+		Frame pending;           //!< the latest frame submitted while busy
+	};
+	void startEncoding(QString const& viewID, Frame const& frame);
+	void encodingFinished(QString const& viewID, QByteArray const& img, qint64 encodeMS);
+
+	QThreadPool m_pool;
+	QMap<QString, ViewState> m_views;   //!< per-view state; only accessed from the GUI thread
+	Statistics m_stats;
+};
@@ -4,12 +4,17 @@
 
 #include <iALog.h>
 
+#include <vtkImageData.h>
+#include <vtkImageResize.h>
 #include <vtkJPEGWriter.h>
 #include <vtkRenderWindow.h>
 #include <vtkUnsignedCharArray.h>
 #include <vtkWindowToImageFilter.h>
 
-#include <QElapsedTimer> 
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <algorithm>
 
 #ifdef CUDA_AVAILABLE
 #include <iACudaHelper.h>
@@ -104,19 +109,14 @@ namespace
 		cudaStream_t stream = nullptr;
 	};
 
-	QByteArray nvJPEGCreateImage(vtkRenderWindow* window, int quality)
+	QByteArray nvJPEGEncodeImage(vtkImageData* image, int quality)
 	{
-		QElapsedTimer t1; t1.start();
+		// the encoder state is shared, so only one image can be encoded at a time:
+		static QMutex cudaMutex;
+		QMutexLocker lock(&cudaMutex);
 		static iACudaImageGen cudaImageGen;
-		vtkNew<vtkWindowToImageFilter> w2if;
-		w2if->ShouldRerenderOff();
-		w2if->SetInput(window);
-		w2if->Update();
-
 		QElapsedTimer t2; t2.start();
 		// nvidia expects image flipped around y axis in comparison to VTK!
-
-		auto image = w2if->GetOutput();
 		vtkNew<vtkImageFlip> flipYFilter;
 		flipYFilter->SetFilteredAxis(1); // flip y axis
 		flipYFilter->SetInputData(image);
@@ -126,7 +126,7 @@ namespace
 		auto const dim = vtkImg->GetDimensions();
 		unsigned char* buffer = static_cast<unsigned char*>(vtkImg->GetScalarPointer());
 		assert(dim[2] == 1);
-		LOG(lvlDebug, QString("grab: %1 ms").arg(t2.elapsed()));
+		LOG(lvlDebug, QString("flip: %1 ms").arg(t2.elapsed()));
 
 		QElapsedTimer t3; t3.start();
 		auto data = cudaImageGen.BitmapToJpegCUDA(dim[0], dim[1], buffer, quality);
@@ -136,16 +136,11 @@ namespace
 
 #endif
 
-	QByteArray vtkTurboJPEGCreateImage(vtkRenderWindow* window, int quality)
+	QByteArray vtkTurboJPEGEncodeImage(vtkImageData* image, int quality)
 	{
-		vtkNew<vtkWindowToImageFilter> w2if;
-		w2if->ShouldRerenderOff();
-		w2if->SetInput(window);
-		w2if->Update();
-
 		QElapsedTimer t; t.start();
 		vtkNew<vtkJPEGWriter> writer;
-		writer->SetInputConnection(w2if->GetOutputPort());
+		writer->SetInputData(image);
 		writer->SetQuality(quality);
 		writer->WriteToMemoryOn();
 		writer->Write();
@@ -159,11 +154,41 @@ namespace
 
 QByteArray iAImagegenerator::createImage(vtkRenderWindow* window, int quality)
 {
+	auto image = grabImage(window);
+	return encodeImage(image, quality);
+}
+
+vtkSmartPointer<vtkImageData> iAImagegenerator::grabImage(vtkRenderWindow* window)
+{
+	vtkNew<vtkWindowToImageFilter> w2if;
+	w2if->ShouldRerenderOff();
+	w2if->SetInput(window);
+	w2if->Update();
+	auto result = vtkSmartPointer<vtkImageData>::New();
+	result->ShallowCopy(w2if->GetOutput());
+	return result;
+}
+
+QByteArray iAImagegenerator::encodeImage(vtkImageData* image, int quality, double ratio)
+{
+	vtkSmartPointer<vtkImageData> scaled = image;
+	auto const dim = image->GetDimensions();
+	if (ratio < 1.0)
+	{
+		vtkNew<vtkImageResize> resize;
+		resize->SetResizeMethodToOutputDimensions();
+		resize->SetOutputDimensions(
+			std::max(1, static_cast<int>(dim[0] * ratio)),
+			std::max(1, static_cast<int>(dim[1] * ratio)), 1);
+		resize->SetInputData(image);
+		resize->Update();
+		scaled = resize->GetOutput();
+	}
 #if CUDA_AVAILABLE
 	if (isCUDAAvailable())
 	{
-		return nvJPEGCreateImage(window, quality);
+		return nvJPEGEncodeImage(scaled, quality);
 	}
 #endif
-	return vtkTurboJPEGCreateImage(window, quality);
+	return vtkTurboJPEGEncodeImage(scaled, quality);
 }
@@ -2,8 +2,11 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #pragma once
 
+#include <vtkSmartPointer.h>
+
 #include <QObject>
 
+class vtkImageData;
 class vtkRenderWindow;
 
 class QByteArray;
@@ -12,5 +15,10 @@ class iAImagegenerator: QObject
 {
 	Q_OBJECT
 public:
+	//! Grab the current content of the given window and encode it as JPEG image of given quality.
 	static QByteArray createImage(vtkRenderWindow* window, int quality);
+	//! Grab the current content of the given window; needs to be called from the thread owning the window's OpenGL context (i.e. the GUI thread).
+	static vtkSmartPointer<vtkImageData> grabImage(vtkRenderWindow* window);
+	//! Encode a grabbed image as JPEG image of given quality, scaled by the given ratio (0..1]; can be called from any thread.
+	static QByteArray encodeImage(vtkImageData* image, int quality, double ratio = 1.0);
 };
@@ -2,19 +2,29 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iARemoteRenderer.h"
 
+#include "iAFrameStreamer.h"
 #include "iAImagegenerator.h"
 #include "iAViewHandler.h"
 #include "iAWebsocketAPI.h"
 
+#include <iAMathUtility.h>
+
 #include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
 #include <vtkRenderWindow.h>
 #include <vtkRendererCollection.h>
 #include <vtkUnsignedCharArray.h>
 
+#include <algorithm>
+
 iARemoteRenderer::iARemoteRenderer(int port):
-	m_websocket(std::make_unique<iAWebsocketAPI>(port))
+	m_websocket(std::make_unique<iAWebsocketAPI>(port)),
+	m_streamer(new iAFrameStreamer(this))
 {
+	connect(m_streamer, &iAFrameStreamer::imageEncoded, this, &iARemoteRenderer::imageHasChanged);
 	connect(this, &iARemoteRenderer::imageHasChanged, m_websocket.get(), &iAWebsocketAPI::sendViewIDUpdate);
+	connect(m_websocket.get(), &iAWebsocketAPI::viewQualityChanged, this, &iARemoteRenderer::setViewQuality);
+	connect(m_websocket.get(), &iAWebsocketAPI::viewSizeChanged, this, &iARemoteRenderer::setViewSize);
 }
 
 void iARemoteRenderer::addRenderWindow(vtkRenderWindow* window, QString const& viewID)
@@ -43,10 +53,38 @@ vtkRenderWindow* iARemoteRenderer::renderWindow(QString const& viewID)
 	return m_renderWindows[viewID];
 }
 
-void iARemoteRenderer::createImage(QString const& ViewID, int Quality)
+void iARemoteRenderer::createImage(QString const& ViewID, int Quality, double Ratio)
 {
 	QSignalBlocker block(views[ViewID]);
-	auto data = iAImagegenerator::createImage(m_renderWindows[ViewID],Quality);
+	// grabbing needs to happen here in the GUI thread, encoding is done by the worker pool:
+	auto image = iAImagegenerator::grabImage(m_renderWindows[ViewID]);
+	if (m_clientSizes.contains(ViewID))
+	{   // no need to send images larger than the client displays them:
+		auto const dim = image->GetDimensions();
+		auto const& clientSize = m_clientSizes[ViewID];
+		Ratio = std::min({Ratio,
+			static_cast<double>(clientSize.width()) / dim[0],
+			static_cast<double>(clientSize.height()) / dim[1]});
+	}
+	m_streamer->submit(ViewID, image, Quality, Ratio);
+}
 
-	imageHasChanged(data, ViewID);
+void iARemoteRenderer::setViewQuality(QString const& ViewID, int Quality, double Ratio)
+{
+	if (!views.contains(ViewID))
+	{
+		return;
+	}
+	views[ViewID]->quality = clamp(1, 100, Quality);
+	views[ViewID]->ratio = clamp(0.1, 1.0, Ratio);
+}
+
+void iARemoteRenderer::setViewSize(QString const& ViewID, int Width, int Height)
+{
+	if (Width <= 0 || Height <= 0)
+	{
+		m_clientSizes.remove(ViewID);
+		return;
+	}
+	m_clientSizes.insert(ViewID, QSize(Width, Height));
 }
@@ -4,9 +4,11 @@
 
 #include <QMap>
 #include <QObject>
+#include <QSize>
 
 #include <memory>
 
+class iAFrameStreamer;
 class iAViewHandler;
 class iAWebsocketAPI;
 
@@ -30,9 +32,13 @@ private:
 	long long Lastrendered=0;
 	int timeRendering;
 	QMap<QString, iAViewHandler*> views;
+	QMap<QString, QSize> m_clientSizes;           //!< size of the view at the client side (no need to send larger images)
+	iAFrameStreamer* m_streamer;                   //!< encodes frames off the GUI thread
 
 public Q_SLOTS: 
-	void createImage(QString const& ViewID, int Quality );
+	void createImage(QString const& ViewID, int Quality, double Ratio);
+	void setViewQuality(QString const& ViewID, int Quality, double Ratio);
+	void setViewSize(QString const& ViewID, int Width, int Height);
 
 Q_SIGNALS:
 	void imageHasChanged(QByteArray Image, QString ViewID);
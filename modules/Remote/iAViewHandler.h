@@ -19,7 +19,11 @@ public:
 	void vtkCallbackFunc(vtkObject* caller, long unsigned int evId, void* /*callData*/);
 
 	QString id;
-	int quality = 45;
+	static const int DefaultQuality = 45;        //!< JPEG quality of frames sent during interaction, if not set by a client
+	static constexpr double DefaultRatio = 1.0;  //!< scaling factor for frames sent during interaction, if not set by a client
+	int quality = DefaultQuality;  //!< JPEG quality of frames sent during interaction (can be adapted by client)
+	double ratio = DefaultRatio;   //!< scaling factor for frames sent during interaction (can be adapted by client)
+	static const int RefinementQuality = 100;  //!< JPEG quality of the refinement frame sent once interaction has stopped
 
 private: 
 	long long Lastrendered =0;
@@ -29,5 +33,5 @@ private:
 	QElapsedTimer m_StoppWatch;
 
 Q_SIGNALS:
-	void createImage(QString id, int Quality);
+	void createImage(QString id, int Quality, double Ratio);
 };
@@ -5,6 +5,7 @@
 #include <iALog.h>
 
 #include "iARemoteAction.h"
+#include "iAViewHandler.h"
 
 #include <QWebSocketServer>
 #include <QWebSocket>
@@ -12,8 +13,17 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QBuffer>
 #include <QFile>
-#include <QImage>
+#include <QImageReader>
+
+#include <algorithm>
+
+namespace
+{
+	//! maximum number of bytes not yet written out to a client before we stop sending new images to it
+	const qint64 MaxPendingBytes = 1024 * 1024;
+}
 
 
 
@@ -40,6 +50,10 @@ iAWebsocketAPI::iAWebsocketAPI(quint16 port, bool debug, QObject* parent) :
 void iAWebsocketAPI::setRenderedImage(QByteArray img, QString id)
 {
 	images.insert(id,img);
+	// only reads the image header, to avoid decoding the full image:
+	QBuffer buffer(&img);
+	QImageReader reader(&buffer);
+	m_imageSizes.insert(id, reader.size());
 }
 
 iAWebsocketAPI::~iAWebsocketAPI()
@@ -59,6 +73,8 @@ void iAWebsocketAPI::onNewConnection()
 	connect(pSocket, &QWebSocket::textMessageReceived, this, &iAWebsocketAPI::processTextMessage);
 	connect(pSocket, &QWebSocket::binaryMessageReceived, this, &iAWebsocketAPI::processBinaryMessage);
 	connect(pSocket, &QWebSocket::disconnected, this, &iAWebsocketAPI::socketDisconnected);
+	connect(pSocket, &QWebSocket::bytesWritten, this, &iAWebsocketAPI::socketBytesWritten);
+	m_pendingBytes.insert(pSocket, 0);
 
 
 
@@ -90,6 +106,8 @@ void iAWebsocketAPI::processTextMessage(QString message)
 	}
 	else if (Request["method"].toString() == "viewport.image.push.original.size")
 	{
+		auto args = Request["args"];
+		emit viewSizeChanged(args[0].toString(), args[1].toInt(), args[2].toInt());
 		commandImagePushSize(Request, pClient);
 	}
 	else if (Request["method"].toString() == "viewport.image.push.invalidate.cache")
@@ -199,7 +217,23 @@ void iAWebsocketAPI::commandImagePushInvalidateCache(QJsonDocument Request, QWeb
 
 void iAWebsocketAPI::commandImagePushQuality(QJsonDocument Request, QWebSocket* pClient)
 {
-	sendSuccess(Request, pClient);
+	// arguments: view ID, quality (0..100), ratio (scaling factor, optional):
+	auto args = Request["args"];
+	QString viewID = args[0].toString();
+	int previousQuality = iAViewHandler::DefaultQuality;
+	double previousRatio = iAViewHandler::DefaultRatio;
+	if (m_viewQualities.contains(viewID))
+	{
+		previousQuality = m_viewQualities[viewID].first;
+		previousRatio = m_viewQualities[viewID].second;
+	}
+	m_viewQualities[viewID] = qMakePair(args[1].toInt(), args[2].toDouble(1.0));
+	emit viewQualityChanged(viewID, args[1].toInt(), args[2].toDouble(1.0));
+	// the response contains the previous settings, so that clients changing them temporarily can restore them:
+	QJsonObject ResponseArray;
+	ResponseArray["wslink"] = "1.0";
+	ResponseArray["result"] = QJsonObject{{"result", "success"}, {"quality", previousQuality}, {"ratio", previousRatio}};
+	sendText(pClient, QJsonDocument{ResponseArray}.toJson());
 }
 
 void iAWebsocketAPI::sendSuccess(QJsonDocument Request, QWebSocket* pClient)
@@ -266,7 +300,7 @@ void iAWebsocketAPI::commandControls(QJsonDocument Request, QWebSocket* pClient)
 
 
 
-void iAWebsocketAPI::sendImage(QWebSocket* pClient, QString viewID)  // use in future
+void iAWebsocketAPI::sendImage(QWebSocket* pClient, QString viewID)
 {
 	QString imageString("wslink_bin");
 	
@@ -282,23 +316,17 @@ void iAWebsocketAPI::sendImage(QWebSocket* pClient, QString viewID)  // use in f
 
 	const QJsonDocument Response{ResponseArray};
 
-	pClient->sendTextMessage(Response.toJson());
-
-	
+	sendText(pClient, Response.toJson());
 
-	int width=0, height=0;
-
-	
 	QByteArray ba = images[viewID];
-	QImage img;
-	img.loadFromData(ba);
-	width = img.size().width();
-	height = img.size().height();
+	auto const imgSize = m_imageSizes[viewID];
 	pClient->sendBinaryMessage(ba);
+	m_pendingBytes[pClient] += ba.size();
+	m_staleViews[pClient].remove(viewID);
 
 	auto imageSize = ba.size();
 
-	const auto resultArray2 = QJsonArray{width, height};
+	const auto resultArray2 = QJsonArray{imgSize.width(), imgSize.height()};
 	const auto result = QJsonObject{{"format", "jpeg"}, {"global_id", 1}, {"global_id", "1"}, {"id", viewID},
 		{"image", imageString}, {"localTime", 0}, {"memsize", imageSize}, {"mtime", 2125+m_count*5}, {"size", resultArray2},
 		{"stale", m_count%2==0}, {"workTime", 77}};
@@ -312,7 +340,7 @@ void iAWebsocketAPI::sendImage(QWebSocket* pClient, QString viewID)  // use in f
 
 	const QJsonDocument Response2{ResponseArray2};
 
-	pClient->sendTextMessage(Response2.toJson());
+	sendText(pClient, Response2.toJson());
 
 	pClient->flush();
 
@@ -320,6 +348,12 @@ void iAWebsocketAPI::sendImage(QWebSocket* pClient, QString viewID)  // use in f
 
 }
 
+void iAWebsocketAPI::sendText(QWebSocket* pClient, QByteArray const& text)
+{
+	pClient->sendTextMessage(QString::fromUtf8(text));
+	m_pendingBytes[pClient] += text.size();
+}
+
 void iAWebsocketAPI::sendViewIDUpdate(QByteArray img, QString ViewID)
 {
 
@@ -329,11 +363,36 @@ void iAWebsocketAPI::sendViewIDUpdate(QByteArray img, QString ViewID)
 	{
 		for (auto client : subscriptions[ViewID])
 		{
+			if (m_pendingBytes.value(client, 0) > MaxPendingBytes)
+			{   // client hasn't caught up yet; send latest image once it has (see socketBytesWritten)
+				m_staleViews[client].insert(ViewID);
+				continue;
+			}
 			sendImage(client, ViewID);
 		}
 	}
 }
 
+void iAWebsocketAPI::socketBytesWritten(qint64 bytes)
+{
+	QWebSocket* pClient = qobject_cast<QWebSocket*>(sender());
+	if (!pClient || !m_pendingBytes.contains(pClient))
+	{
+		return;
+	}
+	// bytes written include websocket framing overhead, so we might drop below 0:
+	m_pendingBytes[pClient] = std::max(static_cast<qint64>(0), m_pendingBytes[pClient] - bytes);
+	if (m_pendingBytes[pClient] > MaxPendingBytes || m_staleViews[pClient].isEmpty())
+	{
+		return;
+	}
+	auto staleViews = m_staleViews[pClient];
+	for (auto const& viewID : staleViews)
+	{
+		sendImage(pClient, viewID);
+	}
+}
+
 void iAWebsocketAPI::processBinaryMessage(QByteArray message)
 {
 	QWebSocket* pClient = qobject_cast<QWebSocket*>(sender());
@@ -363,6 +422,8 @@ void iAWebsocketAPI::socketDisconnected()
 		}
 
 		m_clients.removeAll(pClient);
+		m_pendingBytes.remove(pClient);
+		m_staleViews.remove(pClient);
 		pClient->deleteLater();
 	}
 }
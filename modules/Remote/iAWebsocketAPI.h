@@ -6,6 +6,8 @@
 #include <QList>
 #include <QObject>
 #include <QMap>
+#include <QSet>
+#include <QSize>
 #include <QThread>
 #include <iACaptionItem.h>
 #include <QJsonDocument>
@@ -33,12 +35,17 @@ Q_SIGNALS:
 	void selectCaption(int id);
 	void changeCaptionTitle(int id, QString title); 
 	void hideAnnotation(int id);
+	//! emitted when a client requests a specific JPEG quality and scaling ratio for a view (e.g. lower ones during interaction)
+	void viewQualityChanged(QString viewID, int quality, double ratio);
+	//! emitted when a client informs about the size a view is shown in
+	void viewSizeChanged(QString viewID, int width, int height);
 	
 private Q_SLOTS:
 	void onNewConnection();
 	void processTextMessage(QString message);
 	void processBinaryMessage(QByteArray message);
 	void socketDisconnected();
+	void socketBytesWritten(qint64 bytes);
 	void captionSubscribe(QWebSocket* pClient);
 
 	void sendCaptionUpdate();
@@ -59,6 +66,13 @@ private:
 	bool m_debug;
 	int m_count;
 	QMap<QString, QByteArray> images;
+	QMap<QString, QSize> m_imageSizes;           //!< size of the current image of each view
+	//! Number of bytes already sent to, but not yet written out to each client. Used for back-pressure:
+	//! While above MaxPendingBytes, no new images are sent to the client; instead, the views are marked
+	//! in m_staleViews, and their latest image is sent as soon as the client has caught up.
+	QMap<QWebSocket*, qint64> m_pendingBytes;
+	QMap<QWebSocket*, QSet<QString>> m_staleViews; //!< per client, views for which a newer image is available than the last one sent
+	QMap<QString, QPair<int, double>> m_viewQualities; //!< per view, the JPEG quality and scaling ratio last requested by a client
 	QJsonDocument m_captionUpdate;
 	const QString cptionKey = "caption";
 
@@ -78,5 +92,6 @@ private:
 
 	void sendSuccess(QJsonDocument Request, QWebSocket* pClient);
 	void sendImage(QWebSocket* pClient, QString viewID);
+	void sendText(QWebSocket* pClient, QByteArray const& text);
 
 };
@@ -0,0 +1,119 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Scripted client for measuring latency and bandwidth of the image stream of the Remote module.
+// Simulates a mouse drag (rotation) in one view and reports frame rate, bandwidth and latency
+// (time from sending an interaction event to receiving the next image), as well as the time
+// until the refinement frame arrives after the interaction has stopped.
+//
+// Requires node.js >= 22 (for the built-in WebSocket client). Usage:
+//     node benchmark/streamBenchmark.js [url] [view] [seconds] [eventsPerSecond] [interactiveQuality] [interactiveRatio]
+// e.g.
+//     node benchmark/streamBenchmark.js ws://localhost:1234/ws 3D 10 30 50 0.7
+
+const url = process.argv[2] || 'ws://localhost:1234/ws';
+const view = process.argv[3] || '3D';
+const durationSec = Number(process.argv[4] || 10);
+const eventsPerSec = Number(process.argv[5] || 30);
+const interactiveQuality = Number(process.argv[6] || 50);
+const interactiveRatio = Number(process.argv[7] || 0.7);
+const IdleWaitMS = 2000;   // time to wait for the refinement frame after the interaction stopped
+
+let msgID = 0;
+const frames = [];         // { time, bytes }
+const latencies = [];
+let unansweredEventTime = null;
+let interactionEnd = null;
+let previousQuality = null; // quality settings of the view before the benchmark, restored at its end
+
+const ws = new WebSocket(url);
+ws.binaryType = 'arraybuffer';
+
+function call(method, args) {
+  ws.send(JSON.stringify({ wslink: '1.0', id: `rpc:c0:${msgID++}`, method, args }));
+}
+
+function mouseEvent(action, x, y) {
+  call('viewport.mouse.interaction', [{
+    view, action, x, y,
+    buttonLeft: 1, buttonMiddle: 0, buttonRight: 0,
+    altKey: 0, controlKey: 0, metaKey: 0, shiftKey: 0,
+  }]);
+  if (unansweredEventTime === null) {
+    unansweredEventTime = performance.now();
+  }
+}
+
+function percentile(sorted, p) {
+  return sorted.length ? sorted[Math.min(sorted.length - 1, Math.floor(p * sorted.length))] : NaN;
+}
+
+function report() {
+  const during = frames.filter((f) => f.time <= interactionEnd);
+  const bytes = during.reduce((sum, f) => sum + f.bytes, 0);
+  const sorted = latencies.slice().sort((a, b) => a - b);
+  const mean = sorted.reduce((sum, l) => sum + l, 0) / sorted.length;
+  const after = frames.filter((f) => f.time > interactionEnd);
+  console.log(`View ${view}, ${durationSec} s interaction at ${eventsPerSec} events/s ` +
+    `(interactive quality ${interactiveQuality}, ratio ${interactiveRatio}):`);
+  console.log(`  frames during interaction: ${during.length} (${(during.length / durationSec).toFixed(1)} fps)`);
+  console.log(`  bandwidth: ${(bytes / durationSec / 1024).toFixed(1)} KiB/s, ` +
+    `mean frame size ${(bytes / Math.max(1, during.length) / 1024).toFixed(1)} KiB`);
+  console.log(`  latency (ms): mean ${mean.toFixed(1)}, median ${percentile(sorted, 0.5).toFixed(1)}, ` +
+    `95th percentile ${percentile(sorted, 0.95).toFixed(1)}, max ${sorted[sorted.length - 1]?.toFixed(1)}`);
+  if (after.length) {
+    const last = after[after.length - 1];
+    console.log(`  refinement frame: ${(last.time - interactionEnd).toFixed(1)} ms after interaction end, ` +
+      `${(last.bytes / 1024).toFixed(1)} KiB`);
+  } else {
+    console.log('  no refinement frame received!');
+  }
+  ws.close();
+}
+
+ws.onmessage = (event) => {
+  if (typeof event.data === 'string') {
+    // the response to the quality request contains the previous quality settings:
+    const result = JSON.parse(event.data).result;
+    if (previousQuality === null && result && result.quality !== undefined) {
+      previousQuality = { quality: result.quality, ratio: result.ratio };
+    }
+    return;
+  }
+  const now = performance.now();
+  frames.push({ time: now, bytes: event.data.byteLength });
+  if (unansweredEventTime !== null && (interactionEnd === null || now <= interactionEnd)) {
+    latencies.push(now - unansweredEventTime);
+    unansweredEventTime = null;
+  }
+};
+
+ws.onerror = (event) => {
+  console.error(`Connection error: ${event.message || event}`);
+  process.exit(1);
+};
+
+ws.onopen = () => {
+  call('wslink.hello', [{ secret: 'wslink-secret' }]);
+  call('viewport.image.push.observer.add', [view]);
+  call('viewport.image.push.quality', [view, interactiveQuality, interactiveRatio]);
+  const numEvents = Math.round(durationSec * eventsPerSec);
+  let i = 0;
+  mouseEvent('down', 0.5, 0.5);
+  const timer = setInterval(() => {
+    if (i >= numEvents) {
+      clearInterval(timer);
+      mouseEvent('up', 0.5, 0.5);
+      if (previousQuality !== null) {
+        call('viewport.image.push.quality', [view, previousQuality.quality, previousQuality.ratio]);
+      }
+      interactionEnd = performance.now();
+      setTimeout(report, IdleWaitMS);
+      return;
+    }
+    // move on a circle around the view center:
+    const angle = (2 * Math.PI * i) / eventsPerSec;
+    mouseEvent('down', 0.5 + 0.25 * Math.cos(angle), 0.5 + 0.25 * Math.sin(angle));
+    ++i;
+  }, 1000 / eventsPerSec);
+};
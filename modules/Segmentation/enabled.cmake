@@ -3,13 +3,17 @@ if (openiA_TESTING_ENABLED)
 	get_filename_component(CoreBinDir "../libs" REALPATH BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
 	add_executable(ImageGraphTest Segmentation/iAImageGraphTest.cpp Segmentation/iAImageGraph.cpp ${CoreSrcDir}/base/iAImageCoordinate.cpp)
 	add_executable(DistanceMeasureTest Segmentation/iADistanceMeasureTest.cpp Segmentation/iAVectorDistanceImpl.cpp Segmentation/iAVectorArrayImpl.cpp Segmentation/iAVectorTypeImpl.cpp ${CoreSrcDir}/base/iAImageCoordinate.cpp)
+	add_executable(DistanceMeasureBenchmarkTest Segmentation/iADistanceMeasureBenchmarkTest.cpp Segmentation/iAGraphWeights.cpp Segmentation/iAImageGraph.cpp Segmentation/iAVectorDistanceImpl.cpp Segmentation/iAVectorArrayImpl.cpp Segmentation/iAVectorTypeImpl.cpp ${CoreSrcDir}/base/iAImageCoordinate.cpp)
+	add_executable(SVMPredictTest Segmentation/iASVMPredictTest.cpp Segmentation/svm.cpp)
 	target_link_libraries(ImageGraphTest PRIVATE Qt${QT_VERSION_MAJOR}::Core)
 	target_link_libraries(DistanceMeasureTest PRIVATE Qt${QT_VERSION_MAJOR}::Core)
+	target_link_libraries(DistanceMeasureBenchmarkTest PRIVATE Qt${QT_VERSION_MAJOR}::Core)
 	set(VTK_REQUIRED_LIBS
 		CommonCore        # for vtkSmartPointer
 		CommonDataModel   # for vtkImageData
 	)
 	ADD_VTK_LIBRARIES(DistanceMeasureTest "PRIVATE" "${VTK_REQUIRED_LIBS}")
+	ADD_VTK_LIBRARIES(DistanceMeasureBenchmarkTest "PRIVATE" "${VTK_REQUIRED_LIBS}")
 	#set(ITK_REQUIRED_LIBS
 	#	ITKCommon
 	#	ITKVNL             # drawn in by itkVector
@@ -22,20 +26,29 @@ if (openiA_TESTING_ENABLED)
 	#ADD_LEGACY_LIBRARIES(DistanceMeasureTest "" "PRIVATE" "${ITK_REQUIRED_LIBS}")
 	target_include_directories(ImageGraphTest PRIVATE ${CoreSrcDir}/base  ${CoreBinDir})
 	target_include_directories(DistanceMeasureTest PRIVATE ${CoreSrcDir}/base ${CoreBinDir} ${CMAKE_CURRENT_BINARY_DIR})
+	target_include_directories(DistanceMeasureBenchmarkTest PRIVATE ${CoreSrcDir}/base ${CoreBinDir} ${CMAKE_CURRENT_BINARY_DIR})
 	target_compile_definitions(ImageGraphTest PRIVATE NO_DLL_LINKAGE)
 	target_compile_definitions(DistanceMeasureTest PRIVATE NO_DLL_LINKAGE)
+	target_compile_definitions(DistanceMeasureBenchmarkTest PRIVATE NO_DLL_LINKAGE)
+	target_include_directories(SVMPredictTest PRIVATE ${CoreSrcDir}/base)   # for iASimpleTester.h
 	add_test(NAME ImageGraphTest COMMAND ImageGraphTest)
 	add_test(NAME DistanceMeasureTest COMMAND DistanceMeasureTest)
+	add_test(NAME DistanceMeasureBenchmarkTest COMMAND DistanceMeasureBenchmarkTest)
+	add_test(NAME SVMPredictTest COMMAND SVMPredictTest)
 	if (MSVC)
 		set_tests_properties(ImageGraphTest PROPERTIES ENVIRONMENT "PATH=${TestEnvPath}")
 		set_tests_properties(DistanceMeasureTest PROPERTIES ENVIRONMENT "PATH=${TestEnvPath}")
+		set_tests_properties(DistanceMeasureBenchmarkTest PROPERTIES ENVIRONMENT "PATH=${TestEnvPath}")
 		set_target_properties(ImageGraphTest PROPERTIES VS_DEBUGGER_ENVIRONMENT "PATH=${WinDLLPaths};$ENV{PATH}")
 		set_target_properties(DistanceMeasureTest PROPERTIES VS_DEBUGGER_ENVIRONMENT "PATH=${WinDLLPaths};$ENV{PATH}")
+		set_target_properties(DistanceMeasureBenchmarkTest PROPERTIES VS_DEBUGGER_ENVIRONMENT "PATH=${WinDLLPaths};$ENV{PATH}")
 	endif()
 
 	if (openiA_USE_IDE_FOLDERS)
 		set_property(TARGET ImageGraphTest PROPERTY FOLDER "Tests")
 		set_property(TARGET DistanceMeasureTest PROPERTY FOLDER "Tests")
+		set_property(TARGET DistanceMeasureBenchmarkTest PROPERTY FOLDER "Tests")
+		set_property(TARGET SVMPredictTest PROPERTY FOLDER "Tests")
 	endif()
 endif()
 
@@ -0,0 +1,153 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "iAGraphWeights.h"
+#include "iAImageGraph.h"
+#include "iAVectorArrayImpl.h"
+#include "iAVectorDistanceImpl.h"
+#include "iAVectorTypeImpl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	//! vectors of a multi-channel image, stored in memory
+	class BenchmarkVectorArray : public iAVectorArray
+	{
+	public:
+		BenchmarkVectorArray(size_t size, size_t channelCount) :
+			m_data(size * channelCount),
+			m_channelCount(channelCount)
+		{}
+		size_t size() const override
+		{
+			return m_data.size() / m_channelCount;
+		}
+		size_t channelCount() const override
+		{
+			return m_channelCount;
+		}
+		QSharedPointer<iAVectorType const> get(size_t voxelIdx) const override
+		{
+			return QSharedPointer<iAVectorType const>(new iAPixelVector(*this, voxelIdx));
+		}
+		iAVectorDataType get(size_t voxelIdx, size_t channelIdx) const override
+		{
+			return m_data[voxelIdx * m_channelCount + channelIdx];
+		}
+		void set(size_t voxelIdx, size_t channelIdx, iAVectorDataType value)
+		{
+			m_data[voxelIdx * m_channelCount + channelIdx] = value;
+		}
+	private:
+		std::vector<iAVectorDataType> m_data;
+		size_t m_channelCount;
+	};
+
+	//! the edge weights as computed before CalculateGraphWeights used the batch kernels:
+	//! one virtual GetDistance call per edge, accessing the vectors element by element
+	std::vector<double> referenceWeights(iAImageGraph const& graph, iAVectorArray const& data, iAVectorDistance const& dist)
+	{
+		std::vector<double> result(graph.edgeCount());
+		for (iAEdgeIndexType i = 0; i < graph.edgeCount(); ++i)
+		{
+			iAEdgeType edge = graph.edge(i);
+			result[i] = dist.GetDistance(data.get(edge.first), data.get(edge.second));
+		}
+		return result;
+	}
+
+	//! exact equality, also treating two NaN values as equal (chi-square yields NaN where both vectors are 0)
+	bool identical(double expected, double actual)
+	{
+		return expected == actual || (std::isnan(expected) && std::isnan(actual));
+	}
+}
+
+BEGIN_TEST
+	const int Width = 64, Height = 48, Depth = 16;
+	const size_t Channels = 12;
+	iAImageGraph graph(Width, Height, Depth);
+	BenchmarkVectorArray data(static_cast<size_t>(Width) * Height * Depth, Channels);
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> value(0.0, 1000.0);
+	std::uniform_int_distribution<int> zeroChance(0, 9);
+	for (size_t v = 0; v < data.size(); ++v)
+	{
+		for (size_t c = 0; c < Channels; ++c)
+		{
+			// some zero elements, to also cover the special cases of the normalizing measures:
+			data.set(v, c, zeroChance(rng) == 0 ? 0.0 : value(rng));
+		}
+	}
+	for (int m = 0; m < GetDistanceMeasureCount(); ++m)
+	{
+		auto dist = GetDistanceMeasureFromShortName(GetShortMeasureNames()[m]);
+		TestEqual(static_cast<int>(GetMeasureIndex(*dist)), m);
+		auto start = std::chrono::steady_clock::now();
+		auto expected = referenceWeights(graph, data, *dist);
+		auto middle = std::chrono::steady_clock::now();
+		auto weights = CalculateGraphWeights(graph, data, *dist);
+		auto end = std::chrono::steady_clock::now();
+		std::cout << GetDistanceMeasureNames()[m] << ", " << graph.edgeCount() << " edges: per-edge virtual "
+			<< std::chrono::duration<double>(middle - start).count() << " s, batch "
+			<< std::chrono::duration<double>(end - middle).count() << " s" << std::endl;
+		TestEqual(weights->GetEdgeCount(), static_cast<int>(expected.size()));
+		int differing = 0;
+		for (iAEdgeIndexType i = 0; i < graph.edgeCount(); ++i)
+		{
+			if (!identical(expected[i], weights->GetWeight(i)))
+			{
+				++differing;
+			}
+		}
+		TestEqual(differing, 0);
+	}
+	// measures without batch kernel still use GetDistance:
+	iANullDistance nullDist;
+	TestEqual(GetMeasureIndex(nullDist), dmInvalid);
+	auto nullWeights = CalculateGraphWeights(graph, data, nullDist);
+	TestEqual(nullWeights->GetMaxWeight(), 0.0);
+
+	// the copy of vtk images directly from their scalar arrays yields the same values as the per-vector access:
+	int const dim[3] = {13, 7, 5};
+	iAvtkPixelVectorArray vtkData(dim);
+	for (int c = 0; c < 4; ++c)
+	{
+		auto img = vtkSmartPointer<vtkImageData>::New();
+		img->SetDimensions(dim[0], dim[1], dim[2]);
+		img->AllocateScalars((c % 2 == 0) ? VTK_FLOAT : VTK_UNSIGNED_SHORT, 1);
+		for (int z = 0; z < dim[2]; ++z)
+		{
+			for (int y = 0; y < dim[1]; ++y)
+			{
+				for (int x = 0; x < dim[0]; ++x)
+				{
+					img->SetScalarComponentFromDouble(x, y, z, 0, value(rng));
+				}
+			}
+		}
+		vtkData.AddImage(img);
+	}
+	std::vector<iAVectorDataType> copied(vtkData.size() * vtkData.channelCount());
+	vtkData.copyTo(copied.data());
+	int differingValues = 0;
+	for (size_t v = 0; v < vtkData.size(); ++v)
+	{
+		auto vec = vtkData.get(v);
+		for (size_t c = 0; c < vtkData.channelCount(); ++c)
+		{
+			if (copied[v * vtkData.channelCount() + c] != vec->get(c))
+			{
+				++differingValues;
+			}
+		}
+	}
+	TestEqual(differingValues, 0);
+	iAVectorArrayBuffer buffer(vtkData);
+	TestAssert(std::equal(copied.begin(), copied.end(), buffer.data()));
+END_TEST
@@ -5,7 +5,7 @@
 #include "iANormalizer.h"
 #include "iAImageGraph.h"
 #include "iAVectorArray.h"
-#include "iAVectorDistance.h"
+#include "iAVectorDistanceImpl.h"
 
 #include <algorithm>
 #include <cassert>
@@ -41,6 +41,11 @@ void iAGraphWeights::Normalize(QSharedPointer<iANormalizer> normalizeFunc)
 	}
 }
 
+iAEdgeWeightType * iAGraphWeights::GetWeightData()
+{
+	return m_weights.data();
+}
+
 int iAGraphWeights::GetEdgeCount() const
 {
 	return m_weights.size();
@@ -52,6 +57,26 @@ QSharedPointer<iAGraphWeights> CalculateGraphWeights(
 	iAVectorDistance const & distanceFunc)
 {
 	QSharedPointer<iAGraphWeights> result(new iAGraphWeights(graph.edgeCount()));
+	MeasureIndices measure = GetMeasureIndex(distanceFunc);
+	if (measure != dmInvalid && graph.edgeCount() > 0)
+	{
+		// copy the vectors into one contiguous buffer once, instead of retrieving each vector
+		// (element by element, via virtual calls) again for each of its edges:
+		iAVectorArrayBuffer buffer(voxelData);
+		const long long EdgeBlockSize = 4096;
+		long long edgeCount = graph.edgeCount();
+		long long blockCount = (edgeCount + EdgeBlockSize - 1) / EdgeBlockSize;
+		iAEdgeWeightType* weights = result->GetWeightData();
+#pragma omp parallel for schedule(dynamic, 1)
+		for (long long block = 0; block < blockCount; ++block)
+		{
+			long long begin = block * EdgeBlockSize;
+			long long end = std::min(begin + EdgeBlockSize, edgeCount);
+			CalculateDistances(measure, buffer.data(), buffer.channelCount(),
+				&graph.edge(static_cast<iAEdgeIndexType>(begin)), end - begin, weights + begin);
+		}
+		return result;
+	}
 	for (iAEdgeIndexType i=0; i<graph.edgeCount(); ++i)
 	{
 		iAEdgeType edge = graph.edge(i);
@@ -20,6 +20,8 @@ public:
 	iAEdgeWeightType GetMaxWeight() const;
 	iAEdgeWeightType GetWeight(iAEdgeIndexType edgeIdx) const;
 	void SetWeight(iAEdgeIndexType edgeIdx, iAEdgeWeightType weight);
+	//! direct access to the weights of all edges, for setting many weights at once
+	iAEdgeWeightType * GetWeightData();
 	int GetEdgeCount() const;
 private:
 	QVector<iAEdgeWeightType> m_weights;
@@ -9,13 +9,17 @@
 #include <iALog.h>
 #include <iAProgress.h>
 #include <iASeedType.h>
-#include <iAVtkDraw.h>
 #include <iAToolsVTK.h>
 #include <iATypedCallHelper.h>
 
 #include <itkScalarImageKmeansImageFilter.h>
 
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <vector>
 
 IAFILTER_DEFAULT_CLASS(iAKMeans);
 IAFILTER_DEFAULT_CLASS(iASVMImageFilter);
@@ -26,6 +30,8 @@ namespace
 	{
 	}
 	const double MY_EPSILON = 1e-6;
+	//! number of voxels predicted at once by a thread
+	const int PredictBlockSize = 4096;
 
 	int MapKernelTypeToIndex(QString const & type)
 	{
@@ -126,64 +132,101 @@ void iASVMImageFilter::performWork(QVariantMap const & parameters)
 	svm_model* model = svm_train(&problem, &param);
 	int labelCount = labelMax - labelMin + 1;
 
+	int nrClass = svm_get_nr_class(model);
+	int featureCount = static_cast<int>(inputCount());
+
 	QVector<vtkSmartPointer<vtkImageData> > probabilities(labelCount);
-	svm_node* node = new svm_node[inputCount() + 1];
-	node[inputCount()].index = -1;  // the termination marker
+	std::vector<double*> probBuffers(labelCount);
 	double const* spc = imageInput(0)->vtkImage()->GetSpacing();
-	double * prob_estimates = new double[labelCount];
-
 	for (int l = 0; l < labelCount; ++l)
 	{
 		probabilities[l] = allocateImage(VTK_DOUBLE, dim, spc, 1);
-		prob_estimates[l] = 0;
+		probBuffers[l] = static_cast<double*>(probabilities[l]->GetScalarPointer());
+	}
+	std::vector<vtkDataArray*> channels(inputCount());
+	for (size_t m = 0; m < inputCount(); ++m)
+	{
+		channels[m] = imageInput(m)->vtkImage()->GetPointData()->GetScalars();
 	}
 
-	// for each pixel, execute svm_predict :
-	FOR_VTKIMG_PIXELS(imageInput(0)->vtkImage(), x, y, z)
+	// predict blocks of voxels in parallel; the channels of a block are gathered into
+	// one contiguous feature array, and svm_predict_dense evaluates the kernel only once per voxel
+	long long voxelCount = static_cast<long long>(dim[0]) * dim[1] * dim[2];
+	long long blockCount = (voxelCount + PredictBlockSize - 1) / PredictBlockSize;
+	long long blocksDone = 0;
+	int lastPercent = 0;
+#pragma omp parallel
 	{
-		for (size_t m = 0; m < inputCount(); ++m)
+		std::vector<double> features(PredictBlockSize * featureCount);
+		std::vector<double> prob_estimates(PredictBlockSize * nrClass);
+#pragma omp for schedule(dynamic, 1)
+		for (long long b = 0; b < blockCount; ++b)
 		{
-			node[m].index = m;
-			node[m].value = imageInput(m)->vtkImage()->GetScalarComponentAsDouble(x, y, z, 0);
-		}
-		/*double label =*/ svm_predict_probability(model, node, prob_estimates);
-		/*double label2 =*/ svm_predict(model, node);
-		double probSum = 0;
-		for (int l = 0; l < labelCount; ++l)
-		{
-			drawPixel(probabilities[l], x, y, z, prob_estimates[l]);
-			probSum += prob_estimates[l];
-			// DEBUG check begin
-			if (prob_estimates[l] < -MY_EPSILON || prob_estimates[l] > 1.0+MY_EPSILON)
+			if (isAborted())
 			{
-				LOG(lvlWarn, QString("SVM: Invalid probability (%1) at %2, %3, %4")
-					.arg(prob_estimates[l])
-					.arg(x)
-					.arg(y)
-					.arg(z));
+				continue;
+			}
+			long long begin = b * PredictBlockSize;
+			int count = static_cast<int>(std::min(static_cast<long long>(PredictBlockSize), voxelCount - begin));
+			for (int v = 0; v < count; ++v)
+			{
+				for (int m = 0; m < featureCount; ++m)
+				{
+					features[v * featureCount + m] = channels[m]->GetComponent(begin + v, 0);
+				}
+			}
+			std::fill(prob_estimates.begin(), prob_estimates.end(), 0.0);
+			svm_predict_dense(model, features.data(), count, featureCount, nullptr, prob_estimates.data());
+			for (int v = 0; v < count; ++v)
+			{
+				double probSum = 0;
+				for (int l = 0; l < labelCount; ++l)
+				{
+					double prob = (l < nrClass) ? prob_estimates[v * nrClass + l] : 0.0;
+					probBuffers[l][begin + v] = prob;
+					probSum += prob;
+					// DEBUG check begin
+					if (prob < -MY_EPSILON || prob > 1.0 + MY_EPSILON)
+					{
+						LOG(lvlWarn, QString("SVM: Invalid probability (%1) at voxel %2")
+							.arg(prob)
+							.arg(begin + v));
+					}
+					// DEBUG check end
+				}
+				// DEBUG check begin
+				if (probSum - 1.0 > MY_EPSILON)
+				{
+					LOG(lvlWarn, QString("SVM: Probabilities at voxel %1 add up to %2 instead of 1!")
+						.arg(begin + v)
+						.arg(probSum));
+				}
+				// DEBUG check end
+			}
+#pragma omp critical
+			{
+				++blocksDone;
+				int percent = static_cast<int>((100 * blocksDone) / blockCount);
+				if (percent > lastPercent)
+				{
+					lastPercent = percent;
+					progress()->emitProgress(percent);
+				}
 			}
-			// DEBUG check end
-		}
-		// DEBUG check begin
-		if (probSum - 1.0 > MY_EPSILON)
-		{
-			LOG(lvlWarn, QString("SVM: Probabilities at %1, %2, %3 add up to %4 instead of 1!")
-				.arg(x)
-				.arg(y)
-				.arg(z)
-				.arg(probSum) );
 		}
-		// DEBUG check end
+	}
+	svm_free_and_destroy_model(&model);
+	delete[] x_space;
+	delete[] problem.x;
+	delete[] problem.y;
+	if (isAborted())
+	{
+		return;
 	}
 	for (int l = 0; l < labelCount; ++l)
 	{
 		addOutput(probabilities[l]);
 	}
-	delete[] prob_estimates;
-	delete[] node;
-	delete[] x_space;
-	delete[] problem.x;
-	delete[] problem.y;
 }
 
 
@@ -201,7 +244,8 @@ iASVMImageFilter::iASVMImageFilter() :
 		"<pre>x y z label</pre>"
 		"where x, y and z are the coordinates(set z = 0 for 2D images) and label is the index of the label "
 		"for this seed point. Label indices should start at 0 and be contiguous (so if you have N different "
-		"labels, you should use label indices 0..N - 1 and make sure that there is at least one seed per label).")
+		"labels, you should use label indices 0..N - 1 and make sure that there is at least one seed per label).",
+		1, 1, true)
 {
 	QStringList kernels; kernels
 		<< "Linear" << "Polynomial" << "RBF" << "Sigmoid";
@@ -0,0 +1,173 @@
+// Copyright 2016-2023, the open_iA contributors
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "iASimpleTester.h"
+
+#include "svm.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+	void nullPrint(char const*)
+	{
+	}
+
+	//! a small synthetic multi-channel volume: each voxel belongs to one of several regions (depending on its position),
+	//! each channel has a region-specific mean plus noise
+	struct SyntheticVolume
+	{
+		int dim[3];
+		int channels;
+		int labelCount;
+		std::vector<double> features;    //!< voxel by voxel, channels contiguous
+		std::vector<int> labels;
+		SyntheticVolume(int dx, int dy, int dz, int channelCount, int regions) :
+			channels(channelCount), labelCount(regions)
+		{
+			dim[0] = dx; dim[1] = dy; dim[2] = dz;
+			std::mt19937 rng(42);
+			std::normal_distribution<double> noise(0.0, 0.6);
+			for (int z = 0; z < dz; ++z)
+			{
+				for (int y = 0; y < dy; ++y)
+				{
+					for (int x = 0; x < dx; ++x)
+					{
+						int label = ((x * regions) / dx + (z % 2)) % regions;
+						labels.push_back(label);
+						for (int c = 0; c < channels; ++c)
+						{
+							features.push_back(label * (c + 1) + noise(rng));
+						}
+					}
+				}
+			}
+		}
+		size_t voxelCount() const
+		{
+			return labels.size();
+		}
+	};
+
+	//! trains a model as iASVMImageFilter does, from every seedStep-th voxel
+	svm_model* train(SyntheticVolume const& vol, int kernelType, size_t seedStep, svm_problem& problem, std::vector<svm_node>& space)
+	{
+		svm_parameter param;
+		param.svm_type = C_SVC;
+		param.kernel_type = kernelType;
+		param.gamma = 0.1;
+		param.C = 10;
+		param.degree = 2;
+		param.coef0 = 1;
+		param.probability = 1;
+		param.nu = 0.5;
+		param.cache_size = 100;
+		param.eps = 1e-3;
+		param.p = 0.1;
+		param.shrinking = 0;
+		param.nr_weight = 0;
+		param.weight_label = nullptr;
+		param.weight = nullptr;
+		size_t seedCount = (vol.voxelCount() + seedStep - 1) / seedStep;
+		space.resize(seedCount * (vol.channels + 1));
+		problem.l = static_cast<int>(seedCount);
+		problem.x = new svm_node*[seedCount];
+		problem.y = new double[seedCount];
+		for (size_t s = 0; s < seedCount; ++s)
+		{
+			size_t v = s * seedStep;
+			svm_node* node = &space[s * (vol.channels + 1)];
+			problem.x[s] = node;
+			problem.y[s] = vol.labels[v];
+			for (int c = 0; c < vol.channels; ++c)
+			{
+				node[c].index = c;
+				node[c].value = vol.features[v * vol.channels + c];
+			}
+			node[vol.channels].index = -1;
+		}
+		return svm_train(&problem, &param);
+	}
+
+	//! number of voxels for which svm_predict_dense does not yield bit-identical labels and probabilities
+	//! to the per-voxel svm_predict / svm_predict_probability calls
+	size_t compareToPerVoxelPrediction(SyntheticVolume const& vol, svm_model const* model, int blockSize)
+	{
+		int nrClass = svm_get_nr_class(model);
+		std::vector<double> labels(vol.voxelCount()), prob(vol.voxelCount() * nrClass);
+		for (size_t begin = 0; begin < vol.voxelCount(); begin += blockSize)
+		{
+			int count = static_cast<int>(std::min(static_cast<size_t>(blockSize), vol.voxelCount() - begin));
+			svm_predict_dense(model, &vol.features[begin * vol.channels], count, vol.channels,
+				&labels[begin], &prob[begin * nrClass]);
+		}
+		std::vector<svm_node> node(vol.channels + 1);
+		node[vol.channels].index = -1;
+		std::vector<double> expectedProb(nrClass);
+		size_t mismatches = 0;
+		for (size_t v = 0; v < vol.voxelCount(); ++v)
+		{
+			for (int c = 0; c < vol.channels; ++c)
+			{
+				node[c].index = c;
+				node[c].value = vol.features[v * vol.channels + c];
+			}
+			svm_predict_probability(model, node.data(), expectedProb.data());
+			double expectedLabel = svm_predict(model, node.data());
+			bool equal = (expectedLabel == labels[v]);
+			for (int l = 0; l < nrClass; ++l)
+			{
+				equal = equal && (expectedProb[l] == prob[v * nrClass + l]);
+			}
+			if (!equal)
+			{
+				++mismatches;
+			}
+		}
+		return mismatches;
+	}
+}
+
+BEGIN_TEST
+{
+	svm_set_print_string_function(nullPrint);
+	SyntheticVolume threeClasses(16, 12, 6, 3, 3);
+	SyntheticVolume twoClasses(10, 10, 4, 2, 2);
+	char const* kernelNames[] = {"Linear", "Polynomial", "RBF", "Sigmoid"};
+	int kernels[] = {LINEAR, POLY, RBF, SIGMOID};
+	for (int k = 0; k < 4; ++k)
+	{
+		for (auto vol : {&threeClasses, &twoClasses})
+		{
+			svm_problem problem;
+			std::vector<svm_node> space;
+			svm_model* model = train(*vol, kernels[k], 7, problem, space);
+			std::cout << kernelNames[k] << " kernel, " << vol->labelCount << " labels, "
+				<< svm_get_nr_sv(model) << " support vectors:" << std::endl;
+			TestEqual(vol->labelCount, svm_get_nr_class(model));
+			TestEqual(static_cast<size_t>(0), compareToPerVoxelPrediction(*vol, model, 64));
+			TestEqual(static_cast<size_t>(0), compareToPerVoxelPrediction(*vol, model, 1));
+			svm_free_and_destroy_model(&model);
+			delete[] problem.x;
+			delete[] problem.y;
+		}
+	}
+
+	// support vectors without some of the indices can't be evaluated densely, the per-vector fallback is used:
+	{
+		svm_problem problem;
+		std::vector<svm_node> space;
+		svm_model* model = train(twoClasses, RBF, 1, problem, space);
+		for (int s = 0; s < problem.l; s += 2)
+		{
+			problem.x[s][0].index = 1;    // drop index 0 (libsvm treats missing values as 0)
+			problem.x[s][1].index = -1;
+		}
+		TestEqual(static_cast<size_t>(0), compareToPerVoxelPrediction(twoClasses, model, 32));
+		svm_free_and_destroy_model(&model);
+		delete[] problem.x;
+		delete[] problem.y;
+	}
+}
+END_TEST
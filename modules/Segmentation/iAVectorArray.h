@@ -7,6 +7,7 @@
 #include <QSharedPointer>
 
 #include <cstddef> // for size_t
+#include <vector>
 
 //! abstract base class for access to multi-channel/vector data, arranged as array
 class iAVectorArray
@@ -17,4 +18,22 @@ public:
 	virtual size_t channelCount() const =0;
 	virtual QSharedPointer<iAVectorType const> get(size_t voxelIdx) const =0;
 	virtual iAVectorDataType get(size_t voxelIdx, size_t channelIdx) const =0;
+	//! copy all vectors to the given buffer, channel-interleaved (i.e. to buffer[voxelIdx * channelCount() + channelIdx]);
+	//! the buffer needs to hold size() * channelCount() values
+	virtual void copyTo(iAVectorDataType * buffer) const;
+};
+
+//! contiguous, channel-interleaved copy of all vectors of an iAVectorArray,
+//! for computations accessing the vectors many times (see CalculateDistances)
+class iAVectorArrayBuffer
+{
+public:
+	explicit iAVectorArrayBuffer(iAVectorArray const & source);
+	size_t size() const;
+	size_t channelCount() const;
+	//! all vectors, channelCount() consecutive values per voxel
+	iAVectorDataType const * data() const;
+private:
+	std::vector<iAVectorDataType> m_data;
+	size_t m_channelCount;
 };
@@ -2,9 +2,46 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iAVectorArrayImpl.h"
 
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
 iAVectorArray::~iAVectorArray()
 {}
 
+void iAVectorArray::copyTo(iAVectorDataType * buffer) const
+{
+	size_t channels = channelCount();
+	for (size_t voxelIdx = 0; voxelIdx < size(); ++voxelIdx)
+	{
+		for (size_t channelIdx = 0; channelIdx < channels; ++channelIdx)
+		{
+			buffer[voxelIdx * channels + channelIdx] = get(voxelIdx, channelIdx);
+		}
+	}
+}
+
+iAVectorArrayBuffer::iAVectorArrayBuffer(iAVectorArray const & source):
+	m_data(source.size() * source.channelCount()),
+	m_channelCount(source.channelCount())
+{
+	source.copyTo(m_data.data());
+}
+
+size_t iAVectorArrayBuffer::size() const
+{
+	return (m_channelCount == 0) ? 0 : m_data.size() / m_channelCount;
+}
+
+size_t iAVectorArrayBuffer::channelCount() const
+{
+	return m_channelCount;
+}
+
+iAVectorDataType const * iAVectorArrayBuffer::data() const
+{
+	return m_data.data();
+}
+
 iAvtkPixelVectorArray::iAvtkPixelVectorArray(int const * dim):
 	m_coordConv(dim[0], dim[1], dim[2])
 {
@@ -46,3 +83,19 @@ iAVectorDataType iAvtkPixelVectorArray::get(size_t voxelIdx, size_t channelIdx)
 	iAVectorDataType value = m_images[channelIdx]->GetScalarComponentAsDouble(coords.x, coords.y, coords.z, 0);
 	return value;
 }
+
+void iAvtkPixelVectorArray::copyTo(iAVectorDataType * buffer) const
+{
+	// the voxel index of m_coordConv (x fastest, then y, then z) is the point id in the images
+	size_t channels = m_images.size();
+	long long voxelCount = static_cast<long long>(size());
+	for (size_t channelIdx = 0; channelIdx < channels; ++channelIdx)
+	{
+		vtkDataArray* scalars = m_images[channelIdx]->GetPointData()->GetScalars();
+#pragma omp parallel for
+		for (long long voxelIdx = 0; voxelIdx < voxelCount; ++voxelIdx)
+		{
+			buffer[voxelIdx * channels + channelIdx] = scalars->GetComponent(voxelIdx, 0);
+		}
+	}
+}
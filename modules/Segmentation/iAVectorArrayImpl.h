@@ -24,6 +24,7 @@ public:
 	size_t channelCount() const override;
 	QSharedPointer<iAVectorType const> get(size_t voxelIdx) const override;
 	iAVectorDataType get(size_t voxelIdx, size_t channelIdx) const override;
+	void copyTo(iAVectorDataType * buffer) const override;
 	void AddImage(vtkSmartPointer<vtkImageData> img);
 private:
 	std::vector<vtkSmartPointer<vtkImageData> > m_images;
@@ -8,6 +8,7 @@
 
 #include <numeric>
 #include <cmath>
+#include <cstring>
 
 namespace
 {
@@ -74,6 +75,161 @@ namespace
 		// ----------
 		QSharedPointer<iANullDistance>::create()
 	};
+
+	// Batch versions of the GetDistance methods below, working directly on contiguous vectors;
+	// each one uses exactly the same operations (in the same order) as the respective GetDistance.
+
+	double Sum(iAVectorDataType const * a, size_t n)
+	{
+		iAVectorDataType sum = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			sum += a[i];
+		}
+		return sum;
+	}
+
+	double KullbackLeibler(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		// vectors are normalized on the fly, a[i] / sumA is the value of a->normalized()
+		double sumA = Sum(a, n), sumB = Sum(b, n);
+		double kldiv = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double s1 = a[i] / sumA, s2 = b[i] / sumB;
+			double logTerm = (s2 == 0) ? 0 : (s1 / s2);
+			if (qIsInf(logTerm) || qIsNaN(logTerm))
+			{
+				logTerm = 0;
+			}
+			kldiv += (logTerm == 0) ? 0 : (std::log(logTerm) * s1);
+			if (qIsInf(kldiv) || qIsNaN(kldiv))
+			{
+				kldiv = 0;
+			}
+		}
+		return kldiv;
+	}
+
+	template <MeasureIndices M>
+	double Distance(iAVectorDataType const * a, iAVectorDataType const * b, size_t n);
+
+	template <>
+	double Distance<dmL1>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		double sum = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			sum += std::abs(a[i] - b[i]);
+		}
+		return sum;
+	}
+
+	template <>
+	double Distance<dmSquared>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		double sum = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double diff = a[i] - b[i];
+			sum += std::pow(diff, 2);
+		}
+		return sum;
+	}
+
+	template <>
+	double Distance<dmL2>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		return std::sqrt(Distance<dmSquared>(a, b, n));
+	}
+
+	template <>
+	double Distance<dmLinf>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		double maxDist = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double dist = std::abs(a[i] - b[i]);
+			if (dist > maxDist)
+			{
+				maxDist = dist;
+			}
+		}
+		return maxDist;
+	}
+
+	template <>
+	double Distance<dmCosine>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		double prod = 0, sqSum1 = 0, sqSum2 = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			prod += a[i] * b[i];
+			sqSum1 += a[i] * a[i];
+			sqSum2 += b[i] * b[i];
+		}
+		double len1 = std::sqrt(sqSum1);
+		double len2 = std::sqrt(sqSum2);
+		if (len1 == 0 || len2 == 0)
+		{
+			return 0;
+		}
+		double cosAngle = prod / (len1*len2);
+		return clamp(-1.0, 1.0, cosAngle);
+	}
+
+	template <>
+	double Distance<dmKullbackLeibler>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		return KullbackLeibler(a, b, n);
+	}
+
+	template <>
+	double Distance<dmJensenShannon>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		return std::sqrt(0.5 * KullbackLeibler(a, b, n) + 0.5 * KullbackLeibler(b, a, n));
+	}
+
+	template <>
+	double Distance<dmChiSquare>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		double sumA = Sum(a, n), sumB = Sum(b, n);
+		double chiSquare = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double s1 = a[i] / sumA, s2 = b[i] / sumB;
+			chiSquare += std::pow(s1 - s2, 2) / (s1 + s2);
+		}
+		return chiSquare / 2.0;
+	}
+
+	template <>
+	double Distance<dmEarthMovers>(iAVectorDataType const * a, iAVectorDataType const * b, size_t n)
+	{
+		double sumA = Sum(a, n), sumB = Sum(b, n);
+		double emd = 0;
+		double lastEmd = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double newEmd = a[i] / sumA + lastEmd - b[i] / sumB;
+			emd += std::abs(newEmd);
+			lastEmd = newEmd;
+		}
+		return emd;
+	}
+
+	template <MeasureIndices M>
+	void Distances(iAVectorDataType const * data, size_t channelCount,
+		std::pair<iAVoxelIndexType, iAVoxelIndexType> const * pairs, size_t pairCount, double * result)
+	{
+		for (size_t p = 0; p < pairCount; ++p)
+		{
+			result[p] = Distance<M>(
+				data + static_cast<size_t>(pairs[p].first) * channelCount,
+				data + static_cast<size_t>(pairs[p].second) * channelCount,
+				channelCount);
+		}
+	}
 }
 
 
@@ -127,6 +283,39 @@ QSharedPointer<iAVectorDistance> GetDistanceMeasureFromShortName(QString const &
 	return Measure[dmInvalid];
 }
 
+MeasureIndices GetMeasureIndex(iAVectorDistance const & distFunc)
+{
+	for (int m = 0; m < dmCount; ++m)
+	{
+		if (std::strcmp(distFunc.GetShortName(), MeasureShortNames[m]) == 0)
+		{
+			return static_cast<MeasureIndices>(m);
+		}
+	}
+	return dmInvalid;
+}
+
+void CalculateDistances(MeasureIndices measure, iAVectorDataType const * data, size_t channelCount,
+	std::pair<iAVoxelIndexType, iAVoxelIndexType> const * pairs, size_t pairCount, double * result)
+{
+	switch (measure)
+	{
+	case dmL1:              Distances<dmL1>(data, channelCount, pairs, pairCount, result); break;
+	case dmL2:              Distances<dmL2>(data, channelCount, pairs, pairCount, result); break;
+	case dmLinf:            Distances<dmLinf>(data, channelCount, pairs, pairCount, result); break;
+	case dmCosine:          Distances<dmCosine>(data, channelCount, pairs, pairCount, result); break;
+	case dmJensenShannon:   Distances<dmJensenShannon>(data, channelCount, pairs, pairCount, result); break;
+	case dmKullbackLeibler: Distances<dmKullbackLeibler>(data, channelCount, pairs, pairCount, result); break;
+	case dmChiSquare:       Distances<dmChiSquare>(data, channelCount, pairs, pairCount, result); break;
+	case dmEarthMovers:     Distances<dmEarthMovers>(data, channelCount, pairs, pairCount, result); break;
+	case dmSquared:         Distances<dmSquared>(data, channelCount, pairs, pairCount, result); break;
+	default:
+		// we _should_ never get here...
+		assert(false);
+		break;
+	}
+}
+
 
 iAVectorDistance::~iAVectorDistance()
 {}
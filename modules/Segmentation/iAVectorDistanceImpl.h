@@ -4,8 +4,13 @@
 
 #include "iAVectorDistance.h"
 
+#include <iAImageCoordinate.h>  // for iAVoxelIndexType
+
 #include <QString>
 
+#include <cstddef> // for size_t
+#include <utility> // for std::pair
+
 enum MeasureIndices
 {
 	dmL1,
@@ -27,6 +32,19 @@ char const * const * GetDistanceMeasureNames();
 char const * const * GetShortMeasureNames();
 QSharedPointer<iAVectorDistance> GetDistanceMeasure(QString const & distFuncName);
 QSharedPointer<iAVectorDistance> GetDistanceMeasureFromShortName(QString const & distFuncName);
+//! the index of the given measure, dmInvalid if it is none of the measures listed in MeasureIndices
+MeasureIndices GetMeasureIndex(iAVectorDistance const & distFunc);
+
+//! Computes the distances between many pairs of vectors with the given measure, without virtual calls per vector element.
+//! Results are identical to those of the GetDistance method of the respective iAVectorDistance.
+//! @param measure the distance measure to use; must not be dmInvalid
+//! @param data all vectors, channelCount consecutive values per vector (see iAVectorArrayBuffer)
+//! @param channelCount the number of values per vector
+//! @param pairs the indices of the two vectors to compare, for each distance
+//! @param pairCount the number of distances to compute
+//! @param result receives the pairCount distances
+void CalculateDistances(MeasureIndices measure, iAVectorDataType const * data, size_t channelCount,
+	std::pair<iAVoxelIndexType, iAVoxelIndexType> const * pairs, size_t pairCount, double * result);
 
 class Segmentation_API iASpectralAngularDistance: public iAVectorDistance
 {
@@ -2674,6 +2674,168 @@ double svm_predict_probability(
 		return svm_predict(model, x);
 }
 
+// whether all support vectors consist of exactly the indices 0..dim-1, in that order
+static bool svm_has_dense_sv(const svm_model *model, int dim)
+{
+	for(int i=0;i<model->l;i++)
+	{
+		const svm_node *sv = model->SV[i];
+		for(int d=0;d<dim;d++)
+			if(sv[d].index != d)
+				return false;
+		if(sv[dim].index != -1)
+			return false;
+	}
+	return true;
+}
+
+// Same as Kernel::k_function for a vector and a support vector which both contain all indices 0..dim-1;
+// the terms are summed up in the same order, so the results are identical.
+static double dense_k_function(const double *x, const svm_node *sv, int dim, const svm_parameter& param)
+{
+	double sum = 0;
+	switch(param.kernel_type)
+	{
+		case LINEAR:
+			for(int d=0;d<dim;d++)
+				sum += x[d] * sv[d].value;
+			return sum;
+		case POLY:
+			for(int d=0;d<dim;d++)
+				sum += x[d] * sv[d].value;
+			return powi(param.gamma*sum+param.coef0,param.degree);
+		case RBF:
+			for(int d=0;d<dim;d++)
+			{
+				double diff = x[d] - sv[d].value;
+				sum += diff*diff;
+			}
+			return std::exp(-param.gamma*sum);
+		case SIGMOID:
+			for(int d=0;d<dim;d++)
+				sum += x[d] * sv[d].value;
+			return tanh(param.gamma*sum+param.coef0);
+		default:
+			return 0;  // Unreachable, precomputed kernels are handled by svm_predict_dense
+	}
+}
+
+void svm_predict_dense(const svm_model *model, const double *x, int count, int dim, double *labels, double *prob_estimates)
+{
+	int nr_class = model->nr_class;
+	bool has_probability = (model->param.svm_type == C_SVC || model->param.svm_type == NU_SVC) &&
+		model->probA!=nullptr && model->probB!=nullptr;
+	if((model->param.svm_type != C_SVC && model->param.svm_type != NU_SVC) ||
+	   model->param.kernel_type == PRECOMPUTED || !svm_has_dense_sv(model, dim))
+	{
+		// no shortcut possible, predict each vector on its own
+		svm_node *node = Malloc(svm_node,dim+1);
+		node[dim].index = -1;
+		for(int v=0;v<count;v++)
+		{
+			for(int d=0;d<dim;d++)
+			{
+				node[d].index = d;
+				node[d].value = x[v*(size_t)dim+d];
+			}
+			if(prob_estimates)
+				svm_predict_probability(model,node,prob_estimates+v*(size_t)nr_class);
+			if(labels)
+				labels[v] = svm_predict(model,node);
+		}
+		free(node);
+		return;
+	}
+
+	int i;
+	int l = model->l;
+	double *kvalue = Malloc(double,l);
+	double *dec_values = Malloc(double,nr_class*(nr_class-1)/2);
+	int *start = Malloc(int,nr_class);
+	int *vote = Malloc(int,nr_class);
+	double **pairwise_prob=Malloc(double *,nr_class);
+	for(i=0;i<nr_class;i++)
+		pairwise_prob[i]=Malloc(double,nr_class);
+	start[0] = 0;
+	for(i=1;i<nr_class;i++)
+		start[i] = start[i-1]+model->nSV[i-1];
+	double min_prob=1e-7;
+
+	for(int v=0;v<count;v++)
+	{
+		const double *xv = x+v*(size_t)dim;
+		for(i=0;i<l;i++)
+			kvalue[i] = dense_k_function(xv,model->SV[i],dim,model->param);
+
+		// decision values and voting as in svm_predict_values:
+		for(i=0;i<nr_class;i++)
+			vote[i] = 0;
+		int p=0;
+		for(i=0;i<nr_class;i++)
+			for(int j=i+1;j<nr_class;j++)
+			{
+				double sum = 0;
+				int si = start[i];
+				int sj = start[j];
+				int ci = model->nSV[i];
+				int cj = model->nSV[j];
+
+				int k;
+				double *coef1 = model->sv_coef[j-1];
+				double *coef2 = model->sv_coef[i];
+				for(k=0;k<ci;k++)
+					sum += coef1[si+k] * kvalue[si+k];
+				for(k=0;k<cj;k++)
+					sum += coef2[sj+k] * kvalue[sj+k];
+				sum -= model->rho[p];
+				dec_values[p] = sum;
+
+				if(dec_values[p] > 0)
+					++vote[i];
+				else
+					++vote[j];
+				p++;
+			}
+		if(labels)
+		{
+			int vote_max_idx = 0;
+			for(i=1;i<nr_class;i++)
+				if(vote[i] > vote[vote_max_idx])
+					vote_max_idx = i;
+			labels[v] = model->label[vote_max_idx];
+		}
+
+		// probability estimates from the same decision values, as in svm_predict_probability:
+		if(prob_estimates && has_probability)
+		{
+			double *pv = prob_estimates+v*(size_t)nr_class;
+			int k=0;
+			for(i=0;i<nr_class;i++)
+				for(int j=i+1;j<nr_class;j++)
+				{
+					pairwise_prob[i][j]=std::min(std::max(sigmoid_predict(dec_values[k],model->probA[k],model->probB[k]),min_prob),1-min_prob);
+					pairwise_prob[j][i]=1-pairwise_prob[i][j];
+					k++;
+				}
+			if (nr_class == 2)
+			{
+				pv[0] = pairwise_prob[0][1];
+				pv[1] = pairwise_prob[1][0];
+			}
+			else
+				multiclass_probability(nr_class,pairwise_prob,pv);
+		}
+	}
+
+	for(i=0;i<nr_class;i++)
+		free(pairwise_prob[i]);
+	free(pairwise_prob);
+	free(vote);
+	free(start);
+	free(dec_values);
+	free(kvalue);
+}
+
 static const char *svm_type_table[] =
 {
 	"c_svc","nu_svc","one_class","epsilon_svr","nu_svr",nullptr
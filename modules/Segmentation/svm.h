@@ -122,6 +122,10 @@ double svm_get_svr_probability(const struct svm_model *model);
 double svm_predict_values(const struct svm_model *model, const struct svm_node *x, double* dec_values);
 double svm_predict(const struct svm_model *model, const struct svm_node *x);
 double svm_predict_probability(const struct svm_model *model, const struct svm_node *x, double* prob_estimates);
+// Predicts count dense feature vectors (x[i*dim+d] is feature d, i.e. node index d, of vector i) at once.
+// The kernel values of each vector are evaluated only once; labels (may be null) receive the same values as
+// svm_predict, prob_estimates (count*nr_class values, may be null) the same as svm_predict_probability.
+void svm_predict_dense(const struct svm_model *model, const double *x, int count, int dim, double *labels, double *prob_estimates);
 
 void svm_free_model_content(struct svm_model *model_ptr);
 void svm_free_and_destroy_model(struct svm_model **model_ptr_ptr);
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "iASimpleTester.h"
 
+#include <random>
 #include <vector>
 
 #include <iAFunctionalBoxplot.h>
@@ -73,8 +74,57 @@ BEGIN_TEST
 	iAFunctionalBoxplot<TestArgType, TestValType> bp(functions, &measure, TestFuncBandSize);
 	
 	testFunc(bp.getMedian(), argMin, argMax, { 20, 30, 20, 20 } );
-	testFuncBand<TestArgType, TestValType>(bp.getCentralRegion(), argMin, argMax, { {19,20}, {28,30}, {17,20}, {18,20} } );
+	testFuncBand<TestArgType, TestValType>(bp.getCentralRegion(), argMin, argMax, { {20,25}, {30,31}, {20,22}, {20,24} } );
 	testFuncBand<TestArgType, TestValType>(bp.getEnvelope(), argMin, argMax, { {19,45}, {9,31}, {17,34}, {18,27} } );
 	
 	TestEqual(static_cast<size_t>(0), bp.getOutliers().size());
+
+	// the same from a dense function matrix:
+	iAFunctionMatrix<TestArgType, TestValType> matrix(functions);
+	iAFunctionalBoxplot<TestArgType, TestValType> matrixBP(matrix);
+	testFunc(matrixBP.getMedian(), argMin, argMax, { 20, 30, 20, 20 } );
+	testFuncBand<TestArgType, TestValType>(matrixBP.getCentralRegion(), argMin, argMax, { {20,25}, {30,31}, {20,22}, {20,24} } );
+	testFuncBand<TestArgType, TestValType>(matrixBP.getEnvelope(), argMin, argMax, { {19,45}, {9,31}, {17,34}, {18,27} } );
+	TestEqual(static_cast<size_t>(0), matrixBP.getOutliers().size());
+
+	// random functions, filled directly into a matrix, compared to the boxplot of the same functions given separately:
+	const size_t RandomFuncCount = 301, RandomArgCount = 50;
+	std::vector<TestArgType> args;
+	for (size_t a = 0; a < RandomArgCount; ++a)
+	{
+		args.push_back(a);
+	}
+	iAFunctionMatrix<TestArgType, TestValType> randomMatrix(args, RandomFuncCount);
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<TestValType> value(0, 100);
+	for (size_t a = 0; a < RandomArgCount; ++a)
+	{
+		for (size_t f = 0; f < RandomFuncCount; ++f)
+		{
+			randomMatrix.argValues(a)[f] = value(rng);
+		}
+	}
+	std::vector<iAFunction<TestArgType, TestValType>> randomFunctions;
+	for (size_t f = 0; f < RandomFuncCount; ++f)
+	{
+		randomFunctions.push_back(randomMatrix.function(f));
+	}
+	std::vector<iAFunction<TestArgType, TestValType>*> randomFunctionPtrs;
+	for (auto& f : randomFunctions)
+	{
+		randomFunctionPtrs.push_back(&f);
+	}
+	iAFunctionalBoxplot<TestArgType, TestValType> randomBP(randomFunctionPtrs, &measure, 2);
+	iAFunctionalBoxplot<TestArgType, TestValType> randomMatrixBP(randomMatrix);
+	TestAssert(randomBP.getMedian() == randomMatrixBP.getMedian());
+	int differingBounds = 0;
+	for (size_t a = 0; a < RandomArgCount; ++a)
+	{
+		differingBounds += (randomBP.getCentralRegion().getMin(a) != randomMatrixBP.getCentralRegion().getMin(a) ||
+			randomBP.getCentralRegion().getMax(a) != randomMatrixBP.getCentralRegion().getMax(a) ||
+			randomBP.getEnvelope().getMin(a) != randomMatrixBP.getEnvelope().getMin(a) ||
+			randomBP.getEnvelope().getMax(a) != randomMatrixBP.getEnvelope().getMax(a)) ? 1 : 0;
+	}
+	TestEqual(differingBounds, 0);
+	TestEqual(randomBP.getOutliers().size(), randomMatrixBP.getOutliers().size());
 END_TEST